@@ -9,7 +9,7 @@
 				
 	Version:	2.0.2
 
-	Copyright: 	 Copyright 2000 - 2002 Apple Computer, Inc. All rights reserved.
+	Copyright: 	© Copyright 2000 - 2002 Apple Computer, Inc. All rights reserved.
 	
 	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
 				("Apple") in consideration of your agreement to the following terms, and your
@@ -18,7 +18,7 @@
 				please do not use, install, modify or redistribute this Apple software.
 
 				In consideration of your agreement to abide by the following terms, and subject
-				to these terms, Apple grants you a personal, non-exclusive license, under Apples
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
 				copyrights in this original Apple software (the "Apple Software"), to use,
 				reproduce, modify and redistribute the Apple Software, with or without
 				modifications, in source and/or binary forms; provided that if you redistribute
@@ -46,7 +46,46 @@
 				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
 				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 				
-	Change History (most recent first): <5> 06/12/02 don't call SetEchoPort in Begin by default
+	Change History (most recent first): <41> 10/19/26 a Movie drawing into the output is legalized through a swap chain, rate conversion
+													 legalizes as it composes, OutputFrameDone() no longer does, turning
+													 the echo port off puts the Movie back in its swap chain buffer
+										<40> 10/19/26 the loudness meter reads the Movie's sound with a movie audio extraction session
+										<39> 10/19/26 the device task is only used for thread-safe components, Close() blocks
+													 on a semaphore and takes a timeout
+										<38> 10/19/26 the DV encode is left on the work pool until FinishFrame()
+										<37> 10/19/26 StartRecording can tap the DV decode after the legalizer, StartLegalizer says why it can't
+										<36> 10/19/26 the scopes see the DV encoder's source legalized, as it's encoded
+										<35> 10/19/26 every routed sound output gets the format, routes keep the track's balance
+										<34> 10/19/26 the Movie's format comes from the track catalog
+										<33> 10/19/26 PresentFrame() leaves the DV decode on the work pool until the next idle
+										<32> 10/19/26 StartSyncMonitor() asks the sound output for its latency, logs its errors
+										<31> 10/19/26 StartAtTime() returns straight away
+										<30> 10/19/26 added OpenDVIndex, cueing goes by the DV file's own timecode
+										<29> 10/19/26 the Movie draws into the swap chain's buffers
+										<28> 10/19/26 the cadence is built a field at a time on an interlaced mode
+										<27> 10/19/26 PresentFrame() shows the frames rate conversion asks for
+										<26> 10/19/26 added the legalizer
+										<25> 10/19/26 added the scopes
+										<24> 10/19/26 added the loudness meter
+										<23> 10/19/26 sound tracks follow their audio route, see CVideoOutputAudioRouting
+										<22> 10/19/26 Begin() sets the sound output's sample size and channels
+										<21> 10/19/26 what the component can do comes from CVideoOutputCapabilities
+										<20> 10/19/26 the tracks come from the track catalog
+										<19> 10/19/26 added trace points
+										<18> 10/19/26 errors are recorded in mErrorLog
+										<17> 10/19/26 added BeginAsync and EndAsync
+										<16> 10/19/26 state machine replaces mVideoOutputInUse
+										<15> 10/19/26 added GetTimeUntilNextFrame
+										<14> 10/19/26 added the sync monitor
+										<13> 10/19/26 added CueFrame, CueTimecode and StartAtTime
+										<12> 10/19/26 added StartRecording
+										<11> 10/19/26 added CreateSwapChain
+										<10> 10/19/26 decode DV movies straight into the output GWorld
+										<9> 10/19/26 encode non DV movies for DV only outputs
+										<8> 10/19/26 track the movie and display mode field order
+										<7> 10/19/26 added SetRateConversion and GetCadenceFrame
+										<6> 10/19/26 added SelectBestDisplayMode
+										<5> 06/12/02 don't call SetEchoPort in Begin by default
 										<4> 05/27/02 don't leak SoundInfoList handle
 										<3> 11/16/01 initial release version 2.0
 										<2> 10/11/01 modified to support multiple components
@@ -54,19 +93,48 @@
 */
 
 #include "CVideoOutput.h"
+#include "CVideoOutputTrace.h"
 
 using namespace dts;
 
+// How far the cadence can get from the Movie, in frames, before it's anchored again
+const SInt64 kCadenceResyncFrames = 2;
+
+static UInt64 MicrosecondsSince( AbsoluteTime inStart )
+{
+	return ::UnsignedWideToUInt64( ::AbsoluteToNanoseconds( ::SubAbsoluteFromAbsolute( ::UpTime(), inStart ) ) ) / 1000;
+}
+
+// What's left of a timeout in milliseconds started at inStart
+static Duration TimeLeft( AbsoluteTime inStart, Duration inTimeout )
+{
+	UInt64 theElapsed;
+	
+	if ( inTimeout == kDurationForever || inTimeout <= kDurationImmediate ) return inTimeout;
+	
+	theElapsed = MicrosecondsSince( inStart ) / 1000;
+	
+	return ( theElapsed < (UInt64)inTimeout ) ? (Duration)( inTimeout - theElapsed ) : kDurationImmediate;
+}
+
 /*	Check the result of GetError() before using the object.
 	
 	NOTE: This class will not throw any exceptions but does keep track of errors internally and will
 	return errors from most methods. You should call the GetError() method before working with
 	the object just to make sure things haven't failed miserably.
 */
-CVideoOutput::CVideoOutput( const unsigned char inClientNameStr[], const Movie inMovie ) : mMovie(inMovie), mVOutputComponent(NULL), mVOutputGWorld(NULL),
+CVideoOutput::CVideoOutput( const unsigned char inClientNameStr[], const Movie inMovie ) : mMovie(inMovie), mTrackCatalog(NULL), mVOutputComponent(NULL), mVOutputGWorld(NULL),
 																							mSoundOutComponent(NULL), mVideoOutputClockInstance(NULL),
-																							 mNumberAudioTracks(0), mVideoOutputInUse(false), mCanDoEchoPort(false),
-																							  mHasSoundOutput(false), mHasClock(false), rc(noErr)
+																							 mNumberAudioTracks(0), mState(eVideoOutputClosed), mStateChanged(0), mCanDoEchoPort(false),
+																							  mHasSoundOutput(false), mHasClock(false), mCadenceOrigin(0), mCadenceBase(0), mCadenceGWorld(NULL),
+																							   mHasCadenceShown(false),
+																							   mMovieFieldOrder(eFieldOrderUnknown), mModeFieldOrder(eFieldOrderUnknown),
+																								mDVEncoder(NULL), mDVSourceGWorld(NULL), mDVDrawingCompleteUPP(NULL),
+																								 mDVDecoder(NULL), mDVTrack(NULL), mDVSample(NULL), mDVSampleNum(0), mDVSystem(eDVSystem525_60),
+																								  mSwapChain(NULL), mHasMovieBuffer(false), mIsMovieBufferDrawn(false), mRecorder(NULL), mIsRecordingDVFrames(false), mOutputDrawingCompleteUPP(NULL), mDVIndex(NULL), mSyncMonitor(NULL), mLoudnessMeter(NULL), mScopes(NULL), mLegalizer(NULL), mIsLegalizerSwapChain(false),
+																								   mBeginSampleRate(0), mBeginSampleSize(0), mBeginChannels(0), mBeginUseVOsdev(true), mBeginUseVOClock(true), mBeginChangeMovieGWorld(false),
+																									mIsHardwareOurs(false), mDeviceTask(NULL), mAsyncDoneProc(NULL), mAsyncRefCon(NULL), mAsyncTimer(NULL),
+																									 mAsyncAbandoned(noErr), rc(noErr)
 {	
 	// Instantiate the actual QuickTime VO Component object used by this class.
 	// We could do this in the ctor init list, but we don't want any uncaught
@@ -75,8 +143,19 @@ CVideoOutput::CVideoOutput( const unsigned char inClientNameStr[], const Movie i
 		CVideoOutputComponentPtr pVOComponent(new CVideoOutputComponent);
 		mVOutputComponent = pVOComponent;
 	}
+	catch ( ComponentResult inErr ) {
+		rc = LogError( eErrorOperationCreate, inErr );
+		return;
+	}
 	catch ( ... ) {
-		rc = badComponentType;
+		rc = LogError( eErrorOperationCreate, badComponentType );
+		return;
+	}
+	
+	// Close() waits on this for a transition on another thread
+	if (( rc = ::MPCreateSemaphore( 1, 0, &mStateChanged ) ) != noErr ) {
+		mStateChanged = 0;
+		rc = LogError( eErrorOperationCreate, rc );
 		return;
 	}
 	
@@ -88,11 +167,31 @@ CVideoOutput::CVideoOutput( const unsigned char inClientNameStr[], const Movie i
 
 	BlockMoveData( inClientNameStr, mClientNameStr, inClientNameStr[0]+1 );
 	
+	mDeviceTimes.beginMicroseconds = mDeviceTimes.soundMicroseconds = 0;
+	mDeviceTimes.endMicroseconds = mDeviceTimes.asyncMicroseconds = 0;
+	
+	mWantedSampleSize = mWantedChannels = 0;
+	mAudioFormat.sampleRate = 0;
+	mAudioFormat.sampleSize = mAudioFormat.channels = 0;
+	
+	mIsUsingVOsdev = false;
+	
 	for ( UInt8 i = 0; i < kMaxAudioTracks; i++ ) {
 		mAudioMediaHandler[i] = NULL;
+		mAudioTrack[i] = NULL;
 	}
 }
 
+/* ~CVideoOutput()
+		Closes, waiting for as long as the device takes.
+*/
+CVideoOutput::~CVideoOutput()
+{
+	Close();
+	
+	if ( mStateChanged ) ::MPDeleteSemaphore( mStateChanged );
+}
+
 #pragma mark-
 
 /* Open( void )
@@ -102,35 +201,81 @@ CVideoOutput::CVideoOutput( const unsigned char inClientNameStr[], const Movie i
 OSErr CVideoOutput::Open( void )
 {
 	ComponentInstance theInstance = 0;
+	OSErr			  err = noErr;
  
-	if ( mVideoOutputInUse ) { rc = videoOutputInUseErr; goto bail; }
-	if ( mVOutputComponent.get() == NULL ) { rc = badComponentType; goto bail; }
+	if ( mVOutputComponent.get() == NULL ) { err = badComponentType; goto bail; }
+	if ( !ChangeState( eVideoOutputClosed, eVideoOutputOpening ) ) { err = videoOutputInUseErr; goto bail; }
 	
 	// Specifically open a chosen video output component
 	mVOutputComponent->OpenComponent();
 	
-	if (( theInstance = mVOutputComponent->GetComponentInstance() ) == NULL ) { rc = badComponentInstance; goto bail; }
+	if (( theInstance = mVOutputComponent->GetComponentInstance() ) == NULL ) { err = LogError( eErrorOperationOpen, badComponentInstance ); goto done; }
 	
 	// Register your client name with the Video Output Component
 	::QTVideoOutputSetClientName( theInstance, mClientNameStr );
 	
 	// Set the display mode
-	rc = ::QTVideoOutputSetDisplayMode( theInstance, mVOutputComponent->GetDisplayMode() );
-	if ( rc ) Close();
+	err = LogError( eErrorOperationSetDisplayMode, ::QTVideoOutputSetDisplayMode( theInstance, mVOutputComponent->GetDisplayMode() ) );
+	
+done:
+	if ( err ) {
+		mVOutputComponent->CloseComponent();
+		ChangeState( eVideoOutputOpening, eVideoOutputClosed );
+	} else {
+		ChangeState( eVideoOutputOpening, eVideoOutputOpened );
+	}
 	
 bail:
-	return rc;
+	rc = err;
+	return err;
 }
 
-/* Close( void )
+/* Close( Duration inTimeout = kDurationForever )
 		Closes the component instance and zeros the object. It is also called by the destructor.
 */
-void CVideoOutput::Close( void )
+OSErr CVideoOutput::Close( Duration inTimeout )
 {	
-	if ( mVideoOutputInUse )
-		End();
+	AbsoluteTime theStart = ::UpTime();
+	OSErr		 err = noErr;
+	
+	// Give up on a Begin on the device task and wait for either to come back, which gets us to Begun or Opened
+	if ( IsAsyncPending() ) {
+		if ( GetState() == eVideoOutputBeginning ) CancelAsync();
+		err = mDeviceTask->Wait( inTimeout );
+		if ( err ) goto bail;
+	}
+	
+	for ( ;; ) {
+		VideoOutputState theState = GetState();
+		
+		if ( theState == eVideoOutputClosed ) goto bail;
+		if ( theState == eVideoOutputBegun ) End();
+		else if ( theState == eVideoOutputOpened && ChangeState( eVideoOutputOpened, eVideoOutputClosing ) ) break;
+		else if ( ::MPWaitOnSemaphore( mStateChanged, TimeLeft( theStart, inTimeout ) ) ) {
+			// someone else is in the middle of a transition and hasn't finished in time
+			err = kMPTimeoutErr;
+			goto bail;
+		}
+	}
 	
 	mVOutputComponent->CloseComponent();
+	
+	ChangeState( eVideoOutputClosing, eVideoOutputClosed );
+	
+bail:
+	return err;
+}
+
+/* ChangeState( VideoOutputState inFrom, VideoOutputState inTo )
+		Takes one step if we're still at inFrom, and wakes a Close() waiting for it.
+*/
+Boolean CVideoOutput::ChangeState( VideoOutputState inFrom, VideoOutputState inTo )
+{
+	if ( !::CompareAndSwap( inFrom, inTo, &mState ) ) return false;
+	
+	::MPSignalSemaphore( mStateChanged );
+	
+	return true;
 }
 
 #pragma mark-
@@ -143,93 +288,171 @@ void CVideoOutput::Close( void )
 */
 OSErr CVideoOutput::Begin( Boolean inUseVOsdev, Boolean inUseVOClock, AudioRate inAudioRate, Boolean inChangeMovieGWorld )
 {
-	ComponentInstance theInstance = 0;
-	UnsignedFixed	  theSampleRate = inAudioRate;
+	OSErr err = PrepareBegin( inUseVOsdev, inUseVOClock, inAudioRate, inChangeMovieGWorld );
+	if ( err ) return err;
+	
+	return FinishBegin( DeviceBegin() );
+}
+
+/* PrepareBegin( Boolean inUseVOsdev, Boolean inUseVOClock, AudioRate inAudioRate, Boolean inChangeMovieGWorld )
+		The first part of Begin(), on the calling thread. Takes us to Beginning and finds the sound tracks.
+*/
+OSErr CVideoOutput::PrepareBegin( Boolean inUseVOsdev, Boolean inUseVOClock, AudioRate inAudioRate, Boolean inChangeMovieGWorld )
+{
+	const CVideoOutputTrackCatalog *pCatalog;
+	UnsignedFixed theSampleRate = inAudioRate;
 	
 	if ( mMovie == NULL ) { rc = paramErr; goto bail; }
-	if ( mVideoOutputInUse ) { rc = videoOutputInUseErr; goto bail; }
-	if (( theInstance = mVOutputComponent->GetComponentInstance() ) == NULL ) { rc = badComponentInstance; goto bail; }
+	if (( pCatalog = GetTrackCatalog() ) == NULL ) { rc = memFullErr; goto bail; }
+	if ( !ChangeState( eVideoOutputOpened, eVideoOutputBeginning ) ) { rc = ( GetState() == eVideoOutputClosed ) ? badComponentInstance : videoOutputInUseErr; goto bail; }
+	if ( mVOutputComponent->GetComponentInstance() == NULL ) {
+		ChangeState( eVideoOutputBeginning, eVideoOutputOpened );
+		rc = badComponentInstance;
+		goto bail;
+	}
 	
-	// Find out how many tracks the movie contains, then for each track find out
-	// which contain a sound media type and finally grab the media handler for those tracks
-  {	// gcc complains without this in brackets
-	long theTrackCount = ::GetMovieTrackCount( mMovie );
-	for ( UInt8 i = 1; i < theTrackCount + 1; i++) {
-		OSType aMediaType;
-		
-		Track aTrack = ::GetMovieIndTrack( mMovie, i );
-		Media aMedia = ::GetTrackMedia( aTrack );		
-		::GetMediaHandlerDescription( aMedia, &aMediaType, NULL, NULL );	
-		
-		if ( aMediaType == SoundMediaType ) {
-			mAudioMediaHandler[mNumberAudioTracks] = ::GetMediaHandler( aMedia );
+	// Grab the media handler of each sound track from the catalog, and the volume and balance
+	// the Movie has for it so End() can put them back after the audio routes
+	for ( UInt32 i = 0; i < pCatalog->GetTrackCount() && mNumberAudioTracks < kMaxAudioTracks; i++ ) {
+		if ( pCatalog->GetTrack( i ).mediaType == SoundMediaType ) {
+			mAudioMediaHandler[mNumberAudioTracks] = pCatalog->GetTrack( i ).handler;
+			mAudioTrack[mNumberAudioTracks] = pCatalog->GetTrack( i ).track;
+			mAudioTrackVolume[mNumberAudioTracks] = ::GetTrackVolume( mAudioTrack[mNumberAudioTracks] );
+			if ( ::MediaGetSoundBalance( mAudioMediaHandler[mNumberAudioTracks], &mAudioTrackBalance[mNumberAudioTracks] ) )
+				mAudioTrackBalance[mNumberAudioTracks] = 0;
 			mNumberAudioTracks++;
-			
-			// When the default audio sample rate has been requested, get the sample rate
-			// the sound was originally captured at - this becomes the sample rate
-			// passed to the output component
-			// If there are multiple audio tracks pick the higest rate
-			if ( inAudioRate == eAudioRateDefault ) {
-				SoundDescriptionHandle hSoundDesc = (SoundDescriptionHandle)::NewHandle(0);
-				if ( hSoundDesc ) {
-					::GetMediaSampleDescription( aMedia, 1, (SampleDescriptionHandle)hSoundDesc );
-					if ( theSampleRate < (**hSoundDesc).sampleRate )
-						theSampleRate = (**hSoundDesc).sampleRate;
-					::DisposeHandle( (Handle)hSoundDesc );
-				}
-			}
 		}
-		
-		if ( mNumberAudioTracks == kMaxAudioTracks ) break;
 	}
-  }
+	
+	// When the default audio sample rate has been requested, use the sample rate the sound was
+	// originally captured at - this becomes the sample rate passed to the output component
+	// If there are multiple audio tracks pick the higest rate
+	if ( inAudioRate == eAudioRateDefault && theSampleRate < pCatalog->GetHighestSampleRate() )
+		theSampleRate = pCatalog->GetHighestSampleRate();
+	
+	mBeginSampleRate = theSampleRate;
+	mBeginSampleSize = mWantedSampleSize ? mWantedSampleSize : pCatalog->GetHighestSampleSize();
+	mBeginChannels = mWantedChannels ? mWantedChannels : pCatalog->GetHighestChannels();
+	mBeginUseVOsdev = inUseVOsdev;
+	mBeginUseVOClock = inUseVOClock;
+	mBeginChangeMovieGWorld = inChangeMovieGWorld;
+	
+	rc = noErr;
+	
+bail:
+	return rc;
+}
+
+/* DeviceBegin( void )
+		The part of Begin() which waits on the device, on the calling thread or the device task. Only
+		touches the component, the sound output and the members no one else looks at while we're Beginning.
+*/
+OSErr CVideoOutput::DeviceBegin( void )
+{
+	ComponentInstance theInstance = mVOutputComponent->GetComponentInstance();
+	AbsoluteTime	  theStart = ::UpTime();
+	OSErr			  err;
+	
 	// Gain exclusive access to the video output hardware
-	rc = ::QTVideoOutputBegin( theInstance );
-	if ( rc ) goto bail;
+	err = LogError( eErrorOperationBegin, ::QTVideoOutputBegin( theInstance ) );
+	mDeviceTimes.beginMicroseconds = MicrosecondsSince( theStart );
+	if ( err ) return err;
 	
-	mVideoOutputInUse = true;
+	mIsHardwareOurs = true;
 	
-	// Does this Video Output Component implement an EchoPort?
-	if ( ::ComponentFunctionImplemented( theInstance, kQTVideoOutputSetEchoPortSelect ) )
-		mCanDoEchoPort = true;
+	theStart = ::UpTime();
+	
+	// What the component can do, echo port, clock, sound output and its sample rates - only asked
+	// the first time a component of this subType is begun
+	err = LogError( eErrorOperationGetSoundOutputInfo, CVideoOutputCapabilities::GetCapabilities( mVOutputComponent->GetComponentSubType(), theInstance, mCapabilities ) );
+	if ( err ) goto bail;
 	
 	// Does this Video Output Component have a Sound Output Component associated with it?
-	if ( ::ComponentFunctionImplemented( theInstance, kQTVideoOutputGetIndSoundOutputSelect ) ) {
-		// Get the first sound output component associated with the video output component
-		::QTVideoOutputGetIndSoundOutput( theInstance, 1, &mSoundOutComponent );
-		if ( mSoundOutComponent ) {
-			mHasSoundOutput = true;
-			
-			// Does the output component actually supports the chosen audio sample rate?
-			// If it does just go ahead and use it. If not, the sample rate will be changed
-			// to a valid rate
-			SoundInfoList theInfoList;
-			rc = ::GetSoundOutputInfo( mSoundOutComponent, siSampleRateAvailable, &theInfoList);
-			if ( rc ) { Close(); goto bail; }
-			
-			UnsignedFixedPtr pRates = reinterpret_cast<UnsignedFixedPtr>( *(theInfoList.infoHandle) );
-			UnsignedFixed tempRate = 0;
-			for ( UInt8 i = 0; i < theInfoList.count; i++ ) {				
-				tempRate = pRates[i];
-				if ( tempRate == theSampleRate ) break;
-			}
-			DisposeHandle( theInfoList.infoHandle );
-			
-			if ( tempRate != theSampleRate )
-				theSampleRate = tempRate;
-
-			rc = ::SetSoundOutputInfo( mSoundOutComponent, siSampleRate, (void *)theSampleRate );
-			if ( rc ) { Close(); goto bail; }
-		}
+	mSoundOutComponent = mCapabilities.soundOutput;
+	if ( mSoundOutComponent ) {
+		mHasSoundOutput = true;
+		
+		err = SetSoundOutputFormat( mSoundOutComponent, mCapabilities, mAudioFormat );
 	}
 	
+bail:
+	mDeviceTimes.soundMicroseconds = MicrosecondsSince( theStart );
+	
+	return err;
+}
+
+/* SetSoundOutputFormat( Component inSoundOutput, const CapabilityRecord &inCapabilities, AudioFormatRecord &outFormat )
+		Sets inSoundOutput to the sample rate, sample size and channels Begin() was asked for, or the nearest
+		it takes, and says what it got. Only the sample rate has to be taken, a sound output which won't
+		have the sample size or channels keeps its own and the field is 0.
+*/
+OSErr CVideoOutput::SetSoundOutputFormat( Component inSoundOutput, const CapabilityRecord &inCapabilities, AudioFormatRecord &outFormat )
+{
+	UnsignedFixed theSampleRate = mBeginSampleRate;
+	OSErr		  err;
+	
+	outFormat.sampleRate = 0;
+	outFormat.sampleSize = 0;
+	outFormat.channels = 0;
+	
+	// Does the output component actually supports the chosen audio sample rate?
+	// If it does just go ahead and use it. If not, the sample rate will be changed
+	// to the nearest valid rate above it
+	if ( inCapabilities.sampleRateCount )
+		theSampleRate = CVideoOutputCapabilities::FindSampleRate( inCapabilities, theSampleRate );
+	
+	err = LogError( eErrorOperationSetSoundOutputInfo, ::SetSoundOutputInfo( inSoundOutput, siSampleRate, (void *)theSampleRate ) );
+	if ( err ) return err;
+	
+	outFormat.sampleRate = theSampleRate;
+	
+	// Then the sample size and channels nearest the Movie's that the device takes, the Sound Manager
+	// converts to them on the way out. If the sound output won't have them it keeps its own
+	outFormat.sampleSize = CVideoOutputCapabilities::FindSampleSize( inCapabilities, mBeginSampleSize );
+	if ( outFormat.sampleSize &&
+		 LogError( eErrorOperationSetSoundOutputInfo, ::SetSoundOutputInfo( inSoundOutput, siSampleSize, (void *)(long)outFormat.sampleSize ) ) )
+		outFormat.sampleSize = 0;
+	
+	outFormat.channels = CVideoOutputCapabilities::FindChannels( inCapabilities, mBeginChannels );
+	if ( outFormat.channels &&
+		 LogError( eErrorOperationSetSoundOutputInfo, ::SetSoundOutputInfo( inSoundOutput, siNumberChannels, (void *)(long)outFormat.channels ) ) )
+		outFormat.channels = 0;
+	
+	return noErr;
+}
+
+/* FinishBegin( OSErr inDeviceErr )
+		The rest of Begin(), back on the calling thread once DeviceBegin() is done. Sets up the clock, the
+		GWorld and the DV encoder or decoder and takes us to Begun, or undoes it all if anything failed.
+*/
+OSErr CVideoOutput::FinishBegin( OSErr inDeviceErr )
+{
+	ComponentInstance theInstance = mVOutputComponent->GetComponentInstance();
+	OSErr			  err = inDeviceErr;
+	
+	if ( err ) goto bail;
+	
+	// Field order of the Movie and the display mode, if they match the fields can go straight out
+	if ( mTrackCatalog.get() ) mMovieFieldOrder = mTrackCatalog->GetFieldOrder();
+	mModeFieldOrder = CVideoOutputModeMatcher::GetModeFieldOrder( mVOutputComponent->GetRegistry(), mVOutputComponent->GetSelectedMode() );
+	
+	// Does this Video Output Component implement an EchoPort?
+	mCanDoEchoPort = mCapabilities.canDoEchoPort;
+	
 	// Does this Video Output Component have a Clock Component associated with it?
-	if ( ::ComponentFunctionImplemented( theInstance, kQTVideoOutputGetClockSelect ) ) {
+	if ( mCapabilities.hasClock ) {
 		// Get an instance of the clock component associated with the video output component - used to
 		// synchronize video and sound to the rate of the display
 		::QTVideoOutputGetClock( theInstance, &mVideoOutputClockInstance );
-		if ( mVideoOutputClockInstance )
+		if ( mVideoOutputClockInstance ) {
+			TimeRecord theTime;
+			
 			mHasClock = true;
+			
+			// Frame rate conversion counts output frames from here
+			::GetClockTime( mVideoOutputClockInstance, &theTime );
+			mCadenceOrigin = mRateConverter.GetOutputFrameForTime( theTime );
+		}
 	}
 	
 	if ( mQTVersion >= kQTVersion501 ) {
@@ -239,26 +462,46 @@ OSErr CVideoOutput::Begin( Boolean inUseVOsdev, Boolean inUseVOClock, AudioRate
 	}
 	
 	// Get a pointer to the graphics world used by a video output component
-	rc = ::QTVideoOutputGetGWorld( theInstance, &mVOutputGWorld );
-	if ( rc ) goto bail;
+	err = LogError( eErrorOperationGetGWorld, ::QTVideoOutputGetGWorld( theInstance, &mVOutputGWorld ) );
+	if ( err ) goto bail;
+	
+	// A DV only output won't take anything else, so if the Movie isn't DV we encode it ourselves
+	err = LogError( eErrorOperationDVEncoder, SetUpDVEncoder() );
+	if ( err ) goto bail;
+	
+	// and if it's DV going to a 2vuy or yuvs output we decode it in place rather than have it drawn and copied
+	err = LogError( eErrorOperationDVDecoder, SetUpDVDecoder() );
+	if ( err ) goto bail;
+	
+	// Frame rate conversion builds its frames in whatever the decoder or the encoder writes, so it comes after them
+	SetUpCadence();
 	
 	// Set up the sound device
-	SetSoundDevice( inUseVOsdev );
+	SetSoundDevice( mBeginUseVOsdev );
 	
 	// Set up the clock - needs to be called after setting up the sdev
-	SetClock( inUseVOClock );
+	SetClock( mBeginUseVOClock );
 	
 	// Don't call SetEchoPort by default as it could cause some problems when using the standard movie
 	// controller and a video output component which doesn't support an echo port (rare but still...).
 	// We just force the client of this class to call SetEchoPort() when they want, instead
 	// of doing it for them, unless they specifically tell us that it's ok to call it.
-	if ( inChangeMovieGWorld ) {
+	if ( mBeginChangeMovieGWorld ) {
 		// Set up the Movie GWorld and initially turn off the EchoPort.
 		SetEchoPort( NULL );
 	}
 	
-bail:	
-	return rc;
+bail:
+	// All the way to Begun or back to Opened with whatever we got done undone
+	if ( err ) {
+		TearDown( mIsHardwareOurs );
+		ChangeState( eVideoOutputBeginning, eVideoOutputOpened );
+	} else {
+		ChangeState( eVideoOutputBeginning, eVideoOutputBegun );
+	}
+	
+	rc = err;
+	return err;
 }
 
 /* End( void )
@@ -266,24 +509,75 @@ bail:
 */
 void CVideoOutput::End( void )
 {
-	if ( mVideoOutputInUse ) {
-		// Because the video output component disposes of the instance of the clock component which was returned to us
-		// by the QTVideoOutputGetClock call in the Begin() method, we need to reset the clock for the movie to the default
-		// QuickTime clock before calling QTVideoOutputEnd()
+	if ( !ChangeState( eVideoOutputBegun, eVideoOutputEnding ) ) return;
+	
+	TearDown( true );
+	
+	ChangeState( eVideoOutputEnding, eVideoOutputOpened );
+}
 
-		SetSoundDevice( false );
-		SetClock( false );
-		
-		if ( mQTVersion >= kQTVersion501 ) {
-			// Set the vout parameter to NULL as soon as the video out component is no longer in use
-			::SetMovieVideoOutput( mMovie, NULL );
-		}
-		
-		::QTVideoOutputEnd( mVOutputComponent->GetComponentInstance() );
-		
-		mVideoOutputInUse = false;
+/* TearDown( Boolean inEndHardware )
+		Undoes Begin(), from End() or from Begin() itself when it fails part way. inEndHardware is false
+		when Begin() didn't get as far as QTVideoOutputBegin().
+*/
+void CVideoOutput::TearDown( Boolean inEndHardware )
+{
+	if ( inEndHardware ) {
+		DetachOutput();
+		DeviceEnd();
+	}
+	
+	ResetOutput();
+}
+
+/* DetachOutput( void )
+		Takes the Movie off the video output, ready for QTVideoOutputEnd().
+*/
+void CVideoOutput::DetachOutput( void )
+{
+	FinishFrame();
+	DisposeCadence();
+	StopRecording();
+	StopSyncMonitor();
+	StopLoudnessMeter();
+	StopScopes();
+	StopLegalizer();
+	ReleaseSwapChain();
+	DisposeDVEncoder();
+	DisposeDVDecoder();
+	
+	// Because the video output component disposes of the instance of the clock component which was returned to us
+	// by the QTVideoOutputGetClock call in the Begin() method, we need to reset the clock for the movie to the default
+	// QuickTime clock before calling QTVideoOutputEnd()
+
+	SetSoundDevice( false );
+	SetClock( false );
+	
+	if ( mQTVersion >= kQTVersion501 ) {
+		// Set the vout parameter to NULL as soon as the video out component is no longer in use
+		::SetMovieVideoOutput( mMovie, NULL );
 	}
+}
+
+/* DeviceEnd( void )
+		QTVideoOutputEnd(), on the calling thread or the device task.
+*/
+OSErr CVideoOutput::DeviceEnd( void )
+{
+	AbsoluteTime theStart = ::UpTime();
+	OSErr		 err;
 	
+	err = LogError( eErrorOperationEnd, ::QTVideoOutputEnd( mVOutputComponent->GetComponentInstance() ) );
+	mDeviceTimes.endMicroseconds = MicrosecondsSince( theStart );
+	
+	return err;
+}
+
+/* ResetOutput( void )
+		Forgets everything Begin() found out.
+*/
+void CVideoOutput::ResetOutput( void )
+{
 	// If the video output was in use, after the call to ::QTVideoOutputEnd() mVOutputGWorld is
 	// no longer valid as the video output component automatically disposes of the
 	// graphics world. If you need to use the GWorld after calling End(), you can call
@@ -294,87 +588,1675 @@ void CVideoOutput::End( void )
 	mVOutputGWorld = NULL;
 
 	mSoundOutComponent = NULL;
+	mAudioFormat.sampleRate = 0;
+	mAudioFormat.sampleSize = mAudioFormat.channels = 0;
 	mVideoOutputClockInstance = NULL;
+	mCadenceOrigin = 0;
+	mMovieFieldOrder = mModeFieldOrder = eFieldOrderUnknown;
+	mCue.Reset();
 	
 	mNumberAudioTracks = 0;
+	mIsHardwareOurs = false;
 	
 	mCanDoEchoPort = false;
 	mHasSoundOutput = false;
 	mHasClock = false;
 
+	mIsUsingVOsdev = false;
+
 	for ( UInt8 i = 0; i < kMaxAudioTracks; i++) {
 		mAudioMediaHandler[i] = NULL;
+		mAudioTrack[i] = NULL;
 	}
 }
 
 #pragma mark-
 
-/* SetEchoPort( const CGrafPtr inEchoPort = NULL )
-		Allows you to display video both on an external video display and in a window.
-		Pass in a CGrafPtr to specify a window to display video sent to the device. When the
-		Echo Port is on, the movie is displayed in the window and sent to the video output device.
-		If the EchoPort is not supported by the video output component or is turned off,
-		the Movie will be directed to the video output components GWorld as you would expect.
-		Call CanDoEchoPort() before assuming the video output component supports the echo port.
+/* BeginAsync( AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout = kEventDurationForever, ... )
+		PrepareBegin() here, DeviceBegin() on the device task and FinishBegin() from DeviceDone().
 */
-OSErr CVideoOutput::SetEchoPort( const CGrafPtr inEchoPort )
+OSErr CVideoOutput::BeginAsync( AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout, Boolean inUseVOsdev,
+								Boolean inUseVOClock, AudioRate inAudioRate, Boolean inChangeMovieGWorld )
 {
-	ComponentInstance theInstance = 0;
+	rc = PrepareBegin( inUseVOsdev, inUseVOClock, inAudioRate, inChangeMovieGWorld );
+	if ( rc ) goto bail;
 	
-	if ( mVideoOutputInUse == false ) return videoOutputInUseErr;
-		
-	if (( theInstance = mVOutputComponent->GetComponentInstance() ) == NULL ) { rc = badComponentInstance; goto bail; }
+	rc = StartAsync( DeviceBeginProc, inDoneProc, inRefCon, inTimeout );
+	if ( rc ) FinishBegin( rc );
 	
-	if ( mCanDoEchoPort ) {
-		if ( inEchoPort == NULL ) {
-			// Turn off Echo Port
-			rc = ::QTVideoOutputSetEchoPort( theInstance, (CGrafPtr)NULL );
-			if ( rc == noErr ) {
-				if ( mVideoOutputInUse ) {
-					::SetMovieGWorld( mMovie, mVOutputGWorld, NULL );
-				}
-			}
-		} else {
-			// Turn on Echo Port		
-			rc = ::QTVideoOutputSetEchoPort( theInstance, inEchoPort );
-			if ( rc == noErr ) {
-				if ( mVideoOutputInUse ) {						
-					::SetMovieGWorld( mMovie, inEchoPort, NULL);
-				}
-			}
+bail:
+	return rc;
+}
+
+/* EndAsync( AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout = kEventDurationForever )
+		DetachOutput() here, DeviceEnd() on the device task and ResetOutput() from DeviceDone(). If the device
+		task can't be had we just end here.
+*/
+OSErr CVideoOutput::EndAsync( AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout )
+{
+	if ( !ChangeState( eVideoOutputBegun, eVideoOutputEnding ) ) { rc = IsInUse() ? videoOutputInUseErr : paramErr; goto bail; }
+	
+	DetachOutput();
+	
+	rc = StartAsync( DeviceEndProc, inDoneProc, inRefCon, inTimeout );
+	if ( rc ) {
+		DeviceEnd();
+		ResetOutput();
+		ChangeState( eVideoOutputEnding, eVideoOutputOpened );
+	}
+	
+bail:
+	return rc;
+}
+
+/* StartAsync( DeviceProcPtr inProc, AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout )
+		Hands inProc to the device task, making the task the first time, and starts the timeout.
+*/
+OSErr CVideoOutput::StartAsync( DeviceProcPtr inProc, AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout )
+{
+	static EventLoopTimerUPP sAsyncTimeoutUPP = NULL;
+	OSErr err = noErr;
+	
+	if ( inDoneProc == NULL ) return paramErr;
+	
+	if ( mDeviceTask.get() == NULL ) {
+		try {
+			CVideoOutputDeviceTaskPtr pDeviceTask(new CVideoOutputDeviceTask( DeviceDone, this ));
+			mDeviceTask = pDeviceTask;
 		}
-	} else {
-		// The Echo Port isn't supported by this component but
-		// we still need to set the Movie GWorld correctly
-		if ( inEchoPort == NULL ) {	
-			::SetMovieGWorld( mMovie, mVOutputGWorld, NULL );
-		} else {
-			::SetMovieGWorld( mMovie, inEchoPort, NULL );
+		catch ( OSStatus inErr ) {
+			return inErr;
+		}
+		catch ( ... ) {
+			return memFullErr;
 		}
 	}
-
+	
+	mAsyncDoneProc = inDoneProc;
+	mAsyncRefCon = inRefCon;
+	mAsyncAbandoned = noErr;
+	
+	if ( inTimeout != kEventDurationForever ) {
+		if ( sAsyncTimeoutUPP == NULL ) sAsyncTimeoutUPP = ::NewEventLoopTimerUPP( AsyncTimeout );
+		err = ::InstallEventLoopTimer( ::GetMainEventLoop(), inTimeout, 0, sAsyncTimeoutUPP, this, &mAsyncTimer );
+		if ( err ) goto bail;
+	}
+	
+	// The instance was opened on this thread, only a thread-safe component's can be used on the task
+	err = mDeviceTask->Run( inProc, mVOutputComponent->IsThreadSafe() );
+	
 bail:
-	return rc;
+	if ( err ) {
+		LogError( eErrorOperationAsync, err );
+		if ( mAsyncTimer ) ::RemoveEventLoopTimer( mAsyncTimer );
+		mAsyncTimer = NULL;
+		mAsyncDoneProc = NULL;
+	}
+	
+	return err;
 }
 
-/* SetSoundDevice( Boolean inUseVOsdev = true )
-		This call will turn on/off the use of the video output components sound device. Passing in 'true'
-		will set up the use of the video output components sound device, this is the default setting.
-		You should call SetClock() after this call to choose the correct clock.
+/* AbandonAsync( OSErr inReason )
+		Timed out or canceled, the client hears now, DeviceDone() cleans up when the device gets back to us.
 */
-OSErr CVideoOutput::SetSoundDevice( Boolean inUseVOsdev )
-{			
-	if ( mVideoOutputInUse == false ) return videoOutputInUseErr;
+OSErr CVideoOutput::AbandonAsync( OSErr inReason )
+{
+	if ( !IsAsyncPending() || mAsyncDoneProc == NULL ) return paramErr;
 	
-	if ( mHasSoundOutput ) {
-		if ( inUseVOsdev == true ) {
-			for ( UInt8 i = 0;i < mNumberAudioTracks; i++ ) {
-				rc = ::MediaSetSoundOutputComponent( mAudioMediaHandler[i], mSoundOutComponent );
-				if ( rc ) goto bail;
+	mAsyncAbandoned = inReason;
+	
+	if ( mAsyncTimer ) ::RemoveEventLoopTimer( mAsyncTimer );
+	mAsyncTimer = NULL;
+	
+	NotifyAsync( inReason );
+	
+	return noErr;
+}
+
+/* NotifyAsync( OSErr inResult )
+		Calls the client's done proc, once.
+*/
+void CVideoOutput::NotifyAsync( OSErr inResult )
+{
+	AsyncDoneProcPtr theDoneProc = mAsyncDoneProc;
+	
+	if ( theDoneProc == NULL ) return;
+	
+	mAsyncDoneProc = NULL;
+	(*theDoneProc)( this, inResult, mDeviceTimes, mAsyncRefCon );
+}
+
+/* LogError( OSType inOperation, OSErr inErr )
+		Records inErr against the video output component in use and hands it back. Called on the device
+		task as well, CVideoOutputErrorLog takes no locks.
+*/
+OSErr CVideoOutput::LogError( OSType inOperation, OSErr inErr )
+{
+	return mErrorLog.Log( inOperation, mVOutputComponent.get() ? mVOutputComponent->GetComponentSubType() : 0, inErr );
+}
+
+OSErr CVideoOutput::DeviceBeginProc( void *inRefCon )
+{
+	return static_cast<CVideoOutput *>(inRefCon)->DeviceBegin();
+}
+
+OSErr CVideoOutput::DeviceEndProc( void *inRefCon )
+{
+	return static_cast<CVideoOutput *>(inRefCon)->DeviceEnd();
+}
+
+/* DeviceDone( void *inRefCon, OSErr inResult, UInt64 inMicroseconds )
+		Back on the main thread with what the device task did. A Begin that was given up on is undone.
+*/
+void CVideoOutput::DeviceDone( void *inRefCon, OSErr inResult, UInt64 inMicroseconds )
+{
+	CVideoOutput *pThis = static_cast<CVideoOutput *>(inRefCon);
+	OSErr		 err = inResult;
+	
+	pThis->mDeviceTimes.asyncMicroseconds = inMicroseconds;
+	
+	if ( pThis->mAsyncTimer ) ::RemoveEventLoopTimer( pThis->mAsyncTimer );
+	pThis->mAsyncTimer = NULL;
+	
+	if ( pThis->GetState() == eVideoOutputBeginning ) {
+		err = pThis->FinishBegin( pThis->mAsyncAbandoned ? pThis->mAsyncAbandoned : inResult );
+	} else if ( pThis->GetState() == eVideoOutputEnding ) {
+		pThis->ResetOutput();
+		pThis->ChangeState( eVideoOutputEnding, eVideoOutputOpened );
+	}
+	
+	pThis->NotifyAsync( err );
+}
+
+pascal void CVideoOutput::AsyncTimeout( EventLoopTimerRef /*inTimer*/, void *inUserData )
+{
+	CVideoOutput *pThis = static_cast<CVideoOutput *>(inUserData);
+	
+	// DeviceDone() removes the timer
+	if ( pThis->mAsyncDoneProc ) {
+		pThis->mAsyncAbandoned = pThis->LogError( eErrorOperationAsync, kMPTimeoutErr );
+		pThis->NotifyAsync( kMPTimeoutErr );
+	}
+}
+
+/* SetUpDVEncoder( void )
+		Called by Begin() once it has the video output component's GWorld. When the selected display mode
+		only takes DV and the Movie isn't DV the Movie is redirected to a '2vuy' GWorld of the same size and
+		every frame drawn there is encoded straight into the video output component's GWorld.
+*/
+OSErr CVideoOutput::SetUpDVEncoder( void )
+{
+	OSType			  theModePixelType = mVOutputComponent->GetRegistry().GetModePixelType( mVOutputComponent->GetSelectedMode() );
+	MovieFormatRecord theFormat;
+	DVSystem		  theSystem;
+	Rect			  theBounds;
+	OSErr			  err = noErr;
+	
+	if ( theModePixelType != kDVCNTSCCodecType && theModePixelType != kDVCPALCodecType ) goto bail;
+	if ( GetMovieFormat( theFormat ) == noErr && theFormat.codecType == theModePixelType ) goto bail;
+	
+	theSystem = ( theModePixelType == kDVCPALCodecType ) ? eDVSystem625_50 : eDVSystem525_60;
+	
+	::SetRect( &theBounds, 0, 0, CVideoOutputDV::GetSystem( theSystem ).width, CVideoOutputDV::GetSystem( theSystem ).height );
+	err = ::QTNewGWorld( &mDVSourceGWorld, k2vuyPixelFormat, &theBounds, NULL, NULL, 0 );
+	if ( err ) goto bail;
+	
+	// The encoder reads the pixels from another thread, keep them where they are
+	::LockPixels( ::GetGWorldPixMap( mDVSourceGWorld ) );
+	
+	try {
+		CVideoOutputDVEncoderPtr pEncoder(new CVideoOutputDVEncoder( theSystem, CVideoOutputFields::IsInterlaced( mModeFieldOrder ) ));
+		mDVEncoder = pEncoder;
+	}
+	catch ( ... ) {
+		err = memFullErr;
+		goto bail;
+	}
+	
+	mDVDrawingCompleteUPP = ::NewMovieDrawingCompleteUPP( DVDrawingComplete );
+	::SetMovieDrawingCompleteProc( mMovie, movieDrawingCallWhenChanged, mDVDrawingCompleteUPP, (long)this );
+	
+	// Whatever the component says, nothing but DV gets out so there's no echo port
+	mCanDoEchoPort = false;
+	
+bail:
+	if ( err ) DisposeDVEncoder();
+	
+	return err;
+}
+
+/* DisposeDVEncoder( void )
+		Undoes SetUpDVEncoder(), it's fine to call when we're not encoding.
+*/
+void CVideoOutput::DisposeDVEncoder( void )
+{
+	FinishEncodeSourceFrame();
+	
+	if ( mDVDrawingCompleteUPP ) {
+		::SetMovieDrawingCompleteProc( mMovie, 0, NULL, 0 );
+		::DisposeMovieDrawingCompleteUPP( mDVDrawingCompleteUPP );
+		mDVDrawingCompleteUPP = NULL;
+	}
+	
+	mDVEncoder.reset();
+	
+	if ( mDVSourceGWorld ) {
+		::DisposeGWorld( mDVSourceGWorld );
+		mDVSourceGWorld = NULL;
+	}
+}
+
+/* DVDrawingComplete( Movie inMovie, long inRefCon )
+		Movie drawing complete proc, starts encoding the frame the Movie just drew into the video output
+		component's GWorld. With rate conversion on the frame is only kept, PresentFrame() encodes
+		what the cadence builds from it.
+*/
+pascal OSErr CVideoOutput::DVDrawingComplete( Movie /*inMovie*/, long inRefCon )
+{
+	CVideoOutput *pThis = reinterpret_cast<CVideoOutput *>( inRefCon );
+	
+	if ( pThis->mRateConverter.HasFrames() ) {
+		pThis->StoreDrawnFrame( pThis->mDVSourceGWorld );
+		return noErr;
+	}
+	
+	return pThis->StartEncodeSourceFrame();
+}
+
+/* StartEncodeSourceFrame( void )
+		Starts encoding the frame in the DV encoder's source GWorld into the video output component's
+		GWorld. The encode is left on the work pool, like the decode in PresentFrame(), and finished by
+		FinishFrame() before the Movie draws into the source again.
+*/
+OSErr CVideoOutput::StartEncodeSourceFrame( void )
+{
+	PixMapHandle hSourcePixMap = ::GetGWorldPixMap( mDVSourceGWorld );
+	PixMapHandle hOutputPixMap = ::GetGWorldPixMap( mVOutputGWorld );
+	OSErr		 err = noErr;
+	
+	VIDEO_OUTPUT_TRACE_SCOPE( "convert" );
+	
+	FinishEncodeSourceFrame();
+	
+	if ( ::LockPixels( hOutputPixMap ) ) {
+		err = mDVEncoder->StartEncodeFrame( (UInt8 *)::GetPixBaseAddr( hSourcePixMap ), ::GetPixRowBytes( hSourcePixMap ),
+											k2vuyPixelFormat, (UInt8 *)::GetPixBaseAddr( hOutputPixMap ) );
+		if ( err == noErr ) {
+			// It's going up as it's encoded, the sound is measured against it from now
+			if ( mSyncMonitor.get() ) mSyncMonitor->FramePresented();
+		} else {
+			::UnlockPixels( hOutputPixMap );
+		}
+	}
+	
+	return err;
+}
+
+/* FinishEncodeSourceFrame( void )
+		Waits for the frame StartEncodeSourceFrame() started, then hands the DV frame to the recorder and
+		the source to the scopes and lets go of the output GWorld.
+*/
+void CVideoOutput::FinishEncodeSourceFrame( void )
+{
+	PixMapHandle hSourcePixMap;
+	PixMapHandle hOutputPixMap;
+	
+	if ( mDVEncoder.get() == NULL || !mDVEncoder->IsEncodingFrame() ) return;
+	
+	mDVEncoder->FinishEncodeFrame();
+	
+	hSourcePixMap = ::GetGWorldPixMap( mDVSourceGWorld );
+	hOutputPixMap = ::GetGWorldPixMap( mVOutputGWorld );
+	if ( mRecorder.get() ) mRecorder->WriteFrame( ::GetPixBaseAddr( hOutputPixMap ), 0, mDVEncoder->GetFrameSize(), 1 );
+	if ( mScopes.get() ) mScopes->SampleFrame( ::GetPixBaseAddr( hSourcePixMap ), ::GetPixRowBytes( hSourcePixMap ), mLegalizer.get() );
+	
+	::UnlockPixels( hOutputPixMap );
+}
+
+/* SetUpDVDecoder( void )
+		Called by Begin() once it has the video output component's GWorld. When the Movie is DV and the
+		selected display mode is a '2vuy' or 'yuvs' mode the size of a DV frame, the DV track is disabled so
+		QuickTime no longer decompresses it into the Movie GWorld, and PresentFrame() decodes the samples
+		straight into the video output component's GWorld instead.
+*/
+OSErr CVideoOutput::SetUpDVDecoder( void )
+{
+	OSType			  theModePixelType = mVOutputComponent->GetRegistry().GetModePixelType( mVOutputComponent->GetSelectedMode() );
+	PixMapHandle	  hOutputPixMap = ::GetGWorldPixMap( mVOutputGWorld );
+	MovieFormatRecord theFormat;
+	DVSystem		  theSystem;
+	Rect			  theBounds;
+	OSErr			  err = noErr;
+	
+	if ( mDVEncoder.get() ) goto bail;
+	if ( theModePixelType != k2vuyPixelFormat && theModePixelType != kYUVSPixelFormat ) goto bail;
+	if ( GetMovieFormat( theFormat ) ) goto bail;
+	if ( theFormat.codecType != kDVCNTSCCodecType && theFormat.codecType != kDVCPALCodecType ) goto bail;
+	
+	theSystem = ( theFormat.codecType == kDVCPALCodecType ) ? eDVSystem625_50 : eDVSystem525_60;
+	
+	// The decoder writes a whole frame in the layout of the mode, so that's exactly what the GWorld must be
+	::GetPortBounds( mVOutputGWorld, &theBounds );
+	if ( theBounds.right - theBounds.left != CVideoOutputDV::GetSystem( theSystem ).width ) goto bail;
+	if ( theBounds.bottom - theBounds.top != CVideoOutputDV::GetSystem( theSystem ).height ) goto bail;
+	if ( GETPIXMAPPIXELFORMAT( *hOutputPixMap ) != theModePixelType ) goto bail;
+	
+	mDVTrack = mTrackCatalog->FindTrack( VideoMediaType );
+	if ( mDVTrack == NULL ) goto bail;
+	
+	mDVSample = ::NewHandle( 0 );
+	if ( mDVSample == NULL ) { err = ::MemError(); goto bail; }
+	
+	try {
+		CVideoOutputDVDecoderPtr pDecoder(new CVideoOutputDVDecoder);
+		mDVDecoder = pDecoder;
+	}
+	catch ( ... ) {
+		err = memFullErr;
+		goto bail;
+	}
+	
+	mDVSystem = theSystem;
+	
+	// The Movie keeps its time and sound, it just doesn't draw the DV track any more
+	::SetTrackEnabled( mDVTrack, false );
+	
+	// We write the output GWorld directly, there's nothing for an echo port to show
+	mCanDoEchoPort = false;
+	
+bail:
+	if ( err || mDVDecoder.get() == NULL ) {
+		// Leave the track alone if we never got as far as disabling it
+		mDVTrack = NULL;
+		DisposeDVDecoder();
+	}
+	
+	return err;
+}
+
+/* DisposeDVDecoder( void )
+		Undoes SetUpDVDecoder(), it's fine to call when we're not decoding.
+*/
+void CVideoOutput::DisposeDVDecoder( void )
+{
+	if ( mDVTrack ) {
+		::SetTrackEnabled( mDVTrack, true );
+		mDVTrack = NULL;
+	}
+	
+	FinishPresentFrame();
+	mDVDecoder.reset();
+	
+	if ( mDVSample ) {
+		::DisposeHandle( mDVSample );
+		mDVSample = NULL;
+	}
+	
+	mDVSampleNum = 0;
+}
+
+/* PresentFrame( void )
+		Decodes the DV sample at the current Movie time into the video output component's GWorld. The
+		decoder is handed the GWorld's base address and rowBytes, so the pixels are written once, where
+		they're shown. A sample that's already up isn't decoded again. The decode is only started here,
+		every session shares the one work pool and waiting for it would hold up the others' idles.
+*/
+OSErr CVideoOutput::PresentFrame( void )
+{
+	PixMapHandle hOutputPixMap;
+	Media		 theMedia;
+	TimeValue	 theMediaTime;
+	long		 theSampleNum = 0;
+	long		 theSize = 0;
+	
+	VIDEO_OUTPUT_TRACE_SCOPE( "present" );
+	
+	// The last frame's had the time since the last idle
+	FinishPresentFrame();
+	
+	if ( mIsMovieBufferDrawn ) { rc = PresentMovieBuffer(); goto bail; }
+	if ( mRateConverter.HasFrames() ) { rc = PresentCadenceFrame(); goto bail; }
+	if ( mDVDecoder.get() == NULL ) { rc = noErr; goto bail; }
+	
+	theMedia = ::GetTrackMedia( mDVTrack );
+	
+	// Nothing to do in an empty edit, whatever's up stays up
+	theMediaTime = ::TrackTimeToMediaTime( ::GetMovieTime( mMovie, NULL ), mDVTrack );
+	if ( theMediaTime < 0 ) { rc = noErr; goto bail; }
+	
+	::MediaTimeToSampleNum( theMedia, theMediaTime, &theSampleNum, NULL, NULL );
+	if ( theSampleNum == mDVSampleNum ) { rc = noErr; goto bail; }
+	
+  {	// the trace scope ends with the read
+	VIDEO_OUTPUT_TRACE_SCOPE( "read" );
+	rc = LogError( eErrorOperationPresentFrame, ::GetMediaSample( theMedia, mDVSample, 0, &theSize, theMediaTime, NULL, NULL, NULL, NULL, 1, NULL, NULL ) );
+  }
+	if ( rc ) goto bail;
+	
+	// A frame of the other system would run off the end of the GWorld
+	if ( theSize < (long)CVideoOutputDV::GetSystem( mDVSystem ).frameSize ||
+		 CVideoOutputDV::GetFrameSystem( (UInt8 *)*mDVSample ) != mDVSystem ) { rc = LogError( eErrorOperationPresentFrame, codecBadDataErr ); goto bail; }
+	
+	hOutputPixMap = ::GetGWorldPixMap( mVOutputGWorld );
+	if ( ::LockPixels( hOutputPixMap ) ) {
+		::HLock( mDVSample );
+		rc = LogError( eErrorOperationPresentFrame, mDVDecoder->StartDecodeFrame( (UInt8 *)*mDVSample, (UInt8 *)::GetPixBaseAddr( hOutputPixMap ),
+																					::GetPixRowBytes( hOutputPixMap ), GETPIXMAPPIXELFORMAT( *hOutputPixMap ) ) );
+		if ( rc == noErr ) {
+			// It's going up as it's decoded, the sound is measured against it from now
+			mDVSampleNum = theSampleNum;
+			if ( mSyncMonitor.get() ) mSyncMonitor->FramePresented();
+		} else {
+			::HUnlock( mDVSample );
+			::UnlockPixels( hOutputPixMap );
+		}
+	}
+	
+bail:
+	// Whoever put the frame up, this is where it's checked against the sound
+	if ( mSyncMonitor.get() ) mSyncMonitor->Measure();
+	if ( mLoudnessMeter.get() ) mLoudnessMeter->Measure();
+	
+	return rc;
+}
+
+/* FinishFrame( void )
+		The encode is finished first thing in the idle rather than in PresentFrame(), which comes right
+		after the Movie's drawn, so the pool has the time between this session's idles to do it.
+*/
+void CVideoOutput::FinishFrame( void )
+{
+	FinishEncodeSourceFrame();
+	FinishPresentFrame();
+}
+
+/* FinishPresentFrame( void )
+		Waits for the DV frame PresentFrame() started, the pool has usually long finished it, then hands
+		it to the recorder, the DV frame or the pixels it was decoded to, and to the scopes and lets go of the
+		sample and the GWorld.
+*/
+void CVideoOutput::FinishPresentFrame( void )
+{
+	PixMapHandle hOutputPixMap;
+	
+	if ( mDVDecoder.get() == NULL || !mDVDecoder->IsDecodingFrame() ) return;
+	
+	mDVDecoder->FinishDecodeFrame();
+	
+	hOutputPixMap = ::GetGWorldPixMap( mVOutputGWorld );
+	if ( mRecorder.get() ) {
+		if ( mIsRecordingDVFrames ) {
+			mRecorder->WriteFrame( *mDVSample, 0, CVideoOutputDV::GetSystem( mDVSystem ).frameSize, 1 );
+		} else {
+			RecordOutputFrame();
+		}
+	}
+	if ( mScopes.get() ) mScopes->SampleFrame( ::GetPixBaseAddr( hOutputPixMap ), ::GetPixRowBytes( hOutputPixMap ) );
+	
+	::HUnlock( mDVSample );
+	::UnlockPixels( hOutputPixMap );
+}
+
+/* GetTimeUntilNextFrame( long &outDuration, TimeScale inScale = 1000 )
+		The DV track is disabled while we decode it so ask the track, not the Movie, for the next sample.
+*/
+Boolean CVideoOutput::GetTimeUntilNextFrame( long &outDuration, TimeScale inScale ) const
+{
+	Track	  theTrack;
+	Fixed	  theRate;
+	TimeValue theTime, theNextTime = -1;
+	SInt64	  theDuration;
+	Boolean	  isFrameOnPool;
+	
+	if ( mMovie == NULL ) return false;
+	
+	// Idle in time for the start
+	if ( mCue.GetTimeUntilStart( outDuration, inScale ) ) return true;
+	
+	isFrameOnPool = ( ( mDVDecoder.get() && mDVDecoder->IsDecodingFrame() ) || ( mDVEncoder.get() && mDVEncoder->IsEncodingFrame() ) );
+	if ( mDVDecoder.get() == NULL && mSyncMonitor.get() == NULL && !mRateConverter.HasFrames() && !isFrameOnPool ) return false;
+	
+	theRate = ::GetMovieRate( mMovie );
+	
+	// Stopped with a frame still on the work pool, come back to finish it
+	if ( theRate == 0 && isFrameOnPool ) { outDuration = 0; return true; }
+	if ( theRate == 0 ) return false;
+	
+	// Every output frame can be a new one
+	if ( mRateConverter.HasFrames() ) {
+		outDuration = mRateConverter.GetOutputFrameDuration( inScale );
+		return true;
+	}
+	
+	if ( mDVTrack ) {
+		theTrack = mDVTrack;
+	} else if ( mTrackCatalog.get() ) {
+		theTrack = mTrackCatalog->FindTrack( VideoMediaType );
+	} else {
+		theTrack = ::GetMovieIndTrackType( mMovie, 1, VideoMediaType, movieTrackMediaType | movieTrackEnabledOnly );
+	}
+	if ( theTrack == NULL ) return false;
+	
+	theTime = ::GetMovieTime( mMovie, NULL );
+	::GetTrackNextInterestingTime( theTrack, nextTimeMediaSample, theTime, theRate, &theNextTime, NULL );
+	if ( theNextTime < 0 ) return false;	// off the end
+	
+	// movie time to inScale at the play rate, the signs cancel when playing backwards
+	theDuration = ( (SInt64)( theNextTime - theTime ) * inScale * fixed1 ) / ( (SInt64)::GetMovieTimeScale( mMovie ) * theRate );
+	outDuration = ( theDuration > 0 ) ? (long)theDuration : 0;
+	
+	return true;
+}
+
+/* SetAudioFormat( UInt16 inSampleSize = 0, UInt16 inChannels = 0 )
+		Kept for the next Begin(), 0 for the Movie's.
+*/
+OSErr CVideoOutput::SetAudioFormat( UInt16 inSampleSize, UInt16 inChannels )
+{
+	if ( GetState() > eVideoOutputOpened ) return videoOutputInUseErr;
+	
+	mWantedSampleSize = inSampleSize;
+	mWantedChannels = inChannels;
+	
+	return noErr;
+}
+
+/* SetAudioRoute( UInt8 inSoundTrack, const AudioRouteRecord &inRoute )
+		The gains go to the track now if the video output's sound device is playing it, the sound output
+		waits for SetSoundDevice().
+*/
+OSErr CVideoOutput::SetAudioRoute( UInt8 inSoundTrack, const AudioRouteRecord &inRoute )
+{
+	OSErr err = mAudioRouting.SetRoute( inSoundTrack, inRoute );
+	
+	if ( noErr == err && IsBegun() && inSoundTrack < mNumberAudioTracks ) SetAudioGain( inSoundTrack );
+	
+	return err;
+}
+
+/* ClearAudioRoute( UInt8 inSoundTrack )
+		The track goes back to the Movie's volume and balance, and to the first sound output at the next
+		SetSoundDevice().
+*/
+OSErr CVideoOutput::ClearAudioRoute( UInt8 inSoundTrack )
+{
+	if ( inSoundTrack >= kMaxAudioRoutes ) return paramErr;
+	
+	mAudioRouting.ClearRoute( inSoundTrack );
+	if ( IsBegun() && inSoundTrack < mNumberAudioTracks ) SetAudioGain( inSoundTrack );
+	
+	return noErr;
+}
+
+/* LoadAudioRouting( Handle inPreset )
+		Replaces every route, a track the preset doesn't have goes back to the Movie's volume and balance.
+*/
+OSErr CVideoOutput::LoadAudioRouting( Handle inPreset )
+{
+	OSErr err = mAudioRouting.Load( inPreset );
+	
+	if ( noErr == err && IsBegun() ) {
+		for ( UInt8 i = 0; i < mNumberAudioTracks; i++ ) {
+			SetAudioGain( i );
+		}
+	}
+	
+	return err;
+}
+
+/* GetTrackCatalog( void )
+		Makes the catalog the first time, it's kept until the Movie changes.
+*/
+const CVideoOutputTrackCatalog *CVideoOutput::GetTrackCatalog( void )
+{
+	if ( mMovie == NULL ) return NULL;
+	
+	if ( mTrackCatalog.get() == NULL ) {
+		try {
+			CVideoOutputTrackCatalogPtr pCatalog(new CVideoOutputTrackCatalog( mMovie ));
+			mTrackCatalog = pCatalog;
+		}
+		catch ( ... ) {
+			return NULL;
+		}
+	}
+	
+	return mTrackCatalog.get();
+}
+
+/* GetMovieFormat( MovieFormatRecord &outFormat )
+		The Movie's format from the track catalog, so it's only worked out once however often it's asked for.
+*/
+OSErr CVideoOutput::GetMovieFormat( MovieFormatRecord &outFormat )
+{
+	const CVideoOutputTrackCatalog *pCatalog = GetTrackCatalog();
+	
+	if ( pCatalog == NULL ) return ( mMovie ? memFullErr : paramErr );
+	
+	return pCatalog->GetMovieFormat( outFormat );
+}
+
+/* GetRoutedSoundOutput( UInt8 inSoundTrack )
+		The sound output the track's route asks for, the first one without a route or when the component
+		doesn't have the one asked for. Any other is set to the same format as the first, as near as it goes.
+*/
+Component CVideoOutput::GetRoutedSoundOutput( UInt8 inSoundTrack )
+{
+	AudioRouteRecord  theRoute;
+	CapabilityRecord  theCapabilities;
+	AudioFormatRecord theFormat;
+	Component		  theSoundOutput = NULL;
+	
+	if ( !mAudioRouting.GetRoute( inSoundTrack, theRoute ) || theRoute.output == 1 ) return mSoundOutComponent;
+	
+	if ( LogError( eErrorOperationSetSoundDevice, ::QTVideoOutputGetIndSoundOutput( mVOutputComponent->GetComponentInstance(), theRoute.output, &theSoundOutput ) ) ||
+		 theSoundOutput == NULL )
+		return mSoundOutComponent;
+	
+	if ( theSoundOutput == mSoundOutComponent ) return theSoundOutput;
+	
+	// Only the first sound output's capabilities are kept, ask this one now
+	if ( LogError( eErrorOperationGetSoundOutputInfo, CVideoOutputCapabilities::AskSoundOutput( theSoundOutput, theCapabilities ) ) )
+		theCapabilities.sampleRateCount = theCapabilities.sampleSizeCount = theCapabilities.channels = 0;
+	SetSoundOutputFormat( theSoundOutput, theCapabilities, theFormat );
+	
+	return theSoundOutput;
+}
+
+/* SetAudioGain( UInt8 inSoundTrack )
+		The track's volume and balance for its route while the video output's sound device is in use,
+		otherwise the ones the Movie had at Begin().
+*/
+void CVideoOutput::SetAudioGain( UInt8 inSoundTrack )
+{
+	AudioRouteRecord theRoute;
+	short theVolume = mAudioTrackVolume[inSoundTrack];
+	short theBalance = mAudioTrackBalance[inSoundTrack];
+	
+	if ( mIsUsingVOsdev && mAudioRouting.GetRoute( inSoundTrack, theRoute ) )
+		CVideoOutputAudioRouting::GetVolumeAndBalance( theRoute, mAudioTrackVolume[inSoundTrack], mAudioTrackBalance[inSoundTrack], theVolume, theBalance );
+	
+	::SetTrackVolume( mAudioTrack[inSoundTrack], theVolume );
+	LogError( eErrorOperationSetSoundDevice, ::MediaSetSoundBalance( mAudioMediaHandler[inSoundTrack], theBalance ) );
+}
+
+/* CreateSwapChain( UInt16 inBufferCount = 3, Boolean inDrawMovie = true )
+		Sets up the buffers and the output task, replacing any swap chain we already had. With inDrawMovie
+		the Movie is pointed at the first buffer and our drawing complete proc notes when it's been drawn.
+*/
+OSErr CVideoOutput::CreateSwapChain( UInt16 inBufferCount, Boolean inDrawMovie )
+{
+	if ( !IsBegun() ) { rc = videoOutputInUseErr; goto bail; }
+	if ( IsEncodingDV() || IsDecodingDV() || mRateConverter.HasFrames() ) { rc = paramErr; goto bail; }
+	
+	ReleaseSwapChain();
+	
+	try {
+		CVideoOutputSwapChainPtr pSwapChain(new CVideoOutputSwapChain( mVOutputGWorld, inBufferCount ));
+		mSwapChain = pSwapChain;
+		mSwapChain->SetRecorder( mRecorder.get() );
+		mSwapChain->SetScopes( mScopes.get() );
+		mSwapChain->SetLegalizer( mLegalizer.get() );
+		rc = noErr;
+	}
+	catch ( OSStatus err ) {
+		rc = LogError( eErrorOperationSwapChain, err );
+	}
+	catch ( ... ) {
+		rc = LogError( eErrorOperationSwapChain, memFullErr );
+	}
+	if ( rc || !inDrawMovie ) goto bail;
+	
+	rc = LogError( eErrorOperationSwapChain, mSwapChain->AcquireBuffer( mMovieBuffer ) );
+	if ( rc ) { ReleaseSwapChain(); goto bail; }
+	
+	mHasMovieBuffer = true;
+	::SetMovieGWorld( mMovie, mMovieBuffer.gWorld, NULL );
+	UpdateDrawingCompleteProc();
+	
+bail:
+	return rc;
+}
+
+/* DisposeSwapChain( void )
+		While the legalizer's on the Movie is given a swap chain of the legalizer's own straight back.
+*/
+void CVideoOutput::DisposeSwapChain( void )
+{
+	ReleaseSwapChain();
+	
+	if ( mLegalizer.get() ) CreateLegalizerSwapChain();
+}
+
+/* ReleaseSwapChain( void )
+		Points the Movie back at the output GWorld if it was drawing into the buffers.
+*/
+void CVideoOutput::ReleaseSwapChain( void )
+{
+	if ( mHasMovieBuffer ) {
+		mHasMovieBuffer = mIsMovieBufferDrawn = false;
+		::SetMovieGWorld( mMovie, GetDrawingGWorld(), NULL );
+		mSwapChain->CancelBuffer( mMovieBuffer.index );
+	}
+	
+	mSwapChain.reset();
+	mIsLegalizerSwapChain = false;
+	UpdateDrawingCompleteProc();
+}
+
+/* CreateLegalizerSwapChain( void )
+		A Movie drawing straight into the output GWorld would have to be legalized in a pass of its own
+		once it's drawn. Drawn into a swap chain instead it's legalized as the output task copies it out.
+		Anything else that writes the output GWorld legalizes as it does.
+*/
+OSErr CVideoOutput::CreateLegalizerSwapChain( void )
+{
+	if ( mSwapChain.get() || IsEncodingDV() || IsDecodingDV() || mRateConverter.HasFrames() ) return noErr;
+	
+	rc = CreateSwapChain();
+	if ( rc == noErr ) mIsLegalizerSwapChain = true;
+	
+	return rc;
+}
+
+/* PresentMovieBuffer( void )
+		The Movie has drawn into its buffer, present it and give the Movie the next one. If they're all
+		still in use the frame's dropped and the Movie draws over it, presenting it would mean waiting here.
+*/
+OSErr CVideoOutput::PresentMovieBuffer( void )
+{
+	SwapBufferRecord theNextBuffer;
+	
+	mIsMovieBufferDrawn = false;
+	
+	if ( mSwapChain->AcquireBuffer( theNextBuffer ) ) return noErr;
+	
+	rc = LogError( eErrorOperationSwapChain, mSwapChain->PresentBuffer( mMovieBuffer.index ) );
+	if ( rc ) mSwapChain->CancelBuffer( mMovieBuffer.index );
+	
+	mMovieBuffer = theNextBuffer;
+	::SetMovieGWorld( mMovie, mMovieBuffer.gWorld, NULL );
+	
+	if ( rc == noErr && mSyncMonitor.get() ) mSyncMonitor->FramePresented();
+	
+	return rc;
+}
+
+/* StartRecording( const FSSpec &inFile, Boolean inUncached = false, RecordTap inTap = eRecordDVFrames )
+		Sets up the recorder and hooks it in wherever frames are written to the output GWorld - the DV
+		encoder and decoder, the swap chain, or when the Movie draws there itself a drawing complete proc.
+		The DV encoder legalizes what it encodes, so its DV frames are already what went out whatever inTap is.
+*/
+OSErr CVideoOutput::StartRecording( const FSSpec &inFile, Boolean inUncached, RecordTap inTap )
+{
+	PixMapHandle hOutputPixMap;
+	Rect		 theBounds;
+	UInt32		 theFrameSize;
+	OSType		 theFileType;
+	
+	if ( !IsBegun() ) { rc = videoOutputInUseErr; goto bail; }
+	
+	StopRecording();
+	
+	mIsRecordingDVFrames = ( IsEncodingDV() || ( IsDecodingDV() && inTap == eRecordDVFrames ) );
+	if ( mIsRecordingDVFrames ) {
+		theFrameSize = IsEncodingDV() ? mDVEncoder->GetFrameSize() : CVideoOutputDV::GetSystem( mDVSystem ).frameSize;
+		theFileType = FOUR_CHAR_CODE('dvc!');
+	} else {
+		hOutputPixMap = ::GetGWorldPixMap( mVOutputGWorld );
+		::GetPortBounds( mVOutputGWorld, &theBounds );
+		theFrameSize = ( ( theBounds.right - theBounds.left ) * ::GetPixDepth( hOutputPixMap ) + 7 ) / 8 * ( theBounds.bottom - theBounds.top );
+		theFileType = GETPIXMAPPIXELFORMAT( *hOutputPixMap );
+	}
+	
+	try {
+		CVideoOutputRecorderPtr pRecorder(new CVideoOutputRecorder( inFile, theFileType, theFrameSize, kRecorderQueueFrames, inUncached ));
+		mRecorder = pRecorder;
+		rc = noErr;
+	}
+	catch ( OSStatus err ) {
+		rc = LogError( eErrorOperationRecord, err );
+	}
+	catch ( ... ) {
+		rc = LogError( eErrorOperationRecord, memFullErr );
+	}
+	if ( rc ) goto bail;
+	
+	if ( mSwapChain.get() ) mSwapChain->SetRecorder( mRecorder.get() );
+	
+	// Otherwise the Movie draws the frames into the output GWorld
+	UpdateDrawingCompleteProc();
+	
+bail:
+	return rc;
+}
+
+/* StopRecording( void )
+		Unhooks the recorder then deletes it, which writes out the queue and closes the file.
+*/
+void CVideoOutput::StopRecording( void )
+{
+	if ( mSwapChain.get() ) mSwapChain->SetRecorder( NULL );
+	
+	mRecorder.reset();
+	
+	UpdateDrawingCompleteProc();
+}
+
+#pragma mark-
+
+/* StartSyncMonitor( UInt32 inThreshold = kSyncDefaultThreshold, SyncEventProcPtr inEventProc = NULL, void *inRefCon = NULL, UInt32 inAudioLatency = kSyncOutputLatency )
+		Sets up the sync monitor. The DV encoder and decoder tell it about their frames, when the Movie
+		draws into the output GWorld itself the drawing complete proc does. Asked to, the sound output
+		component Begin() set up says how far behind the Movie the sound is heard.
+*/
+OSErr CVideoOutput::StartSyncMonitor( UInt32 inThreshold, SyncEventProcPtr inEventProc, void *inRefCon, UInt32 inAudioLatency )
+{
+	if ( !IsBegun() ) { rc = videoOutputInUseErr; goto bail; }
+	
+	StopSyncMonitor();
+	
+	if ( inAudioLatency == kSyncOutputLatency ) inAudioLatency = GetAudioLatency();
+	
+	try {
+		CVideoOutputSyncMonitorPtr pMonitor(new CVideoOutputSyncMonitor( mMovie, inThreshold, inEventProc, inRefCon, inAudioLatency ));
+		mSyncMonitor = pMonitor;
+		rc = noErr;
+	}
+	catch ( ... ) {
+		rc = LogError( eErrorOperationSyncMonitor, memFullErr );
+		goto bail;
+	}
+	
+	UpdateDrawingCompleteProc();
+	
+bail:
+	return rc;
+}
+
+/* GetAudioLatency( void )
+		The sound output component's siOutputLatency in milliseconds, that's its own buffering and the
+		hardware's as far as the Sound Manager knows it. 0 when there's no sound output or it doesn't say.
+*/
+UInt32 CVideoOutput::GetAudioLatency( void ) const
+{
+	TimeRecord theLatency;
+	SInt64 theValue;
+	
+	if ( mSoundOutComponent == NULL ) return 0;
+	if ( ::GetSoundOutputInfo( mSoundOutComponent, siOutputLatency, &theLatency ) != noErr || theLatency.scale <= 0 ) return 0;
+	
+	theValue = ((SInt64)theLatency.value.hi << 32) | theLatency.value.lo;
+	if ( theValue <= 0 ) return 0;
+	
+	return (UInt32)( ( theValue * 1000 + theLatency.scale / 2 ) / theLatency.scale );
+}
+
+/* StopSyncMonitor( void )
+		Unhooks the sync monitor and deletes it.
+*/
+void CVideoOutput::StopSyncMonitor( void )
+{
+	mSyncMonitor.reset();
+	
+	UpdateDrawingCompleteProc();
+}
+
+/* StartLoudnessMeter( void )
+		Meters the Movie's sound when Begin() found sound tracks playing to the video output's sound output.
+*/
+OSErr CVideoOutput::StartLoudnessMeter( void )
+{
+	if ( !IsBegun() ) { rc = videoOutputInUseErr; goto bail; }
+	if ( mNumberAudioTracks == 0 ) { rc = paramErr; goto bail; }
+	if ( mQTVersion < kQTVersion700 ) { rc = unimpErr; goto bail; }
+	
+	StopLoudnessMeter();
+	
+	try {
+		CVideoOutputLoudnessMeterPtr pMeter(new CVideoOutputLoudnessMeter( mMovie ));
+		mLoudnessMeter = pMeter;
+		rc = noErr;
+	}
+	catch ( OSStatus err ) {
+		rc = err;
+	}
+	catch ( ... ) {
+		rc = memFullErr;
+	}
+	
+bail:
+	return rc;
+}
+
+/* StartScopes( UInt32 inFrameInterval = 1, UInt32 inStep = 2 )
+		Sets up the scopes for the frames as they're written to the output GWorld, or as they're given to
+		the DV encoder, and hooks them in the same places as the recorder.
+*/
+OSErr CVideoOutput::StartScopes( UInt32 inFrameInterval, UInt32 inStep )
+{
+	GWorldPtr	 theGWorld;
+	PixMapHandle hPixMap;
+	Rect		 theBounds;
+	
+	if ( !IsBegun() ) { rc = videoOutputInUseErr; goto bail; }
+	
+	StopScopes();
+	
+	// What goes out when encoding is DV, the frame before it was encoded is in the source GWorld
+	theGWorld = IsEncodingDV() ? mDVSourceGWorld : mVOutputGWorld;
+	hPixMap = ::GetGWorldPixMap( theGWorld );
+	::GetPortBounds( theGWorld, &theBounds );
+	
+	try {
+		CVideoOutputScopesPtr pScopes(new CVideoOutputScopes( theBounds.right - theBounds.left, theBounds.bottom - theBounds.top,
+															  GETPIXMAPPIXELFORMAT( *hPixMap ), inFrameInterval, inStep ));
+		mScopes = pScopes;
+		rc = noErr;
+	}
+	catch ( OSStatus err ) {
+		rc = err;
+	}
+	catch ( ... ) {
+		rc = memFullErr;
+	}
+	if ( rc ) goto bail;
+	
+	if ( mSwapChain.get() ) mSwapChain->SetScopes( mScopes.get() );
+	
+	UpdateDrawingCompleteProc();
+	
+bail:
+	return rc;
+}
+
+/* StopScopes( void )
+		Unhooks the scopes then deletes them, which stops their task.
+*/
+void CVideoOutput::StopScopes( void )
+{
+	if ( mSwapChain.get() ) mSwapChain->SetScopes( NULL );
+	
+	mScopes.reset();
+	
+	UpdateDrawingCompleteProc();
+}
+
+/* StartLegalizer( const LegalizerLimitsRecord *inLimits = NULL )
+		Sets up the legalizer for the pixel format being written and hands it to whatever writes the frames.
+		The legalizer throws cDepthErr for anything but 4:2:2 Y'CbCr, which is passed on as it is.
+*/
+OSErr CVideoOutput::StartLegalizer( const LegalizerLimitsRecord *inLimits )
+{
+	LegalizerLimitsRecord theLimits;
+	GWorldPtr			  theGWorld;
+	
+	if ( !IsBegun() ) { rc = videoOutputInUseErr; goto bail; }
+	
+	StopLegalizer();
+	
+	if ( inLimits ) {
+		theLimits = *inLimits;
+	} else {
+		CVideoOutputLegalizer::GetDefaultLimits( theLimits );
+	}
+	
+	// The same GWorld the scopes look at, the DV encoder legalizes what it reads from its source
+	theGWorld = IsEncodingDV() ? mDVSourceGWorld : mVOutputGWorld;
+	
+	try {
+		CVideoOutputLegalizerPtr pLegalizer(new CVideoOutputLegalizer( theLimits, GETPIXMAPPIXELFORMAT( *::GetGWorldPixMap( theGWorld ) ) ));
+		mLegalizer = pLegalizer;
+		rc = noErr;
+	}
+	catch ( OSStatus err ) {
+		rc = err;
+	}
+	catch ( ... ) {
+		rc = memFullErr;
+	}
+	if ( rc ) goto bail;
+	
+	if ( mDVEncoder.get() ) mDVEncoder->SetLegalizer( mLegalizer.get() );
+	if ( mDVDecoder.get() ) mDVDecoder->SetLegalizer( mLegalizer.get() );
+	if ( mSwapChain.get() ) mSwapChain->SetLegalizer( mLegalizer.get() );
+	
+	rc = CreateLegalizerSwapChain();
+	if ( rc ) StopLegalizer();
+	
+bail:
+	return rc;
+}
+
+/* StopLegalizer( void )
+		Unhooks the legalizer then deletes it.
+*/
+void CVideoOutput::StopLegalizer( void )
+{
+	// Not with a frame on the work pool still using it
+	FinishFrame();
+	
+	if ( mDVEncoder.get() ) mDVEncoder->SetLegalizer( NULL );
+	if ( mDVDecoder.get() ) mDVDecoder->SetLegalizer( NULL );
+	if ( mSwapChain.get() ) mSwapChain->SetLegalizer( NULL );
+	
+	mLegalizer.reset();
+	
+	// The Movie goes back to drawing into the output GWorld
+	if ( mIsLegalizerSwapChain ) ReleaseSwapChain();
+}
+
+/* UpdateDrawingCompleteProc( void )
+		A Movie only has the one drawing complete proc, so ours is installed while the recorder, the sync
+		monitor, the scopes, rate conversion or the Movie drawing into the swap chain need it and taken out
+		when none do. The DV encoder has its own and tells them itself.
+*/
+void CVideoOutput::UpdateDrawingCompleteProc( void )
+{
+	Boolean isNeeded = ( !IsEncodingDV() && ( mRecorder.get() || mSyncMonitor.get() || mScopes.get() || mRateConverter.HasFrames() ||
+											  mHasMovieBuffer ) );
+	
+	if ( isNeeded && mOutputDrawingCompleteUPP == NULL ) {
+		mOutputDrawingCompleteUPP = ::NewMovieDrawingCompleteUPP( OutputDrawingComplete );
+		::SetMovieDrawingCompleteProc( mMovie, movieDrawingCallWhenChanged, mOutputDrawingCompleteUPP, (long)this );
+	} else if ( !isNeeded && mOutputDrawingCompleteUPP ) {
+		::SetMovieDrawingCompleteProc( mMovie, 0, NULL, 0 );
+		::DisposeMovieDrawingCompleteUPP( mOutputDrawingCompleteUPP );
+		mOutputDrawingCompleteUPP = NULL;
+	}
+}
+
+/* OutputDrawingComplete( Movie inMovie, long inRefCon )
+		Movie drawing complete proc, when nothing else is writing the output GWorld for us. With rate conversion
+		on it keeps the frame the Movie drew for PresentFrame(), otherwise the frame's in the output GWorld.
+*/
+pascal OSErr CVideoOutput::OutputDrawingComplete( Movie /*inMovie*/, long inRefCon )
+{
+	CVideoOutput *pThis = reinterpret_cast<CVideoOutput *>( inRefCon );
+	
+	// The swap chain's output task hands over the buffer once it's been presented
+	if ( pThis->mHasMovieBuffer ) {
+		pThis->mIsMovieBufferDrawn = true;
+		return noErr;
+	}
+	
+	// DV decoding and clients of the swap chain hand their frames over themselves
+	if ( pThis->IsDecodingDV() || pThis->mSwapChain.get() ) return noErr;
+	
+	if ( pThis->mRateConverter.HasFrames() ) {
+		pThis->StoreDrawnFrame( pThis->mCadenceGWorld );
+		return noErr;
+	}
+	
+	pThis->OutputFrameDone();
+	
+	return noErr;
+}
+
+/* OutputFrameDone( void )
+		A new frame is in the output GWorld, already legalized by whoever wrote it - records it, hands it to
+		the scopes and notes it for the sync monitor.
+*/
+void CVideoOutput::OutputFrameDone( void )
+{
+	PixMapHandle hOutputPixMap = ::GetGWorldPixMap( mVOutputGWorld );
+	
+	if ( mSyncMonitor.get() ) mSyncMonitor->FramePresented();
+	
+	if ( ( mRecorder.get() || mScopes.get() ) && ::LockPixels( hOutputPixMap ) ) {
+		if ( mRecorder.get() ) RecordOutputFrame();
+		if ( mScopes.get() ) mScopes->SampleFrame( ::GetPixBaseAddr( hOutputPixMap ), ::GetPixRowBytes( hOutputPixMap ) );
+		::UnlockPixels( hOutputPixMap );
+	}
+}
+
+/* RecordOutputFrame( void )
+		Hands the pixels of the output GWorld, which the caller has locked, to the recorder without the row padding.
+*/
+void CVideoOutput::RecordOutputFrame( void )
+{
+	PixMapHandle hOutputPixMap = ::GetGWorldPixMap( mVOutputGWorld );
+	Rect		 theBounds;
+	
+	::GetPortBounds( mVOutputGWorld, &theBounds );
+	mRecorder->WriteFrame( ::GetPixBaseAddr( hOutputPixMap ), ::GetPixRowBytes( hOutputPixMap ),
+						   ( ( theBounds.right - theBounds.left ) * ::GetPixDepth( hOutputPixMap ) + 7 ) / 8, theBounds.bottom - theBounds.top );
+}
+
+#pragma mark-
+
+/* SelectBestDisplayMode( ModeScorePtr outScore = NULL )
+		Scores every mode of every video output component against the format of the Movie and selects the
+		one which needs the least conversion work per frame. Call after SetMovie() and before Open().
+*/
+OSErr CVideoOutput::SelectBestDisplayMode( ModeScorePtr outScore )
+{
+	MovieFormatRecord theFormat;
+	SInt32			  theBestMode;
+	
+	if ( mMovie == NULL ) { rc = paramErr; goto bail; }
+	if ( GetState() > eVideoOutputOpened ) { rc = videoOutputInUseErr; goto bail; }
+	
+	rc = GetMovieFormat( theFormat );
+	if ( rc ) goto bail;
+	
+	theBestMode = CVideoOutputModeMatcher::FindBestMode( mVOutputComponent->GetRegistry(), theFormat, outScore );
+	if ( theBestMode < 0 ) { rc = badComponentType; goto bail; }
+	
+	rc = LogError( eErrorOperationSetDisplayMode, mVOutputComponent->SelectDisplayMode( theBestMode ) );
+	
+bail:
+	return rc;
+}
+
+/* SetRateConversion( RateConversionMode inMode )
+		Builds the cadence table taking the Movie frame rate to the refresh rate of the selected mode.
+		Pulldown and blending are done per field when the mode is interlaced.
+*/
+OSErr CVideoOutput::SetRateConversion( RateConversionMode inMode )
+{
+	const CVideoOutputRegistry &theRegistry = mVOutputComponent->GetRegistry();
+	MovieFormatRecord theFormat;
+	UInt16			  theMode;
+	FieldOrder		  theFieldOrder;
+	
+	if ( mMovie == NULL ) { rc = paramErr; goto bail; }
+	if ( GetState() > eVideoOutputOpened ) { rc = videoOutputInUseErr; goto bail; }
+	
+	if ( inMode == eRateConversionOff ) {
+		mRateConverter.Reset();
+		rc = noErr;
+		goto bail;
+	}
+	
+	rc = GetMovieFormat( theFormat );
+	if ( rc ) goto bail;
+	
+	theMode = mVOutputComponent->GetSelectedMode();
+	theFieldOrder = CVideoOutputModeMatcher::GetModeFieldOrder( theRegistry, theMode );
+	
+	rc = mRateConverter.Configure( theFormat.frameRate, theRegistry.GetModeRefreshRate( theMode ), inMode,
+								   ( theFieldOrder == eFieldOrderUpperFirst || theFieldOrder == eFieldOrderLowerFirst ) );
+	
+bail:
+	return rc;
+}
+
+/* GetCadenceFrame( CadenceFrameRecord &outFrame )
+		The output frame is taken from the video output component's clock rather than counting calls,
+		so a late call picks up the right movie frame instead of drifting.
+*/
+OSErr CVideoOutput::GetCadenceFrame( CadenceFrameRecord &outFrame )
+{
+	TimeRecord theTime;
+	UInt64	   theOutputFrame;
+	
+	if ( !IsBegun() || !mHasClock || mRateConverter.GetMode() == eRateConversionOff ) { rc = paramErr; goto bail; }
+	
+	::GetClockTime( mVideoOutputClockInstance, &theTime );
+	
+	theOutputFrame = mRateConverter.GetOutputFrameForTime( theTime );
+	theOutputFrame = ( theOutputFrame > mCadenceOrigin ) ? theOutputFrame - mCadenceOrigin : 0;
+	
+	mRateConverter.GetOutputFrame( theOutputFrame, outFrame );
+	rc = noErr;
+	
+bail:
+	return rc;
+}
+
+/* SetUpCadence( void )
+		Called by Begin() once the DV encoder or decoder is set up. Gives the rate converter a store for the
+		movie frames shaped like the GWorld the output frames are built in, the encoder's source GWorld or the
+		video output component's GWorld. Unless we're decoding DV the Movie draws into a GWorld of our own, so
+		what it draws never goes out before the cadence asks for it.
+*/
+void CVideoOutput::SetUpCadence( void )
+{
+	GWorldPtr	 theGWorld = IsEncodingDV() ? mDVSourceGWorld : mVOutputGWorld;
+	PixMapHandle hPixMap = ::GetGWorldPixMap( theGWorld );
+	Rect		 theBounds;
+	OSErr		 err;
+	
+	if ( mRateConverter.GetMode() == eRateConversionOff || !mHasClock ) return;
+	
+	::GetPortBounds( theGWorld, &theBounds );
+	::OffsetRect( &theBounds, -theBounds.left, -theBounds.top );
+	
+	if ( !IsEncodingDV() && !IsDecodingDV() ) {
+		err = LogError( eErrorOperationRateConversion, ::QTNewGWorld( &mCadenceGWorld, GETPIXMAPPIXELFORMAT( *hPixMap ), &theBounds, NULL, NULL, 0 ) );
+		if ( err ) { mCadenceGWorld = NULL; return; }
+		
+		::LockPixels( ::GetGWorldPixMap( mCadenceGWorld ) );
+	}
+	
+	err = LogError( eErrorOperationRateConversion, mRateConverter.AllocateFrames( ::GetPixRowBytes( hPixMap ), ( theBounds.right * ::GetPixDepth( hPixMap ) + 7 ) / 8,
+																				   theBounds.bottom, mModeFieldOrder ) );
+	if ( err ) { DisposeCadence(); return; }
+	
+	// Only the frames the cadence builds go out, there's nothing for an echo port to show
+	mCanDoEchoPort = false;
+	
+	AnchorCadence();
+	UpdateDrawingCompleteProc();
+}
+
+/* DisposeCadence( void )
+		Undoes SetUpCadence(), it's fine to call when we're not converting.
+*/
+void CVideoOutput::DisposeCadence( void )
+{
+	CGrafPtr theMovieGWorld = NULL;
+	
+	mRateConverter.DisposeFrames();
+	mHasCadenceShown = false;
+	
+	if ( mCadenceGWorld ) {
+		::GetMovieGWorld( mMovie, &theMovieGWorld, NULL );
+		if ( theMovieGWorld == mCadenceGWorld ) ::SetMovieGWorld( mMovie, mVOutputGWorld, NULL );
+		
+		::DisposeGWorld( mCadenceGWorld );
+		mCadenceGWorld = NULL;
+	}
+	
+	UpdateDrawingCompleteProc();
+}
+
+/* AnchorCadence( void )
+		Counts output frames from now and movie frames from the one the Movie is on.
+*/
+void CVideoOutput::AnchorCadence( void )
+{
+	TimeRecord theTime;
+	Track	   theTrack = GetVideoTrack();
+	
+	::GetClockTime( mVideoOutputClockInstance, &theTime );
+	mCadenceOrigin = mRateConverter.GetOutputFrameForTime( theTime );
+	mCadenceBase = theTrack ? GetTrackSample( theTrack ) : 0;
+	mHasCadenceShown = false;
+}
+
+/* PresentCadenceFrame( void )
+		Puts up the output frame the cadence asks for now, built by the rate converter from the movie frames in
+		its store. When decoding DV they're decoded into the store here, otherwise they're the frames the Movie
+		drew and the cadence runs behind it by as many frames as it looks ahead, so the frames it needs have all
+		been drawn. On an interlaced mode each field can come from, or be blended with, a movie frame of its own.
+		While the Movie's stopped whatever went out last stays up, and when it's been moved the cadence starts
+		again from where it is.
+*/
+OSErr CVideoOutput::PresentCadenceFrame( void )
+{
+	GWorldPtr		   theGWorld = IsEncodingDV() ? mDVSourceGWorld : mVOutputGWorld;
+	PixMapHandle	   hPixMap = ::GetGWorldPixMap( theGWorld );
+	Track			   theTrack = GetVideoTrack();
+	long			   theDelay = IsDecodingDV() ? 0 : ( mRateConverter.GetFramesAhead() > 1 ? mRateConverter.GetFramesAhead() : 1 );
+	CadenceFrameRecord theFrame;
+	long			   theSample;
+	SInt64			   theDrift;
+	
+	rc = noErr;
+	
+	if ( theTrack == NULL || ::GetMovieRate( mMovie ) <= 0 ) goto bail;
+	
+	theSample = GetTrackSample( theTrack );
+	if ( theSample <= 0 ) goto bail;
+	
+	rc = GetCadenceFrame( theFrame );
+	if ( rc ) goto bail;
+	
+	theDrift = (SInt64)( mCadenceBase + theFrame.firstField ) - theSample;
+	if ( theDrift > kCadenceResyncFrames || theDrift < -kCadenceResyncFrames ) {
+		AnchorCadence();
+		GetCadenceFrame( theFrame );
+	}
+	
+	// Samples from here on
+	theFrame.firstField += mCadenceBase - theDelay;
+	theFrame.secondField += mCadenceBase - theDelay;
+	
+	if ( mHasCadenceShown && theFrame.firstField == mCadenceShown.firstField && theFrame.secondField == mCadenceShown.secondField &&
+		 theFrame.blendWeight == mCadenceShown.blendWeight && theFrame.secondBlendWeight == mCadenceShown.secondBlendWeight ) goto bail;
+	
+	if ( IsDecodingDV() ) {
+		rc = DecodeCadenceFrame( theFrame.firstField );
+		if ( rc == noErr && theFrame.blendWeight ) rc = DecodeCadenceFrame( theFrame.firstField + 1 );
+		if ( rc == noErr ) rc = DecodeCadenceFrame( theFrame.secondField );
+		if ( rc == noErr && theFrame.secondBlendWeight ) rc = DecodeCadenceFrame( theFrame.secondField + 1 );
+		if ( rc ) goto bail;
+	}
+	
+	// The encoder may still be reading the source
+	if ( IsEncodingDV() ) FinishEncodeSourceFrame();
+	
+	if ( !::LockPixels( hPixMap ) ) goto bail;
+	
+	// Nothing changes if a frame isn't there yet, the one before stays up. The DV codecs legalize for
+	// themselves, otherwise it's done a row at a time as the frame's composed
+	if ( mRateConverter.ComposeFrame( theFrame, (UInt8 *)::GetPixBaseAddr( hPixMap ), ::GetPixRowBytes( hPixMap ),
+									  ( IsEncodingDV() || IsDecodingDV() ) ? NULL : mLegalizer.get() ) ) {
+		mCadenceShown = theFrame;
+		mHasCadenceShown = true;
+		
+		if ( IsEncodingDV() ) {
+			rc = StartEncodeSourceFrame();
+		} else if ( IsDecodingDV() ) {
+			if ( mSyncMonitor.get() ) mSyncMonitor->FramePresented();
+			if ( mRecorder.get() && !mIsRecordingDVFrames ) RecordOutputFrame();
+			if ( mScopes.get() ) mScopes->SampleFrame( ::GetPixBaseAddr( hPixMap ), ::GetPixRowBytes( hPixMap ) );
+		} else {
+			OutputFrameDone();
+		}
+	}
+	
+	// SetUpDVEncoder() keeps the source locked
+	if ( !IsEncodingDV() ) ::UnlockPixels( hPixMap );
+	
+bail:
+	return rc;
+}
+
+/* DecodeCadenceFrame( UInt64 inSample )
+		Decodes DV sample inSample into the rate converter's store if it isn't there already. A sample off
+		either end of the track is left out, so the last frame stays up. When recording DV frames each sample
+		goes to the recorder as it's read, so a recording has the Movie's frames at the Movie's rate; recording
+		the output pixels is done by PresentCadenceFrame(), at the output's rate.
+*/
+OSErr CVideoOutput::DecodeCadenceFrame( UInt64 inSample )
+{
+	Media		 theMedia = ::GetTrackMedia( mDVTrack );
+	PixMapHandle hOutputPixMap = ::GetGWorldPixMap( mVOutputGWorld );
+	TimeValue	 theMediaTime = 0;
+	long		 theSize = 0;
+	
+	rc = noErr;
+	
+	if ( mRateConverter.GetStoredFrame( inSample ) ) goto bail;
+	if ( inSample < 1 || inSample > (UInt64)::GetMediaSampleCount( theMedia ) ) goto bail;
+	
+	::SampleNumToMediaTime( theMedia, (long)inSample, &theMediaTime, NULL );
+	
+  {	// the trace scope ends with the read
+	VIDEO_OUTPUT_TRACE_SCOPE( "read" );
+	rc = LogError( eErrorOperationPresentFrame, ::GetMediaSample( theMedia, mDVSample, 0, &theSize, theMediaTime, NULL, NULL, NULL, NULL, 1, NULL, NULL ) );
+  }
+	if ( rc ) goto bail;
+	
+	if ( theSize < (long)CVideoOutputDV::GetSystem( mDVSystem ).frameSize ||
+		 CVideoOutputDV::GetFrameSystem( (UInt8 *)*mDVSample ) != mDVSystem ) { rc = LogError( eErrorOperationPresentFrame, codecBadDataErr ); goto bail; }
+	
+	::HLock( mDVSample );
+	rc = LogError( eErrorOperationPresentFrame, mDVDecoder->DecodeFrame( (UInt8 *)*mDVSample, mRateConverter.StoreFrame( inSample ), mRateConverter.GetFrameRowBytes(),
+																		  GETPIXMAPPIXELFORMAT( *hOutputPixMap ) ) );
+	if ( rc ) {
+		mRateConverter.ForgetFrame( inSample );
+	} else if ( mRecorder.get() && mIsRecordingDVFrames ) {
+		mRecorder->WriteFrame( *mDVSample, 0, CVideoOutputDV::GetSystem( mDVSystem ).frameSize, 1 );
+	}
+	::HUnlock( mDVSample );
+	
+bail:
+	return rc;
+}
+
+/* StoreDrawnFrame( GWorldPtr inGWorld )
+		From the drawing complete procs, keeps the frame the Movie just drew into inGWorld for the cadence.
+*/
+void CVideoOutput::StoreDrawnFrame( GWorldPtr inGWorld )
+{
+	PixMapHandle hPixMap = ::GetGWorldPixMap( inGWorld );
+	Track		 theTrack = GetVideoTrack();
+	long		 theSample = theTrack ? GetTrackSample( theTrack ) : 0;
+	
+	if ( theSample <= 0 || !::LockPixels( hPixMap ) ) return;
+	
+	mRateConverter.StoreFrame( theSample, (UInt8 *)::GetPixBaseAddr( hPixMap ), ::GetPixRowBytes( hPixMap ) );
+	
+	::UnlockPixels( hPixMap );
+}
+
+/* GetDrawingGWorld( void )
+		Where the Movie draws when it isn't drawing into an echo port.
+*/
+GWorldPtr CVideoOutput::GetDrawingGWorld( void ) const
+{
+	if ( mDVSourceGWorld ) return mDVSourceGWorld;
+	if ( mCadenceGWorld ) return mCadenceGWorld;
+	if ( mHasMovieBuffer ) return mMovieBuffer.gWorld;
+	
+	return mVOutputGWorld;
+}
+
+/* GetVideoTrack( void )
+		The DV track we decode, or the first enabled video track.
+*/
+Track CVideoOutput::GetVideoTrack( void ) const
+{
+	if ( mDVTrack ) return mDVTrack;
+	
+	return mTrackCatalog.get() ? mTrackCatalog->FindTrack( VideoMediaType ) : NULL;
+}
+
+/* GetTrackSample( Track inTrack )
+		The sample of inTrack at the current Movie time, 0 in an empty edit.
+*/
+long CVideoOutput::GetTrackSample( Track inTrack ) const
+{
+	TimeValue theMediaTime = ::TrackTimeToMediaTime( ::GetMovieTime( mMovie, NULL ), inTrack );
+	long	  theSampleNum = 0;
+	
+	if ( theMediaTime >= 0 ) ::MediaTimeToSampleNum( ::GetTrackMedia( inTrack ), theMediaTime, &theSampleNum, NULL, NULL );
+	
+	return theSampleNum;
+}
+
+#pragma mark-
+
+/* CueFrame( long inFrame, Fixed inRate = fixed1 )
+		Cues the Movie with CVideoOutputCue. When we're decoding DV the Movie doesn't draw the cued frame,
+		PresentFrame() puts it up.
+*/
+OSErr CVideoOutput::CueFrame( long inFrame, Fixed inRate )
+{
+	TimeValue theMovieTime;
+	
+	if ( !IsBegun() ) { rc = paramErr; goto bail; }
+	if ( mDVIndex.get() && ( inFrame < 0 || (UInt32)inFrame >= mDVIndex->GetFrameCount() ) ) { rc = paramErr; goto bail; }
+	
+	rc = CVideoOutputCue::GetFrameTime( mMovie, inFrame, theMovieTime );
+	if ( rc ) goto bail;
+	
+	rc = mCue.Cue( mMovie, theMovieTime, inRate );
+	if ( rc ) goto bail;
+	
+	if ( mRateConverter.HasFrames() ) AnchorCadence();
+	
+	rc = PresentFrame();
+	
+bail:
+	return rc;
+}
+
+/* CueTimecode( const TimeCodeRecord &inTimecode, Fixed inRate = fixed1 )
+		Finds the frame with the timecode and cues it. The DV index has the timecode each frame was
+		recorded with, which is right even where the tape was stopped and started again, so it's used
+		when we have one.
+*/
+OSErr CVideoOutput::CueTimecode( const TimeCodeRecord &inTimecode, Fixed inRate )
+{
+	long theFrame;
+	
+	if ( !IsBegun() ) { rc = paramErr; goto bail; }
+	
+	if ( mDVIndex.get() ) {
+		theFrame = mDVIndex->FindTimecode( CVideoOutputDVIndex::MakeTimecode( inTimecode.t.hours, inTimecode.t.minutes & ~tctNegFlag,
+																			  inTimecode.t.seconds, inTimecode.t.frames ) );
+		if ( theFrame < 0 ) { rc = paramErr; goto bail; }
+	} else {
+		rc = CVideoOutputCue::GetTimecodeFrame( mMovie, inTimecode, theFrame );
+		if ( rc ) goto bail;
+	}
+	
+	rc = CueFrame( theFrame, inRate );
+	
+bail:
+	return rc;
+}
+
+/* OpenDVIndex( const FSSpec &inDVFile )
+		An index that can't be loaded is built again and saved for next time, if it can't be saved we
+		carry on with the one in memory.
+*/
+OSErr CVideoOutput::OpenDVIndex( const FSSpec &inDVFile )
+{
+	FSSpec theIndexFile;
+	OSErr  err;
+	
+	if ( mMovie == NULL ) { rc = paramErr; goto bail; }
+	
+	CloseDVIndex();
+	
+	try {
+		CVideoOutputDVIndexPtr pIndex(new CVideoOutputDVIndex);
+		
+		err = CVideoOutputDVIndex::MakeIndexSpec( inDVFile, theIndexFile );
+		if ( err == noErr ) err = pIndex->Load( inDVFile, theIndexFile );
+		if ( err ) {
+			rc = LogError( eErrorOperationDVIndex, pIndex->Build( inDVFile ) );
+			if ( rc ) goto bail;
+			
+			err = CVideoOutputDVIndex::MakeIndexSpec( inDVFile, theIndexFile );
+			if ( err == noErr || err == fnfErr ) LogError( eErrorOperationDVIndex, pIndex->Save( theIndexFile ) );
+		}
+		
+		mDVIndex = pIndex;
+		rc = noErr;
+	}
+	catch ( ... ) {
+		rc = LogError( eErrorOperationDVIndex, memFullErr );
+	}
+	
+bail:
+	return rc;
+}
+
+/* GetOutputTime( TimeRecord &outTime )
+		Reads the video output component's clock, the time line StartAtTime() works on.
+*/
+OSErr CVideoOutput::GetOutputTime( TimeRecord &outTime )
+{
+	if ( !IsBegun() || !mHasClock ) { rc = paramErr; goto bail; }
+	
+	::GetClockTime( mVideoOutputClockInstance, &outTime );
+	rc = noErr;
+	
+bail:
+	return rc;
+}
+
+/* StartAtTime( const TimeRecord &inStartTime )
+		Has CVideoOutputCue start the cued Movie on the video output component's clock. The idle after the
+		start presents the first frame as usual.
+*/
+OSErr CVideoOutput::StartAtTime( const TimeRecord &inStartTime )
+{
+	if ( !IsBegun() || !mHasClock ) { rc = paramErr; goto bail; }
+	
+	rc = mCue.StartAtTime( mVideoOutputClockInstance, inStartTime, CueStarted, this );
+	
+bail:
+	return rc;
+}
+
+/* CueStarted( void *inRefCon )
+		The cued Movie has just been set going, the cadence starts with it.
+*/
+void CVideoOutput::CueStarted( void *inRefCon )
+{
+	CVideoOutput *pThis = reinterpret_cast<CVideoOutput *>( inRefCon );
+	
+	if ( pThis->mRateConverter.HasFrames() ) pThis->AnchorCadence();
+}
+
+#pragma mark-
+
+/* SetEchoPort( const CGrafPtr inEchoPort = NULL )
+		Allows you to display video both on an external video display and in a window.
+		Pass in a CGrafPtr to specify a window to display video sent to the device. When the
+		Echo Port is on, the movie is displayed in the window and sent to the video output device.
+		If the EchoPort is not supported by the video output component or is turned off,
+		the Movie will be directed to the video output components GWorld as you would expect.
+		Call CanDoEchoPort() before assuming the video output component supports the echo port.
+*/
+OSErr CVideoOutput::SetEchoPort( const CGrafPtr inEchoPort )
+{
+	ComponentInstance theInstance = 0;
+	
+	if ( !IsInUse() ) return videoOutputInUseErr;
+		
+	if (( theInstance = mVOutputComponent->GetComponentInstance() ) == NULL ) { rc = badComponentInstance; goto bail; }
+	
+	if ( mCanDoEchoPort ) {
+		if ( inEchoPort == NULL ) {
+			// Turn off Echo Port
+			rc = LogError( eErrorOperationSetEchoPort, ::QTVideoOutputSetEchoPort( theInstance, (CGrafPtr)NULL ) );
+			if ( rc == noErr ) {
+				if ( IsInUse() ) {
+					// back into the swap chain's buffer if it was drawing into one
+					::SetMovieGWorld( mMovie, GetDrawingGWorld(), NULL );
+				}
+			}
+		} else {
+			// Turn on Echo Port		
+			rc = LogError( eErrorOperationSetEchoPort, ::QTVideoOutputSetEchoPort( theInstance, inEchoPort ) );
+			if ( rc == noErr ) {
+				if ( IsInUse() ) {						
+					::SetMovieGWorld( mMovie, inEchoPort, NULL);
+				}
+			}
+		}
+	} else {
+		// The Echo Port isn't supported by this component but
+		// we still need to set the Movie GWorld correctly, when we're
+		// encoding DV or converting the frame rate the Movie draws into
+		// a GWorld of ours
+		if ( inEchoPort == NULL ) {	
+			::SetMovieGWorld( mMovie, GetDrawingGWorld(), NULL );
+		} else {
+			::SetMovieGWorld( mMovie, inEchoPort, NULL );
+		}
+	}
+
+bail:
+	return rc;
+}
+
+/* SetSoundDevice( Boolean inUseVOsdev = true )
+		This call will turn on/off the use of the video output components sound device. Passing in 'true'
+		will set up the use of the video output components sound device, this is the default setting.
+		You should call SetClock() after this call to choose the correct clock.
+*/
+OSErr CVideoOutput::SetSoundDevice( Boolean inUseVOsdev )
+{			
+	if ( !IsInUse() ) return videoOutputInUseErr;
+	
+	if ( mHasSoundOutput ) {
+		if ( inUseVOsdev == true ) {
+			for ( UInt8 i = 0;i < mNumberAudioTracks; i++ ) {
+				rc = LogError( eErrorOperationSetSoundDevice, ::MediaSetSoundOutputComponent( mAudioMediaHandler[i], GetRoutedSoundOutput( i ) ) );
+				if ( rc ) goto bail;
+			}
+			mIsUsingVOsdev = true;
+			for ( UInt8 i = 0;i < mNumberAudioTracks; i++ ) {
+				SetAudioGain( i );
+			}
+		} else {
+			// the routes are for the video output's sound device, the tracks go back to how the Movie has them
+			mIsUsingVOsdev = false;
+			for ( UInt8 i = 0;i < mNumberAudioTracks; i++ ) {
+				SetAudioGain( i );
 			}
-		} else {	
 			for ( UInt8 i = 0;i < mNumberAudioTracks; i++ ) {
-				rc = ::MediaSetSoundOutputComponent( mAudioMediaHandler[i], NULL );
+				rc = LogError( eErrorOperationSetSoundDevice, ::MediaSetSoundOutputComponent( mAudioMediaHandler[i], NULL ) );
 				if( rc ) goto bail;
 			}
 		}
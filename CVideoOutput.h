@@ -10,7 +10,7 @@
 				
 	Version:	2.0.2
 
-	Copyright: 	 Copyright 2000-2002 Apple Computer, Inc. All rights reserved.
+	Copyright: 	© Copyright 2000-2002 Apple Computer, Inc. All rights reserved.
 	
 	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
 				("Apple") in consideration of your agreement to the following terms, and your
@@ -19,7 +19,7 @@
 				please do not use, install, modify or redistribute this Apple software.
 
 				In consideration of your agreement to abide by the following terms, and subject
-				to these terms, Apple grants you a personal, non-exclusive license, under Apples
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
 				copyrights in this original Apple software (the "Apple Software"), to use,
 				reproduce, modify and redistribute the Apple Software, with or without
 				modifications, in source and/or binary forms; provided that if you redistribute
@@ -47,7 +47,48 @@
 				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
 				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 				
-	Change History (most recent first): <4> 06/14/02 Begin now takes a boolean to control setting the echo port
+	Change History (most recent first): <41> 10/19/26 the legalizer gives a Movie drawing into the output GWorld a swap
+													 chain, long lines wrapped
+										<40> 10/19/26 the loudness meter measures BS.1770 loudness and true peak, QuickTime 7
+													 and later
+										<39> 10/19/26 SetAudioRoute says it routes whole tracks
+										<38> 10/19/26 the device task is only used for thread-safe components, Close() blocks
+													 on a semaphore and takes a timeout
+										<37> 10/19/26 the DV encode is left on the work pool too, added FinishFrame
+										<36> 10/19/26 StartRecording takes a RecordTap, the legalizer returns cDepthErr for an output
+													 it can't legalize
+										<35> 10/19/26 the scopes see the DV encoder's source legalized
+										<34> 10/19/26 the loudness meter reports dBFS levels
+										<33> 10/19/26 every routed sound output gets the format, routes keep the track's balance
+										<32> 10/19/26 SetAudioFormat() says who does the sample conversion
+										<31> 10/19/26 the Movie's format comes from the track catalog
+										<30> 10/19/26 PresentFrame() leaves the DV decode on the work pool until the next idle
+										<29> 10/19/26 StartSyncMonitor() asks the sound output for its latency
+										<28> 10/19/26 StartAtTime() returns straight away
+										<27> 10/19/26 added OpenDVIndex, cueing goes by the DV file's own timecode
+										<26> 10/19/26 the Movie draws into the swap chain's buffers
+										<25> 10/19/26 PresentFrame() shows the frames rate conversion asks for
+										<24> 10/19/26 added StartLegalizer, StopLegalizer and GetLegalizerStats
+										<23> 10/19/26 added StartScopes, StopScopes and GetScopes
+										<22> 10/19/26 added StartLoudnessMeter, StopLoudnessMeter and GetLoudnessStats
+										<21> 10/19/26 added SetAudioRoute, ClearAudioRoute, SaveAudioRouting and LoadAudioRouting
+										<20> 10/19/26 added SetAudioFormat and GetAudioFormat
+										<19> 10/19/26 Begin() asks the component what it can do only the first time
+										<18> 10/19/26 added GetTrackCatalog, Begin() no longer walks the tracks
+										<17> 10/19/26 added GetErrorLog
+										<16> 10/19/26 added BeginAsync and EndAsync
+										<15> 10/19/26 state machine replaces mVideoOutputInUse, added GetState
+										<14> 10/19/26 added GetTimeUntilNextFrame
+										<13> 10/19/26 added the sync monitor
+										<12> 10/19/26 added CueFrame, CueTimecode and StartAtTime
+										<11> 10/19/26 added StartRecording
+										<10> 10/19/26 added the swap chain
+										<9> 10/19/26 decode DV movies straight into the output GWorld
+										<8> 10/19/26 encode non DV movies for DV only outputs
+										<7> 10/19/26 added GetFieldOrder and IsFieldAccurate
+										<6> 10/19/26 added SetRateConversion and GetCadenceFrame
+										<5> 10/19/26 added SelectBestDisplayMode
+										<4> 06/14/02 Begin now takes a boolean to control setting the echo port
 										<3> 11/16/01 initial release version 2.0
 										<2> 10/19/01 updated to support multiple components
 										<1> 01/28/00 initial release
@@ -62,17 +103,77 @@
 	
 	Open( void )
 		Opens an instance of a video output component, registers the client name with the component
-		and sets up the display mode.
+		and sets up the display mode. Closed -> Opened, returns videoOutputInUseErr from any other state.
 	
 	Begin( Boolean inUseVOsdev = true, Boolean inUseVOClk = true, AudioRate inAudioRate = eAudioRateDefault, Boolean inChangeMovieGWorld = false )
 		Gains exclusive access to the hardware, and sets up the sound output and clock associated with the
 		video output component. Begin also acquires the GWorld used by the video output component.
 		Both the sound and clock parameters are set to 'true' by default, the audio rate is set to "eAudioRateDefault"
 		and Begin will not set the Video Output echo port or call SetMovieGWorld by default, allowing the client of this
-		class to call SetEchoPort when needed.
+		class to call SetEchoPort when needed. Opened -> Begun, if anything fails after the hardware is ours Begin
+		calls End() and we're back to Opened. Returns badComponentInstance when Closed, videoOutputInUseErr otherwise.
+		What the component can do and the sample rates its sound output takes are only asked the first time a
+		component of that subType is begun, see CVideoOutputCapabilities.h.
+	
+	BeginAsync( AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout = kEventDurationForever, ... )
+	EndAsync( AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout = kEventDurationForever )
+		Begin() and End() with the calls which wait on the device - QTVideoOutputBegin, finding the sound output and
+		setting its sample rate, and QTVideoOutputEnd - made on a device task, see CVideoOutputDeviceTask.h. The
+		rest happens on the calling thread, which must be the main thread, and both return as soon as the device
+		task has the job. inDoneProc is called from the main event loop with the result, Begun or Opened by then.
+		The task only gets the instance when the video output component is flagged cmpThreadSafe, and the state
+		keeps everything else off it until the result is back. Any other component's calls are made on the
+		calling thread before BeginAsync() or EndAsync() return, and the result still comes back the same way.
+		If the device takes longer than inTimeout the done proc gets kMPTimeoutErr straight away, a Begin is
+		undone once the device gets back to us and an End still finishes. The state stays Beginning or Ending
+		until then, so nothing else can get in.
+	
+	CancelAsync( void )
+		Tells the done proc userCanceledErr now, a Begin is undone when the device gets back to us. Close() and
+		the destructor cancel a Begin and wait for the device. Returns paramErr if nothing's pending.
+	
+	GetDeviceTimes( DeviceTimesRecord &outTimes )
+		How long the device calls of the last Begin, End, BeginAsync or EndAsync took, in microseconds.
 	
 	SetMovie( const Movie inMovie )
 		Set's the Movie to be used by this class. CVideoOutput must have a valid movie before Begin() is called.
+		Returns videoOutputInUseErr once Begin() has started, the Movie can't change under the hardware.
+	
+	SetAudioFormat( UInt16 inSampleSize = 0, UInt16 inChannels = 0 )
+		The sample size in bits and number of channels Begin() asks the sound output for, along with the audio
+		rate. 0, the default, is the highest the Movie's sound tracks have, so DV's 4 channel 12 bit sound and
+		16 bit stereo both go to the device the way they are when it takes them. Otherwise the nearest it does
+		take is used, see CVideoOutputCapabilities.h, and the Sound Manager converts to that on the way out,
+		once. Returns videoOutputInUseErr once Begin() has started.
+		There's no conversion stage in CVideoOutput, the sound samples never come through here - the sound
+		media handler hands them to the sound output component and the Sound Manager does every conversion,
+		sample size, channels, byte order and interleaving. The last two can't be asked for through the sound
+		output component, the Sound Manager matches the device by itself.
+	
+	GetAudioFormat( AudioFormatRecord &outFormat )
+		The sample rate, sample size and channels the sound output was set to by Begin(), a field is 0 when the
+		sound output didn't say what it takes and was left as it was. All 0 with no sound output.
+	
+	SetAudioRoute( UInt8 inSoundTrack, const AudioRouteRecord &inRoute )
+	ClearAudioRoute( UInt8 inSoundTrack )
+		Which sound output of the video output component a sound track plays to and at what left and right
+		gain, see CVideoOutputAudioRouting.h. Sound tracks count from 0 in the order of the Movie's tracks.
+		Whole tracks are routed, not their channels one by one.
+		Gains take effect right away while the video output's sound device is in use, they're the track's
+		volume and balance so changing them doesn't drop or click the sound. The gains pan on top of the
+		track's own balance. The sound output changes at the next Begin() or SetSoundDevice(), and a sound
+		output other than the first is set to the same sample rate, sample size and channels, or the nearest
+		it takes. Tracks go back to their own volume and balance at End().
+	
+	SaveAudioRouting( Handle *outPreset )
+	LoadAudioRouting( Handle inPreset )
+		Every route as a preset handle the caller disposes of, and back. Loading applies the gains the same
+		way SetAudioRoute() does. Returns paramErr for a handle which isn't a preset.
+	
+	GetTrackCatalog( void )
+		What's in the tracks of the Movie, looked up the first time it's needed and kept until SetMovie() is
+		given a different Movie, so Begin() after End() doesn't walk the tracks again. Returns NULL without a
+		Movie or the memory for it.
 		
 	SetEchoPort( const CGrafPtr inEchoPort = NULL )
 		Allows you to display video both on an external video display and in a window.
@@ -96,10 +197,22 @@
 		setting up the sound device or it's gets whacked back to the default QuickTime clock.
 		
 	End( void )
-		Relinquishes exclusive access to the hardware. Also called by Close().
+		Relinquishes exclusive access to the hardware. Also called by Close(). Begun -> Opened, does nothing
+		in any other state.
+	
+	Close( Duration inTimeout = kDurationForever )
+		Closes the component instance and zeros the object. It is also called by the destructor. Ends first
+		when Begun, and waits for a Begin() or End() running on the device task or another thread to finish.
+		The wait blocks on a semaphore, returns kMPTimeoutErr and leaves the object as it is if they're still
+		going after inTimeout.
 	
-	Close( void )
-		Closes the component instance and zeros the object. It is also called by the destructor.
+	GetState( void )
+		Where the object is: eVideoOutputClosed, eVideoOutputOpened or eVideoOutputBegun, or one of the
+		in between states while another thread is making the transition. The state is a single word changed
+		with CompareAndSwap, so GetState(), IsBegun() and GetGWorld() take no locks and can be called from an
+		output thread while the UI thread calls Open(), Begin(), End() and Close(). Only one caller wins a
+		transition, the others get an error rather than half a Begin(). Everything else still belongs to
+		the thread driving the transitions.
 				
 	GetGWorld( void )
 		Returns a pointer to the graphics world used by a video output component.
@@ -107,11 +220,195 @@
 		
 	GetError( void )
 		Returns the last return code generated by the system.
+	
+	GetErrorLog( void )
+		Every error CVideoOutput gets back from the system is also recorded in a CVideoOutputErrorLog, with
+		what it was doing, the subType of the video output component and when, so the first error of a run
+		isn't lost under the ones that follow from it. Recording takes no locks, errors on the device task
+		and during playback are in there too.
 		
 	SelectVideoOutputComponent( void )
 		Calls the CVideoOutputComponents DoSettingsDialog() method. Allows the client of this class to
 		select which video output component and mode to use.
 	
+	SelectBestDisplayMode( ModeScorePtr outScore = NULL )
+		Scores every mode of every video output component against the format of the Movie and selects the
+		one which needs the least scaling, frame rate, field order and pixel format conversion. Call after
+		SetMovie() and before Open(). Pass in a ModeScorePtr to get the score breakdown of the chosen mode,
+		CVideoOutputModeMatcher::ScoreMode() can be used to check any other mode.
+	
+	SetRateConversion( RateConversionMode inMode )
+		Sets up frame rate conversion from the Movie frame rate to the refresh rate of the selected display
+		mode, see CVideoOutputRateConverter.h for the modes. Call after selecting the mode and before Begin().
+		Pass eRateConversionOff to turn it off again. It needs the video output component's clock, without one
+		Begin() leaves it off. While it's on PresentFrame() builds each output frame from the movie frames the
+		cadence asks for: the DV decoder decodes them itself, otherwise the Movie draws into a GWorld of our
+		own and the drawing complete proc keeps each frame, and the output runs one movie frame behind so the
+		next one is there to blend with. There's no echo port in this case.
+	
+	GetCadenceFrame( CadenceFrameRecord &outFrame )
+		Reads the video output component's clock and returns the movie frame(s) to present for the current
+		output frame, counted from Begin(). Requires a clock, see HasClock(), and SetRateConversion().
+	
+	FieldOrder GetFieldOrder( void )
+		Returns the field order of the selected display mode, set up by Begin(). Use it with
+		CVideoOutputFields::ForEachField() to process the output GWorld a field at a time.
+	
+	Boolean IsFieldAccurate( void )
+		True when the Movie and the display mode are interlaced with the same field order, so the
+		decompressed fields can go straight out. Turn on the High Quality play hint in this case so
+		DV is decompressed as two full fields rather than one field line doubled.
+	
+	Boolean IsEncodingDV( void )
+		True when the selected display mode only takes DV and the Movie isn't DV. Begin() then has the
+		Movie draw into a '2vuy' GWorld and each frame is encoded into the video output component's GWorld
+		with CVideoOutputDVEncoder. The encode is started when the Movie has drawn and left on the shared
+		work pool until FinishFrame(). There's no echo port in this case.
+	
+	Boolean IsDecodingDV( void )
+		True when the Movie is DV and the selected display mode is a 720 wide '2vuy' or 'yuvs' mode of the
+		same system. Begin() then takes the DV track out of the Movie's drawing and PresentFrame() decodes
+		each sample with CVideoOutputDVDecoder directly into the video output component's GWorld, so the
+		frame is written once where it will be shown. There's no echo port in this case.
+	
+	FinishFrame( void )
+		Call before MCIdle() or MoviesTask(). Finishes the frame the DV encoder is still working on, it
+		reads the GWorld the Movie draws into so it has to be done before the Movie draws again, and the
+		DV frame PresentFrame() is still decoding. Meanwhile the other sessions get their idles and their
+		frames share the pool's tasks with this one.
+	
+	PresentFrame( void )
+		Call after MCIdle() or MoviesTask(). When IsDecodingDV() is true it decodes the DV sample at the
+		current Movie time into the video output component's GWorld, if it isn't the one already there.
+		The decode is left running on the shared work pool and the next call finishes it, so the other
+		sessions get their idles meanwhile and their frames share the pool's tasks with this one.
+		With rate conversion on it puts up the output frame the cadence asks for, see SetRateConversion().
+		When the Movie draws into the swap chain it presents the buffer the Movie last drew into.
+		Also takes a sync measurement when the sync monitor is on.
+	
+	GetTimeUntilNextFrame( long &outDuration, TimeScale inScale = 1000 )
+		While the Movie plays and PresentFrame() has work to do, decoding DV, converting the frame rate or
+		measuring sync, returns true and the time until the next video frame is due in inScale units, like
+		QTGetTimeUntilNextTask(). Between StartAtTime() and the start it returns the time until the start.
+		QuickTime doesn't know about the DV track we draw ourselves, so idle on the sooner of the two.
+		Returns false when stopped or when there's nothing for PresentFrame() to do, unless a DV frame is
+		still to be finished.
+	
+	CreateSwapChain( UInt16 inBufferCount = 3, Boolean inDrawMovie = true )
+		Call after Begin() to draw frames ahead instead of into GetGWorld(). Sets up inBufferCount buffers
+		like the video output component's GWorld and a task which copies each presented buffer to it when
+		its time comes, see CVideoOutputSwapChain.h. With inDrawMovie the Movie draws into a buffer of its
+		own and PresentFrame() presents it once drawn, the copy happens on the output task rather than in
+		MCIdle(). A frame is dropped if no other buffer's free yet. Turning on the echo port takes the Movie
+		away from the buffers. Not available when encoding or decoding DV or converting the frame rate, they
+		write the GWorld themselves. End() disposes it. With the legalizer on the Movie already draws into
+		one, see StartLegalizer(), GetSwapChain() returns it and this replaces it.
+	
+	DisposeSwapChain( void )
+		Points the Movie back at the output GWorld, or while the legalizer's on at a swap chain of its own.
+	
+	AcquireBuffer( SwapBufferRecord &outBuffer, Duration inTimeout = kDurationImmediate )
+	PresentBuffer( const SwapBufferRecord &inBuffer, UInt64 inDisplayTime = 0 )
+	CancelBuffer( const SwapBufferRecord &inBuffer )
+		Get a free buffer, fill it on any thread, then queue it to go out at inDisplayTime (nanoseconds on
+		the CVideoOutputSwapChain::GetCurrentTime() time line, 0 for as soon as possible) or give it back.
+		These can be called from any thread so they return their error rather than keeping it for GetError().
+	
+	StartRecording( const FSSpec &inFile, Boolean inUncached = false, RecordTap inTap = eRecordDVFrames )
+		Call after Begin() to write a copy of every frame sent to the video output into inFile, creating it if
+		needed, see CVideoOutputRecorder.h. When encoding DV the file is a DV stream of the frames as they went
+		out. When decoding DV inTap picks where the recording is tapped: eRecordDVFrames is a DV stream of the
+		Movie's frames, which costs nothing but is before the legalizer, so with one on it isn't what went out;
+		eRecordOutputPixels is the output GWorld after the legalizer. Otherwise it's the pixels of the output
+		GWorld in the pixel format of the display mode, one frame after the other with no row padding. Sound
+		isn't recorded separately - QuickTime plays it straight to the video output component's sound output
+		component - but DV frames from a DV Movie keep the audio which was recorded in them. Presenting a frame
+		never waits for the disk, if the file can't keep up frames are dropped from the recording and counted.
+		End() stops recording.
+	
+	StopRecording( void )
+		Writes out what's still queued and closes the file.
+	
+	GetRecorderStats( RecorderStatsRecord &outStats )
+		Frames recorded and dropped so far, returns paramErr if we're not recording.
+	
+	CueFrame( long inFrame, Fixed inRate = fixed1 )
+	CueTimecode( const TimeCodeRecord &inTimecode, Fixed inRate = fixed1 )
+		Call after Begin() to stop the Movie on a frame, counted from 0, or on a SMPTE timecode, preroll it for
+		inRate and put the frame up on the output, see CVideoOutputCue.h. StartAtTime() then sets it going.
+		With a DV index open CueTimecode() looks for the timecode recorded in the DV frames, and CueFrame()
+		returns paramErr for a frame past the end of the file.
+	
+	OpenDVIndex( const FSSpec &inDVFile )
+		The Movie was opened from DV stream inDVFile, so each frame of the file is a frame of the Movie. Loads
+		the file's index from next to it, or builds it on the work pool and saves it there when it's missing
+		or out of date, see CVideoOutputDVIndex.h. It can be called before Begin(), it stays open until the
+		CVideoOutput goes or CloseDVIndex() is called.
+	
+	GetOutputTime( TimeRecord &outTime )
+		The time now on the video output component's clock. Requires a clock, see HasClock().
+	
+	StartAtTime( const TimeRecord &inStartTime )
+		Starts the cued Movie so the cued frame is the one on the output at inStartTime on the video output
+		component's clock, GetOutputTime() plus a second for example. Returns straight away, the Movie is set
+		going from MCIdle() or MoviesTask() when the time comes so keep idling it. The Movie must be using the
+		video output clock, see SetClock(). IsStarting() is true until it's going, after that GetCueStats() has
+		how late the start was and how far the Movie's time line ended up from where it should be.
+	
+	StartSyncMonitor( UInt32 inThreshold = kSyncDefaultThreshold, SyncEventProcPtr inEventProc = NULL, void *inRefCon = NULL,
+					  UInt32 inAudioLatency = kSyncOutputLatency )
+		Call after Begin() to keep checking audio / video sync while the Movie plays, see CVideoOutputSyncMonitor.h.
+		Each frame written to the output GWorld - by the Movie, the DV encoder or the DV decoder - is noted and
+		PresentFrame() measures how far the sound is from it, so call PresentFrame() every idle. inEventProc is
+		called from there when the offset goes over inThreshold milliseconds and when it comes back. Frames sent
+		with the swap chain aren't measured, their times are up to you. End() stops the monitor.
+		inAudioLatency is in milliseconds, kSyncOutputLatency gets it from the sound output component's
+		siOutputLatency, 0 if it doesn't say.
+	
+	StopSyncMonitor( void )
+	GetSyncStats( SyncStatsRecord &outStats )
+		Mean, 99th percentile and largest offset over the last few seconds, returns paramErr if the monitor isn't on.
+	
+	StartLoudnessMeter( void )
+		Call after Begin() to meter the loudness of the Movie's sound while it plays, see
+		CVideoOutputLoudnessMeter.h. PresentFrame() does the measuring so call it every idle. Starting
+		again starts the integrated loudness over. End() stops the meter. Needs QuickTime 7 for the movie
+		audio extraction, returns unimpErr before that.
+	
+	StopLoudnessMeter( void )
+	GetLoudnessStats( LoudnessStatsRecord &outStats )
+		Momentary, short term and integrated loudness in LUFS and the true peak in dBTP, as EBU R128 and
+		ATSC A/85 measure them. Returns paramErr if the meter isn't on.
+	
+	StartScopes( UInt32 inFrameInterval = 1, UInt32 inStep = 2 )
+		Call after Begin() for a waveform, vectorscope and RGB histograms of the frames sent to the video output,
+		see CVideoOutputScopes.h. They're taken wherever frames are written to the output GWorld, like the
+		recorder's, and when encoding DV from the frame the encoder was given, legalized on the way in as the
+		encoder legalizes it when there's a legalizer. Every inFrameInterval'th frame is
+		looked at, every inStep'th row and pair of pixels of it, on a task of its own. Returns paramErr for an
+		output pixel format the scopes don't read. End() stops the scopes.
+	
+	StopScopes( void )
+	GetScopes( ScopeDataRecord &outScopes )
+	GetScopeStats( ScopeStatsRecord &outStats )
+		The scopes of the latest frame looked at, and how many frames were looked at and skipped. Return
+		paramErr if the scopes aren't on.
+	
+	StartLegalizer( const LegalizerLimitsRecord *inLimits = NULL )
+		Call after Begin() to keep the frames sent to the video output within inLimits, NULL for the
+		defaults, see CVideoOutputLegalizer.h. The DV decoder legalizes each macroblock as it stores it, the
+		DV encoder as it reads it, the swap chain each row as it copies it and rate conversion each row as it
+		composes it, so it doesn't take another pass over the frame. A Movie which would draw into the output
+		GWorld itself is given a swap chain to draw into, as CreateSwapChain() does, and StopLegalizer() takes
+		it away again; with the echo port on the Movie draws into the window instead and isn't legalized. The
+		legalizer works on pairs of 4:2:2 Y'CbCr pixels, so it returns cDepthErr unless the output, or the DV
+		encoder's source, is '2vuy' or 'yuvs' - an RGB display mode can't be legalized - and paramErr for
+		limits which don't make sense. End() stops the legalizer.
+	
+	StopLegalizer( void )
+	GetLegalizerStats( LegalizerStatsRecord &outStats )
+		Pixels changed in the last frame and in all of them, returns paramErr if the legalizer isn't on.
+	
 	Boolean CanDoEchoPort( void )
 		Does this component support an EchoPort?
 		
@@ -137,11 +434,31 @@
 
 #include "GetFile.h"
 #include "CVideoOutputComponent.h"
+#include "CVideoOutputModeMatcher.h"
+#include "CVideoOutputRateConverter.h"
+#include "CVideoOutputFields.h"
+#include "CVideoOutputDVEncoder.h"
+#include "CVideoOutputDVDecoder.h"
+#include "CVideoOutputDVIndex.h"
+#include "CVideoOutputSwapChain.h"
+#include "CVideoOutputRecorder.h"
+#include "CVideoOutputCue.h"
+#include "CVideoOutputSyncMonitor.h"
+#include "CVideoOutputLoudnessMeter.h"
+#include "CVideoOutputScopes.h"
+#include "CVideoOutputLegalizer.h"
+#include "CVideoOutputDeviceTask.h"
+#include "CVideoOutputErrorLog.h"
+#include "CVideoOutputTrackCatalog.h"
+#include "CVideoOutputCapabilities.h"
+#include "CVideoOutputAudioRouting.h"
 
 namespace dts {
 
 const UInt8  kMaxAudioTracks = 5;
 const UInt16 kQTVersion501 = 0x0501;
+const UInt16 kQTVersion700 = 0x0700;
+const UInt32 kRecorderQueueFrames = 60;	// a couple of seconds for the disk to catch up
 
 enum AudioRate {
 	eAudioRate48khz = (long)0xBB800000, /* 48000.00000 in fixed-point */
@@ -150,32 +467,220 @@ enum AudioRate {
 	eAudioRateDefault = 0L				/* use default sampling rate of the media */
 }; 
 
+// Where StartRecording() taps the frames when decoding DV
+enum RecordTap {
+	eRecordDVFrames = 0,	// the DV frames read from the Movie, before the legalizer
+	eRecordOutputPixels		// the pixels of the output GWorld, after the legalizer
+};
+
+// Open() and Begin() move forward a step, End() and Close() back. The in between states
+// belong to whichever thread is making the transition
+enum VideoOutputState {
+	eVideoOutputClosed = 0,
+	eVideoOutputOpening,
+	eVideoOutputOpened,
+	eVideoOutputBeginning,
+	eVideoOutputBegun,
+	eVideoOutputEnding,
+	eVideoOutputClosing
+};
+
+typedef struct {
+	UnsignedFixed	sampleRate;
+	UInt16			sampleSize;			// bits
+	UInt16			channels;
+} AudioFormatRecord;
+
+typedef struct {
+	UInt64	beginMicroseconds;		// QTVideoOutputBegin
+	UInt64	soundMicroseconds;		// finding the sound output and setting its format
+	UInt64	endMicroseconds;		// QTVideoOutputEnd
+	UInt64	asyncMicroseconds;		// the whole device task job of the last BeginAsync or EndAsync
+} DeviceTimesRecord;
+
+class CVideoOutput;
+
+typedef void (*AsyncDoneProcPtr)( CVideoOutput *inVideoOutput, OSErr inResult, const DeviceTimesRecord &inTimes,
+								  void *inRefCon );
+
 class CVideoOutput {
 	public:
 		explicit CVideoOutput( const unsigned char inClientNameStr[], const Movie inMovie = NULL );
-		~CVideoOutput() { Close(); }
+		~CVideoOutput();
 		
 		OSErr Open( void );
-		void  Close( void );		
+		OSErr Close( Duration inTimeout = kDurationForever );
 		
 		OSErr Begin( Boolean inUseVOsdev = true, Boolean inUseVOClock = true, AudioRate inAudioRate = eAudioRateDefault, Boolean inChangeMovieGWorld = false );
 		void  End( void );		
 		
-		void  SetMovie( const Movie inMovie ) { if ( mVideoOutputInUse == false ) mMovie = inMovie; }
+		OSErr BeginAsync( AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout = kEventDurationForever,
+						  Boolean inUseVOsdev = true, Boolean inUseVOClock = true, AudioRate inAudioRate = eAudioRateDefault,
+						  Boolean inChangeMovieGWorld = false );
+		OSErr EndAsync( AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout = kEventDurationForever );
+		OSErr CancelAsync( void ) { return AbandonAsync( userCanceledErr ); }
+		Boolean IsAsyncPending( void ) const { return ( mDeviceTask.get() && mDeviceTask->IsBusy() ); }
+		void  GetDeviceTimes( DeviceTimesRecord &outTimes ) const { outTimes = mDeviceTimes; }
+		
+		OSErr SetMovie( const Movie inMovie )
+		{
+			if ( GetState() > eVideoOutputOpened ) return videoOutputInUseErr;
+			if ( inMovie != mMovie ) mTrackCatalog.reset();
+			mMovie = inMovie;
+			return noErr;
+		}
+		const CVideoOutputTrackCatalog *GetTrackCatalog( void );
+		OSErr SetAudioFormat( UInt16 inSampleSize = 0, UInt16 inChannels = 0 );
+		void  GetAudioFormat( AudioFormatRecord &outFormat ) const { outFormat = mAudioFormat; }
+		OSErr SetAudioRoute( UInt8 inSoundTrack, const AudioRouteRecord &inRoute );
+		OSErr ClearAudioRoute( UInt8 inSoundTrack );
+		OSErr SaveAudioRouting( Handle *outPreset ) const { return mAudioRouting.Save( outPreset ); }
+		OSErr LoadAudioRouting( Handle inPreset );
 		OSErr SetEchoPort( const CGrafPtr inEchoPort = NULL );
 		OSErr SetSoundDevice( Boolean inUseVOsdev = true );
 		void  SetClock( Boolean inUseVOClock = true );
 		
-		const GWorldPtr GetGWorld( void ) const { if ( mVideoOutputInUse == true ) return mVOutputGWorld; else return NULL; }
+		const GWorldPtr GetGWorld( void ) const { if ( IsBegun() ) return mVOutputGWorld; else return NULL; }
 		OSErr GetError( void ) const { return rc; }
+		const CVideoOutputErrorLog &GetErrorLog( void ) const { return mErrorLog; }
+		
+		VideoOutputState GetState( void ) const { return (VideoOutputState)*(volatile UInt32 *)&mState; }
+		Boolean IsBegun( void ) const { return ( GetState() == eVideoOutputBegun ); }
 		
 		OSErr SelectVideoOutputComponent( void ) { return ( mVOutputComponent->DoSettingsDialog() ); }
+		OSErr SelectBestDisplayMode( ModeScorePtr outScore = NULL );
+		
+		OSErr SetRateConversion( RateConversionMode inMode );
+		OSErr GetCadenceFrame( CadenceFrameRecord &outFrame );
+		
+		FieldOrder GetFieldOrder( void ) const { return mModeFieldOrder; }
+		Boolean IsFieldAccurate( void ) const
+			{ return ( CVideoOutputFields::IsInterlaced( mModeFieldOrder ) && mMovieFieldOrder == mModeFieldOrder ); }
+		
+		Boolean IsEncodingDV( void ) const { return ( mDVEncoder.get() != NULL ); }
+		Boolean IsDecodingDV( void ) const { return ( mDVDecoder.get() != NULL ); }
+		
+		void  FinishFrame( void );
+		OSErr PresentFrame( void );
+		Boolean GetTimeUntilNextFrame( long &outDuration, TimeScale inScale = 1000 ) const;
+		
+		OSErr CreateSwapChain( UInt16 inBufferCount = 3, Boolean inDrawMovie = true );
+		void  DisposeSwapChain( void );
+		CVideoOutputSwapChain *GetSwapChain( void ) const { return mSwapChain.get(); }
+		
+		OSErr AcquireBuffer( SwapBufferRecord &outBuffer, Duration inTimeout = kDurationImmediate )
+			{ return ( mSwapChain.get() ? mSwapChain->AcquireBuffer( outBuffer, inTimeout ) : paramErr ); }
+		OSErr PresentBuffer( const SwapBufferRecord &inBuffer, UInt64 inDisplayTime = 0 )
+			{ return ( mSwapChain.get() ? mSwapChain->PresentBuffer( inBuffer.index, inDisplayTime ) : paramErr ); }
+		OSErr CancelBuffer( const SwapBufferRecord &inBuffer )
+			{ return ( mSwapChain.get() ? mSwapChain->CancelBuffer( inBuffer.index ) : paramErr ); }
+		
+		OSErr StartRecording( const FSSpec &inFile, Boolean inUncached = false, RecordTap inTap = eRecordDVFrames );
+		void  StopRecording( void );
+		Boolean IsRecording( void ) const { return ( mRecorder.get() != NULL ); }
+		OSErr GetRecorderStats( RecorderStatsRecord &outStats ) const
+			{ if ( mRecorder.get() == NULL ) return paramErr; mRecorder->GetStats( outStats ); return noErr; }
+		
+		OSErr CueFrame( long inFrame, Fixed inRate = fixed1 );
+		OSErr CueTimecode( const TimeCodeRecord &inTimecode, Fixed inRate = fixed1 );
+		OSErr OpenDVIndex( const FSSpec &inDVFile );
+		void  CloseDVIndex( void ) { mDVIndex.reset(); }
+		const CVideoOutputDVIndex *GetDVIndex( void ) const { return mDVIndex.get(); }
+		OSErr GetOutputTime( TimeRecord &outTime );
+		OSErr StartAtTime( const TimeRecord &inStartTime );
+		Boolean IsStarting( void ) const { return mCue.IsStarting(); }
+		void  GetCueStats( CueStatsRecord &outStats ) const { mCue.GetStats( outStats ); }
+		
+		OSErr StartSyncMonitor( UInt32 inThreshold = kSyncDefaultThreshold, SyncEventProcPtr inEventProc = NULL, void *inRefCon = NULL,
+								UInt32 inAudioLatency = kSyncOutputLatency );
+		void  StopSyncMonitor( void );
+		Boolean IsMonitoringSync( void ) const { return ( mSyncMonitor.get() != NULL ); }
+		OSErr GetSyncStats( SyncStatsRecord &outStats ) const
+			{ if ( mSyncMonitor.get() == NULL ) return paramErr; mSyncMonitor->GetStats( outStats ); return noErr; }
+		
+		OSErr StartLoudnessMeter( void );
+		void  StopLoudnessMeter( void ) { mLoudnessMeter.reset(); }
+		Boolean IsMeteringLoudness( void ) const { return ( mLoudnessMeter.get() != NULL ); }
+		OSErr GetLoudnessStats( LoudnessStatsRecord &outStats ) const
+			{ if ( mLoudnessMeter.get() == NULL ) return paramErr; mLoudnessMeter->GetStats( outStats ); return noErr; }
+		
+		OSErr StartScopes( UInt32 inFrameInterval = 1, UInt32 inStep = 2 );
+		void  StopScopes( void );
+		Boolean IsRunningScopes( void ) const { return ( mScopes.get() != NULL ); }
+		OSErr GetScopes( ScopeDataRecord &outScopes ) const
+			{ if ( mScopes.get() == NULL ) return paramErr; mScopes->GetScopes( outScopes ); return noErr; }
+		OSErr GetScopeStats( ScopeStatsRecord &outStats ) const
+			{ if ( mScopes.get() == NULL ) return paramErr; mScopes->GetStats( outStats ); return noErr; }
+		
+		OSErr StartLegalizer( const LegalizerLimitsRecord *inLimits = NULL );
+		void  StopLegalizer( void );
+		Boolean IsLegalizing( void ) const { return ( mLegalizer.get() != NULL ); }
+		OSErr GetLegalizerStats( LegalizerStatsRecord &outStats ) const
+			{ if ( mLegalizer.get() == NULL ) return paramErr; mLegalizer->GetStats( outStats ); return noErr; }
 	
 		Boolean CanDoEchoPort( void ) const { return mCanDoEchoPort; }
 		Boolean HasSoundOutput( void ) const { return mHasSoundOutput; }
 		Boolean HasClock( void ) const { return mHasClock; }
 
 	private:
+		OSErr SetUpDVEncoder( void );
+		void  DisposeDVEncoder( void );
+		OSErr SetUpDVDecoder( void );
+		void  DisposeDVDecoder( void );
+		void  UpdateDrawingCompleteProc( void );
+		void  TearDown( Boolean inEndHardware );
+		GWorldPtr GetDrawingGWorld( void ) const;
+		Track GetVideoTrack( void ) const;
+		long  GetTrackSample( Track inTrack ) const;
+		
+		void  SetUpCadence( void );
+		void  DisposeCadence( void );
+		void  AnchorCadence( void );
+		OSErr PresentCadenceFrame( void );
+		OSErr DecodeCadenceFrame( UInt64 inSample );
+		void  StoreDrawnFrame( GWorldPtr inGWorld );
+		OSErr StartEncodeSourceFrame( void );
+		void  FinishEncodeSourceFrame( void );
+		void  OutputFrameDone( void );
+		void  ReleaseSwapChain( void );
+		OSErr CreateLegalizerSwapChain( void );
+		void  RecordOutputFrame( void );
+		OSErr PresentMovieBuffer( void );
+		void  FinishPresentFrame( void );
+		OSErr GetMovieFormat( MovieFormatRecord &outFormat );
+		
+		OSErr PrepareBegin( Boolean inUseVOsdev, Boolean inUseVOClock, AudioRate inAudioRate, Boolean inChangeMovieGWorld );
+		OSErr DeviceBegin( void );
+		OSErr FinishBegin( OSErr inDeviceErr );
+		void  DetachOutput( void );
+		OSErr DeviceEnd( void );
+		void  ResetOutput( void );
+		
+		OSErr StartAsync( DeviceProcPtr inProc, AsyncDoneProcPtr inDoneProc, void *inRefCon, EventTimerInterval inTimeout );
+		OSErr AbandonAsync( OSErr inReason );
+		void  NotifyAsync( OSErr inResult );
+		
+		OSErr LogError( OSType inOperation, OSErr inErr );
+		
+		Component GetRoutedSoundOutput( UInt8 inSoundTrack );
+		OSErr SetSoundOutputFormat( Component inSoundOutput, const CapabilityRecord &inCapabilities, AudioFormatRecord &outFormat );
+		void  SetAudioGain( UInt8 inSoundTrack );
+		UInt32 GetAudioLatency( void ) const;
+		
+		static OSErr DeviceBeginProc( void *inRefCon );
+		static OSErr DeviceEndProc( void *inRefCon );
+		static void  DeviceDone( void *inRefCon, OSErr inResult, UInt64 inMicroseconds );
+		static pascal void AsyncTimeout( EventLoopTimerRef inTimer, void *inUserData );
+		
+		// the hardware is ours for the length of Begin() and End() as well
+		Boolean IsInUse( void ) const
+			{ VideoOutputState theState = GetState(); return ( theState >= eVideoOutputBeginning && theState <= eVideoOutputEnding ); }
+		Boolean ChangeState( VideoOutputState inFrom, VideoOutputState inTo );
+		
+		static pascal OSErr DVDrawingComplete( Movie inMovie, long inRefCon );
+		static pascal OSErr OutputDrawingComplete( Movie inMovie, long inRefCon );
+		static void CueStarted( void *inRefCon );
+		
 		// nope
 		CVideoOutput( const CVideoOutput &inVOObject );
 		CVideoOutput operator=( CVideoOutput inVOObject );
@@ -183,17 +688,76 @@ class CVideoOutput {
 	private:
 		Str255					 mClientNameStr;
 		Movie					 mMovie;
+		CVideoOutputTrackCatalogPtr mTrackCatalog;	// made by GetTrackCatalog()
 		CVideoOutputComponentPtr mVOutputComponent;	// auto_ptr object, deletion will be handled for us
 		GWorldPtr				 mVOutputGWorld;
 		Component				 mSoundOutComponent;
 		ComponentInstance		 mVideoOutputClockInstance;
 		MediaHandler 			 mAudioMediaHandler[kMaxAudioTracks];
+		Track					 mAudioTrack[kMaxAudioTracks];
+		short					 mAudioTrackVolume[kMaxAudioTracks];	// as the Movie had them, for End()
+		short					 mAudioTrackBalance[kMaxAudioTracks];
 		UInt8					 mNumberAudioTracks;
-		Boolean					 mVideoOutputInUse;
+		UInt32					 mState;			// atomic, a VideoOutputState
+		MPSemaphoreID			 mStateChanged;		// signaled by every transition, for Close()
 		Boolean					 mCanDoEchoPort;
 		Boolean					 mHasSoundOutput;
 		Boolean					 mHasClock;
 		UInt16					 mQTVersion;
+		CVideoOutputRateConverter mRateConverter;
+		UInt64					 mCadenceOrigin;		// output frame count at Begin(), or when the cadence was last anchored
+		long					 mCadenceBase;		// video sample shown at mCadenceOrigin
+		GWorldPtr				 mCadenceGWorld;	// the Movie draws here when we're converting its frames
+		CadenceFrameRecord		 mCadenceShown;		// in samples, what PresentFrame() put up last
+		Boolean					 mHasCadenceShown;
+		FieldOrder				 mMovieFieldOrder;
+		FieldOrder				 mModeFieldOrder;
+		CVideoOutputDVEncoderPtr mDVEncoder;		// only for DV only outputs and non DV movies
+		GWorldPtr				 mDVSourceGWorld;	// the Movie draws here when we're encoding
+		MovieDrawingCompleteUPP	 mDVDrawingCompleteUPP;
+		CVideoOutputDVDecoderPtr mDVDecoder;		// only for DV movies and 2vuy or yuvs outputs
+		Track					 mDVTrack;			// the DV track we decode instead of the Movie drawing it
+		Handle					 mDVSample;
+		long					 mDVSampleNum;		// sample in the output GWorld, 0 for none
+		DVSystem				 mDVSystem;
+		CVideoOutputSwapChainPtr mSwapChain;
+		SwapBufferRecord		 mMovieBuffer;		// the buffer the Movie draws into
+		Boolean					 mHasMovieBuffer;
+		Boolean					 mIsMovieBufferDrawn;	// waiting for PresentFrame()
+		CVideoOutputRecorderPtr	 mRecorder;
+		Boolean					 mIsRecordingDVFrames;	// rather than the output GWorld's pixels
+		MovieDrawingCompleteUPP	 mOutputDrawingCompleteUPP;	// when the Movie draws straight into the output GWorld
+		CVideoOutputCue			 mCue;
+		CVideoOutputDVIndexPtr	 mDVIndex;			// of the DV file the Movie was opened from
+		CVideoOutputSyncMonitorPtr mSyncMonitor;
+		CVideoOutputLoudnessMeterPtr mLoudnessMeter;
+		CVideoOutputScopesPtr	 mScopes;
+		CVideoOutputLegalizerPtr mLegalizer;
+		Boolean					 mIsLegalizerSwapChain;	// mSwapChain was made for the legalizer, not asked for
+		
+		// what Begin() needs between the calling thread and the device task
+		UnsignedFixed			 mBeginSampleRate;
+		UInt16					 mBeginSampleSize;
+		UInt16					 mBeginChannels;
+		Boolean					 mBeginUseVOsdev;
+		Boolean					 mBeginUseVOClock;
+		Boolean					 mBeginChangeMovieGWorld;
+		Boolean					 mIsHardwareOurs;	// QTVideoOutputBegin succeeded
+		CapabilityRecord		 mCapabilities;		// from the device task for FinishBegin()
+		UInt16					 mWantedSampleSize;	// SetAudioFormat(), 0 for the Movie's
+		UInt16					 mWantedChannels;
+		AudioFormatRecord		 mAudioFormat;		// what the sound output was set to
+		CVideoOutputAudioRouting mAudioRouting;
+		Boolean					 mIsUsingVOsdev;	// SetSoundDevice( true ) last
+		DeviceTimesRecord		 mDeviceTimes;
+		
+		CVideoOutputDeviceTaskPtr mDeviceTask;		// made by the first BeginAsync or EndAsync
+		AsyncDoneProcPtr		 mAsyncDoneProc;	// NULL once told
+		void					 *mAsyncRefCon;
+		EventLoopTimerRef		 mAsyncTimer;
+		OSErr					 mAsyncAbandoned;	// timed out or canceled, the result when the device gets back
+		
+		CVideoOutputErrorLog	 mErrorLog;
 		ComponentResult			 rc;
 };
 
@@ -0,0 +1,184 @@
+/*
+	File:		 CVideoOutputAudioRouting.cpp
+	
+	Description: Sound track routing for the video output.
+				 See CVideoOutputAudioRouting.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 GetVolumeAndBalance keeps the track's balance
+										<1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputAudioRouting.h"
+
+using namespace dts;
+
+CVideoOutputAudioRouting::CVideoOutputAudioRouting()
+{
+	for (UInt32 i = 0; i < kMaxAudioRoutes; i++) {
+		mIsRouted[i] = false;
+	}
+}
+
+OSErr CVideoOutputAudioRouting::SetRoute(UInt32 inSoundTrack, const AudioRouteRecord &inRoute)
+{
+	if (inSoundTrack >= kMaxAudioRoutes || 0 == inRoute.output || inRoute.leftGain < 0 || inRoute.rightGain < 0) return paramErr;
+
+	mRoutes[inSoundTrack] = inRoute;
+	mIsRouted[inSoundTrack] = true;
+
+	return noErr;
+}
+
+Boolean CVideoOutputAudioRouting::GetRoute(UInt32 inSoundTrack, AudioRouteRecord &outRoute) const
+{
+	if (inSoundTrack >= kMaxAudioRoutes || !mIsRouted[inSoundTrack]) return false;
+
+	outRoute = mRoutes[inSoundTrack];
+
+	return true;
+}
+
+void CVideoOutputAudioRouting::GetVolumeAndBalance(const AudioRouteRecord &inRoute, short inTrackVolume, short inTrackBalance, short &outVolume, short &outBalance)
+{
+	SInt32 theBalance = (inTrackBalance < -128) ? -128 : (inTrackBalance > 128) ? 128 : inTrackBalance;
+	SInt32 theLeft, theRight, theLouder;
+	SInt64 theVolume;
+
+	// Each side's gain, kRouteUnityGain * 128 is unity - the track's balance only ever takes a side down
+	theLeft = (SInt32)inRoute.leftGain * ((theBalance > 0) ? 128 - theBalance : 128);
+	theRight = (SInt32)inRoute.rightGain * ((theBalance < 0) ? 128 + theBalance : 128);
+	theLouder = (theLeft > theRight) ? theLeft : theRight;
+
+	if (theLouder <= 0) {
+		outVolume = 0;
+		outBalance = 0;
+		return;
+	}
+
+	// The louder side scales the track's own volume, the balance takes the quieter side down from there
+	theVolume = ((SInt64)inTrackVolume * theLouder) / (kRouteUnityGain * 128);
+	outVolume = (short)((theVolume > 0x7FFF) ? 0x7FFF : theVolume);
+	outBalance = (short)(((SInt64)(theRight - theLeft) * 128) / theLouder);
+}
+
+#pragma mark-
+
+OSErr CVideoOutputAudioRouting::Save(Handle *outPreset) const
+{
+	PresetHeaderRecord *pHeader;
+	PresetRouteRecord  *pRoute;
+	UInt32				theCount = 0;
+	Handle				hPreset;
+
+	if (NULL == outPreset) return paramErr;
+
+	for (UInt32 i = 0; i < kMaxAudioRoutes; i++) {
+		if (mIsRouted[i]) theCount++;
+	}
+
+	hPreset = ::NewHandle(sizeof(PresetHeaderRecord) + sizeof(PresetRouteRecord) * theCount);
+	if (NULL == hPreset) return ::MemError();
+
+	pHeader = (PresetHeaderRecord *)*hPreset;
+	pHeader->signature = EndianU32_NtoB(kAudioRoutingSignature);
+	pHeader->version = EndianU32_NtoB(kAudioRoutingVersion);
+	pHeader->routeCount = EndianU32_NtoB(theCount);
+
+	pRoute = (PresetRouteRecord *)(pHeader + 1);
+	for (UInt32 i = 0; i < kMaxAudioRoutes; i++) {
+		if (!mIsRouted[i]) continue;
+
+		pRoute->soundTrack = EndianU16_NtoB((UInt16)i);
+		pRoute->output = EndianU16_NtoB(mRoutes[i].output);
+		pRoute->leftGain = EndianS16_NtoB(mRoutes[i].leftGain);
+		pRoute->rightGain = EndianS16_NtoB(mRoutes[i].rightGain);
+		pRoute++;
+	}
+
+	*outPreset = hPreset;
+
+	return noErr;
+}
+
+OSErr CVideoOutputAudioRouting::Load(Handle inPreset)
+{
+	const PresetHeaderRecord *pHeader;
+	const PresetRouteRecord	 *pRoute;
+	AudioRouteRecord		 theRoutes[kMaxAudioRoutes];
+	Boolean					 isRouted[kMaxAudioRoutes];
+	UInt32					 theCount;
+
+	if (NULL == inPreset || ::GetHandleSize(inPreset) < (long)sizeof(PresetHeaderRecord)) return paramErr;
+
+	pHeader = (const PresetHeaderRecord *)*inPreset;
+	if (EndianU32_BtoN(pHeader->signature) != kAudioRoutingSignature || EndianU32_BtoN(pHeader->version) != kAudioRoutingVersion) return paramErr;
+
+	theCount = EndianU32_BtoN(pHeader->routeCount);
+	if (theCount > kMaxAudioRoutes || ::GetHandleSize(inPreset) < (long)(sizeof(PresetHeaderRecord) + sizeof(PresetRouteRecord) * theCount)) return paramErr;
+
+	// All of it or none of it
+	for (UInt32 i = 0; i < kMaxAudioRoutes; i++) {
+		isRouted[i] = false;
+	}
+
+	pRoute = (const PresetRouteRecord *)(pHeader + 1);
+	for (UInt32 i = 0; i < theCount; i++, pRoute++) {
+		UInt16 theTrack = EndianU16_BtoN(pRoute->soundTrack);
+		if (theTrack >= kMaxAudioRoutes) return paramErr;
+
+		theRoutes[theTrack].output = EndianU16_BtoN(pRoute->output);
+		theRoutes[theTrack].leftGain = EndianS16_BtoN(pRoute->leftGain);
+		theRoutes[theTrack].rightGain = EndianS16_BtoN(pRoute->rightGain);
+		if (0 == theRoutes[theTrack].output || theRoutes[theTrack].leftGain < 0 || theRoutes[theTrack].rightGain < 0) return paramErr;
+
+		isRouted[theTrack] = true;
+	}
+
+	for (UInt32 i = 0; i < kMaxAudioRoutes; i++) {
+		mRoutes[i] = theRoutes[i];
+		mIsRouted[i] = isRouted[i];
+	}
+
+	return noErr;
+}
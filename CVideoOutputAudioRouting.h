@@ -0,0 +1,145 @@
+/*
+	File:		 CVideoOutputAudioRouting.h
+	
+	Description: Which sound output of the video output component each sound track of the Movie plays to,
+				 and at what left and right gain, with presets that can be saved and loaded. Used by the
+				 CVideoOutput class.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 says what the routing can't do
+										<2> 10/19/26 GetVolumeAndBalance keeps the track's balance
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	The sound media handler mixes a track down to the sound output it's given, so the routing is by track -
+	a track goes to one sound output, panned and scaled by its left and right gain. A track without a route
+	is left as the Movie has it.
+	
+	This is not a (track, channel) to output channel matrix. The mix down happens inside the media handler
+	before the sound output sees a sample, so a track's third and fourth channels can't be sent anywhere of
+	their own, a channel can't fan out to several outputs and there's no gain per channel. The QuickTime 7
+	channel layout and audio context calls which could do that drive a Core Audio device, not the Sound
+	Manager sound output the video output component hands us. Routing channels means the video output
+	playing the Movie's sound itself, which it doesn't.
+
+	SetRoute(UInt32 inSoundTrack, const AudioRouteRecord &inRoute)
+	ClearRoute(UInt32 inSoundTrack)
+	GetRoute(UInt32 inSoundTrack, AudioRouteRecord &outRoute)
+		Sound tracks count from 0 in the order of the Movie's tracks. GetRoute() returns false when the
+		track has no route. SetRoute() returns paramErr past kMaxAudioRoutes.
+
+	GetVolumeAndBalance(const AudioRouteRecord &inRoute, short inTrackVolume, short inTrackBalance, short &outVolume, short &outBalance)
+		The track volume and sound balance which play the route on top of the track's own. inTrackBalance,
+		-128 left to 128 right, takes the far side down like the Sound Manager does and the route's gains
+		scale each side from there. The louder side sets the volume and the other is panned down to its gain.
+
+	Save(Handle *outPreset)
+	Load(Handle inPreset)
+		A preset is a handle of big endian data, put it in a resource or the preferences. Load() returns
+		paramErr for a handle which isn't a preset and leaves the routes as they were.
+*/
+
+#ifndef __CVIDEOOUTPUTAUDIOROUTING_H__
+	#define __CVIDEOOUTPUTAUDIOROUTING_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+#else
+	#include <Carbon.h>
+#endif
+
+namespace dts {
+
+const UInt32 kMaxAudioRoutes = 8;
+const short	 kRouteUnityGain = 0x0100;		// 8.8 like a track volume
+const OSType kAudioRoutingSignature = FOUR_CHAR_CODE('VOrt');
+const UInt32 kAudioRoutingVersion = 1;
+
+typedef struct {
+	UInt16	output;				// sound output of the video output component, from 1
+	short	leftGain;			// 8.8, kRouteUnityGain as recorded
+	short	rightGain;
+} AudioRouteRecord;
+
+class CVideoOutputAudioRouting {
+	public:
+		CVideoOutputAudioRouting();
+		~CVideoOutputAudioRouting() {}
+
+		OSErr	SetRoute(UInt32 inSoundTrack, const AudioRouteRecord &inRoute);
+		void	ClearRoute(UInt32 inSoundTrack) { if (inSoundTrack < kMaxAudioRoutes) mIsRouted[inSoundTrack] = false; }
+		Boolean GetRoute(UInt32 inSoundTrack, AudioRouteRecord &outRoute) const;
+
+		static void GetVolumeAndBalance(const AudioRouteRecord &inRoute, short inTrackVolume, short inTrackBalance, short &outVolume, short &outBalance);
+
+		OSErr Save(Handle *outPreset) const;
+		OSErr Load(Handle inPreset);
+
+	private:
+		// nope
+		CVideoOutputAudioRouting(const CVideoOutputAudioRouting &inRouting);
+		CVideoOutputAudioRouting operator=(CVideoOutputAudioRouting inRouting);
+
+	private:
+		typedef struct {
+			OSType	signature;
+			UInt32	version;
+			UInt32	routeCount;
+		} PresetHeaderRecord;
+
+		typedef struct {
+			UInt16	soundTrack;
+			UInt16	output;
+			SInt16	leftGain;
+			SInt16	rightGain;
+		} PresetRouteRecord;
+
+		AudioRouteRecord	mRoutes[kMaxAudioRoutes];
+		Boolean				mIsRouted[kMaxAudioRoutes];
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTAUDIOROUTING_H__
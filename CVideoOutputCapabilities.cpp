@@ -0,0 +1,187 @@
+/*
+	File:		 CVideoOutputCapabilities.cpp
+	
+	Description: Per component capability cache for the video output.
+				 See CVideoOutputCapabilities.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 AskSoundOutput split out of AskComponent
+										<2> 10/19/26 ask for the sample sizes and channels too
+										<1> 10/19/26 initial release
+*/
+
+#include <algorithm>
+
+#include "CVideoOutputCapabilities.h"
+
+using namespace dts;
+
+CVideoOutputCapabilities::CacheEntry CVideoOutputCapabilities::sCache[kMaxCachedComponents];
+
+OSErr CVideoOutputCapabilities::GetCapabilities(OSType inSubType, ComponentInstance inInstance, CapabilityRecord &outCapabilities)
+{
+	OSErr err;
+
+	// Already asked, an entry doesn't change once it's ready
+	for (UInt32 i = 0; i < kMaxCachedComponents; i++) {
+		const CacheEntry &theEntry = sCache[i];
+
+		if (*(volatile UInt32 *)&theEntry.state == eEntryReady && theEntry.capabilities.subType == inSubType) {
+			outCapabilities = theEntry.capabilities;
+			return noErr;
+		}
+	}
+
+	err = AskComponent(inSubType, inInstance, outCapabilities);
+	if (err) return err;
+
+	// Keep it in the first empty entry, if two threads get here for the same subType it's in there twice
+	for (UInt32 i = 0; i < kMaxCachedComponents; i++) {
+		CacheEntry &theEntry = sCache[i];
+
+		if (::CompareAndSwap(eEntryEmpty, eEntryFilling, &theEntry.state)) {
+			theEntry.capabilities = outCapabilities;
+
+			// CompareAndSwap orders the capabilities before the state the lookup checks
+			::CompareAndSwap(eEntryFilling, eEntryReady, &theEntry.state);
+			break;
+		}
+	}
+
+	return noErr;
+}
+
+UnsignedFixed CVideoOutputCapabilities::FindSampleRate(const CapabilityRecord &inCapabilities, UnsignedFixed inRate)
+{
+	const UnsignedFixed *pFirst = inCapabilities.sampleRates;
+	const UnsignedFixed *pLast = inCapabilities.sampleRates + inCapabilities.sampleRateCount;
+
+	if (0 == inCapabilities.sampleRateCount) return 0;
+
+	const UnsignedFixed *pFound = std::lower_bound(pFirst, pLast, inRate);
+
+	return (pFound == pLast) ? *(pLast - 1) : *pFound;
+}
+
+UInt16 CVideoOutputCapabilities::FindSampleSize(const CapabilityRecord &inCapabilities, UInt16 inSampleSize)
+{
+	const UInt16 *pFirst = inCapabilities.sampleSizes;
+	const UInt16 *pLast = inCapabilities.sampleSizes + inCapabilities.sampleSizeCount;
+
+	if (0 == inCapabilities.sampleSizeCount || 0 == inSampleSize) return 0;
+
+	const UInt16 *pFound = std::lower_bound(pFirst, pLast, inSampleSize);
+
+	return (pFound == pLast) ? *(pLast - 1) : *pFound;
+}
+
+UInt16 CVideoOutputCapabilities::FindChannels(const CapabilityRecord &inCapabilities, UInt16 inChannels)
+{
+	if (0 == inCapabilities.channels) return 0;
+
+	return (inChannels < inCapabilities.channels) ? inChannels : inCapabilities.channels;
+}
+
+OSErr CVideoOutputCapabilities::AskComponent(OSType inSubType, ComponentInstance inInstance, CapabilityRecord &outCapabilities)
+{
+	OSErr err = noErr;
+
+	outCapabilities.subType = inSubType;
+	outCapabilities.canDoEchoPort = ::ComponentFunctionImplemented(inInstance, kQTVideoOutputSetEchoPortSelect);
+	outCapabilities.hasClock = ::ComponentFunctionImplemented(inInstance, kQTVideoOutputGetClockSelect);
+	outCapabilities.soundOutput = NULL;
+	outCapabilities.sampleRateCount = 0;
+	outCapabilities.sampleSizeCount = 0;
+	outCapabilities.channels = 0;
+
+	// Does this Video Output Component have a Sound Output Component associated with it?
+	if (::ComponentFunctionImplemented(inInstance, kQTVideoOutputGetIndSoundOutputSelect))
+		::QTVideoOutputGetIndSoundOutput(inInstance, 1, &outCapabilities.soundOutput);
+
+	if (outCapabilities.soundOutput) err = AskSoundOutput(outCapabilities.soundOutput, outCapabilities);
+
+	return err;
+}
+
+OSErr CVideoOutputCapabilities::AskSoundOutput(Component inSoundOutput, CapabilityRecord &ioCapabilities)
+{
+	SoundInfoList theInfoList;
+	UInt16		  theCount;
+	short		  theChannels = 0;
+	OSErr		  err;
+
+	ioCapabilities.sampleRateCount = 0;
+	ioCapabilities.sampleSizeCount = 0;
+	ioCapabilities.channels = 0;
+
+	if (NULL == inSoundOutput) return paramErr;
+
+	err = ::GetSoundOutputInfo(inSoundOutput, siSampleRateAvailable, &theInfoList);
+	if (err) return err;
+
+	UnsignedFixedPtr pRates = reinterpret_cast<UnsignedFixedPtr>(*(theInfoList.infoHandle));
+	theCount = (theInfoList.count < kMaxSampleRates) ? theInfoList.count : kMaxSampleRates;
+
+	::BlockMoveData(pRates, ioCapabilities.sampleRates, theCount * sizeof(UnsignedFixed));
+	::DisposeHandle(theInfoList.infoHandle);
+
+	std::sort(ioCapabilities.sampleRates, ioCapabilities.sampleRates + theCount);
+	ioCapabilities.sampleRateCount = theCount;
+
+	// Not every sound output says what sample sizes and channels it takes, that's not an error
+	if (noErr == ::GetSoundOutputInfo(inSoundOutput, siSampleSizeAvailable, &theInfoList)) {
+		short *pSizes = reinterpret_cast<short *>(*(theInfoList.infoHandle));
+		theCount = (theInfoList.count < kMaxSampleSizes) ? theInfoList.count : kMaxSampleSizes;
+
+		for (UInt16 i = 0; i < theCount; i++) ioCapabilities.sampleSizes[i] = pSizes[i];
+		::DisposeHandle(theInfoList.infoHandle);
+
+		std::sort(ioCapabilities.sampleSizes, ioCapabilities.sampleSizes + theCount);
+		ioCapabilities.sampleSizeCount = theCount;
+	}
+
+	if (noErr == ::GetSoundOutputInfo(inSoundOutput, siChannelAvailable, &theChannels) && theChannels > 0)
+		ioCapabilities.channels = theChannels;
+
+	return noErr;
+}
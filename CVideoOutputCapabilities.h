@@ -0,0 +1,136 @@
+/*
+	File:		 CVideoOutputCapabilities.h
+	
+	Description: What each video output component can do, asked once per component subType and kept for
+				 every Begin() after that. Used by the CVideoOutput class.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 added AskSoundOutput
+										<2> 10/19/26 added the sample sizes and channels, FindSampleSize and FindChannels
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	GetCapabilities(OSType inSubType, ComponentInstance inInstance, CapabilityRecord &outCapabilities)
+		Copies out what the component of inSubType can do, echo port, clock, its sound output component
+		and the sample rates, sample sizes and number of channels that takes. The first time for a subType the component is asked through
+		inInstance, which must have had QTVideoOutputBegin() called for the sound output to answer, and
+		the answer is kept for the rest of the run. An error getting the sample rates is returned and
+		nothing is kept, so the next call asks again. Takes no locks, it's called on the device task.
+
+	AskSoundOutput(Component inSoundOutput, CapabilityRecord &ioCapabilities)
+		Fills in the sample rates, sample sizes and channels of any sound output, the other sound outputs
+		of a video output component for example. Nothing is kept, it asks every time. Returns the error
+		getting the sample rates, the sample sizes and channels are left at 0 if the sound output doesn't say.
+
+	FindSampleRate(const CapabilityRecord &inCapabilities, UnsignedFixed inRate)
+		A binary search of the sample rates for inRate. If the sound output doesn't take it, the lowest
+		rate above it, or the highest there is when they're all below. 0 with no sample rates.
+
+	FindSampleSize(const CapabilityRecord &inCapabilities, UInt16 inSampleSize)
+		The same for a sample size in bits, 0 when the sound output doesn't say or inSampleSize is 0.
+
+	FindChannels(const CapabilityRecord &inCapabilities, UInt16 inChannels)
+		inChannels, or as many as the sound output has if that's fewer. 0 when it doesn't say or inChannels
+		is 0.
+*/
+
+#ifndef __CVIDEOOUTPUTCAPABILITIES_H__
+	#define __CVIDEOOUTPUTCAPABILITIES_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <QuickTimeComponents.h>
+	#include <Sound.h>
+#endif
+
+namespace dts {
+
+const UInt32 kMaxCachedComponents = 16;		// subTypes after this are asked every time
+const UInt16 kMaxSampleRates = 16;
+const UInt16 kMaxSampleSizes = 8;
+
+typedef struct {
+	OSType			subType;
+	Boolean			canDoEchoPort;
+	Boolean			hasClock;
+	Component		soundOutput;			// NULL for none
+	UInt16			sampleRateCount;
+	UnsignedFixed	sampleRates[kMaxSampleRates];	// lowest first
+	UInt16			sampleSizeCount;		// 0 when the sound output doesn't say
+	UInt16			sampleSizes[kMaxSampleSizes];	// bits, lowest first
+	UInt16			channels;				// the most it takes, 0 when it doesn't say
+} CapabilityRecord;
+
+class CVideoOutputCapabilities {
+	public:
+		static OSErr GetCapabilities(OSType inSubType, ComponentInstance inInstance, CapabilityRecord &outCapabilities);
+		static OSErr AskSoundOutput(Component inSoundOutput, CapabilityRecord &ioCapabilities);
+		static UnsignedFixed FindSampleRate(const CapabilityRecord &inCapabilities, UnsignedFixed inRate);
+		static UInt16 FindSampleSize(const CapabilityRecord &inCapabilities, UInt16 inSampleSize);
+		static UInt16 FindChannels(const CapabilityRecord &inCapabilities, UInt16 inChannels);
+
+	private:
+		static OSErr AskComponent(OSType inSubType, ComponentInstance inInstance, CapabilityRecord &outCapabilities);
+
+		// nope
+		CVideoOutputCapabilities();
+
+	private:
+		enum { eEntryEmpty = 0, eEntryFilling, eEntryReady };
+
+		struct CacheEntry {
+			UInt32				state;			// atomic, eEntryEmpty to eEntryFilling to eEntryReady
+			CapabilityRecord	capabilities;
+		};
+
+		static CacheEntry	sCache[kMaxCachedComponents];
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTCAPABILITIES_H__
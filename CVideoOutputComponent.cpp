@@ -9,7 +9,7 @@
 
 	Version:	2.0.6
 
-	Copyright: 	 Copyright 2001-2005 Apple Computer, Inc. All rights reserved.
+	Copyright: 	© Copyright 2001-2005 Apple Computer, Inc. All rights reserved.
 	
 	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
 				("Apple") in consideration of your agreement to the following terms, and your
@@ -18,7 +18,7 @@
 				please do not use, install, modify or redistribute this Apple software.
 
 				In consideration of your agreement to abide by the following terms, and subject
-				to these terms, Apple grants you a personal, non-exclusive license, under Apples
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
 				copyrights in this original Apple software (the "Apple Software"), to use,
 				reproduce, modify and redistribute the Apple Software, with or without
 				modifications, in source and/or binary forms; provided that if you redistribute
@@ -46,7 +46,11 @@
 				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
 				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 				
-	Change History (most recent first): <5> 07/29/05 added endian macros for mode data
+	Change History (most recent first): <8> 10/19/26 added IsThreadSafe
+										<7> 10/19/26 open the Component kept by the registry instead of finding it again
+										<6> 10/19/26 component and mode lists moved into CVideoOutputRegistry,
+													 no limit on the number of components
+										<5> 07/29/05 added endian macros for mode data
 										<4> 10/02/04 check return code from QTVideoOutputGetDisplayModeList
 										<3> 09/26/02 for CW 8.2 MSL remove calls to num2dec and dec2str
 										<2> 06/ 4/02 don't crash if VOut has a bad mode list
@@ -60,83 +64,22 @@
 using namespace dts;
 
 #ifdef _CSTD
-	using _CSTD::strncpy;
 	using _CSTD::sprintf;
 #endif
 
-CVideoOutputComponent::CVideoOutputComponent() throw(ComponentResult): mComponent(0), mComponentInstance(0), mComponentList(NULL), mTotalNumOfComponents(0),
-															            mWhichComponentIndex(1), mWhichModeIndex(1), mDialogRef(NULL)
+// The registry throws if there are no Video Output Components at all
+CVideoOutputComponent::CVideoOutputComponent() throw(ComponentResult): mComponent(0), mComponentInstance(0), mWhichComponentIndex(1), mWhichModeIndex(1),
+																		mDialogRef(NULL)
 {
-	ComponentDescription cd = {QTVideoOutputComponentType, 0, 0, 0L, kQTVideoOutputDontDisplayToUser};
-	QTAtomContainer 	 modeListAtomContainer = NULL;
-	UInt8 				 componentIndex = 0;
-	ComponentResult		 rc = badComponentType;
-	
-	mComponentList = (ComponentListPtr)::NewPtrClear(sizeof(ComponentListRecord) * kMaxNumberOfComponents);
-	if (NULL == mComponentList) throw (rc = ::MemError());
-	
-	while ((mComponent = ::FindNextComponent(mComponent, &cd))) {
-		if (componentIndex < kMaxNumberOfComponents) {
-			ComponentDescription cInfo;
-			Handle hComponentName = ::NewHandle(0);
-			if (NULL == hComponentName) throw (rc = ::MemError());
-			
-			::GetComponentInfo(mComponent, &cInfo, hComponentName, NULL, NULL);
-			mComponentList[componentIndex].hName = hComponentName;
-			mComponentList[componentIndex].subType = cInfo.componentSubType;
-			
-			rc = ::QTVideoOutputGetDisplayModeList((ComponentInstance)mComponent, &modeListAtomContainer);
-			if (noErr == rc && NULL != modeListAtomContainer) {
-				mComponentList[componentIndex].numberOfModes =::QTCountChildrenOfType(modeListAtomContainer, kParentAtomIsContainer, kQTVODisplayModeItem); 
-				mComponentList[componentIndex].pDisplayModeList = GetFirstLevelAtoms(modeListAtomContainer, mComponentList[componentIndex].numberOfModes);
-				::QTDisposeAtomContainer(modeListAtomContainer);
-				modeListAtomContainer = NULL;
-			} else {
-				// This VOut component has no mode list !! BAD !!
-				mComponentList[componentIndex].numberOfModes = 0;
-				mComponentList[componentIndex].pDisplayModeList = (DisplayModeAtomPtr)NewPtrClear(sizeof(DisplayModeAtomRecord));
-				mComponentList[componentIndex].pDisplayModeList->pixelType = 'BAD ';
-			}
-			componentIndex++;
-		}
-    }
-    
-    mTotalNumOfComponents = componentIndex;
-    
     // We have at least one Video Output Component available
     // Select the first one as a default
-    try { 
-	    if (mTotalNumOfComponents) {
-			cd.componentSubType = mComponentList[mWhichComponentIndex-1].subType;
-			
-			mComponent = ::FindNextComponent(0, &cd);
-			if (0 == mComponent) throw (rc);
-	   	} else {
-			throw (rc);
-		}
-	}
-	catch (ComponentResult) {
-		this->~CVideoOutputComponent();
-		throw;
-	}	
+	mComponent = mRegistry.GetComponent(mWhichComponentIndex-1);
+	if (0 == mComponent) throw (ComponentResult)badComponentType;
 }
 
 CVideoOutputComponent::~CVideoOutputComponent()
 {
-	UInt8 componentIndex;
-	
 	CloseComponent();
-	
-	if (mComponentList) {
-	    for (componentIndex = 0; componentIndex < mTotalNumOfComponents; componentIndex++) {
-	    	if (mComponentList[componentIndex].hName)
-	    		::DisposeHandle(mComponentList[componentIndex].hName);
-	    	if (mComponentList[componentIndex].pDisplayModeList)
-	    		::DisposePtr((Ptr)mComponentList[componentIndex].pDisplayModeList);
-	    }
-	    
-	    ::DisposePtr((Ptr)mComponentList);
-	}
 }
 
 #pragma mark-
@@ -163,6 +106,29 @@ void CVideoOutputComponent::CloseComponent(void)
 	}
 }
 
+// Returns the global registry index of the chosen mode, components without a
+// mode list all share the registry's bad mode placeholder
+UInt16 CVideoOutputComponent::GetSelectedMode(void) const
+{
+	UInt16 theComponent = mWhichComponentIndex-1;
+	
+	if (0 == mRegistry.GetModeCount(theComponent) || 0 == mWhichModeIndex)
+		return mRegistry.GetFirstMode(theComponent);
+	
+	return mRegistry.GetFirstMode(theComponent) + mWhichModeIndex-1;
+}
+
+// The component says it can be called from threads other than the main one, the instance opened
+// here can then be used on another thread while this one keeps its hands off it
+Boolean CVideoOutputComponent::IsThreadSafe(void) const
+{
+	ComponentDescription theDescription;
+	
+	if (NULL == mComponent || ::GetComponentInfo(mComponent, &theDescription, NULL, NULL, NULL)) return false;
+	
+	return (theDescription.componentFlags & cmpThreadSafe) != 0;
+}
+
 OSErr CVideoOutputComponent::DoSettingsDialog(void)
 {
 	ControlRef	  componentListControlRef = NULL,
@@ -185,14 +151,14 @@ OSErr CVideoOutputComponent::DoSettingsDialog(void)
 	err = ::GetDialogItemAsControl(mDialogRef, kComponentListPopUpDialogItem, &componentListControlRef);
 	if (err) goto bail;
 	
-	::SetControlMaximum(componentListControlRef, kMaxNumberOfComponents);
+	::SetControlMaximum(componentListControlRef, mRegistry.GetComponentCount());
 	componentListMenuRef = ::GetControlPopupMenuHandle(componentListControlRef);
 	if (NULL == componentListMenuRef) { err = menuNotFoundErr; goto bail; }
 	
 	err = ::GetDialogItemAsControl(mDialogRef, kModeListPopUpDialogItem, &modeListControlRef);
 	if (err) goto bail;
 	
-	::SetControlMaximum(modeListControlRef, kMaxNumberOfComponents);
+	::SetControlMaximum(modeListControlRef, mRegistry.GetModeCount(mWhichComponentIndex-1));
 	modeListMenuRef = ::GetControlPopupMenuHandle(modeListControlRef);
 	if (NULL == modeListMenuRef) { err = menuNotFoundErr; goto bail; }
 	
@@ -203,15 +169,13 @@ OSErr CVideoOutputComponent::DoSettingsDialog(void)
     ::SetControlCommandID(modeListControlRef, kCommandModeListPopUp);
     ::SetControlCommandID(okButtonControlRef, kHICommandOK);
 	
-	Str255 thePStr;
-    UInt8  componentIndex, modeIndex;
-    for (componentIndex = 0; componentIndex < mTotalNumOfComponents; componentIndex++) {
-		::AppendMenu(componentListMenuRef, (unsigned char *)*mComponentList[componentIndex].hName);
+    UInt16 componentIndex, modeIndex;
+    for (componentIndex = 0; componentIndex < mRegistry.GetComponentCount(); componentIndex++) {
+		::AppendMenu(componentListMenuRef, mRegistry.GetComponentName(componentIndex));
 	}
 	
-	for (modeIndex = 0; modeIndex < mComponentList[mWhichComponentIndex-1].numberOfModes; modeIndex++) {
-		::c2pstrcpy(thePStr, (mComponentList[mWhichComponentIndex-1]).pDisplayModeList[modeIndex].name);		
-		::AppendMenu(modeListMenuRef, thePStr);
+	for (modeIndex = 0; modeIndex < mRegistry.GetModeCount(mWhichComponentIndex-1); modeIndex++) {
+		::AppendMenu(modeListMenuRef, mRegistry.GetModeName(mRegistry.GetFirstMode(mWhichComponentIndex-1) + modeIndex));
 	}
     
     ::SetControlValue(componentListControlRef, mWhichComponentIndex);
@@ -227,11 +191,8 @@ OSErr CVideoOutputComponent::DoSettingsDialog(void)
 	::RunAppModalLoopForWindow(GetDialogWindow(mDialogRef));
 	
 	// Apply the new selection
-    { // gcc complains without this in brackets
-	ComponentDescription cd = {QTVideoOutputComponentType, mComponentList[mWhichComponentIndex-1].subType, 0, 0L, kQTVideoOutputDontDisplayToUser};
-	mComponent = ::FindNextComponent(0, &cd);
+	mComponent = mRegistry.GetComponent(mWhichComponentIndex-1);
 	if (0 == mComponent) err = badComponentType;
-    }
   
 bail:
 	if (mDialogRef) {
@@ -247,27 +208,47 @@ bail:
 	return err; 
 }
 
+// Select a mode (a global registry index) without going through the dialog, the
+// dialog will show this selection the next time it's displayed
+OSErr CVideoOutputComponent::SelectDisplayMode(UInt16 inMode)
+{
+	Component theComponent;
+	UInt16	  theComponentIndex;
+	
+	if (inMode >= mRegistry.GetTotalModeCount()) return paramErr;
+	
+	theComponentIndex = mRegistry.GetModeComponent(inMode);
+	
+	theComponent = mRegistry.GetComponent(theComponentIndex);
+	if (0 == theComponent) return badComponentType;
+	
+	mComponent = theComponent;
+	mWhichComponentIndex = theComponentIndex + 1;
+	mWhichModeIndex = inMode - mRegistry.GetFirstMode(theComponentIndex) + 1;
+	
+	return noErr;
+}
+
 #pragma mark-
 
-void CVideoOutputComponent::UpdateModeListPopUp(UInt8 inValue)
+void CVideoOutputComponent::UpdateModeListPopUp(UInt16 inValue)
 {
 	ControlRef modeListControlRef;
 	MenuRef	   modeListMenuRef;
-	UInt8	   modeIndex;
-	Str255 	   thePStr;
+	UInt16	   modeIndex;
 
 	::GetDialogItemAsControl(mDialogRef, kModeListPopUpDialogItem, &modeListControlRef);	
 	modeListMenuRef = ::GetControlPopupMenuHandle(modeListControlRef);
 	::SetControlValue(modeListControlRef, 1);
 	
-	for (modeIndex = 0; modeIndex < mComponentList[mWhichComponentIndex-1].numberOfModes; modeIndex++) {
+	for (modeIndex = 0; modeIndex < mRegistry.GetModeCount(mWhichComponentIndex-1); modeIndex++) {
 		::DeleteMenuItem(modeListMenuRef, 1);
 	}
 	
-	for (modeIndex = 0; modeIndex < mComponentList[inValue-1].numberOfModes; modeIndex++) {
-		::c2pstrcpy(thePStr, (mComponentList[inValue-1]).pDisplayModeList[modeIndex].name);		
-		::AppendMenu(modeListMenuRef, thePStr);
+	for (modeIndex = 0; modeIndex < mRegistry.GetModeCount(inValue-1); modeIndex++) {
+		::AppendMenu(modeListMenuRef, mRegistry.GetModeName(mRegistry.GetFirstMode(inValue-1) + modeIndex));
 	}
+	::SetControlMaximum(modeListControlRef, mRegistry.GetModeCount(inValue-1));
 	
 	::DrawOneControl(modeListControlRef);
 }
@@ -278,22 +259,22 @@ void CVideoOutputComponent::UpdateDialogTextItems(void)
 	char    tempStr[8];
 	double  tempDbl;
 	
-    DisplayModeAtomPtr pModeListData = mComponentList[mWhichComponentIndex-1].pDisplayModeList;
+    UInt16 theMode = GetSelectedMode();
     
 	// Display atom info in fields
-	NumToString(pModeListData[mWhichModeIndex-1].width, thePStr);
+	NumToString(mRegistry.GetModeWidth(theMode), thePStr);
 	SetText(kModeWidthItem, thePStr);
 
-	NumToString(pModeListData[mWhichModeIndex-1].height, thePStr);
+	NumToString(mRegistry.GetModeHeight(theMode), thePStr);
 	SetText(kModeHeightItem, thePStr);
 
-	NumToString(Fix2Long(pModeListData[mWhichModeIndex-1].hRes), thePStr);
+	NumToString(Fix2Long(mRegistry.GetModeHRes(theMode)), thePStr);
 	SetText(kModeHResItem, thePStr);
 
-	NumToString(Fix2Long(pModeListData[mWhichModeIndex-1].vRes), thePStr);
+	NumToString(Fix2Long(mRegistry.GetModeVRes(theMode)), thePStr);
 	SetText(kModeVRestItem, thePStr);
 	
-	tempDbl = Fix2X(pModeListData[mWhichModeIndex-1].refreshRate);
+	tempDbl = Fix2X(mRegistry.GetModeRefreshRate(theMode));
 	sprintf(tempStr, "%.2lf", tempDbl);
 	CopyCStringToPascal(tempStr, thePStr);
 	SetText(kModeRefreshRateItem, thePStr);
@@ -303,12 +284,12 @@ void CVideoOutputComponent::UpdateDialogTextItems(void)
     // Values of 33, 34, 36 and 40 specify standard Mac OS gray-scale pixel formats with
     // depths of 1, 2, 4, and 8 bits per pixel. 
     // Other pixel formats are specified by four-character codes.
-	if (pModeListData[mWhichModeIndex-1].pixelType <= 40) {
-		NumToString(pModeListData[mWhichModeIndex-1].pixelType, thePStr);
+	if (mRegistry.GetModePixelType(theMode) <= 40) {
+		NumToString(mRegistry.GetModePixelType(theMode), thePStr);
 		SetText(kModePixelTypeItem, thePStr);
 	} else {
 		char thePixelType[5] = { 0x04 };
-		*(OSType *)&thePixelType[1] = EndianU32_NtoB(pModeListData[mWhichModeIndex-1].pixelType);
+		*(OSType *)&thePixelType[1] = EndianU32_NtoB(mRegistry.GetModePixelType(theMode));
 		SetText(kModePixelTypeItem, (unsigned char *)&thePixelType[0]);
 	}
 }
@@ -321,105 +302,6 @@ void CVideoOutputComponent::SetText(UInt8 inItem, Str255 inString)
 	::SetDialogItemText((Handle)theControl, inString);
 }
 
-// First level:
-//		Children of the container are of type:
-//		kQTVODisplayModeItem
-// At the root of the QT atom container returned by QTVideoOutputGetDisplayModeList()
-// are one or more atoms of type kQTVODisplayModeItem
-DisplayModeAtomPtr CVideoOutputComponent::GetFirstLevelAtoms(QTAtomContainer container, UInt8 inNumberOfModes)
-{
-	DisplayModeAtomPtr pModeListData = NULL;
-	QTAtom 			   atomDisplay = 0, nextAtomDisplay = 0;
-	UInt8			   i = 0;
-	QTAtomType		   type;
-	QTAtomID		   id;
-	OSErr			   err;
-	
-	// Allocate display structs to hold info found in container
-	pModeListData = (DisplayModeAtomPtr)NewPtrClear(sizeof(DisplayModeAtomRecord) * inNumberOfModes);
-	
-	while (i < inNumberOfModes) {
-	
-		err = QTNextChildAnyType(container, kParentAtomIsContainer, atomDisplay, &nextAtomDisplay);
-										
-		// Make sure its a display atom
-		err = QTGetAtomTypeAndID(container, nextAtomDisplay, &type, &id);
-		if (type != kQTVODisplayModeItem) continue;														
-		
-		// Get children of this display atom										
-		atomDisplay = nextAtomDisplay;										
-		GetSecondLevelAtoms(&pModeListData[i], atomDisplay, container);
-		i++;
-	}
-	
-	return pModeListData;
-}
-
-// Second level:
-//		Children of the kQTVODisplayModeItem atom are of type:
-// 		kQTVODimensions
-//		kQTVOResolution
-//		kQTVORefreshRate
-//		kQTVOPixelType
-//		kQTVOName
-// 		kQTVODecompressors atom(s)
-void CVideoOutputComponent::GetSecondLevelAtoms(DisplayModeAtomPtr myPtr, QTAtom parentAtom, QTAtomContainer container)
-{
-	QTAtom atom;
-	long   dataSize, *dataPtr;
-	OSErr  err;
-						
-	// ******************* kQTVODimensions
-	atom = QTFindChildByID(container, parentAtom, kQTVODimensions, 1, NULL);
-	err = QTGetAtomDataPtr(container, atom, &dataSize, (Ptr *)&dataPtr);
-	if (noErr == err) {
-		myPtr->width  = EndianS32_BtoN(dataPtr[0]);
-		myPtr->height = EndianS32_BtoN(dataPtr[1]);
-	}		
-
-	// ******************* kQTVOResolution
-	atom = QTFindChildByID( container, parentAtom, kQTVOResolution, 1, NULL);
-	err = QTGetAtomDataPtr( container, atom, &dataSize, (Ptr *)&dataPtr);
-	if (noErr == err) {
-		myPtr->hRes = EndianS32_BtoN(dataPtr[0]);
-		myPtr->vRes = EndianS32_BtoN(dataPtr[1]);
-	}		
-
-	// ******************* kQTVORefreshRate
-	atom = QTFindChildByID(container, parentAtom, kQTVORefreshRate, 1, NULL);
-	err = QTGetAtomDataPtr(container, atom, &dataSize, (Ptr *)&dataPtr);
-	if (noErr == err) {
-		myPtr->refreshRate = EndianS32_BtoN(dataPtr[0]);
-	}
-
-	// ******************* kQTVOPixelType
-	atom = QTFindChildByID(container, parentAtom, kQTVOPixelType, 1, NULL);
-	err = QTGetAtomDataPtr(container, atom, &dataSize, (Ptr *)&dataPtr);
-	if (noErr == err) {
-		myPtr->pixelType = EndianU32_BtoN(dataPtr[0]);
-	}			
-
-	// ******************* kQTVOName
-	atom = QTFindChildByID(container, parentAtom, kQTVOName, 1, NULL);
-	err = QTGetAtomDataPtr(container, atom, &dataSize, (Ptr*)&dataPtr);
-	if (noErr == err) {
-		strncpy((char *)myPtr->name, (char *)dataPtr, dataSize);
-	}
-	myPtr->name[dataSize] = '\0';
-
-	// ******************* kQTVODecompressors
-	// We don't care about the kQTVODecompressors atom(s) in this sample, if we did we
-	// would need to go down another level and muck about in much the same fashion.
-	// Because kQTVODecompressors atoms are not required to have consecutive IDs, use
-	// QTFindChildByIndex to iterate through the decompressors.
-	
-	// Third level:
-	//		Children of the kQTVODecompressors atom are of type:
-	//		kQTVODecompressorType
-	//		kQTVODecompressorComponent
-	//		kQTVODecompressorContinuous
-}
-
 pascal OSStatus dts::DialogEventHandler(EventHandlerCallRef inHandlerCallRef, EventRef inEvent, void *inUserData)
 {
 #pragma unused(inHandlerCallRef)
@@ -440,7 +322,7 @@ pascal OSStatus dts::DialogEventHandler(EventHandlerCallRef inHandlerCallRef, Ev
 		case kCommandComponentListPopUp:
 		{ // gcc complains without this in brackets
 			::GetDialogItemAsControl(pUserData->mDialogRef, kComponentListPopUpDialogItem, &theControlRef);
-			UInt8 theNewValue = ::GetControlValue(theControlRef);
+			UInt16 theNewValue = ::GetControlValue(theControlRef);
 			
 			// If a new component was chosen from the list, update the mode list popup for that component
 			if (theNewValue != pUserData->mWhichComponentIndex) {
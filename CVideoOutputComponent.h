@@ -9,7 +9,7 @@
 				
 	Version:	2.0.5
 
-	Copyright: 	 Copyright 2001 Apple Computer, Inc. All rights reserved.
+	Copyright: 	© Copyright 2001 Apple Computer, Inc. All rights reserved.
 	
 	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
 				("Apple") in consideration of your agreement to the following terms, and your
@@ -18,7 +18,7 @@
 				please do not use, install, modify or redistribute this Apple software.
 
 				In consideration of your agreement to abide by the following terms, and subject
-				to these terms, Apple grants you a personal, non-exclusive license, under Apples
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
 				copyrights in this original Apple software (the "Apple Software"), to use,
 				reproduce, modify and redistribute the Apple Software, with or without
 				modifications, in source and/or binary forms; provided that if you redistribute
@@ -46,7 +46,11 @@
 				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
 				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 				
-	Change History (most recent first): <1> 11/19/01 initial release
+	Change History (most recent first): <5> 10/19/26 added IsThreadSafe
+										<4> 10/19/26 added GetComponentSubType
+										<3> 10/19/26 added SelectDisplayMode
+										<2> 10/19/26 components and modes come from CVideoOutputRegistry
+										<1> 11/19/01 initial release
 
 */
 
@@ -63,10 +67,10 @@
 #include <memory>
 
 #include "GetFile.h"
+#include "CVideoOutputRegistry.h"
 
 namespace dts {
 
-const UInt8  kMaxNumberOfComponents = 10;
 const UInt16 kComponentDialogResource = 5000;
 
 const UInt8 kOKButtonItem = 1;
@@ -82,37 +86,6 @@ const UInt8 kModePixelTypeItem = 9;
 const UInt32 kCommandComponentListPopUp = FOUR_CHAR_CODE('Itm1');
 const UInt32 kCommandModeListPopUp = FOUR_CHAR_CODE('Itm2');
 
-/*typedef struct {
-	OSType					codecType; 		// specifies the type of compressed data
-									   		// that the decompressor can decompress
-	DecompressorComponent	codecComponent;	// optional - a decompressor component can be used to decompress
-											// the data specified by the corresponding codecType
-	Boolean					continuous;		// optional - specifies whether the resulting video display will be continuous
-											// true = data will be displayed without any visual gaps between successive images
-											// false = data will be displayed, but there may be a visual gap (such as a black screen)
-											// between the display of images - if this atom doesn't exist you should not make any
-											// assumptions about the performance of the decompressor
-} DecompressorAtomRecord, *DecompressorAtomPtr;*/
-
-typedef struct {
-	long	width, height;	// pixels of the display
-	Fixed	hRes, vRes; 	// pixels per inch
-	Fixed	refreshRate;	// refresh rate
-	OSType	pixelType;		// type of pixel used by display format:
-							// 		1,2,4,8,16,24,32 :: standard bit depths
-							//		33,34,36,40 :: gray-scale pixel depths
-							//      of 1,2,4,8
-	char	name[50];		// name of display mode
-	// DecompressorAtomPtr pDecompressorAtom; // not used in this sample		
-} DisplayModeAtomRecord, *DisplayModeAtomPtr;
-
-typedef struct {
-	Handle				hName;
-	OSType		  		subType;
-	UInt8				numberOfModes;
-	DisplayModeAtomPtr	pDisplayModeList;
-} ComponentListRecord, *ComponentListPtr;
-
 class CVideoOutputComponent {
 	public:
 		CVideoOutputComponent() throw(ComponentResult);
@@ -122,16 +95,19 @@ class CVideoOutputComponent {
 		void  CloseComponent(void);
 		
 		OSErr DoSettingsDialog(void);
+		OSErr SelectDisplayMode(UInt16 inMode);
 
 		const QTVideoOutputComponent GetComponentInstance(void) const { return mComponentInstance; }
-		UInt8 GetDisplayMode(void) const { return mWhichModeIndex; }
+		long  GetDisplayMode(void) const { return mRegistry.GetModeID(GetSelectedMode()); }
+		UInt16 GetSelectedMode(void) const;
+		OSType GetComponentSubType(void) const { return mRegistry.GetComponentSubType(mWhichComponentIndex-1); }
+		Boolean IsThreadSafe(void) const;
+		const CVideoOutputRegistry &GetRegistry(void) const { return mRegistry; }
 		
 	private:
-		void UpdateModeListPopUp(UInt8 inValue);
+		void UpdateModeListPopUp(UInt16 inValue);
 		void UpdateDialogTextItems(void);
 		void SetText(UInt8 inItem, Str255 inString);
-		DisplayModeAtomPtr GetFirstLevelAtoms(QTAtomContainer container, UInt8 inNumberOfModes);
-		void GetSecondLevelAtoms(DisplayModeAtomPtr myPtr, QTAtom parentAtom, QTAtomContainer container);
 
 		friend pascal OSStatus DialogEventHandler(EventHandlerCallRef inHandlerCallRef, EventRef inEvent, void *inUserData);
 		
@@ -140,12 +116,11 @@ class CVideoOutputComponent {
 		CVideoOutputComponent operator=(CVideoOutputComponent inVOObject);
 
 	private:
+		CVideoOutputRegistry	mRegistry;
 		Component				mComponent;
 		QTVideoOutputComponent  mComponentInstance;
-		ComponentListPtr		mComponentList;
-		UInt8					mTotalNumOfComponents;
-		UInt8					mWhichComponentIndex;
-		UInt8					mWhichModeIndex;
+		UInt16					mWhichComponentIndex;
+		UInt16					mWhichModeIndex;
 		DialogRef				mDialogRef;
 };
 
@@ -0,0 +1,327 @@
+/*
+	File:		 CVideoOutputCue.cpp
+	
+	Description: Cue to a frame or timecode and start on the output clock.
+				 See CVideoOutputCue.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 StartAtTime returns straight away, a time base callback starts the movie
+										<1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputCue.h"
+
+using namespace dts;
+
+CVideoOutputCue::CVideoOutputCue() : mMovie(NULL), mCueTime(0), mRate(fixed1), mFrameDuration(0), mClock(NULL), mTimeBase(NULL), mCallBack(NULL),
+									 mCallBackUPP(NULL), mStartTime(0), mStartedProc(NULL), mStartedRefCon(NULL)
+{
+	mStats.lateness = 0;
+	mStats.startError = 0;
+	mStats.wasRealigned = false;
+}
+
+SInt64 CVideoOutputCue::GetScaledTime(const TimeRecord &inTime, TimeScale inScale)
+{
+	SInt64 theValue = ((SInt64)inTime.value.hi << 32) | inTime.value.lo;
+
+	if (inTime.scale <= 0) return 0;
+
+	return (theValue * inScale) / inTime.scale;
+}
+
+#pragma mark-
+
+OSErr CVideoOutputCue::GetFrameTime(const Movie inMovie, long inFrame, TimeValue &outMovieTime)
+{
+	Track	  theTrack;
+	Media	  theMedia;
+	TimeValue theMediaTime = 0;
+	TimeScale theMediaScale;
+
+	// The DV decoder disables the track it draws itself, so don't ask for enabled tracks only
+	theTrack = ::GetMovieIndTrackType(inMovie, 1, VideoMediaType, movieTrackMediaType);
+	if (NULL == theTrack) return invalidTrack;
+
+	theMedia = ::GetTrackMedia(theTrack);
+	if (inFrame < 0 || inFrame >= ::GetMediaSampleCount(theMedia)) return paramErr;
+
+	::SampleNumToMediaTime(theMedia, inFrame + 1, &theMediaTime, NULL);
+
+	// Round up so we land inside the frame if the two time scales don't divide
+	theMediaScale = ::GetMediaTimeScale(theMedia);
+	outMovieTime = ::GetTrackOffset(theTrack) +
+				   (TimeValue)(((SInt64)theMediaTime * ::GetMovieTimeScale(inMovie) + theMediaScale - 1) / theMediaScale);
+
+	return noErr;
+}
+
+OSErr CVideoOutputCue::GetTimecodeFrame(const Movie inMovie, const TimeCodeRecord &inTimecode, long &outFrame)
+{
+	Track theTrack = ::GetMovieIndTrackType(inMovie, 1, TimeCodeMediaType, movieTrackMediaType);
+	OSErr err = noErr;
+
+	if (theTrack) {
+		MediaHandler   theHandler = ::GetMediaHandler(::GetTrackMedia(theTrack));
+		TimeCodeDef	   theDef;
+		TimeCodeRecord theFirstTimecode;
+		TimeCodeRecord theTimecode = inTimecode;
+		long		   theFirstFrame = 0, theFrame = 0;
+
+		// Frames are counted from the timecode the track starts at
+		err = ::TCGetTimeCodeAtTime(theHandler, 0, &theFirstFrame, &theDef, &theFirstTimecode, NULL);
+		if (err) goto bail;
+
+		err = ::TCTimeCodeToFrameNumber(theHandler, &theDef, &theTimecode, &theFrame);
+		if (err) goto bail;
+
+		outFrame = theFrame - theFirstFrame;
+	} else {
+		Track  theVideoTrack = ::GetMovieIndTrackType(inMovie, 1, VideoMediaType, movieTrackMediaType);
+		Media  theMedia;
+		long   theSampleCount;
+		Fixed  theRate;
+		UInt32 theFramesPerSecond, theDropFrames, theMinutes;
+
+		if (NULL == theVideoTrack) { err = invalidTrack; goto bail; }
+
+		theMedia = ::GetTrackMedia(theVideoTrack);
+		theSampleCount = ::GetMediaSampleCount(theMedia);
+		if (theSampleCount <= 0 || ::GetMediaDuration(theMedia) <= 0) { err = invalidMedia; goto bail; }
+
+		theRate = ::X2Fix((double)theSampleCount * ::GetMediaTimeScale(theMedia) / ::GetMediaDuration(theMedia));
+		theFramesPerSecond = (theRate + 0x8000) >> 16;
+
+		// 29.97 and 59.94 drop 2 or 4 frame numbers every minute except every tenth
+		theDropFrames = ((theFramesPerSecond == 30 || theFramesPerSecond == 60) && theRate < (Fixed)(theFramesPerSecond << 16)) ? theFramesPerSecond / 15 : 0;
+
+		if (inTimecode.t.frames >= theFramesPerSecond || inTimecode.t.seconds > 59 || (inTimecode.t.minutes & ~tctNegFlag) > 59) { err = paramErr; goto bail; }
+
+		theMinutes = inTimecode.t.hours * 60 + (inTimecode.t.minutes & ~tctNegFlag);
+		outFrame = (theMinutes * 60 + inTimecode.t.seconds) * theFramesPerSecond + inTimecode.t.frames - theDropFrames * (theMinutes - theMinutes / 10);
+	}
+
+bail:
+	return err;
+}
+
+#pragma mark-
+
+OSErr CVideoOutputCue::Cue(const Movie inMovie, TimeValue inMovieTime, Fixed inRate)
+{
+	Track theTrack;
+	OSErr err;
+
+	Reset();
+
+	if (NULL == inMovie || 0 == inRate) return paramErr;
+
+	::SetMovieRate(inMovie, 0);
+	::SetMovieTimeValue(inMovie, inMovieTime);
+
+	err = ::PrerollMovie(inMovie, inMovieTime, inRate);
+	if (err) goto bail;
+
+	// Put the cued frame up
+	::UpdateMovie(inMovie);
+	::MoviesTask(inMovie, 0);
+
+	// Half of this is as far off the start can be and still show the right frame
+	mFrameDuration = 0;
+	theTrack = ::GetMovieIndTrackType(inMovie, 1, VideoMediaType, movieTrackMediaType);
+	if (theTrack) {
+		Media theMedia = ::GetTrackMedia(theTrack);
+		long  theSampleCount = ::GetMediaSampleCount(theMedia);
+
+		if (theSampleCount > 0) mFrameDuration = (TimeValue)(((SInt64)::GetMediaDuration(theMedia) * ::GetMovieTimeScale(inMovie)) /
+															 ((SInt64)::GetMediaTimeScale(theMedia) * theSampleCount));
+	}
+
+	mMovie = inMovie;
+	mCueTime = inMovieTime;
+	mRate = inRate;
+
+bail:
+	return err;
+}
+
+void CVideoOutputCue::Reset(void)
+{
+	CancelStart();
+	mMovie = NULL;
+}
+
+/* StartAtTime
+		Everything is worked out in movie time. Our own time base is slaved to the clock, so its time is the
+		clock's and a callBackAtTime callback on it comes due at the start time without anyone waiting for it.
+*/
+OSErr CVideoOutputCue::StartAtTime(ComponentInstance inClock, const TimeRecord &inStartTime, CueStartedProcPtr inStartedProc, void *inRefCon)
+{
+	TimeScale  theScale;
+	TimeRecord theClockTime;
+	OSErr	   err = noErr;
+
+	if (NULL == mMovie || NULL == inClock) return paramErr;
+
+	CancelStart();
+
+	theScale = ::GetMovieTimeScale(mMovie);
+	mStartTime = GetScaledTime(inStartTime, theScale);
+	if (mStartTime > 0x7FFFFFFF) return paramErr;
+
+	mClock = inClock;
+	mStartedProc = inStartedProc;
+	mStartedRefCon = inRefCon;
+
+	mTimeBase = ::NewTimeBase();
+	if (NULL == mTimeBase) { err = ::GetMoviesError(); goto bail; }
+
+	::SetTimeBaseMasterClock(mTimeBase, (Component)inClock, NULL);
+	::GetClockTime(inClock, &theClockTime);
+	::SetTimeBaseTime(mTimeBase, &theClockTime);
+	::SetTimeBaseRate(mTimeBase, fixed1);
+
+	// Already there, no point waiting for a callback
+	if (GetScaledTime(theClockTime, theScale) >= mStartTime) {
+		::DisposeTimeBase(mTimeBase);
+		mTimeBase = NULL;
+		Start();
+		return noErr;
+	}
+
+	if (NULL == mCallBackUPP) mCallBackUPP = ::NewQTCallBackUPP(StartCallBack);
+
+	mCallBack = ::NewCallBack(mTimeBase, callBackAtTime);
+	if (NULL == mCallBack) { err = ::GetMoviesError(); goto bail; }
+
+	err = ::CallMeWhen(mCallBack, mCallBackUPP, (long)this, triggerTimeFwd, (long)mStartTime, theScale);
+
+bail:
+	if (err) CancelStart();
+
+	return err;
+}
+
+Boolean CVideoOutputCue::GetTimeUntilStart(long &outDuration, TimeScale inScale) const
+{
+	TimeRecord theClockTime;
+	SInt64	   theNow;
+	TimeScale  theScale;
+
+	if (!IsStarting()) return false;
+
+	theScale = ::GetMovieTimeScale(mMovie);
+	::GetClockTime(mClock, &theClockTime);
+	theNow = GetScaledTime(theClockTime, theScale);
+
+	outDuration = (theNow < mStartTime) ? (long)(((mStartTime - theNow) * inScale) / theScale) : 0;
+
+	return true;
+}
+
+void CVideoOutputCue::CancelStart(void)
+{
+	if (mCallBack) {
+		::CancelCallBack(mCallBack);
+		::DisposeCallBack(mCallBack);
+	}
+	if (mTimeBase) ::DisposeTimeBase(mTimeBase);
+	if (mCallBackUPP) ::DisposeQTCallBackUPP(mCallBackUPP);
+
+	mCallBack = NULL;
+	mTimeBase = NULL;
+	mCallBackUPP = NULL;
+}
+
+pascal void CVideoOutputCue::StartCallBack(QTCallBack /*inCallBack*/, long inRefCon)
+{
+	CVideoOutputCue *pThis = reinterpret_cast<CVideoOutputCue *>(inRefCon);
+
+	// The callback can't be disposed of while it's being called, leave the time base and the callback for
+	// the next StartAtTime() or Reset(). The callback only ever fires the once
+	pThis->Start();
+}
+
+/* Start
+		Where the movie was at the start time can be worked out from where it is now, which is the start
+		error - however late the callback came shows up here.
+*/
+void CVideoOutputCue::Start(void)
+{
+	TimeScale  theScale = ::GetMovieTimeScale(mMovie);
+	TimeRecord theClockTime;
+	SInt64	   theStart = mStartTime, theNow, theError;
+	TimeValue  theMovieTime;
+	ComponentInstance theClock = mClock;
+
+	if (NULL == mMovie) return;
+
+	::SetMovieRate(mMovie, mRate);
+
+	::GetClockTime(theClock, &theClockTime);
+	theMovieTime = ::GetMovieTime(mMovie, NULL);
+	theNow = GetScaledTime(theClockTime, theScale);
+
+	// The movie should be at mCueTime plus the time since the start at mRate
+	theError = (SInt64)mCueTime + (((theNow - theStart) * mRate) / fixed1) - theMovieTime;
+
+	mStats.lateness = (SInt32)(((theNow - theStart) * 1000000) / theScale);
+	mStats.wasRealigned = false;
+
+	if (theError != 0 && ((theError < 0) ? -theError : theError) * 2 >= mFrameDuration) {
+		::SetMovieTimeValue(mMovie, theMovieTime + (TimeValue)theError);
+
+		::GetClockTime(theClock, &theClockTime);
+		theNow = GetScaledTime(theClockTime, theScale);
+		theError = (SInt64)mCueTime + (((theNow - theStart) * mRate) / fixed1) - ::GetMovieTime(mMovie, NULL);
+
+		mStats.wasRealigned = true;
+	}
+
+	mStats.startError = (SInt32)((theError * 1000000) / theScale);
+
+	// Start again from a new Cue()
+	mMovie = NULL;
+
+	if (mStartedProc) (*mStartedProc)(mStartedRefCon);
+}
@@ -0,0 +1,152 @@
+/*
+	File:		 CVideoOutputCue.h
+	
+	Description: Cues a movie to a frame or a SMPTE timecode, prerolls it and starts it at a given time
+				 on the video output component's clock rather than whenever the event loop gets to it.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 StartAtTime returns straight away, a time base callback starts the movie
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	GetFrameTime( const Movie inMovie, long inFrame, TimeValue &outMovieTime )
+		The movie time of frame inFrame (counted from 0) of the first video track, at or just after the start
+		of the frame. Takes the video track to play its media straight through from the track offset, as
+		captured and exported material does.
+
+	GetTimecodeFrame( const Movie inMovie, const TimeCodeRecord &inTimecode, long &outFrame )
+		The frame with timecode inTimecode. Uses the movie's timecode track when it has one, otherwise the movie
+		is taken to start at 00:00:00:00 and count at its own frame rate, drop frame for 29.97 and 59.94.
+
+	Cue( const Movie inMovie, TimeValue inMovieTime, Fixed inRate = fixed1 )
+		Stops the movie, moves it to inMovieTime and prerolls it for inRate so starting it doesn't have to wait
+		for media to load. The cued frame is drawn.
+
+	StartAtTime( ComponentInstance inClock, const TimeRecord &inStartTime, CueStartedProcPtr inStartedProc = NULL, void *inRefCon = NULL )
+		Starts the cued movie so that the cued frame is the one on the output at inStartTime on inClock. The
+		movie should be running on inClock, see CVideoOutput::SetClock(). Returns straight away: a callBackAtTime
+		callback on a time base run by inClock sets the movie going, from MoviesTask() on the main thread, and
+		then calls inStartedProc. Keep idling the movie meanwhile, GetTimeUntilStart() says how soon. Once the
+		movie is going its time line is measured against the clock, and if it's off by half a frame or more (the
+		callback came late) it's put back where it should be. Returns paramErr if nothing is cued. Cue() again or
+		Reset() to call the start off.
+
+	IsStarting( void ) / GetTimeUntilStart( long &outDuration, TimeScale inScale )
+		True between StartAtTime() and the movie starting, and how long there is to go in inScale units.
+
+	GetStats( CueStatsRecord &outStats )
+		How the last StartAtTime() went.
+*/
+
+#ifndef __CVIDEOOUTPUTCUE_H__
+	#define __CVIDEOOUTPUTCUE_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <Movies.h>
+	#include <QuickTimeComponents.h>
+	#include <Multiprocessing.h>
+#endif
+
+namespace dts {
+
+typedef void (*CueStartedProcPtr)(void *inRefCon);
+
+typedef struct {
+	SInt32	lateness;		// microseconds after the start time that the movie was set going
+	SInt32	startError;		// microseconds the movie time line is from where it should be, + is behind
+	Boolean	wasRealigned;	// the time line was half a frame or more out so the movie time was moved
+} CueStatsRecord;
+
+class CVideoOutputCue {
+	public:
+		CVideoOutputCue();
+		~CVideoOutputCue() { Reset(); }
+
+		static OSErr GetFrameTime(const Movie inMovie, long inFrame, TimeValue &outMovieTime);
+		static OSErr GetTimecodeFrame(const Movie inMovie, const TimeCodeRecord &inTimecode, long &outFrame);
+
+		OSErr Cue(const Movie inMovie, TimeValue inMovieTime, Fixed inRate = fixed1);
+		OSErr StartAtTime(ComponentInstance inClock, const TimeRecord &inStartTime, CueStartedProcPtr inStartedProc = NULL, void *inRefCon = NULL);
+		void  Reset(void);
+
+		Boolean IsCued(void) const { return (mMovie != NULL); }
+		Boolean IsStarting(void) const { return (mCallBack != NULL && mMovie != NULL); }
+		Boolean GetTimeUntilStart(long &outDuration, TimeScale inScale) const;
+		void	GetStats(CueStatsRecord &outStats) const { outStats = mStats; }
+
+	private:
+		static SInt64 GetScaledTime(const TimeRecord &inTime, TimeScale inScale);
+		static pascal void StartCallBack(QTCallBack inCallBack, long inRefCon);
+		void Start(void);
+		void CancelStart(void);
+
+		// nope
+		CVideoOutputCue(const CVideoOutputCue &inCue);
+		CVideoOutputCue operator=(CVideoOutputCue inCue);
+
+	private:
+		Movie			mMovie;			// NULL when nothing's cued
+		TimeValue		mCueTime;
+		Fixed			mRate;
+		TimeValue		mFrameDuration;	// in movie time
+		CueStatsRecord	mStats;
+
+		// while starting
+		ComponentInstance mClock;
+		TimeBase		mTimeBase;		// runs on mClock
+		QTCallBack		mCallBack;
+		QTCallBackUPP	mCallBackUPP;
+		SInt64			mStartTime;		// in movie time
+		CueStartedProcPtr mStartedProc;
+		void			*mStartedRefCon;
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTCUE_H__
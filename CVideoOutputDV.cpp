@@ -0,0 +1,653 @@
+/*
+	File:		 CVideoOutputDV.cpp
+	
+	Description: DV25 frame layout, tables and transforms.
+				 See CVideoOutputDV.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 added CheckFrameFormat
+										<1> 10/19/26 initial release
+*/
+
+#include <math.h>
+#include <string.h>
+
+#if __SSE2__
+	#include <emmintrin.h>
+#endif
+
+#include "CVideoOutputDV.h"
+
+using namespace dts;
+
+static const DVSystemRecord kDVSystems[] = {
+	{ 10, 720, 480, kDVFrameSize525_60, false, (Fixed)0x001DF853 },	// 29.97
+	{ 12, 720, 576, kDVFrameSize625_50, true,  (Fixed)0x00190000 }	// 25
+};
+
+// The DV shuffle - superblock row offset and column of each macroblock of a video segment
+static const UInt8 kSuperblockRowOffset[kDVMacroblocksPerSegment] = { 2, 6, 8, 0, 4 };
+static const UInt8 kSuperblockColumn[kDVMacroblocksPerSegment] = { 2, 1, 3, 0, 4 };
+
+// 4:1:1 superblocks are 4.5 macroblocks wide, these are their first macroblock columns
+static const UInt8 kSuperblockFirstColumn411[5] = { 0, 4, 9, 13, 18 };
+
+// DIF section types and packs
+const UInt8 kDIFHeaderID = 0x1F;
+const UInt8 kDIFSubcodeID = 0x3F;
+const UInt8 kDIFVAUXID = 0x56;
+const UInt8 kDIFAudioID = 0x76;
+const UInt8 kDIFVideoID = 0x96;
+
+const UInt8 kVAUXSourcePack = 0x60;
+const UInt8 kVAUXSourceControlPack = 0x61;
+
+// 16384 x the orthonormal DCT basis, rows are output coefficients
+static const SInt16 kDCT88[64] = {
+	 5793,  5793,  5793,  5793,  5793,  5793,  5793,  5793,
+	 8035,  6811,  4551,  1598, -1598, -4551, -6811, -8035,
+	 7568,  3135, -3135, -7568, -7568, -3135,  3135,  7568,
+	 6811, -1598, -8035, -4551,  4551,  8035,  1598, -6811,
+	 5793, -5793, -5793,  5793,  5793, -5793, -5793,  5793,
+	 4551, -8035,  1598,  6811, -6811, -1598,  8035, -4551,
+	 3135, -7568,  7568, -3135, -3135,  7568, -7568,  3135,
+	 1598, -4551,  6811, -8035,  8035, -6811,  4551, -1598
+};
+
+// The vertical half of the 2-4-8 DCT - a 4 point DCT of the sum of each pair of lines
+// followed by a 4 point DCT of their difference
+static const SInt16 kDCT248[64] = {
+	 5793,  5793,  5793,  5793,  5793,  5793,  5793,  5793,
+	 7568,  7568,  3135,  3135, -3135, -3135, -7568, -7568,
+	 5793,  5793, -5793, -5793, -5793, -5793,  5793,  5793,
+	 3135,  3135, -7568, -7568,  7568,  7568, -3135, -3135,
+	 5793, -5793,  5793, -5793,  5793, -5793,  5793, -5793,
+	 7568, -7568,  3135, -3135, -3135,  3135, -7568,  7568,
+	 5793, -5793, -5793,  5793, -5793,  5793,  5793, -5793,
+	 3135, -3135, -7568,  7568,  7568, -7568, -3135,  3135
+};
+
+// The inverse transforms are the transposes of the above
+static SInt16 sIDCT88[64];
+static SInt16 sIDCT248[64];
+
+const UInt8 CVideoOutputDV::sScan88[64] = {
+	 0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+	12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// Rows 0 - 3 are the sum coefficients, rows 4 - 7 the difference coefficients, the scan takes
+// the same position of each in turn
+const UInt8 CVideoOutputDV::sScan248[64] = {
+	 0, 32,  1, 33,  8, 40,  2, 34,  9, 41, 16, 48, 24, 56, 17, 49,
+	10, 42,  3, 35,  4, 36, 11, 43, 18, 50, 25, 57, 26, 58, 19, 51,
+	12, 44,  5, 37,  6, 38, 13, 45, 20, 52, 27, 59, 28, 60, 21, 53,
+	14, 46,  7, 39, 15, 47, 22, 54, 29, 61, 30, 62, 23, 55, 31, 63
+};
+
+// Quantization area of each coefficient in scan order
+const UInt8 CVideoOutputDV::sArea[64] = {
+	0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3,
+	3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3
+};
+
+const UInt8 CVideoOutputDV::sQuantOffset[4] = { 6, 3, 0, 1 };
+
+// Quantization step (as a shift) of each area, indexed by quantization number + class offset
+const UInt8 CVideoOutputDV::sQuantShift[22][4] = {
+	{ 3, 3, 4, 4 }, { 3, 3, 4, 4 }, { 2, 3, 3, 4 }, { 2, 3, 3, 4 },
+	{ 2, 2, 3, 3 }, { 2, 2, 3, 3 }, { 1, 2, 2, 3 }, { 1, 2, 2, 3 },
+	{ 1, 1, 2, 2 }, { 1, 1, 2, 2 }, { 0, 1, 1, 2 }, { 0, 1, 1, 2 },
+	{ 0, 0, 1, 1 }, { 0, 0, 1, 1 }, { 0, 0, 0, 1 }, { 0, 0, 0, 0 },
+	{ 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 },
+	{ 0, 0, 0, 0 }, { 0, 0, 0, 0 }
+};
+
+UInt32 CVideoOutputDV::sWeight[2][64];
+UInt32 CVideoOutputDV::sInverseWeight[2][64];
+UInt16 CVideoOutputDV::sShortVLCDecode[1024];
+
+// The AC codes up to 12 bits, in code order. Run escapes (13 bits) and amplitude
+// escapes (15 bits) follow the same pattern and are worked out in MakeVLC and ReadVLC.
+typedef struct {
+	UInt16	code;
+	UInt8	length;		// without the sign bit
+	UInt8	run;
+	UInt8	level;
+} VLCEntryRecord;
+
+static const VLCEntryRecord kVLCTable[] = {
+	{ 0x0000,  2,   0,  1 }, { 0x0002,  3,   0,  2 }, { 0x0006,  4, 127,  0 }, { 0x0007,  4,   1,  1 },
+	{ 0x0008,  4,   0,  3 }, { 0x0009,  4,   0,  4 }, { 0x0014,  5,   2,  1 }, { 0x0015,  5,   1,  2 },
+	{ 0x0016,  5,   0,  5 }, { 0x0017,  5,   0,  6 }, { 0x0030,  6,   3,  1 }, { 0x0031,  6,   4,  1 },
+	{ 0x0032,  6,   0,  7 }, { 0x0033,  6,   0,  8 }, { 0x0068,  7,   5,  1 }, { 0x0069,  7,   6,  1 },
+	{ 0x006A,  7,   2,  2 }, { 0x006B,  7,   1,  3 }, { 0x006C,  7,   1,  4 }, { 0x006D,  7,   0,  9 },
+	{ 0x006E,  7,   0, 10 }, { 0x006F,  7,   0, 11 }, { 0x00E0,  8,   7,  1 }, { 0x00E1,  8,   8,  1 },
+	{ 0x00E2,  8,   9,  1 }, { 0x00E3,  8,  10,  1 }, { 0x00E4,  8,   3,  2 }, { 0x00E5,  8,   4,  2 },
+	{ 0x00E6,  8,   2,  3 }, { 0x00E7,  8,   1,  5 }, { 0x00E8,  8,   1,  6 }, { 0x00E9,  8,   1,  7 },
+	{ 0x00EA,  8,   0, 12 }, { 0x00EB,  8,   0, 13 }, { 0x00EC,  8,   0, 14 }, { 0x00ED,  8,   0, 15 },
+	{ 0x00EE,  8,   0, 16 }, { 0x00EF,  8,   0, 17 }, { 0x01E0,  9,  11,  1 }, { 0x01E1,  9,  12,  1 },
+	{ 0x01E2,  9,  13,  1 }, { 0x01E3,  9,  14,  1 }, { 0x01E4,  9,   5,  2 }, { 0x01E5,  9,   6,  2 },
+	{ 0x01E6,  9,   3,  3 }, { 0x01E7,  9,   4,  3 }, { 0x01E8,  9,   2,  4 }, { 0x01E9,  9,   2,  5 },
+	{ 0x01EA,  9,   1,  8 }, { 0x01EB,  9,   0, 18 }, { 0x01EC,  9,   0, 19 }, { 0x01ED,  9,   0, 20 },
+	{ 0x01EE,  9,   0, 21 }, { 0x01EF,  9,   0, 22 }, { 0x03E0, 10,   5,  3 }, { 0x03E1, 10,   3,  4 },
+	{ 0x03E2, 10,   3,  5 }, { 0x03E3, 10,   2,  6 }, { 0x03E4, 10,   1,  9 }, { 0x03E5, 10,   1, 10 },
+	{ 0x03E6, 10,   1, 11 }, { 0x07CE, 11,   0,  0 }, { 0x07CF, 11,   1,  0 }, { 0x07D0, 11,   6,  3 },
+	{ 0x07D1, 11,   4,  4 }, { 0x07D2, 11,   3,  6 }, { 0x07D3, 11,   1, 12 }, { 0x07D4, 11,   1, 13 },
+	{ 0x07D5, 11,   1, 14 }, { 0x0FAC, 12,   2,  0 }, { 0x0FAD, 12,   3,  0 }, { 0x0FAE, 12,   4,  0 },
+	{ 0x0FAF, 12,   5,  0 }, { 0x0FB0, 12,   7,  2 }, { 0x0FB1, 12,   8,  2 }, { 0x0FB2, 12,   9,  2 },
+	{ 0x0FB3, 12,  10,  2 }, { 0x0FB4, 12,   7,  3 }, { 0x0FB5, 12,   8,  3 }, { 0x0FB6, 12,   4,  5 },
+	{ 0x0FB7, 12,   3,  7 }, { 0x0FB8, 12,   2,  7 }, { 0x0FB9, 12,   2,  8 }, { 0x0FBA, 12,   2,  9 },
+	{ 0x0FBB, 12,   2, 10 }, { 0x0FBC, 12,   2, 11 }, { 0x0FBD, 12,   1, 15 }, { 0x0FBE, 12,   1, 16 },
+	{ 0x0FBF, 12,   1, 17 }
+};
+
+const UInt8 kVLCTableSize = sizeof(kVLCTable) / sizeof(VLCEntryRecord);
+const UInt8 kShortVLCLength = 10;
+const UInt8 kDirectRuns = 15;
+const UInt8 kDirectLevels = 23;
+
+// kVLCTable index + 1 of the code for a run and level, 0 if there isn't one
+static UInt8 sDirectVLC[kDirectRuns][kDirectLevels];
+
+static Boolean sTablesReady = false;
+
+/* InitTables
+		DV weights the coefficients before quantizing them, by w(h) * w(v) / 2 with
+			w(0) = 1, w(1) = CS4 / (4 * CS7 * CS2), w(2) = CS4 / (2 * CS6), w(3) = 1 / (2 * CS5),
+			w(4) = 7 / 8, w(5) = CS4 / CS3, w(6) = CS4 / CS2, w(7) = CS4 / CS1 and CSm = cos(m * pi / 16).
+		The 2-4-8 DCT uses w(2v) vertically. The tables fold in the factor of 8 of ForwardDCT, the
+		forward weights are 16.16 fixed point and the inverse weights 22.10.
+*/
+void CVideoOutputDV::InitTables(void)
+{
+	double CS[8], W[8];
+
+	if (sTablesReady) return;
+
+	for (UInt8 m = 0; m < 8; m++) CS[m] = cos(m * M_PI / 16.0);
+
+	W[0] = 1.0;
+	W[1] = CS[4] / (4.0 * CS[7] * CS[2]);
+	W[2] = CS[4] / (2.0 * CS[6]);
+	W[3] = 1.0 / (2.0 * CS[5]);
+	W[4] = 7.0 / 8.0;
+	W[5] = CS[4] / CS[3];
+	W[6] = CS[4] / CS[2];
+	W[7] = CS[4] / CS[1];
+
+	for (UInt8 i = 0; i < 64; i++) {
+		UInt8  thePosition = sScan88[i];
+		double theWeight = W[thePosition & 7] * W[thePosition >> 3] / 2.0;
+
+		sWeight[0][i] = (UInt32)(theWeight / 8.0 * 65536.0 + 0.5);
+		sInverseWeight[0][i] = (UInt32)(8.0 / theWeight * 1024.0 + 0.5);
+
+		thePosition = sScan248[i];
+		theWeight = W[thePosition & 7] * W[2 * ((thePosition >> 3) & 3)] / 2.0;
+
+		sWeight[1][i] = (UInt32)(theWeight / 8.0 * 65536.0 + 0.5);
+		sInverseWeight[1][i] = (UInt32)(8.0 / theWeight * 1024.0 + 0.5);
+	}
+
+	for (UInt8 row = 0; row < 8; row++) {
+		for (UInt8 column = 0; column < 8; column++) {
+			sIDCT88[row * 8 + column] = kDCT88[column * 8 + row];
+			sIDCT248[row * 8 + column] = kDCT248[column * 8 + row];
+		}
+	}
+
+	for (UInt8 i = 0; i < kVLCTableSize; i++) {
+		const VLCEntryRecord &theEntry = kVLCTable[i];
+
+		if (theEntry.run < kDirectRuns && theEntry.level < kDirectLevels)
+			sDirectVLC[theEntry.run][theEntry.level] = i + 1;
+
+		if (theEntry.length <= kShortVLCLength) {
+			UInt16 theFirst = theEntry.code << (kShortVLCLength - theEntry.length);
+			UInt16 theCount = 1 << (kShortVLCLength - theEntry.length);
+
+			for (UInt16 j = 0; j < theCount; j++) sShortVLCDecode[theFirst + j] = i + 1;
+		}
+	}
+
+	sTablesReady = true;
+}
+
+const DVSystemRecord &CVideoOutputDV::GetSystem(DVSystem inSystem)
+{
+	return kDVSystems[inSystem];
+}
+
+#pragma mark-
+
+/* GetMacroblock
+		Macroblock m of segment k in DIF sequence s comes from superblock row (s + rowOffset[m]) % sequences,
+		superblock column column[m], and is macroblock k of that superblock. Macroblocks run down and up
+		the columns of a superblock - 6 macroblocks of 32 x 8 to a column for 4:1:1, 3 of 16 x 16 for 4:2:0.
+*/
+void CVideoOutputDV::GetMacroblock(DVSystem inSystem, UInt8 inSequence, UInt8 inSegment, UInt8 inMacroblock, DVMacroblockRecord &outMacroblock)
+{
+	const DVSystemRecord &theSystem = kDVSystems[inSystem];
+	UInt8 theRow = (inSequence + kSuperblockRowOffset[inMacroblock]) % theSystem.sequenceCount;
+	UInt8 theColumn = kSuperblockColumn[inMacroblock];
+
+	if (theSystem.is420) {
+		UInt8 theMBColumn = inSegment / 3;
+		UInt8 theMBRow = (theMBColumn & 1) ? 2 - inSegment % 3 : inSegment % 3;
+
+		outMacroblock.x = (theColumn * 9 + theMBColumn) * 16;
+		outMacroblock.y = (theRow * 3 + theMBRow) * 16;
+		outMacroblock.isSquare = true;
+	} else {
+		// Odd superblock columns start half way down the column they share with their left neighbour
+		UInt8 theNumber = (theColumn & 1) ? inSegment + 3 : inSegment;
+		UInt8 theMBColumn = theNumber / 6 + kSuperblockFirstColumn411[theColumn];
+		UInt8 theMBRow = ((theNumber / 6) & 1) ? 5 - theNumber % 6 : theNumber % 6;
+
+		if (theMBColumn < 22) {
+			outMacroblock.x = theMBColumn * 32;
+			outMacroblock.y = (theRow * 6 + theMBRow) * 8;
+			outMacroblock.isSquare = false;
+		} else {
+			// The right hand 16 pixels are 16 x 16 macroblocks
+			outMacroblock.x = 22 * 32;
+			outMacroblock.y = theRow * 48 + theMBRow * 16;
+			outMacroblock.isSquare = true;
+		}
+	}
+}
+
+// Video DIF blocks follow the header, 2 subcode and 3 VAUX blocks with an audio block before every 15
+UInt8 *CVideoOutputDV::GetVideoBlock(UInt8 *inFrame, UInt8 inSequence, UInt8 inSegment, UInt8 inMacroblock)
+{
+	UInt16 theBlock = inSegment * kDVMacroblocksPerSegment + inMacroblock;
+
+	return inFrame + inSequence * kDVDIFSequenceSize + (7 + theBlock + theBlock / 15) * kDVDIFBlockSize;
+}
+
+static UInt8 *WriteDIFID(UInt8 *outBlock, UInt8 inSectionID, UInt8 inSequence, UInt8 inNumber)
+{
+	outBlock[0] = inSectionID;
+	outBlock[1] = (inSequence << 4) | 0x07;
+	outBlock[2] = inNumber;
+
+	return outBlock + 3;
+}
+
+static UInt8 *WriteVAUXPacks(UInt8 *outPacks, DVSystem inSystem, Boolean inInterlaced)
+{
+	// Video source - colour, 525/60 or 625/50, DV25 compression
+	outPacks[0] = kVAUXSourcePack;
+	outPacks[1] = 0xFF;
+	outPacks[2] = 0xFF;
+	outPacks[3] = 0xC0 | ((eDVSystem625_50 == inSystem) ? 0x20 : 0);
+	outPacks[4] = 0xFF;
+
+	// Video source control - 4:3, both fields, field 1 first, interlaced or not
+	outPacks[5] = kVAUXSourceControlPack;
+	outPacks[6] = 0x3F;
+	outPacks[7] = 0xC8;
+	outPacks[8] = 0xEC | (inInterlaced ? 0x10 : 0);
+	outPacks[9] = 0xFF;
+
+	return outPacks + 10;
+}
+
+void CVideoOutputDV::FormatFrame(UInt8 *outFrame, DVSystem inSystem, Boolean inInterlaced)
+{
+	const DVSystemRecord &theSystem = kDVSystems[inSystem];
+
+	for (UInt8 theSequence = 0; theSequence < theSystem.sequenceCount; theSequence++) {
+		UInt8 *pSequence = outFrame + theSequence * kDVDIFSequenceSize;
+		UInt8 *p;
+
+		::memset(pSequence, 0xFF, 6 * kDVDIFBlockSize);
+
+		// Header - DSF and the application IDs
+		p = WriteDIFID(pSequence, kDIFHeaderID, theSequence, 0);
+		p[0] = (eDVSystem625_50 == inSystem) ? 0xBF : 0x3F;
+		p[1] = 0xF8;
+		p[2] = p[3] = p[4] = 0x78;
+
+		// Subcode - sync block IDs only
+		for (UInt8 j = 0; j < 2; j++) {
+			p = WriteDIFID(pSequence + (1 + j) * kDVDIFBlockSize, kDIFSubcodeID, theSequence, j);
+			for (UInt8 k = 0; k < 6; k++, p += 8) {
+				p[0] = ((theSequence < theSystem.sequenceCount / 2) ? 0x80 : 0) | 0x0F;
+				p[1] = 0xF0 | (j * 6 + k);
+			}
+		}
+
+		// VAUX - source and source control packs at the start and in the middle of each block
+		for (UInt8 j = 0; j < 3; j++) {
+			p = WriteDIFID(pSequence + (3 + j) * kDVDIFBlockSize, kDIFVAUXID, theSequence, j);
+			p = WriteVAUXPacks(p, inSystem, inInterlaced);
+			WriteVAUXPacks(p + 7 * 5, inSystem, inInterlaced);
+		}
+
+		// Audio - none, the sound goes out through the sound output component
+		for (UInt8 j = 0; j < 9; j++) {
+			p = pSequence + (6 + j * 16) * kDVDIFBlockSize;
+			::memset(p, 0xFF, kDVDIFBlockSize);
+			WriteDIFID(p, kDIFAudioID, theSequence, j);
+		}
+
+		for (UInt8 j = 0; j < 135; j++) {
+			WriteDIFID(pSequence + (7 + j + j / 15) * kDVDIFBlockSize, kDIFVideoID, theSequence, j);
+		}
+	}
+}
+
+OSErr CVideoOutputDV::CheckFrameFormat(const UInt8 *inFrame, DVSystem inSystem, Boolean inInterlaced)
+{
+	const DVSystemRecord &theSystem = kDVSystems[inSystem];
+	Ptr		pExpected = NULL;
+	OSErr	err = noErr;
+
+	if (theSystem.frameSize != theSystem.sequenceCount * kDVDIFSequenceSize || GetFrameSystem(inFrame) != inSystem) { err = codecBadDataErr; goto bail; }
+
+	pExpected = ::NewPtr(theSystem.frameSize);
+	if (NULL == pExpected) { err = memFullErr; goto bail; }
+
+	FormatFrame((UInt8 *)pExpected, inSystem, inInterlaced);
+
+	for (UInt32 i = 0; i < theSystem.frameSize; i += kDVDIFBlockSize) {
+		const UInt8 *pExpectedBlock = (const UInt8 *)pExpected + i;
+
+		// The section type's the top 3 bits of the ID, the rest of a video block is the encoder's
+		if (::memcmp(inFrame + i, pExpectedBlock, (kDIFVideoID >> 5) == (pExpectedBlock[0] >> 5) ? 3 : kDVDIFBlockSize)) { err = codecBadDataErr; goto bail; }
+	}
+
+bail:
+	if (pExpected) ::DisposePtr(pExpected);
+
+	return err;
+}
+
+#pragma mark-
+
+/* MatrixPass
+		out[k][c] = (sum of inMatrix[k][n] * in[n][c] + rounding) >> inShift for every column c, saturated
+		to 16 bits. Run it, transpose, run it again and transpose back for a separable 2D transform.
+*/
+#if __SSE2__
+static inline void MatrixPass(const SInt16 *inBlock, SInt16 *outBlock, const SInt16 *inMatrix, int inShift)
+{
+	const __m128i *pIn = (const __m128i *)inBlock;
+	const __m128i theRound = _mm_set1_epi32(1 << (inShift - 1));
+	const __m128i theShift = _mm_cvtsi32_si128(inShift);
+	__m128i thePairsLo[4], thePairsHi[4];
+
+	// Interleave rows n and n + 1 so one madd does two taps for 4 columns
+	for (int n = 0; n < 4; n++) {
+		__m128i theRowA = _mm_loadu_si128(pIn + 2 * n);
+		__m128i theRowB = _mm_loadu_si128(pIn + 2 * n + 1);
+
+		thePairsLo[n] = _mm_unpacklo_epi16(theRowA, theRowB);
+		thePairsHi[n] = _mm_unpackhi_epi16(theRowA, theRowB);
+	}
+
+	for (int k = 0; k < 8; k++) {
+		__m128i theSumLo = theRound, theSumHi = theRound;
+
+		for (int n = 0; n < 4; n++) {
+			__m128i theTaps = _mm_set1_epi32((UInt16)inMatrix[k * 8 + 2 * n] | ((UInt32)(UInt16)inMatrix[k * 8 + 2 * n + 1] << 16));
+
+			theSumLo = _mm_add_epi32(theSumLo, _mm_madd_epi16(thePairsLo[n], theTaps));
+			theSumHi = _mm_add_epi32(theSumHi, _mm_madd_epi16(thePairsHi[n], theTaps));
+		}
+
+		theSumLo = _mm_sra_epi32(theSumLo, theShift);
+		theSumHi = _mm_sra_epi32(theSumHi, theShift);
+		_mm_storeu_si128((__m128i *)outBlock + k, _mm_packs_epi32(theSumLo, theSumHi));
+	}
+}
+
+static inline void Transpose(SInt16 *ioBlock)
+{
+	__m128i *p = (__m128i *)ioBlock;
+	__m128i a0 = _mm_unpacklo_epi16(_mm_loadu_si128(p + 0), _mm_loadu_si128(p + 1));
+	__m128i a1 = _mm_unpackhi_epi16(_mm_loadu_si128(p + 0), _mm_loadu_si128(p + 1));
+	__m128i a2 = _mm_unpacklo_epi16(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3));
+	__m128i a3 = _mm_unpackhi_epi16(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3));
+	__m128i a4 = _mm_unpacklo_epi16(_mm_loadu_si128(p + 4), _mm_loadu_si128(p + 5));
+	__m128i a5 = _mm_unpackhi_epi16(_mm_loadu_si128(p + 4), _mm_loadu_si128(p + 5));
+	__m128i a6 = _mm_unpacklo_epi16(_mm_loadu_si128(p + 6), _mm_loadu_si128(p + 7));
+	__m128i a7 = _mm_unpackhi_epi16(_mm_loadu_si128(p + 6), _mm_loadu_si128(p + 7));
+
+	__m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	__m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	__m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	__m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	__m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	__m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	__m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	__m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+	_mm_storeu_si128(p + 0, _mm_unpacklo_epi64(b0, b4));
+	_mm_storeu_si128(p + 1, _mm_unpackhi_epi64(b0, b4));
+	_mm_storeu_si128(p + 2, _mm_unpacklo_epi64(b1, b5));
+	_mm_storeu_si128(p + 3, _mm_unpackhi_epi64(b1, b5));
+	_mm_storeu_si128(p + 4, _mm_unpacklo_epi64(b2, b6));
+	_mm_storeu_si128(p + 5, _mm_unpackhi_epi64(b2, b6));
+	_mm_storeu_si128(p + 6, _mm_unpacklo_epi64(b3, b7));
+	_mm_storeu_si128(p + 7, _mm_unpackhi_epi64(b3, b7));
+}
+#else
+static inline void MatrixPass(const SInt16 *inBlock, SInt16 *outBlock, const SInt16 *inMatrix, int inShift)
+{
+	const SInt32 theRound = 1 << (inShift - 1);
+
+	for (int k = 0; k < 8; k++) {
+		for (int c = 0; c < 8; c++) {
+			SInt32 theSum = theRound;
+
+			for (int n = 0; n < 8; n++) theSum += inMatrix[k * 8 + n] * inBlock[n * 8 + c];
+
+			theSum >>= inShift;
+			outBlock[k * 8 + c] = (theSum > 32767) ? 32767 : (theSum < -32768) ? -32768 : theSum;
+		}
+	}
+}
+
+static inline void Transpose(SInt16 *ioBlock)
+{
+	for (int row = 0; row < 8; row++) {
+		for (int column = row + 1; column < 8; column++) {
+			SInt16 theTemp = ioBlock[row * 8 + column];
+			ioBlock[row * 8 + column] = ioBlock[column * 8 + row];
+			ioBlock[column * 8 + row] = theTemp;
+		}
+	}
+}
+#endif
+
+/* ForwardDCT
+		The vertical pass keeps 3 extra bits, the horizontal pass leaves the coefficients at 8 times
+		the orthonormal DCT. Input is samples - 128.
+*/
+void CVideoOutputDV::ForwardDCT(SInt16 *ioBlock, Boolean in248)
+{
+	SInt16 theTemp[64];
+
+	MatrixPass(ioBlock, theTemp, in248 ? kDCT248 : kDCT88, 11);
+	Transpose(theTemp);
+	MatrixPass(theTemp, ioBlock, kDCT88, 14);
+	Transpose(ioBlock);
+}
+
+void CVideoOutputDV::InverseDCT(SInt16 *ioBlock, Boolean in248)
+{
+	SInt16 theTemp[64];
+
+	MatrixPass(ioBlock, theTemp, in248 ? sIDCT248 : sIDCT88, 14);
+	Transpose(theTemp);
+	MatrixPass(theTemp, ioBlock, sIDCT88, 17);
+	Transpose(ioBlock);
+}
+
+#pragma mark-
+
+void CVideoOutputDV::PutBits(DVBitBufferRecord &ioBuffer, UInt32 inBits, UInt8 inLength)
+{
+	while (inLength) {
+		UInt8 *pByte = ioBuffer.data + (ioBuffer.used >> 3);
+		UInt8 theFree = 8 - (ioBuffer.used & 7);
+		UInt8 theCount = (inLength < theFree) ? inLength : theFree;
+		UInt8 theBits = (inBits >> (inLength - theCount)) & ((1 << theCount) - 1);
+
+		*pByte = (*pByte & ~(((1 << theCount) - 1) << (theFree - theCount))) | (theBits << (theFree - theCount));
+
+		ioBuffer.used += theCount;
+		inLength -= theCount;
+	}
+}
+
+UInt32 CVideoOutputDV::PeekBits(const DVBitBufferRecord &inBuffer)
+{
+	const UInt8 *pData = inBuffer.data + (inBuffer.used >> 3);
+	UInt16		theBytesLeft = ((inBuffer.size + 7) >> 3) - (inBuffer.used >> 3);
+	UInt16		theBitsLeft = inBuffer.size - inBuffer.used;
+	UInt64		theWindow = 0;
+	UInt32		theBits;
+
+	if (inBuffer.used >= inBuffer.size) return 0;
+
+	for (UInt8 i = 0; i < 5; i++) theWindow = (theWindow << 8) | ((i < theBytesLeft) ? pData[i] : 0);
+
+	theBits = (UInt32)(theWindow >> (8 - (inBuffer.used & 7)));
+	if (theBitsLeft < 32) theBits &= ~(0xFFFFFFFF >> theBitsLeft);
+
+	return theBits;
+}
+
+#pragma mark-
+
+UInt8 CVideoOutputDV::MakeVLC(UInt8 inRun, UInt16 inAmplitude, Boolean inNegative, UInt32 &outCode)
+{
+	UInt32 theCode;
+	UInt8  theLength;
+
+	if (inAmplitude > (UInt16)kDVMaxAmplitude) inAmplitude = kDVMaxAmplitude;
+
+	// One code for the pair
+	if (inRun < kDirectRuns && inAmplitude < kDirectLevels && sDirectVLC[inRun][inAmplitude]) {
+		const VLCEntryRecord &theEntry = kVLCTable[sDirectVLC[inRun][inAmplitude] - 1];
+
+		outCode = ((UInt32)theEntry.code << 1) | inNegative;
+		return theEntry.length + 1;
+	}
+
+	// The amplitude on its own, then the zeros in front of it
+	if (inAmplitude < kDirectLevels) {
+		const VLCEntryRecord &theEntry = kVLCTable[sDirectVLC[0][inAmplitude] - 1];
+
+		theCode = ((UInt32)theEntry.code << 1) | inNegative;
+		theLength = theEntry.length + 1;
+	} else {
+		theCode = 0xFE00 | (inAmplitude << 1) | inNegative;
+		theLength = 16;
+	}
+
+	if (inRun) {
+		if (inRun - 1 < kDirectRuns && sDirectVLC[inRun - 1][0]) {
+			const VLCEntryRecord &theEntry = kVLCTable[sDirectVLC[inRun - 1][0] - 1];
+
+			theCode |= (UInt32)theEntry.code << theLength;
+			theLength += theEntry.length;
+		} else {
+			theCode |= (UInt32)(0x1F80 | (inRun - 1)) << theLength;
+			theLength += 13;
+		}
+	}
+
+	outCode = theCode;
+
+	return theLength;
+}
+
+UInt8 CVideoOutputDV::ReadVLC(UInt32 inBits, UInt8 &outRun, SInt16 &outLevel)
+{
+	const VLCEntryRecord *pEntry = NULL;
+	UInt16 theIndex = sShortVLCDecode[inBits >> (32 - kShortVLCLength)];
+	UInt8  theLength;
+
+	if (theIndex) {
+		pEntry = &kVLCTable[theIndex - 1];
+	} else if ((inBits >> 25) == 0x7E) {
+		// Run escape
+		outRun = (inBits >> 19) & 0x3F;
+		outLevel = 0;
+		return 13;
+	} else if ((inBits >> 25) == 0x7F) {
+		// Amplitude escape
+		outRun = 0;
+		outLevel = (inBits >> 17) & 0xFF;
+		if (inBits & 0x10000) outLevel = -outLevel;
+		return 16;
+	} else {
+		for (UInt8 i = 0; i < kVLCTableSize; i++) {
+			if (kVLCTable[i].length > kShortVLCLength && (inBits >> (32 - kVLCTable[i].length)) == kVLCTable[i].code) {
+				pEntry = &kVLCTable[i];
+				break;
+			}
+		}
+		if (NULL == pEntry) { outRun = kDVEndOfBlockRun; outLevel = 0; return 0; }
+	}
+
+	outRun = pEntry->run;
+	outLevel = pEntry->level;
+	theLength = pEntry->length;
+
+	if (outLevel) {
+		if ((inBits >> (31 - theLength)) & 1) outLevel = -outLevel;
+		theLength++;
+	}
+
+	return theLength;
+}
@@ -0,0 +1,204 @@
+/*
+	File:		 CVideoOutputDV.h
+	
+	Description: DV25 (IEC 61834 / SMPTE 314M) frame layout, tables and transforms shared by the
+				 CVideoOutputDVEncoder and CVideoOutputDVDecoder classes.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 added CheckFrameFormat
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	A DV25 frame is 10 (525/60) or 12 (625/50) DIF sequences of 150 DIF blocks of 80 bytes. Each
+	sequence holds 27 video segments, a video segment is 5 compressed macroblocks taken from 5 different
+	places in the picture and is coded on its own, so segments can be encoded and decoded in any order
+	and on any thread.
+
+	InitTables( void )
+		Builds the weighting tables. Called by the encoder and decoder constructors, call it yourself
+		before using the other methods directly.
+
+	GetMacroblock( DVSystem inSystem, UInt8 inSequence, UInt8 inSegment, UInt8 inMacroblock, DVMacroblockRecord &outMacroblock )
+		Where in the picture macroblock inMacroblock (0 - 4) of a video segment lives, undoing the
+		DV shuffle.
+
+	GetVideoBlock( UInt8 *inFrame, UInt8 inSequence, UInt8 inSegment, UInt8 inMacroblock )
+		The DIF block holding a compressed macroblock.
+
+	FormatFrame( UInt8 *outFrame, DVSystem inSystem, Boolean inInterlaced )
+		Writes the header, subcode, VAUX and (empty) audio DIF blocks and the IDs of the video DIF blocks.
+
+	CheckFrameFormat( const UInt8 *inFrame, DVSystem inSystem, Boolean inInterlaced )
+		Checks a frame against what FormatFrame() writes - every DIF block other than video the same, and
+		the IDs of the video ones - and that its header says inSystem. Returns codecBadDataErr if not.
+
+	ForwardDCT( SInt16 *ioBlock, Boolean in248 ) / InverseDCT( SInt16 *ioBlock, Boolean in248 )
+		8x8 or 2-4-8 DCT on a block of centered samples. Coefficients are 8 times the orthonormal DCT.
+		Done as two passes of a fixed point matrix multiply using SSE2 where available, the scalar
+		version gives the same results.
+
+	PutBits( DVBitBufferRecord &ioBuffer, UInt32 inBits, UInt8 inLength ) / PeekBits( const DVBitBufferRecord &inBuffer )
+		Bit access to the fixed size area of a block. PeekBits returns the next 32 bits of the area,
+		padded with zeros past the end.
+
+	MakeVLC( UInt8 inRun, UInt16 inAmplitude, Boolean inNegative, UInt32 &outCode )
+		Returns the length and the code for inRun zero coefficients followed by inAmplitude, using
+		the shortest combination of codes when there isn't one code for the pair. 29 bits at most.
+
+	ReadVLC( UInt32 inBits, UInt8 &outRun, SInt16 &outLevel )
+		Decodes one code from the next 32 bits of a block (most significant bit first) and returns its
+		length. outRun is kDVEndOfBlockRun for the end of block code. A zero outLevel is a run of
+		outRun + 1 zero coefficients.
+*/
+
+#ifndef __CVIDEOOUTPUTDV_H__
+	#define __CVIDEOOUTPUTDV_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+#else
+	#include <Carbon.h>
+#endif
+
+namespace dts {
+
+enum DVSystem {
+	eDVSystem525_60 = 0,	// NTSC, 720 x 480, 4:1:1
+	eDVSystem625_50			// PAL, 720 x 576, 4:2:0
+};
+
+const long   kDVDIFBlockSize = 80;
+const long   kDVDIFSequenceSize = 150 * kDVDIFBlockSize;
+const UInt32 kDVFrameSize525_60 = 10 * kDVDIFSequenceSize;
+const UInt32 kDVFrameSize625_50 = 12 * kDVDIFSequenceSize;
+
+const UInt8  kDVSegmentsPerSequence = 27;
+const UInt8  kDVMacroblocksPerSegment = 5;
+const UInt8  kDVBlocksPerMacroblock = 6;		// Y0 Y1 Y2 Y3 Cr Cb
+
+const UInt16 kDVLumaBlockBits = 14 * 8;
+const UInt16 kDVChromaBlockBits = 10 * 8;
+const UInt16 kDVBlockHeaderBits = 12;			// DC (9), DCT mode (1), class (2)
+const UInt16 kDVEndOfBlockBits = 4;
+
+// The AC bits available to a compressed macroblock and to a whole video segment
+const UInt16 kDVMacroblockACBits = 4 * (kDVLumaBlockBits - kDVBlockHeaderBits) + 2 * (kDVChromaBlockBits - kDVBlockHeaderBits);
+const UInt16 kDVSegmentACBits = kDVMacroblocksPerSegment * kDVMacroblockACBits;
+
+const UInt8  kDVEndOfBlockRun = 127;
+const UInt8  kDVMaxQuantNumber = 15;
+const UInt8  kDVMaxClass = 3;
+const SInt16 kDVMaxAmplitude = 255;
+
+typedef struct {
+	UInt8	sequenceCount;
+	long	width, height;
+	UInt32	frameSize;
+	Boolean	is420;				// 4:2:0 chroma, otherwise 4:1:1
+	Fixed	frameRate;
+} DVSystemRecord;
+
+typedef struct {
+	UInt16	x, y;				// top left luma sample
+	Boolean	isSquare;			// 16 x 16 luma - every 4:2:0 macroblock and the right hand column of 4:1:1
+} DVMacroblockRecord;
+
+typedef struct {
+	UInt8	*data;
+	UInt16	size;				// in bits
+	UInt16	used;
+} DVBitBufferRecord, *DVBitBufferPtr;
+
+class CVideoOutputDV {
+	public:
+		static void InitTables(void);
+
+		static const DVSystemRecord &GetSystem(DVSystem inSystem);
+		static DVSystem GetFrameSystem(const UInt8 *inFrame) { return (inFrame[3] & 0x80) ? eDVSystem625_50 : eDVSystem525_60; }
+
+		static void   GetMacroblock(DVSystem inSystem, UInt8 inSequence, UInt8 inSegment, UInt8 inMacroblock, DVMacroblockRecord &outMacroblock);
+		static UInt8 *GetVideoBlock(UInt8 *inFrame, UInt8 inSequence, UInt8 inSegment, UInt8 inMacroblock);
+		static UInt16 GetBlockBits(UInt8 inBlock) { return (inBlock < 4) ? kDVLumaBlockBits : kDVChromaBlockBits; }
+
+		static void  FormatFrame(UInt8 *outFrame, DVSystem inSystem, Boolean inInterlaced);
+		static OSErr CheckFrameFormat(const UInt8 *inFrame, DVSystem inSystem, Boolean inInterlaced);
+
+		static void ForwardDCT(SInt16 *ioBlock, Boolean in248);
+		static void InverseDCT(SInt16 *ioBlock, Boolean in248);
+
+		// Coefficient order, weighting and quantization
+		static const UInt8 *GetScan(Boolean in248) { return in248 ? sScan248 : sScan88; }
+		static UInt8 GetArea(UInt8 inScanIndex) { return sArea[inScanIndex]; }
+		static UInt8 GetQuantShift(UInt8 inQuantNumber, UInt8 inClass, UInt8 inArea) { return sQuantShift[inQuantNumber + sQuantOffset[inClass]][inArea] + (kDVMaxClass == inClass); }
+		static UInt32 GetWeight(Boolean in248, UInt8 inScanIndex) { return sWeight[in248][inScanIndex]; }
+		static UInt32 GetInverseWeight(Boolean in248, UInt8 inScanIndex) { return sInverseWeight[in248][inScanIndex]; }
+
+		// Bit packing, most significant bit first
+		static UInt16 GetBitsLeft(const DVBitBufferRecord &inBuffer) { return inBuffer.size - inBuffer.used; }
+		static void   PutBits(DVBitBufferRecord &ioBuffer, UInt32 inBits, UInt8 inLength);
+		static UInt32 PeekBits(const DVBitBufferRecord &inBuffer);
+
+		// AC run/amplitude variable length codes
+		static UInt8 MakeVLC(UInt8 inRun, UInt16 inAmplitude, Boolean inNegative, UInt32 &outCode);
+		static UInt8 ReadVLC(UInt32 inBits, UInt8 &outRun, SInt16 &outLevel);
+
+	private:
+		// nope
+		CVideoOutputDV();
+
+	private:
+		static const UInt8 sScan88[64];
+		static const UInt8 sScan248[64];
+		static const UInt8 sArea[64];
+		static const UInt8 sQuantOffset[4];
+		static const UInt8 sQuantShift[22][4];
+		static UInt32	   sWeight[2][64];
+		static UInt32	   sInverseWeight[2][64];
+		static UInt16	   sShortVLCDecode[1024];
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTDV_H__
@@ -0,0 +1,478 @@
+/*
+	File:		 CVideoOutputDVDecoder.cpp
+	
+	Description: Software DV25 decoder.
+				 See CVideoOutputDVDecoder.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <5> 10/19/26 Benchmark checks the round trip first
+										<4> 10/19/26 DecodeFrame is StartDecodeFrame then FinishDecodeFrame
+										<3> 10/19/26 legalize each macroblock as it's stored
+										<2> 10/19/26 added trace points
+										<1> 10/19/26 initial release
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "CVideoOutputDVDecoder.h"
+#include "CVideoOutputTrace.h"
+
+using namespace dts;
+
+const UInt8 kBlocksPerSegment = kDVMacroblocksPerSegment * kDVBlocksPerMacroblock;
+
+// Spare bits of a macroblock and of a segment, plus room for PeekBits to look ahead
+const UInt16 kMacroblockPoolBytes = (kDVDIFBlockSize - 4) + 8;
+const UInt16 kSegmentPoolBytes = kDVMacroblocksPerSegment * (kDVDIFBlockSize - 4) + 8;
+
+// The longest code, a code which doesn't fit in fewer bits than this is damaged rather than split
+const UInt8 kMaxVLCLength = 16;
+
+typedef struct {
+	SInt16	coefficients[64];	// dequantized, 8 times the orthonormal DCT, in raster order
+	Boolean	is248;
+	UInt8	klass;
+	UInt8	quantNumber;
+	UInt8	next;				// scan index of the next coefficient
+	UInt32	partialBits;		// the start of a code split across areas, most significant bit first
+	UInt8	partialCount;
+	Boolean	isFinished;			// end of block read
+} DecodeBlockRecord;
+
+CVideoOutputDVDecoder::CVideoOutputDVDecoder() : mSystem(eDVSystem525_60), mFrame(NULL), mPixels(NULL), mRowBytes(0),
+												 mLumaOffset(1), mCbOffset(0), mCrOffset(2), mMaxTasks(0),
+												 mLegalizer(NULL), mCorrected(0)
+{
+	CVideoOutputDV::InitTables();
+
+	// Make sure the pool is created on this thread
+	CVideoOutputWorkPool::GetSharedPool();
+}
+
+OSErr CVideoOutputDVDecoder::DecodeFrame(const UInt8 *inFrame, UInt8 *outPixels, long inRowBytes, OSType inPixelFormat)
+{
+	OSErr err;
+
+	VIDEO_OUTPUT_TRACE_SCOPE("decode");
+
+	err = StartDecodeFrame(inFrame, outPixels, inRowBytes, inPixelFormat);
+	if (err) return err;
+
+	FinishDecodeFrame();
+
+	return noErr;
+}
+
+OSErr CVideoOutputDVDecoder::StartDecodeFrame(const UInt8 *inFrame, UInt8 *outPixels, long inRowBytes, OSType inPixelFormat)
+{
+	CVideoOutputWorkPool *pPool = CVideoOutputWorkPool::GetSharedPool();
+	UInt32 theSegmentCount;
+	OSErr  err = noErr;
+
+	if (NULL == inFrame || NULL == outPixels) return paramErr;
+
+	FinishDecodeFrame();
+
+	switch (inPixelFormat) {
+	case k2vuyPixelFormat:	// Cb Y0 Cr Y1
+		mLumaOffset = 1; mCbOffset = 0; mCrOffset = 2;
+		break;
+	case kYUVSPixelFormat:	// Y0 Cb Y1 Cr
+		mLumaOffset = 0; mCbOffset = 1; mCrOffset = 3;
+		break;
+	default:
+		return paramErr;
+	}
+
+	mSystem = CVideoOutputDV::GetFrameSystem(inFrame);
+	mFrame = inFrame;
+	mPixels = outPixels;
+	mRowBytes = inRowBytes;
+
+	theSegmentCount = CVideoOutputDV::GetSystem(mSystem).sequenceCount * kDVSegmentsPerSequence;
+	mCorrected = 0;
+
+	if (pPool) {
+		err = pPool->Start(mJob, DecodeSegmentProc, this, theSegmentCount, mMaxTasks);
+		if (err) { mFrame = NULL; mPixels = NULL; }
+	} else {
+		for (UInt32 i = 0; i < theSegmentCount; i++) DecodeSegmentProc(this, i);
+	}
+
+	return err;
+}
+
+void CVideoOutputDVDecoder::FinishDecodeFrame(void)
+{
+	CVideoOutputWorkPool *pPool = CVideoOutputWorkPool::GetSharedPool();
+
+	if (NULL == mFrame) return;
+
+	if (pPool) pPool->Finish(mJob);
+
+	if (mLegalizer) mLegalizer->FrameDone(mCorrected);
+
+	mFrame = NULL;
+	mPixels = NULL;
+}
+
+void CVideoOutputDVDecoder::DecodeSegmentProc(void *inRefCon, UInt32 inItem)
+{
+	((CVideoOutputDVDecoder *)inRefCon)->DecodeSegment(inItem / kDVSegmentsPerSequence, inItem % kDVSegmentsPerSequence);
+}
+
+#pragma mark-
+
+/* ReadCode
+		Reads the next code of a block from ioBuffer, after the bits left over from its previous area.
+		When the code doesn't fit in what's left it's kept for the next area and we return false.
+*/
+static Boolean ReadCode(DecodeBlockRecord &ioBlock, DVBitBufferRecord &ioBuffer, UInt8 &outRun, SInt16 &outLevel)
+{
+	UInt32 theBits = ioBlock.partialBits | (CVideoOutputDV::PeekBits(ioBuffer) >> ioBlock.partialCount);
+	UInt16 theLeft = ioBlock.partialCount + CVideoOutputDV::GetBitsLeft(ioBuffer);
+	UInt8  theLength = CVideoOutputDV::ReadVLC(theBits, outRun, outLevel);
+
+	if (0 == theLength || theLength > theLeft) {
+		if (theLeft >= kMaxVLCLength) {
+			// Not a code at all, give up on the block
+			ioBlock.isFinished = true;
+		} else {
+			ioBlock.partialBits = theLeft ? theBits & ~(0xFFFFFFFF >> theLeft) : 0;
+			ioBlock.partialCount = theLeft;
+			ioBuffer.used = ioBuffer.size;
+		}
+		return false;
+	}
+
+	ioBuffer.used += theLength - ioBlock.partialCount;
+	ioBlock.partialBits = 0;
+	ioBlock.partialCount = 0;
+
+	return true;
+}
+
+// Reads AC coefficients until the end of block or the end of ioBuffer
+static void DecodeAC(DecodeBlockRecord &ioBlock, DVBitBufferRecord &ioBuffer)
+{
+	const UInt8 *pScan = CVideoOutputDV::GetScan(ioBlock.is248);
+	UInt8		theRun;
+	SInt16		theLevel;
+
+	while (!ioBlock.isFinished && ReadCode(ioBlock, ioBuffer, theRun, theLevel)) {
+		if (kDVEndOfBlockRun == theRun) {
+			ioBlock.isFinished = true;
+			break;
+		}
+
+		// A level after a run of zeros, or a run of one more zero on its own
+		ioBlock.next += theRun;
+		if (ioBlock.next > 63) {
+			ioBlock.isFinished = true;
+			break;
+		}
+
+		if (theLevel) {
+			UInt8  theIndex = ioBlock.next;
+			UInt8  theShift = CVideoOutputDV::GetQuantShift(ioBlock.quantNumber, ioBlock.klass, CVideoOutputDV::GetArea(theIndex));
+			SInt32 theAmplitude = (theLevel < 0) ? -theLevel : theLevel;
+
+			theAmplitude = ((theAmplitude << theShift) * (SInt32)CVideoOutputDV::GetInverseWeight(ioBlock.is248, theIndex) + 512) >> 10;
+			if (theAmplitude > 0x7FFF) theAmplitude = 0x7FFF;
+
+			ioBlock.coefficients[pScan[theIndex]] = (theLevel < 0) ? -theAmplitude : theAmplitude;
+		}
+
+		ioBlock.next++;
+	}
+}
+
+// Appends the unread bits of inSource to ioPool, which is read from the start
+static void CollectBits(DVBitBufferRecord &ioPool, DVBitBufferRecord &inSource)
+{
+	DVBitBufferRecord theWriter = { ioPool.data, 0, ioPool.size };
+
+	while (inSource.used < inSource.size) {
+		UInt8 theCount = (CVideoOutputDV::GetBitsLeft(inSource) < 16) ? CVideoOutputDV::GetBitsLeft(inSource) : 16;
+
+		CVideoOutputDV::PutBits(theWriter, CVideoOutputDV::PeekBits(inSource) >> (32 - theCount), theCount);
+		inSource.used += theCount;
+	}
+
+	ioPool.size = theWriter.used;
+}
+
+static inline UInt8 ClampSample(SInt32 inSample)
+{
+	inSample += 128;
+
+	return (inSample < 0) ? 0 : (inSample > 255) ? 255 : inSample;
+}
+
+// The reverse of LoadMacroblock in CVideoOutputDVEncoder.cpp
+static void StoreMacroblock(UInt8 *outPixels, long inRowBytes, UInt8 inLumaOffset, UInt8 inCbOffset, UInt8 inCrOffset,
+							const DVMacroblockRecord &inMacroblock, Boolean in420, SInt16 inSamples[kDVBlocksPerMacroblock][64])
+{
+	for (UInt8 b = 0; b < 4; b++) {
+		UInt16 theX = inMacroblock.x + (inMacroblock.isSquare ? (b & 1) * 8 : b * 8);
+		UInt16 theY = inMacroblock.y + (inMacroblock.isSquare ? (b >> 1) * 8 : 0);
+
+		for (UInt8 row = 0; row < 8; row++) {
+			UInt8		 *pLine = outPixels + (theY + row) * inRowBytes + theX * 2 + inLumaOffset;
+			const SInt16 *pIn = &inSamples[b][row * 8];
+
+			for (UInt8 column = 0; column < 8; column++) pLine[column * 2] = ClampSample(pIn[column]);
+		}
+	}
+
+	for (UInt8 c = 0; c < 2; c++) {
+		UInt8		 theOffset = c ? inCbOffset : inCrOffset;
+		const SInt16 *pIn = inSamples[4 + c];
+
+		if (in420) {
+			// Each chroma sample covers 2 x 2 pixels
+			for (UInt8 row = 0; row < 8; row++) {
+				UInt8 *pLine = outPixels + (inMacroblock.y + row * 2) * inRowBytes + inMacroblock.x * 2 + theOffset;
+
+				for (UInt8 column = 0; column < 8; column++)
+					pLine[column * 4] = pLine[column * 4 + inRowBytes] = ClampSample(pIn[row * 8 + column]);
+			}
+		} else if (!inMacroblock.isSquare) {
+			// Each chroma sample covers 4 x 1 pixels, two 2vuy samples
+			for (UInt8 row = 0; row < 8; row++) {
+				UInt8 *pLine = outPixels + (inMacroblock.y + row) * inRowBytes + inMacroblock.x * 2 + theOffset;
+
+				for (UInt8 column = 0; column < 8; column++)
+					pLine[column * 8] = pLine[column * 8 + 4] = ClampSample(pIn[row * 8 + column]);
+			}
+		} else {
+			// 4 chroma samples across 16 lines, the top 8 lines are on the left of the block, the bottom 8 on the right
+			for (UInt8 row = 0; row < 16; row++) {
+				UInt8		 *pLine = outPixels + (inMacroblock.y + row) * inRowBytes + inMacroblock.x * 2 + theOffset;
+				const SInt16 *pBlock = pIn + (row & 7) * 8 + (row >> 3) * 4;
+
+				for (UInt8 column = 0; column < 4; column++)
+					pLine[column * 8] = pLine[column * 8 + 4] = ClampSample(pBlock[column]);
+			}
+		}
+	}
+}
+
+/* DecodeSegment
+		Reads the bits back the way the encoder spread them: each block from its own area first, then the
+		blocks which didn't fit from what the rest of their macroblock left over, then from what the whole
+		segment left over.
+*/
+void CVideoOutputDVDecoder::DecodeSegment(UInt8 inSequence, UInt8 inSegment)
+{
+	const DVSystemRecord &theSystem = CVideoOutputDV::GetSystem(mSystem);
+	DecodeBlockRecord theBlocks[kBlocksPerSegment];
+	UInt8			  theSegmentBits[kSegmentPoolBytes];
+	DVBitBufferRecord theSegmentPool = { theSegmentBits, 0, 0 };
+	UInt32			  theCorrected = 0;
+
+	for (UInt8 m = 0; m < kDVMacroblocksPerSegment; m++) {
+		const UInt8		  *pDIF = CVideoOutputDV::GetVideoBlock((UInt8 *)mFrame, inSequence, inSegment, m);
+		const UInt8		  *pData = pDIF + 4;
+		UInt8			  theMacroblockBits[kMacroblockPoolBytes];
+		DVBitBufferRecord theMacroblockPool = { theMacroblockBits, 0, 0 };
+
+		// Pass 1 - each block in its own area
+		for (UInt8 b = 0; b < kDVBlocksPerMacroblock; b++) {
+			DecodeBlockRecord &theBlock = theBlocks[m * kDVBlocksPerMacroblock + b];
+			DVBitBufferRecord theBuffer;
+			UInt32			  theHeader;
+
+			theBuffer.data = (UInt8 *)pData;
+			theBuffer.size = CVideoOutputDV::GetBlockBits(b);
+			theBuffer.used = 0;
+			pData += theBuffer.size >> 3;
+
+			::memset(theBlock.coefficients, 0, sizeof(theBlock.coefficients));
+
+			// DC, DCT mode and class
+			theHeader = CVideoOutputDV::PeekBits(theBuffer) >> 20;
+			theBuffer.used = kDVBlockHeaderBits;
+
+			theBlock.coefficients[0] = ((SInt16)(theHeader << 4) >> 7) * 32;
+			theBlock.is248 = (theHeader >> 2) & 1;
+			theBlock.klass = theHeader & 3;
+			theBlock.quantNumber = pDIF[3] & 0x0F;
+			theBlock.next = 1;
+			theBlock.partialBits = 0;
+			theBlock.partialCount = 0;
+			theBlock.isFinished = false;
+
+			DecodeAC(theBlock, theBuffer);
+
+			CollectBits(theMacroblockPool, theBuffer);
+		}
+
+		// Pass 2 - within the macroblock
+		for (UInt8 b = 0; b < kDVBlocksPerMacroblock; b++) {
+			DecodeBlockRecord &theBlock = theBlocks[m * kDVBlocksPerMacroblock + b];
+
+			if (!theBlock.isFinished) DecodeAC(theBlock, theMacroblockPool);
+		}
+
+		CollectBits(theSegmentPool, theMacroblockPool);
+	}
+
+	// Pass 3 - anywhere in the segment, then back to pixels
+	for (UInt8 m = 0; m < kDVMacroblocksPerSegment; m++) {
+		DVMacroblockRecord theMacroblock;
+		SInt16			   theSamples[kDVBlocksPerMacroblock][64];
+
+		for (UInt8 b = 0; b < kDVBlocksPerMacroblock; b++) {
+			DecodeBlockRecord &theBlock = theBlocks[m * kDVBlocksPerMacroblock + b];
+
+			if (!theBlock.isFinished) DecodeAC(theBlock, theSegmentPool);
+
+			::memcpy(theSamples[b], theBlock.coefficients, sizeof(theSamples[b]));
+			CVideoOutputDV::InverseDCT(theSamples[b], theBlock.is248);
+		}
+
+		CVideoOutputDV::GetMacroblock(mSystem, inSequence, inSegment, m, theMacroblock);
+		StoreMacroblock(mPixels, mRowBytes, mLumaOffset, mCbOffset, mCrOffset, theMacroblock, theSystem.is420, theSamples);
+		
+		// 16 x 16 or 32 x 8 pixels, still in the cache from being stored
+		if (mLegalizer) {
+			UInt8 *pMacroblock = mPixels + theMacroblock.y * mRowBytes + theMacroblock.x * 2;
+			theCorrected += mLegalizer->LegalizeRect(pMacroblock, mRowBytes, pMacroblock, mRowBytes, theMacroblock.isSquare ? 8 : 16, theMacroblock.isSquare ? 16 : 8);
+		}
+	}
+
+	if (theCorrected) ::AddAtomic(theCorrected, (SInt32 *)&mCorrected);
+}
+
+#pragma mark-
+
+/* GetPSNR
+		Of the luma and the chroma of two '2vuy' frames of inSystem, 99 dB for no difference at all.
+*/
+static void GetPSNR(DVSystem inSystem, const UInt8 *inPixels, const UInt8 *inDecoded, long inRowBytes, double &outLumaPSNR, double &outChromaPSNR)
+{
+	const DVSystemRecord &theSystem = CVideoOutputDV::GetSystem(inSystem);
+	UInt64 theError[2] = { 0, 0 };	// chroma, luma - the order of '2vuy'
+	double theSamples = (double)theSystem.width * theSystem.height;
+
+	for (long y = 0; y < theSystem.height; y++) {
+		const UInt8 *p = inPixels + y * inRowBytes, *q = inDecoded + y * inRowBytes;
+
+		for (long x = 0; x < theSystem.width * 2; x++) {
+			SInt32 d = (SInt32)p[x] - q[x];
+			theError[x & 1] += d * d;
+		}
+	}
+
+	outLumaPSNR = theError[1] ? 10.0 * ::log10(255.0 * 255.0 * theSamples / theError[1]) : 99.0;
+	outChromaPSNR = theError[0] ? 10.0 * ::log10(255.0 * 255.0 * theSamples / theError[0]) : 99.0;
+}
+
+/* Benchmark
+		Times decoding only once the round trip's been checked, so a decoder which is fast because it's
+		wrong fails loudly instead of looking good.
+*/
+OSErr CVideoOutputDVDecoder::Benchmark(DVSystem inSystem, UInt32 inFrames, UInt32 inMaxTasks, DVBenchmarkRecord &outResult)
+{
+	const DVSystemRecord &theSystem = CVideoOutputDV::GetSystem(inSystem);
+	CVideoOutputDVDecoder theDecoder;
+	CVideoOutputWorkPool  *pPool = CVideoOutputWorkPool::GetSharedPool();
+	long		 theRowBytes = theSystem.width * 2;
+	Ptr			 pPixels = NULL, pDecoded = NULL, pFrame = NULL;
+	AbsoluteTime theStart, theEnd;
+	Nanoseconds	 theElapsed;
+	OSErr		 err = noErr;
+
+	::memset(&outResult, 0, sizeof(outResult));
+
+	pPixels = ::NewPtr(theRowBytes * theSystem.height);
+	pDecoded = ::NewPtr(theRowBytes * theSystem.height);
+	pFrame = ::NewPtr(theSystem.frameSize);
+	if (NULL == pPixels || NULL == pDecoded || NULL == pFrame) { err = memFullErr; goto bail; }
+
+	CVideoOutputDVEncoder::FillTestPattern(inSystem, (UInt8 *)pPixels, theRowBytes);
+	{ // gcc complains without this in brackets
+		CVideoOutputDVEncoder theEncoder(inSystem);
+		err = theEncoder.EncodeFrame((UInt8 *)pPixels, theRowBytes, k2vuyPixelFormat, (UInt8 *)pFrame);
+		if (err) goto bail;
+	}
+
+	err = CVideoOutputDV::CheckFrameFormat((UInt8 *)pFrame, inSystem, true);
+	outResult.isFormatOK = (noErr == err);
+	if (err) goto bail;
+
+	theDecoder.mMaxTasks = inMaxTasks;
+
+	err = theDecoder.DecodeFrame((UInt8 *)pFrame, (UInt8 *)pDecoded, theRowBytes, k2vuyPixelFormat);
+	if (err) goto bail;
+
+	GetPSNR(inSystem, (UInt8 *)pPixels, (UInt8 *)pDecoded, theRowBytes, outResult.lumaPSNR, outResult.chromaPSNR);
+	if (outResult.lumaPSNR < kDVMinLumaPSNR || outResult.chromaPSNR < kDVMinChromaPSNR) { err = codecBadDataErr; goto bail; }
+
+	theStart = ::UpTime();
+	for (UInt32 i = 0; i < inFrames; i++) {
+		err = theDecoder.DecodeFrame((UInt8 *)pFrame, (UInt8 *)pDecoded, theRowBytes, k2vuyPixelFormat);
+		if (err) goto bail;
+	}
+	theEnd = ::UpTime();
+
+	theElapsed = ::AbsoluteToNanoseconds(::SubAbsoluteFromAbsolute(theEnd, theStart));
+
+	outResult.frames = inFrames;
+	outResult.processors = pPool ? pPool->GetWorkerCount() + 1 : 1;
+	if (inMaxTasks && inMaxTasks < outResult.processors) outResult.processors = inMaxTasks;
+	outResult.seconds = ::UnsignedWideToUInt64(theElapsed) / 1.0e9;
+	if (outResult.seconds > 0) {
+		outResult.framesPerSecond = inFrames / outResult.seconds;
+		outResult.realtimeStreams = outResult.framesPerSecond / ::Fix2X(theSystem.frameRate);
+	}
+
+bail:
+	if (pPixels) ::DisposePtr(pPixels);
+	if (pDecoded) ::DisposePtr(pDecoded);
+	if (pFrame) ::DisposePtr(pFrame);
+
+	return err;
+}
@@ -0,0 +1,150 @@
+/*
+	File:		 CVideoOutputDVDecoder.h
+	
+	Description: A software DV25 decoder for echo port previews and video output components which don't
+				 take DV. The video segments of a frame are decoded in parallel on the shared
+				 CVideoOutputWorkPool, straight into '2vuy' or 'yuvs' pixels.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <4> 10/19/26 Benchmark checks the round trip first
+										<3> 10/19/26 added StartDecodeFrame and FinishDecodeFrame
+										<2> 10/19/26 added SetLegalizer
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputDVDecoder( void )
+
+	DecodeFrame( const UInt8 *inFrame, UInt8 *outPixels, long inRowBytes, OSType inPixelFormat )
+		Decodes a 525/60 or 625/50 DV frame, the system comes from the DIF header. outPixels must hold
+		a 720 x 480 or 720 x 576 frame of inPixelFormat, '2vuy' or 'yuvs', inRowBytes apart. Damaged
+		blocks decode as far as they make sense and the rest of the frame is carried on with.
+
+	StartDecodeFrame( const UInt8 *inFrame, UInt8 *outPixels, long inRowBytes, OSType inPixelFormat )
+	FinishDecodeFrame( void )
+		DecodeFrame in two halves. The frame's segments are queued on the work pool and StartDecodeFrame
+		returns, so the caller can get on - other sessions can start their frames and the pool shares its
+		tasks between them. FinishDecodeFrame does what the pool hasn't got to yet and returns once the
+		frame's all there. inFrame and outPixels must stay put in between. IsFrameDecoded() says whether
+		Finish would have to wait, IsDecodingFrame() whether there's a frame to finish.
+
+	SetLegalizer( CVideoOutputLegalizer *inLegalizer )
+		Each macroblock is legalized as soon as it's been stored, while it's still in the cache, and the
+		legalizer told how many pixels were changed once the frame's done. Pass NULL to stop. Not while a
+		frame is being decoded.
+
+	Benchmark( DVSystem inSystem, UInt32 inFrames, UInt32 inMaxTasks, DVBenchmarkRecord &outResult )
+		Decodes a frame of CVideoOutputDVEncoder::FillTestPattern() inFrames times and reports the
+		throughput. inMaxTasks limits the tasks working on each frame (0 for all of them), run it with
+		1, 2, 4 ... to see how it scales. First the encoded frame's layout is checked and it's decoded
+		and compared with the pattern: codecBadDataErr, with the PSNR in outResult, if the frame is laid
+		out wrong or the picture which comes back is below kDVMinLumaPSNR or kDVMinChromaPSNR.
+*/
+
+#ifndef __CVIDEOOUTPUTDVDECODER_H__
+	#define __CVIDEOOUTPUTDVDECODER_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <ImageCompression.h>
+#endif
+
+#include <memory>
+
+#include "CVideoOutputDV.h"
+#include "CVideoOutputDVEncoder.h"
+#include "CVideoOutputWorkPool.h"
+#include "CVideoOutputLegalizer.h"
+
+namespace dts {
+
+// What DV25 at its own rate keeps of CVideoOutputDVEncoder::FillTestPattern(), with room to spare
+const double kDVMinLumaPSNR = 40.0;
+const double kDVMinChromaPSNR = 45.0;
+
+class CVideoOutputDVDecoder {
+	public:
+		CVideoOutputDVDecoder();
+		~CVideoOutputDVDecoder() { FinishDecodeFrame(); }
+
+		OSErr DecodeFrame(const UInt8 *inFrame, UInt8 *outPixels, long inRowBytes, OSType inPixelFormat);
+		OSErr StartDecodeFrame(const UInt8 *inFrame, UInt8 *outPixels, long inRowBytes, OSType inPixelFormat);
+		void  FinishDecodeFrame(void);
+		Boolean IsDecodingFrame(void) const { return mFrame != NULL; }
+		Boolean IsFrameDecoded(void) const { return NULL == mFrame || NULL == CVideoOutputWorkPool::GetSharedPool() || CVideoOutputWorkPool::IsFinished(mJob); }
+
+		void SetLegalizer(CVideoOutputLegalizer *inLegalizer) { mLegalizer = inLegalizer; }
+
+		static OSErr Benchmark(DVSystem inSystem, UInt32 inFrames, UInt32 inMaxTasks, DVBenchmarkRecord &outResult);
+
+	private:
+		static void DecodeSegmentProc(void *inRefCon, UInt32 inItem);
+		void DecodeSegment(UInt8 inSequence, UInt8 inSegment);
+
+		// nope
+		CVideoOutputDVDecoder(const CVideoOutputDVDecoder &inDecoder);
+		CVideoOutputDVDecoder operator=(CVideoOutputDVDecoder inDecoder);
+
+	private:
+		// the frame being decoded
+		DVSystem	mSystem;
+		const UInt8	*mFrame;
+		UInt8		*mPixels;
+		long		mRowBytes;
+		UInt8		mLumaOffset, mCbOffset, mCrOffset;	// byte offsets within a 2 pixel group
+		UInt32		mMaxTasks;
+		WorkJobRecord mJob;				// on the pool between Start and Finish
+
+		CVideoOutputLegalizer *mLegalizer;
+		UInt32		mCorrected;			// atomic, pixels the legalizer changed in the frame
+};
+
+typedef std::auto_ptr<CVideoOutputDVDecoder> CVideoOutputDVDecoderPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTDVDECODER_H__
@@ -0,0 +1,556 @@
+/*
+	File:		 CVideoOutputDVEncoder.cpp
+	
+	Description: Software DV25 encoder.
+				 See CVideoOutputDVEncoder.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <6> 10/19/26 EncodeFrame is StartEncodeFrame then FinishEncodeFrame
+										<5> 10/19/26 Benchmark checks the layout of the frame it encoded
+										<4> 10/19/26 legalize each macroblock as it's loaded
+										<3> 10/19/26 added trace points
+										<2> 10/19/26 Benchmark can limit the tasks used, added FillTestPattern
+										<1> 10/19/26 initial release
+*/
+
+#include <string.h>
+
+#include "CVideoOutputDVEncoder.h"
+#include "CVideoOutputTrace.h"
+
+using namespace dts;
+
+const UInt8 kBlocksPerSegment = kDVMacroblocksPerSegment * kDVBlocksPerMacroblock;
+
+// Largest weighted AC amplitude for classes 0, 1 and 2, anything bigger is class 3
+static const UInt16 kClassThreshold[3] = { 11, 23, 35 };
+
+// A block goes 2-4-8 when the lines of a field are this much closer than the lines of the frame
+const UInt32 kFieldActivityRatio = 2;
+const UInt32 kMinFrameActivity = 7 * 8 * 4;
+
+typedef struct {
+	SInt16	dc;
+	Boolean	is248;
+	UInt8	klass;
+
+	// the non zero weighted AC coefficients in scan order
+	UInt8	count;
+	UInt8	scanIndex[63];
+	UInt16	amplitude[63];
+	Boolean	negative[63];
+
+	// writing out
+	UInt8	quantNumber;
+	UInt8	next;			// next entry of scanIndex[] to code
+	UInt8	lastScanIndex;	// scan index of the last coefficient coded
+	UInt32	pendingCode;	// a code which didn't fit in the space we had
+	UInt8	pendingBits;
+	Boolean	isFinished;		// end of block written
+} BlockStateRecord, *BlockStatePtr;
+
+CVideoOutputDVEncoder::CVideoOutputDVEncoder(DVSystem inSystem, Boolean inInterlaced) : mSystem(inSystem), mInterlaced(inInterlaced), mPixels(NULL), mRowBytes(0),
+																						  mLumaOffset(1), mCbOffset(0), mCrOffset(2), mFrame(NULL), mMaxTasks(0),
+																						  mLegalizer(NULL), mCorrected(0)
+{
+	CVideoOutputDV::InitTables();
+
+	// Make sure the pool is created on this thread
+	CVideoOutputWorkPool::GetSharedPool();
+}
+
+OSErr CVideoOutputDVEncoder::EncodeFrame(const UInt8 *inPixels, long inRowBytes, OSType inPixelFormat, UInt8 *outFrame)
+{
+	OSErr err;
+
+	VIDEO_OUTPUT_TRACE_SCOPE("encode");
+
+	err = StartEncodeFrame(inPixels, inRowBytes, inPixelFormat, outFrame);
+	if (err) return err;
+
+	FinishEncodeFrame();
+
+	return noErr;
+}
+
+OSErr CVideoOutputDVEncoder::StartEncodeFrame(const UInt8 *inPixels, long inRowBytes, OSType inPixelFormat, UInt8 *outFrame)
+{
+	const DVSystemRecord &theSystem = CVideoOutputDV::GetSystem(mSystem);
+	CVideoOutputWorkPool *pPool = CVideoOutputWorkPool::GetSharedPool();
+	UInt32 theSegmentCount = theSystem.sequenceCount * kDVSegmentsPerSequence;
+	OSErr  err = noErr;
+
+	if (NULL == inPixels || NULL == outFrame) return paramErr;
+
+	FinishEncodeFrame();
+
+	switch (inPixelFormat) {
+	case k2vuyPixelFormat:	// Cb Y0 Cr Y1
+		mLumaOffset = 1; mCbOffset = 0; mCrOffset = 2;
+		break;
+	case kYUVSPixelFormat:	// Y0 Cb Y1 Cr
+		mLumaOffset = 0; mCbOffset = 1; mCrOffset = 3;
+		break;
+	default:
+		return paramErr;
+	}
+
+	mPixels = inPixels;
+	mRowBytes = inRowBytes;
+	mFrame = outFrame;
+	mCorrected = 0;
+
+	CVideoOutputDV::FormatFrame(outFrame, mSystem, mInterlaced);
+
+	if (pPool) {
+		err = pPool->Start(mJob, EncodeSegmentProc, this, theSegmentCount, mMaxTasks);
+		if (err) { mPixels = NULL; mFrame = NULL; }
+	} else {
+		for (UInt32 i = 0; i < theSegmentCount; i++) EncodeSegmentProc(this, i);
+	}
+
+	return err;
+}
+
+void CVideoOutputDVEncoder::FinishEncodeFrame(void)
+{
+	CVideoOutputWorkPool *pPool = CVideoOutputWorkPool::GetSharedPool();
+
+	if (NULL == mFrame) return;
+
+	if (pPool) pPool->Finish(mJob);
+
+	if (mLegalizer) mLegalizer->FrameDone(mCorrected);
+
+	mPixels = NULL;
+	mFrame = NULL;
+}
+
+void CVideoOutputDVEncoder::EncodeSegmentProc(void *inRefCon, UInt32 inItem)
+{
+	((CVideoOutputDVEncoder *)inRefCon)->EncodeSegment(inItem / kDVSegmentsPerSequence, inItem % kDVSegmentsPerSequence);
+}
+
+#pragma mark-
+
+// Centered samples of the 6 blocks of a macroblock, Y0 Y1 Y2 Y3 Cr Cb
+static void LoadMacroblock(const UInt8 *inPixels, long inRowBytes, UInt8 inLumaOffset, UInt8 inCbOffset, UInt8 inCrOffset,
+						   const DVMacroblockRecord &inMacroblock, Boolean in420, SInt16 outSamples[kDVBlocksPerMacroblock][64])
+{
+	for (UInt8 b = 0; b < 4; b++) {
+		// 32 x 8 is four blocks across, 16 x 16 is two across and two down
+		UInt16 theX = inMacroblock.x + (inMacroblock.isSquare ? (b & 1) * 8 : b * 8);
+		UInt16 theY = inMacroblock.y + (inMacroblock.isSquare ? (b >> 1) * 8 : 0);
+
+		for (UInt8 row = 0; row < 8; row++) {
+			const UInt8 *pLine = inPixels + (theY + row) * inRowBytes + theX * 2 + inLumaOffset;
+			SInt16		*pOut = &outSamples[b][row * 8];
+
+			for (UInt8 column = 0; column < 8; column++) pOut[column] = pLine[column * 2] - 128;
+		}
+	}
+
+	for (UInt8 c = 0; c < 2; c++) {
+		UInt8  theOffset = c ? inCbOffset : inCrOffset;
+		SInt16 *pOut = outSamples[4 + c];
+
+		if (in420) {
+			// Each chroma sample covers 2 x 2 pixels, average the two lines
+			for (UInt8 row = 0; row < 8; row++) {
+				const UInt8 *pLine = inPixels + (inMacroblock.y + row * 2) * inRowBytes + inMacroblock.x * 2 + theOffset;
+
+				for (UInt8 column = 0; column < 8; column++)
+					pOut[row * 8 + column] = ((pLine[column * 4] + pLine[column * 4 + inRowBytes] + 1) >> 1) - 128;
+			}
+		} else if (!inMacroblock.isSquare) {
+			// Each chroma sample covers 4 x 1 pixels, average the two 2vuy samples
+			for (UInt8 row = 0; row < 8; row++) {
+				const UInt8 *pLine = inPixels + (inMacroblock.y + row) * inRowBytes + inMacroblock.x * 2 + theOffset;
+
+				for (UInt8 column = 0; column < 8; column++)
+					pOut[row * 8 + column] = ((pLine[column * 8] + pLine[column * 8 + 4] + 1) >> 1) - 128;
+			}
+		} else {
+			// The right hand 4 chroma samples of 16 lines, the top 8 lines on the left of the block, the bottom 8 on the right
+			for (UInt8 row = 0; row < 16; row++) {
+				const UInt8 *pLine = inPixels + (inMacroblock.y + row) * inRowBytes + inMacroblock.x * 2 + theOffset;
+				SInt16		*pBlock = pOut + (row & 7) * 8 + (row >> 3) * 4;
+
+				for (UInt8 column = 0; column < 4; column++)
+					pBlock[column] = ((pLine[column * 8] + pLine[column * 8 + 4] + 1) >> 1) - 128;
+			}
+		}
+	}
+}
+
+// Compare the vertical detail between the lines of the frame and between the lines of each field
+static Boolean HasFieldMotion(const SInt16 *inSamples)
+{
+	UInt32 theFrame = 0, theField = 0;
+
+	for (UInt8 row = 0; row < 7; row++) {
+		for (UInt8 column = 0; column < 8; column++) {
+			SInt16 theDelta = inSamples[row * 8 + column] - inSamples[(row + 1) * 8 + column];
+			theFrame += (theDelta < 0) ? -theDelta : theDelta;
+
+			if (row < 6) {
+				theDelta = inSamples[row * 8 + column] - inSamples[(row + 2) * 8 + column];
+				theField += (theDelta < 0) ? -theDelta : theDelta;
+			}
+		}
+	}
+
+	// 7 frame line pairs against 6 field line pairs
+	return (theFrame > kMinFrameActivity && theFrame * 6 > theField * 7 * kFieldActivityRatio);
+}
+
+static void PrepareBlock(SInt16 *ioSamples, Boolean inIsChroma, Boolean inInterlaced, BlockStateRecord &outBlock)
+{
+	const UInt8 *pScan;
+	UInt16		theMax = 0;
+
+	outBlock.is248 = (inInterlaced && !inIsChroma && HasFieldMotion(ioSamples));
+
+	CVideoOutputDV::ForwardDCT(ioSamples, outBlock.is248);
+
+	// DC is 1/4 of the orthonormal DC, the DCT gives us 8 times that
+	outBlock.dc = (ioSamples[0] + 16) >> 5;
+	if (outBlock.dc > 255) outBlock.dc = 255;
+	if (outBlock.dc < -256) outBlock.dc = -256;
+
+	pScan = CVideoOutputDV::GetScan(outBlock.is248);
+	outBlock.count = 0;
+
+	for (UInt8 i = 1; i < 64; i++) {
+		SInt32 theCoefficient = ioSamples[pScan[i]];
+		UInt32 theAmplitude = (theCoefficient < 0) ? -theCoefficient : theCoefficient;
+
+		theAmplitude = (theAmplitude * CVideoOutputDV::GetWeight(outBlock.is248, i) + 0x8000) >> 16;
+		if (theAmplitude) {
+			outBlock.scanIndex[outBlock.count] = i;
+			outBlock.amplitude[outBlock.count] = theAmplitude;
+			outBlock.negative[outBlock.count] = (theCoefficient < 0);
+			outBlock.count++;
+
+			if (theAmplitude > theMax) theMax = theAmplitude;
+		}
+	}
+
+	// Chroma is a class higher for the same amplitude
+	for (outBlock.klass = 0; outBlock.klass < kDVMaxClass && theMax > kClassThreshold[outBlock.klass]; outBlock.klass++) ;
+	if (inIsChroma && outBlock.klass < kDVMaxClass) outBlock.klass++;
+}
+
+static UInt16 QuantizedAmplitude(const BlockStateRecord &inBlock, UInt8 inEntry, UInt8 inQuantNumber)
+{
+	UInt8 theArea = CVideoOutputDV::GetArea(inBlock.scanIndex[inEntry]);
+
+	return inBlock.amplitude[inEntry] >> CVideoOutputDV::GetQuantShift(inQuantNumber, inBlock.klass, theArea);
+}
+
+// The AC bits a block needs at a quantization number, end of block included
+static UInt16 CountBits(const BlockStateRecord &inBlock, UInt8 inQuantNumber)
+{
+	UInt16 theBits = kDVEndOfBlockBits;
+	UInt8  thePrevious = 0;
+	UInt32 theCode;
+
+	for (UInt8 j = 0; j < inBlock.count; j++) {
+		UInt16 theAmplitude = QuantizedAmplitude(inBlock, j, inQuantNumber);
+
+		if (theAmplitude) {
+			theBits += CVideoOutputDV::MakeVLC(inBlock.scanIndex[j] - thePrevious - 1, theAmplitude, false, theCode);
+			thePrevious = inBlock.scanIndex[j];
+		}
+	}
+
+	return theBits;
+}
+
+// The next code of a block, the end of block code once the coefficients run out
+static void NextCode(BlockStateRecord &ioBlock)
+{
+	UInt32 theCode;
+
+	while (ioBlock.next < ioBlock.count) {
+		UInt8  j = ioBlock.next++;
+		UInt16 theAmplitude = QuantizedAmplitude(ioBlock, j, ioBlock.quantNumber);
+
+		if (theAmplitude) {
+			ioBlock.pendingBits = CVideoOutputDV::MakeVLC(ioBlock.scanIndex[j] - ioBlock.lastScanIndex - 1, theAmplitude, ioBlock.negative[j], theCode);
+			ioBlock.pendingCode = theCode;
+			ioBlock.lastScanIndex = ioBlock.scanIndex[j];
+			return;
+		}
+	}
+
+	ioBlock.pendingCode = 0x6;
+	ioBlock.pendingBits = kDVEndOfBlockBits;
+	ioBlock.isFinished = true;
+}
+
+/* WriteAC
+		Writes the codes of a block into inBuffer, moving on to the following buffers up to inEnd when it
+		fills up. A code can be split across buffers. Returns the buffer it stopped in, the block keeps the
+		part of a code that didn't fit for the next pass.
+*/
+static DVBitBufferPtr WriteAC(BlockStateRecord &ioBlock, DVBitBufferPtr inBuffer, DVBitBufferPtr inEnd)
+{
+	DVBitBufferPtr pBuffer = inBuffer;
+
+	for (;;) {
+		UInt16 theLeft;
+
+		while (ioBlock.pendingBits > (theLeft = CVideoOutputDV::GetBitsLeft(*pBuffer))) {
+			if (theLeft) {
+				ioBlock.pendingBits -= theLeft;
+				CVideoOutputDV::PutBits(*pBuffer, ioBlock.pendingCode >> ioBlock.pendingBits, theLeft);
+				ioBlock.pendingCode &= (1UL << ioBlock.pendingBits) - 1;
+			}
+			if (pBuffer + 1 >= inEnd) return pBuffer;
+			pBuffer++;
+		}
+
+		CVideoOutputDV::PutBits(*pBuffer, ioBlock.pendingCode, ioBlock.pendingBits);
+		ioBlock.pendingBits = 0;
+
+		if (ioBlock.isFinished) return pBuffer;
+
+		NextCode(ioBlock);
+	}
+}
+
+/* EncodeSegment
+		Transform and weight the 30 blocks, pick a quantization number for each macroblock so the segment
+		fits, then distribute the bits the DV way: each block in its own area first, what doesn't fit into
+		the space left over in its own macroblock, and what still doesn't fit anywhere in the segment.
+*/
+void CVideoOutputDVEncoder::EncodeSegment(UInt8 inSequence, UInt8 inSegment)
+{
+	const DVSystemRecord &theSystem = CVideoOutputDV::GetSystem(mSystem);
+	BlockStateRecord  theBlocks[kBlocksPerSegment];
+	DVBitBufferRecord theBuffers[kBlocksPerSegment];
+	UInt8			  theQuantNumbers[kDVMacroblocksPerSegment];
+	UInt16			  theBits[kDVMacroblocksPerSegment];
+	UInt32			  theTotal = 0;
+	UInt32			  theCorrected = 0;
+	DVBitBufferPtr	  pBuffer;
+
+	for (UInt8 m = 0; m < kDVMacroblocksPerSegment; m++) {
+		DVMacroblockRecord theMacroblock;
+		SInt16			   theSamples[kDVBlocksPerMacroblock][64];
+
+		CVideoOutputDV::GetMacroblock(mSystem, inSequence, inSegment, m, theMacroblock);
+
+		if (mLegalizer) {
+			// Legalized into a copy of the 16 x 16 or 32 x 8 pixels, which is loaded from instead
+			UInt8			   theLegal[16 * 16 * 2];
+			long			   theLegalRowBytes = theMacroblock.isSquare ? 32 : 64;
+			DVMacroblockRecord theLegalMacroblock = theMacroblock;
+
+			theCorrected += mLegalizer->LegalizeRect(mPixels + theMacroblock.y * mRowBytes + theMacroblock.x * 2, mRowBytes, theLegal, theLegalRowBytes,
+													 theLegalRowBytes / 4, sizeof(theLegal) / theLegalRowBytes);
+			theLegalMacroblock.x = theLegalMacroblock.y = 0;
+			LoadMacroblock(theLegal, theLegalRowBytes, mLumaOffset, mCbOffset, mCrOffset, theLegalMacroblock, theSystem.is420, theSamples);
+		} else {
+			LoadMacroblock(mPixels, mRowBytes, mLumaOffset, mCbOffset, mCrOffset, theMacroblock, theSystem.is420, theSamples);
+		}
+
+		theQuantNumbers[m] = kDVMaxQuantNumber;
+		theBits[m] = 0;
+
+		for (UInt8 b = 0; b < kDVBlocksPerMacroblock; b++) {
+			BlockStateRecord &theBlock = theBlocks[m * kDVBlocksPerMacroblock + b];
+
+			PrepareBlock(theSamples[b], b >= 4, mInterlaced, theBlock);
+			theBits[m] += CountBits(theBlock, kDVMaxQuantNumber);
+		}
+
+		theTotal += theBits[m];
+	}
+
+	if (theCorrected) ::AddAtomic(theCorrected, (SInt32 *)&mCorrected);
+
+	// Coarser quantization for the biggest macroblock until the segment fits
+	while (theTotal > kDVSegmentACBits) {
+		SInt8 theBiggest = -1;
+
+		for (UInt8 m = 0; m < kDVMacroblocksPerSegment; m++) {
+			if (theQuantNumbers[m] && (theBiggest < 0 || theBits[m] > theBits[theBiggest])) theBiggest = m;
+		}
+		if (theBiggest < 0) break;
+
+		theTotal -= theBits[theBiggest];
+		theQuantNumbers[theBiggest]--;
+		theBits[theBiggest] = 0;
+		for (UInt8 b = 0; b < kDVBlocksPerMacroblock; b++)
+			theBits[theBiggest] += CountBits(theBlocks[theBiggest * kDVBlocksPerMacroblock + b], theQuantNumbers[theBiggest]);
+		theTotal += theBits[theBiggest];
+	}
+
+	// Block headers, and pass 1 - each block in its own area
+	for (UInt8 m = 0; m < kDVMacroblocksPerSegment; m++) {
+		UInt8 *pDIF = CVideoOutputDV::GetVideoBlock(mFrame, inSequence, inSegment, m);
+		UInt8 *pData = pDIF + 4;
+
+		pDIF[3] = theQuantNumbers[m];	// STA 0, QNO
+		::memset(pData, 0, kDVDIFBlockSize - 4);
+
+		for (UInt8 b = 0; b < kDVBlocksPerMacroblock; b++) {
+			UInt8			  j = m * kDVBlocksPerMacroblock + b;
+			BlockStateRecord  &theBlock = theBlocks[j];
+			DVBitBufferRecord &theBuffer = theBuffers[j];
+
+			theBuffer.data = pData;
+			theBuffer.size = CVideoOutputDV::GetBlockBits(b);
+			theBuffer.used = 0;
+			pData += theBuffer.size >> 3;
+
+			CVideoOutputDV::PutBits(theBuffer, theBlock.dc & 0x1FF, 9);
+			CVideoOutputDV::PutBits(theBuffer, theBlock.is248, 1);
+			CVideoOutputDV::PutBits(theBuffer, theBlock.klass, 2);
+
+			theBlock.quantNumber = theQuantNumbers[m];
+			theBlock.next = 0;
+			theBlock.lastScanIndex = 0;
+			theBlock.isFinished = false;
+			NextCode(theBlock);
+
+			WriteAC(theBlock, &theBuffer, &theBuffer + 1);
+		}
+	}
+
+	// Pass 2 - within each macroblock
+	for (UInt8 m = 0; m < kDVMacroblocksPerSegment; m++) {
+		DVBitBufferPtr pStart = &theBuffers[m * kDVBlocksPerMacroblock];
+
+		pBuffer = pStart;
+		for (UInt8 b = 0; b < kDVBlocksPerMacroblock; b++) {
+			BlockStateRecord &theBlock = theBlocks[m * kDVBlocksPerMacroblock + b];
+
+			if (theBlock.pendingBits) pBuffer = WriteAC(theBlock, pBuffer, pStart + kDVBlocksPerMacroblock);
+		}
+	}
+
+	// Pass 3 - anywhere in the segment
+	pBuffer = theBuffers;
+	for (UInt8 j = 0; j < kBlocksPerSegment; j++) {
+		if (theBlocks[j].pendingBits) pBuffer = WriteAC(theBlocks[j], pBuffer, theBuffers + kBlocksPerSegment);
+	}
+}
+
+#pragma mark-
+
+/* Benchmark
+		The test frame has detail and noise in it, so the rate control has some work to do. A fast encoder
+		writing broken frames is no use, so the last one is checked before the figures are believed.
+*/
+OSErr CVideoOutputDVEncoder::Benchmark(DVSystem inSystem, UInt32 inFrames, UInt32 inMaxTasks, DVBenchmarkRecord &outResult)
+{
+	const DVSystemRecord &theSystem = CVideoOutputDV::GetSystem(inSystem);
+	CVideoOutputDVEncoder theEncoder(inSystem);
+	CVideoOutputWorkPool  *pPool = CVideoOutputWorkPool::GetSharedPool();
+	long		 theRowBytes = theSystem.width * 2;
+	Ptr			 pPixels = NULL, pFrame = NULL;
+	AbsoluteTime theStart, theEnd;
+	Nanoseconds	 theElapsed;
+	OSErr		 err = noErr;
+
+	::memset(&outResult, 0, sizeof(outResult));
+
+	pPixels = ::NewPtr(theRowBytes * theSystem.height);
+	pFrame = ::NewPtr(theSystem.frameSize);
+	if (NULL == pPixels || NULL == pFrame) { err = memFullErr; goto bail; }
+
+	FillTestPattern(inSystem, (UInt8 *)pPixels, theRowBytes);
+
+	theEncoder.mMaxTasks = inMaxTasks;
+
+	theStart = ::UpTime();
+	for (UInt32 i = 0; i < inFrames; i++) {
+		err = theEncoder.EncodeFrame((UInt8 *)pPixels, theRowBytes, k2vuyPixelFormat, (UInt8 *)pFrame);
+		if (err) goto bail;
+	}
+	theEnd = ::UpTime();
+
+	if (inFrames) {
+		err = CVideoOutputDV::CheckFrameFormat((UInt8 *)pFrame, inSystem, true);
+		outResult.isFormatOK = (noErr == err);
+		if (err) goto bail;
+	}
+
+	theElapsed = ::AbsoluteToNanoseconds(::SubAbsoluteFromAbsolute(theEnd, theStart));
+
+	outResult.frames = inFrames;
+	outResult.processors = pPool ? pPool->GetWorkerCount() + 1 : 1;
+	if (inMaxTasks && inMaxTasks < outResult.processors) outResult.processors = inMaxTasks;
+	outResult.seconds = ::UnsignedWideToUInt64(theElapsed) / 1.0e9;
+	if (outResult.seconds > 0) {
+		outResult.framesPerSecond = inFrames / outResult.seconds;
+		outResult.realtimeStreams = outResult.framesPerSecond / ::Fix2X(theSystem.frameRate);
+	}
+
+bail:
+	if (pPixels) ::DisposePtr(pPixels);
+	if (pFrame) ::DisposePtr(pFrame);
+
+	return err;
+}
+
+void CVideoOutputDVEncoder::FillTestPattern(DVSystem inSystem, UInt8 *outPixels, long inRowBytes)
+{
+	const DVSystemRecord &theSystem = CVideoOutputDV::GetSystem(inSystem);
+	UInt32 theSeed = 1;
+
+	for (long y = 0; y < theSystem.height; y++) {
+		UInt8 *pLine = outPixels + y * inRowBytes;
+
+		for (long x = 0; x < theSystem.width; x++) {
+			theSeed = theSeed * 1103515245 + 12345;
+
+			// Cb ramps across, Cr down, luma is a diagonal ramp with a check and some noise on top
+			pLine[x * 2] = (x & 1) ? 80 + ((y * 96) / theSystem.height) : 80 + ((x * 96) / theSystem.width);
+			pLine[x * 2 + 1] = 16 + ((x + y) * 200) / (theSystem.width + theSystem.height) + ((x / 8 + y / 8) & 1) * 16 + ((theSeed >> 16) & 7);
+		}
+	}
+}
@@ -0,0 +1,166 @@
+/*
+	File:		 CVideoOutputDVEncoder.h
+	
+	Description: A software DV25 encoder for video output components which only take DV frames.
+				 The video segments of a frame are encoded in parallel on the shared CVideoOutputWorkPool.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <5> 10/19/26 added StartEncodeFrame and FinishEncodeFrame
+										<4> 10/19/26 Benchmark checks the layout of the frame it encoded
+										<3> 10/19/26 added SetLegalizer
+										<2> 10/19/26 Benchmark can limit the tasks used, added FillTestPattern
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputDVEncoder( DVSystem inSystem, Boolean inInterlaced = true )
+		inInterlaced lets the encoder pick the 2-4-8 DCT for blocks with motion between the fields,
+		pass false for progressive material.
+
+	EncodeFrame( const UInt8 *inPixels, long inRowBytes, OSType inPixelFormat, UInt8 *outFrame )
+		Encodes a 720 x 480 (525/60) or 720 x 576 (625/50) frame of '2vuy' or 'yuvs' pixels into
+		outFrame, which must be GetFrameSize() bytes. Each video segment gets its own quantization
+		per macroblock so that it fills, but never overflows, its 5 DIF blocks.
+
+	StartEncodeFrame( const UInt8 *inPixels, long inRowBytes, OSType inPixelFormat, UInt8 *outFrame )
+	FinishEncodeFrame( void )
+		EncodeFrame in two halves, like the decoder's. The frame's segments are queued on the work pool
+		and StartEncodeFrame returns, FinishEncodeFrame does what the pool hasn't got to yet and returns
+		once the frame's all there. inPixels and outFrame must stay put, and inPixels unchanged, in
+		between. IsFrameEncoded() says whether Finish would have to wait, IsEncodingFrame() whether
+		there's a frame to finish.
+
+	SetLegalizer( CVideoOutputLegalizer *inLegalizer )
+		Each macroblock is legalized as it's read from inPixels, which are left as they were, and the
+		legalizer told how many pixels were changed once the frame's done. Pass NULL to stop. Not while a
+		frame is being encoded.
+
+	Benchmark( DVSystem inSystem, UInt32 inFrames, UInt32 inMaxTasks, DVBenchmarkRecord &outResult )
+		Encodes inFrames synthetic frames as fast as possible and reports the throughput, and how many
+		realtime streams of inSystem that would sustain. inMaxTasks limits the tasks working on each frame
+		(0 for all of them), run it with 1, 2, 4 ... to see how it scales. The frame it encoded is then
+		checked with CVideoOutputDV::CheckFrameFormat(), codecBadDataErr if it isn't right.
+
+	FillTestPattern( DVSystem inSystem, UInt8 *outPixels, long inRowBytes )
+		Fills a '2vuy' frame with the ramps, checks and noise used by the benchmarks.
+*/
+
+#ifndef __CVIDEOOUTPUTDVENCODER_H__
+	#define __CVIDEOOUTPUTDVENCODER_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <ImageCompression.h>
+#endif
+
+#include <memory>
+
+#include "CVideoOutputDV.h"
+#include "CVideoOutputWorkPool.h"
+#include "CVideoOutputLegalizer.h"
+
+namespace dts {
+
+typedef struct {
+	UInt32	frames;
+	UInt32	processors;			// tasks working on each frame, the calling thread included
+	double	seconds;
+	double	framesPerSecond;
+	double	realtimeStreams;	// framesPerSecond over the frame rate of the system
+	Boolean	isFormatOK;			// the DIF blocks are where CVideoOutputDV::FormatFrame() puts them
+	double	lumaPSNR;			// dB, the test pattern encoded and decoded against itself, decoder only
+	double	chromaPSNR;
+} DVBenchmarkRecord;
+
+class CVideoOutputDVEncoder {
+	public:
+		explicit CVideoOutputDVEncoder(DVSystem inSystem, Boolean inInterlaced = true);
+		~CVideoOutputDVEncoder() { FinishEncodeFrame(); }
+
+		OSErr EncodeFrame(const UInt8 *inPixels, long inRowBytes, OSType inPixelFormat, UInt8 *outFrame);
+		OSErr StartEncodeFrame(const UInt8 *inPixels, long inRowBytes, OSType inPixelFormat, UInt8 *outFrame);
+		void  FinishEncodeFrame(void);
+		Boolean IsEncodingFrame(void) const { return mFrame != NULL; }
+		Boolean IsFrameEncoded(void) const { return NULL == mFrame || NULL == CVideoOutputWorkPool::GetSharedPool() || CVideoOutputWorkPool::IsFinished(mJob); }
+
+		void SetLegalizer(CVideoOutputLegalizer *inLegalizer) { mLegalizer = inLegalizer; }
+
+		DVSystem GetSystem(void) const { return mSystem; }
+		UInt32	 GetFrameSize(void) const { return CVideoOutputDV::GetSystem(mSystem).frameSize; }
+
+		static OSErr Benchmark(DVSystem inSystem, UInt32 inFrames, UInt32 inMaxTasks, DVBenchmarkRecord &outResult);
+		static void  FillTestPattern(DVSystem inSystem, UInt8 *outPixels, long inRowBytes);
+
+	private:
+		static void EncodeSegmentProc(void *inRefCon, UInt32 inItem);
+		void EncodeSegment(UInt8 inSequence, UInt8 inSegment);
+
+		// nope
+		CVideoOutputDVEncoder(const CVideoOutputDVEncoder &inEncoder);
+		CVideoOutputDVEncoder operator=(CVideoOutputDVEncoder inEncoder);
+
+	private:
+		DVSystem	mSystem;
+		Boolean		mInterlaced;
+
+		// the frame being encoded
+		const UInt8	*mPixels;
+		long		mRowBytes;
+		UInt8		mLumaOffset, mCbOffset, mCrOffset;	// byte offsets within a 2 pixel group
+		UInt8		*mFrame;
+		UInt32		mMaxTasks;
+		WorkJobRecord mJob;				// on the pool between Start and Finish
+
+		CVideoOutputLegalizer *mLegalizer;
+		UInt32		mCorrected;			// atomic, pixels the legalizer changed in the frame
+};
+
+typedef std::auto_ptr<CVideoOutputDVEncoder> CVideoOutputDVEncoderPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTDVENCODER_H__
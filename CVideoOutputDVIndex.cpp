@@ -0,0 +1,589 @@
+/*
+	File:		 CVideoOutputDVIndex.cpp
+	
+	Description: Frame and timecode index of a raw DV file.
+				 See CVideoOutputDVIndex.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 added trace points
+										<1> 10/19/26 initial release
+*/
+
+#include <algorithm>
+
+#include "CVideoOutputDVIndex.h"
+#include "CVideoOutputTrace.h"
+
+using namespace dts;
+
+// Each task reads and scans this much of the file at a time
+const UInt32 kDVIndexChunkSize = 8 * 1024 * 1024;
+
+// Entries converted to big endian at a time by Save()
+const UInt32 kDVIndexSaveBlock = 4096;
+
+// The header, 2 subcode and 3 VAUX DIF blocks at the start of every DIF sequence
+const UInt8  kDVFrameHeadBlocks = 6;
+const UInt32 kDVFrameHeadSize = kDVFrameHeadBlocks * kDVDIFBlockSize;
+
+// Packs in the subcode and VAUX
+const UInt8 kDVTimecodePack = 0x13;
+const UInt8 kDVRecordingDatePack = 0x62;
+const UInt8 kDVRecordingTimePack = 0x63;
+
+typedef struct {
+	UInt32	timecode;
+	Boolean	isDropFrame;
+	Boolean	hasDate, hasTime;
+	UInt8	day, month, year;
+	UInt8	hours, minutes, seconds;
+} FramePacksRecord;
+
+class TimecodeLess {
+	public:
+		explicit TimecodeLess(const DVIndexEntryRecord *inEntries) : mEntries(inEntries) {}
+		bool operator()(UInt32 inA, UInt32 inB) const { return (mEntries[inA].timecode < mEntries[inB].timecode) ||
+															   (mEntries[inA].timecode == mEntries[inB].timecode && inA < inB); }
+	private:
+		const DVIndexEntryRecord *mEntries;
+};
+
+// The header, subcode and VAUX DIF blocks of the first DIF sequence, by section type and number
+static Boolean IsFrameStart(const UInt8 *inData)
+{
+	static const UInt8 kSectionTypes[kDVFrameHeadBlocks] = { 0x00, 0x20, 0x20, 0x40, 0x40, 0x40 };
+	static const UInt8 kBlockNumbers[kDVFrameHeadBlocks] = { 0, 0, 1, 0, 1, 2 };
+
+	for (UInt8 i = 0; i < kDVFrameHeadBlocks; i++) {
+		const UInt8 *pBlock = inData + i * kDVDIFBlockSize;
+
+		if ((pBlock[0] & 0xE0) != kSectionTypes[i] || (pBlock[1] & 0xF0) != 0 || pBlock[2] != kBlockNumbers[i]) return false;
+	}
+
+	return true;
+}
+
+static Boolean DecodeBCD(UInt8 inByte, UInt8 inMask, UInt8 inLimit, UInt8 &outValue)
+{
+	inByte &= inMask;
+	if ((inByte & 0x0F) > 9) return false;
+
+	outValue = (inByte >> 4) * 10 + (inByte & 0x0F);
+
+	return outValue < inLimit;
+}
+
+static void ReadPack(const UInt8 *inPack, FramePacksRecord &ioPacks)
+{
+	UInt8 theFrames, theSeconds, theMinutes, theHours;
+
+	switch (inPack[0]) {
+	case kDVTimecodePack:
+		if (ioPacks.timecode != kDVNoTimecode) break;
+		if (DecodeBCD(inPack[1], 0x3F, 30, theFrames) && DecodeBCD(inPack[2], 0x7F, 60, theSeconds) &&
+			DecodeBCD(inPack[3], 0x7F, 60, theMinutes) && DecodeBCD(inPack[4], 0x3F, 24, theHours)) {
+			ioPacks.timecode = CVideoOutputDVIndex::MakeTimecode(theHours, theMinutes, theSeconds, theFrames);
+			ioPacks.isDropFrame = (inPack[1] & 0x40) != 0;
+		}
+		break;
+	case kDVRecordingDatePack:
+		if (ioPacks.hasDate) break;
+		ioPacks.hasDate = DecodeBCD(inPack[2], 0x3F, 32, ioPacks.day) && DecodeBCD(inPack[3], 0x1F, 13, ioPacks.month) &&
+						  DecodeBCD(inPack[4], 0xFF, 100, ioPacks.year) && ioPacks.day && ioPacks.month;
+		break;
+	case kDVRecordingTimePack:
+		if (ioPacks.hasTime) break;
+		ioPacks.hasTime = DecodeBCD(inPack[2], 0x7F, 60, ioPacks.seconds) && DecodeBCD(inPack[3], 0x7F, 60, ioPacks.minutes) &&
+						  DecodeBCD(inPack[4], 0x3F, 24, ioPacks.hours);
+		break;
+	}
+}
+
+// Seconds since midnight January 1 1904 like GetDateTime(), without the toolbox so the MP tasks can call it.
+// DV years are 2 digits, 70 - 99 are taken to be 1900s
+static UInt32 RecordingSeconds(const FramePacksRecord &inPacks)
+{
+	static const UInt16 kDaysBeforeMonth[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+	UInt32 theYear = inPacks.year + ((inPacks.year < 70) ? 2000 : 1900);
+	UInt32 theDays;
+
+	// Every 4th year from 1904 is a leap year until 2100
+	theDays = (theYear - 1904) * 365 + (theYear - 1904 + 3) / 4 + kDaysBeforeMonth[inPacks.month - 1] + inPacks.day - 1;
+	if (inPacks.month > 2 && 0 == (theYear & 3)) theDays++;
+
+	return theDays * 86400 + (inPacks.hasTime ? inPacks.hours * 3600 + inPacks.minutes * 60 + inPacks.seconds : 0);
+}
+
+// Fills in the entry for the frame at inFrame, inLength is less than the frame size if the file ends first
+static void IndexFrame(const UInt8 *inFrame, UInt32 inLength, UInt64 inOffset, DVIndexEntryRecord &outEntry)
+{
+	const DVSystemRecord &theSystem = CVideoOutputDV::GetSystem(CVideoOutputDV::GetFrameSystem(inFrame));
+	FramePacksRecord	 thePacks;
+	UInt8				 theFlags = (CVideoOutputDV::GetFrameSystem(inFrame) == eDVSystem625_50) ? kDVIndexPAL : 0;
+
+	thePacks.timecode = kDVNoTimecode;
+	thePacks.isDropFrame = thePacks.hasDate = thePacks.hasTime = false;
+
+	if (inLength < theSystem.frameSize) theFlags |= kDVIndexTruncated;
+
+	// Every DIF sequence repeats the packs, look until we've got them all
+	for (UInt8 theSequence = 0; theSequence < theSystem.sequenceCount; theSequence++) {
+		const UInt8 *pSequence = inFrame + theSequence * kDVDIFSequenceSize;
+
+		if (theSequence * kDVDIFSequenceSize + kDVFrameHeadSize > inLength) break;
+
+		// 6 subcode sync blocks per DIF block, a 3 byte ID and a pack each
+		for (UInt8 j = 0; j < 2; j++) {
+			for (UInt8 k = 0; k < 6; k++) ReadPack(pSequence + (1 + j) * kDVDIFBlockSize + 3 + k * 8 + 3, thePacks);
+		}
+
+		// 15 packs per VAUX DIF block
+		for (UInt8 j = 0; j < 3; j++) {
+			for (UInt8 k = 0; k < 15; k++) ReadPack(pSequence + (3 + j) * kDVDIFBlockSize + 3 + k * 5, thePacks);
+		}
+
+		if (thePacks.timecode != kDVNoTimecode && thePacks.hasDate && thePacks.hasTime) break;
+	}
+
+	if (thePacks.isDropFrame) theFlags |= kDVIndexDropFrame;
+
+	outEntry.position = (inOffset & kDVIndexOffsetMask) | ((UInt64)theFlags << 56);
+	outEntry.timecode = thePacks.timecode;
+	outEntry.recorded = thePacks.hasDate ? RecordingSeconds(thePacks) : 0;
+}
+
+#pragma mark-
+
+CVideoOutputDVIndex::CVideoOutputDVIndex() : mFork(0), mFileSize(0), mModDate(0), mEntries(NULL), mFrameCount(0), mTimecodeOrder(NULL),
+											 mTimecodeCount(0), mChunkSize(0), mChunks(NULL), mFreeBuffers(0), mScanError(noErr)
+{
+	for (UInt32 i = 0; i < kMaxWorkTasks; i++) mBuffers[i] = NULL;
+}
+
+void CVideoOutputDVIndex::Dispose(void)
+{
+	if (mFork) ::FSCloseFork(mFork);
+	mFork = 0;
+	mFileSize = 0;
+	mModDate = 0;
+
+	if (mEntries) ::DisposePtr((Ptr)mEntries);
+	mEntries = NULL;
+	mFrameCount = 0;
+
+	if (mTimecodeOrder) ::DisposePtr((Ptr)mTimecodeOrder);
+	mTimecodeOrder = NULL;
+	mTimecodeCount = 0;
+}
+
+OSErr CVideoOutputDVIndex::OpenDVFile(const FSSpec &inDVFile)
+{
+	HFSUniStr255  theDataForkName;
+	FSCatalogInfo theInfo;
+	FSRef		  theFileRef;
+	OSErr		  err;
+
+	err = ::FSpMakeFSRef(&inDVFile, &theFileRef);
+	if (err) goto bail;
+
+	err = ::FSGetCatalogInfo(&theFileRef, kFSCatInfoDataSizes | kFSCatInfoContentMod, &theInfo, NULL, NULL, NULL);
+	if (err) goto bail;
+
+	mFileSize = theInfo.dataLogicalSize;
+	mModDate = theInfo.contentModDate.lowSeconds;
+
+	err = ::FSGetDataForkName(&theDataForkName);
+	if (err) goto bail;
+
+	err = ::FSOpenFork(&theFileRef, theDataForkName.length, theDataForkName.unicode, fsRdPerm, &mFork);
+
+bail:
+	return err;
+}
+
+#pragma mark-
+
+OSErr CVideoOutputDVIndex::Build(const FSSpec &inDVFile)
+{
+	CVideoOutputWorkPool *pPool = CVideoOutputWorkPool::GetSharedPool();
+	DVIndexEntryRecord	 *pChunkEntries = NULL;
+	UInt32				 theChunkCount = 0;
+	UInt32				 theEntriesPerChunk;
+	UInt32				 theBufferCount = pPool ? pPool->GetWorkerCount() + 1 : 1;
+	OSErr				 err;
+
+	Dispose();
+
+	err = OpenDVFile(inDVFile);
+	if (err) goto bail;
+
+	// A very big file gets bigger chunks rather than more than the pool can take
+	mChunkSize = kDVIndexChunkSize;
+	while ((mFileSize + mChunkSize - 1) / mChunkSize > kMaxWorkItems) mChunkSize <<= 1;
+
+	theChunkCount = (UInt32)((mFileSize + mChunkSize - 1) / mChunkSize);
+	if (0 == theChunkCount) goto bail;
+
+	// Frames are at least kDVFrameSize525_60 apart, each chunk gets room for as many as can start in it
+	theEntriesPerChunk = mChunkSize / kDVFrameSize525_60 + 1;
+
+	mChunks = (ChunkRecord *)::NewPtrClear(sizeof(ChunkRecord) * theChunkCount);
+	if (NULL == mChunks) { err = ::MemError(); goto bail; }
+
+	pChunkEntries = (DVIndexEntryRecord *)::NewPtr(sizeof(DVIndexEntryRecord) * theEntriesPerChunk * theChunkCount);
+	if (NULL == pChunkEntries) { err = ::MemError(); goto bail; }
+
+	for (UInt32 i = 0; i < theChunkCount; i++) mChunks[i].entries = pChunkEntries + i * theEntriesPerChunk;
+
+	// A read buffer per task, a chunk long plus the most a frame starting in it can run over
+	mFreeBuffers = 0;
+	for (UInt32 i = 0; i < theBufferCount; i++) {
+		mBuffers[i] = ::NewPtr(mChunkSize + kDVFrameSize625_50);
+		if (NULL == mBuffers[i]) { err = ::MemError(); goto bail; }
+		mFreeBuffers |= 1 << i;
+	}
+
+	mScanError = noErr;
+
+	if (pPool) {
+		err = pPool->Run(ScanChunkProc, this, theChunkCount);
+		if (err) goto bail;
+	} else {
+		for (UInt32 i = 0; i < theChunkCount; i++) ScanChunk(i);
+	}
+
+	err = mScanError;
+	if (err) goto bail;
+
+	// Put the chunks together
+	for (UInt32 i = 0; i < theChunkCount; i++) mFrameCount += mChunks[i].count;
+
+	if (mFrameCount) {
+		DVIndexEntryRecord *pEntry;
+
+		mEntries = (DVIndexEntryRecord *)::NewPtr(sizeof(DVIndexEntryRecord) * mFrameCount);
+		if (NULL == mEntries) { err = ::MemError(); goto bail; }
+
+		pEntry = mEntries;
+		for (UInt32 i = 0; i < theChunkCount; i++) {
+			::BlockMoveData(mChunks[i].entries, pEntry, sizeof(DVIndexEntryRecord) * mChunks[i].count);
+			pEntry += mChunks[i].count;
+		}
+	}
+
+	err = SortTimecodes();
+
+bail:
+	for (UInt32 i = 0; i < kMaxWorkTasks; i++) {
+		if (mBuffers[i]) ::DisposePtr(mBuffers[i]);
+		mBuffers[i] = NULL;
+	}
+	if (pChunkEntries) ::DisposePtr((Ptr)pChunkEntries);
+	if (mChunks) ::DisposePtr((Ptr)mChunks);
+	mChunks = NULL;
+
+	if (err) Dispose();
+
+	return err;
+}
+
+void CVideoOutputDVIndex::ScanChunkProc(void *inRefCon, UInt32 inItem)
+{
+	static_cast<CVideoOutputDVIndex *>(inRefCon)->ScanChunk(inItem);
+}
+
+// Indexes the frames which start in the chunk, the last one can run into the next chunk which starts
+// looking for frames after it
+void CVideoOutputDVIndex::ScanChunk(UInt32 inChunk)
+{
+	ChunkRecord &theChunk = mChunks[inChunk];
+	UInt64		theStart = (UInt64)inChunk * mChunkSize;
+	UInt64		theReadSize = mChunkSize + kDVFrameSize625_50;
+	UInt32		theChunkLength = mChunkSize;
+	UInt32		theBuffer, theFree;
+	UInt32		theOffset = 0;
+	ByteCount	theLength = 0;
+	UInt8		*pData;
+	OSErr		err;
+
+	if (theStart + theChunkLength > mFileSize) theChunkLength = (UInt32)(mFileSize - theStart);
+	if (theStart + theReadSize > mFileSize) theReadSize = mFileSize - theStart;
+
+	// No more chunks are scanned at once than there are buffers, so one's free
+	for (;;) {
+		theFree = *(volatile UInt32 *)&mFreeBuffers;
+		if (0 == theFree) { ::MPYield(); continue; }
+
+		for (theBuffer = 0; 0 == (theFree & (1 << theBuffer)); theBuffer++) ;
+		if (::CompareAndSwap(theFree, theFree & ~(1 << theBuffer), &mFreeBuffers)) break;
+	}
+
+	pData = (UInt8 *)mBuffers[theBuffer];
+
+	// Read once, there's no point keeping it in the cache
+	err = ::FSReadFork(mFork, fsFromStart | noCacheMask, theStart, theReadSize, pData, &theLength);
+	if (err && err != eofErr) {
+		::CompareAndSwap(noErr, err, (UInt32 *)&mScanError);
+		goto bail;
+	}
+
+	while (theOffset < theChunkLength && theOffset + kDVFrameHeadSize <= theLength) {
+		if (IsFrameStart(pData + theOffset)) {
+			UInt32 theFrameSize = CVideoOutputDV::GetSystem(CVideoOutputDV::GetFrameSystem(pData + theOffset)).frameSize;
+			UInt32 theAvailable = theLength - theOffset;
+
+			IndexFrame(pData + theOffset, (theAvailable < theFrameSize) ? theAvailable : theFrameSize, theStart + theOffset, theChunk.entries[theChunk.count++]);
+			theOffset += theFrameSize;
+		} else {
+			// Damaged or not DV, look for the next frame a byte at a time
+			theOffset++;
+		}
+	}
+
+bail:
+	do {
+		theFree = *(volatile UInt32 *)&mFreeBuffers;
+	} while (!::CompareAndSwap(theFree, theFree | (1 << theBuffer), &mFreeBuffers));
+}
+
+OSErr CVideoOutputDVIndex::SortTimecodes(void)
+{
+	for (UInt32 i = 0; i < mFrameCount; i++) {
+		if (mEntries[i].timecode != kDVNoTimecode) mTimecodeCount++;
+	}
+
+	if (0 == mTimecodeCount) return noErr;
+
+	mTimecodeOrder = (UInt32 *)::NewPtr(sizeof(UInt32) * mTimecodeCount);
+	if (NULL == mTimecodeOrder) { mTimecodeCount = 0; return ::MemError(); }
+
+	for (UInt32 i = 0, j = 0; i < mFrameCount; i++) {
+		if (mEntries[i].timecode != kDVNoTimecode) mTimecodeOrder[j++] = i;
+	}
+
+	std::sort(mTimecodeOrder, mTimecodeOrder + mTimecodeCount, TimecodeLess(mEntries));
+
+	return noErr;
+}
+
+#pragma mark-
+
+SInt32 CVideoOutputDVIndex::FindTimecode(UInt32 inTimecode) const
+{
+	UInt32 theLow = 0, theHigh = mTimecodeCount;
+
+	// The first of the frames with a timecode not less than inTimecode
+	while (theLow < theHigh) {
+		UInt32 theMiddle = theLow + (theHigh - theLow) / 2;
+
+		if (mEntries[mTimecodeOrder[theMiddle]].timecode < inTimecode) {
+			theLow = theMiddle + 1;
+		} else {
+			theHigh = theMiddle;
+		}
+	}
+
+	if (theLow < mTimecodeCount && mEntries[mTimecodeOrder[theLow]].timecode == inTimecode) return mTimecodeOrder[theLow];
+
+	return -1;
+}
+
+UInt32 CVideoOutputDVIndex::GetFrameSize(UInt32 inFrame) const
+{
+	const DVIndexEntryRecord &theEntry = mEntries[inFrame];
+
+	if (GetFlags(theEntry) & kDVIndexTruncated) return (UInt32)(mFileSize - GetOffset(theEntry));
+
+	return CVideoOutputDV::GetSystem(GetSystem(theEntry)).frameSize;
+}
+
+OSErr CVideoOutputDVIndex::ReadFrame(UInt32 inFrame, UInt8 *outFrame, UInt32 inBufferSize, UInt32 *outSize) const
+{
+	ByteCount theRead = 0;
+	UInt32	  theSize;
+	OSErr	  err;
+
+	if (inFrame >= mFrameCount || NULL == outFrame) return paramErr;
+
+	theSize = GetFrameSize(inFrame);
+	if (theSize > inBufferSize) return paramErr;
+
+	VIDEO_OUTPUT_TRACE_SCOPE("read");
+
+	err = ::FSReadFork(mFork, fsFromStart, GetOffset(mEntries[inFrame]), theSize, outFrame, &theRead);
+
+	if (outSize) *outSize = theRead;
+
+	return err;
+}
+
+#pragma mark-
+
+OSErr CVideoOutputDVIndex::Save(const FSSpec &inIndexFile) const
+{
+	DVIndexHeaderRecord theHeader;
+	DVIndexEntryRecord	*pBlock = NULL;
+	HFSUniStr255		theDataForkName;
+	FSRef				theFileRef;
+	SInt16				theFork = 0;
+	OSErr				err;
+
+	if (0 == mFork) return paramErr;
+
+	err = ::FSpCreate(&inIndexFile, kDVIndexSignature, kDVIndexSignature, smSystemScript);
+	if (err && err != dupFNErr) goto bail;
+
+	err = ::FSpMakeFSRef(&inIndexFile, &theFileRef);
+	if (err) goto bail;
+
+	err = ::FSGetDataForkName(&theDataForkName);
+	if (err) goto bail;
+
+	err = ::FSOpenFork(&theFileRef, theDataForkName.length, theDataForkName.unicode, fsWrPerm, &theFork);
+	if (err) goto bail;
+
+	err = ::FSSetForkSize(theFork, fsFromStart, 0);
+	if (err) goto bail;
+
+	theHeader.signature = EndianU32_NtoB(kDVIndexSignature);
+	theHeader.version = EndianU32_NtoB(kDVIndexVersion);
+	theHeader.frameCount = EndianU32_NtoB(mFrameCount);
+	theHeader.modDate = EndianU32_NtoB(mModDate);
+	theHeader.fileSize = EndianU64_NtoB(mFileSize);
+
+	err = ::FSWriteFork(theFork, fsAtMark, 0, sizeof(theHeader), &theHeader, NULL);
+	if (err) goto bail;
+
+	// A block at a time so it doesn't take a big endian copy of the whole index
+	pBlock = (DVIndexEntryRecord *)::NewPtr(sizeof(DVIndexEntryRecord) * kDVIndexSaveBlock);
+	if (NULL == pBlock) { err = ::MemError(); goto bail; }
+
+	for (UInt32 i = 0; i < mFrameCount; i += kDVIndexSaveBlock) {
+		UInt32 theCount = (mFrameCount - i < kDVIndexSaveBlock) ? mFrameCount - i : kDVIndexSaveBlock;
+
+		for (UInt32 j = 0; j < theCount; j++) {
+			pBlock[j].position = EndianU64_NtoB(mEntries[i + j].position);
+			pBlock[j].timecode = EndianU32_NtoB(mEntries[i + j].timecode);
+			pBlock[j].recorded = EndianU32_NtoB(mEntries[i + j].recorded);
+		}
+
+		err = ::FSWriteFork(theFork, fsAtMark, 0, sizeof(DVIndexEntryRecord) * theCount, pBlock, NULL);
+		if (err) goto bail;
+	}
+
+bail:
+	if (pBlock) ::DisposePtr((Ptr)pBlock);
+	if (theFork) ::FSCloseFork(theFork);
+
+	return err;
+}
+
+OSErr CVideoOutputDVIndex::Load(const FSSpec &inDVFile, const FSSpec &inIndexFile)
+{
+	DVIndexHeaderRecord theHeader;
+	HFSUniStr255		theDataForkName;
+	FSRef				theFileRef;
+	SInt16				theFork = 0;
+	OSErr				err;
+
+	Dispose();
+
+	err = OpenDVFile(inDVFile);
+	if (err) goto bail;
+
+	err = ::FSpMakeFSRef(&inIndexFile, &theFileRef);
+	if (err) goto bail;
+
+	err = ::FSGetDataForkName(&theDataForkName);
+	if (err) goto bail;
+
+	err = ::FSOpenFork(&theFileRef, theDataForkName.length, theDataForkName.unicode, fsRdPerm, &theFork);
+	if (err) goto bail;
+
+	err = ::FSReadFork(theFork, fsAtMark, 0, sizeof(theHeader), &theHeader, NULL);
+	if (err) goto bail;
+
+	// Not an index, or the DV file has changed since
+	if (EndianU32_BtoN(theHeader.signature) != kDVIndexSignature || EndianU32_BtoN(theHeader.version) != kDVIndexVersion ||
+		EndianU64_BtoN(theHeader.fileSize) != mFileSize || EndianU32_BtoN(theHeader.modDate) != mModDate) { err = paramErr; goto bail; }
+
+	mFrameCount = EndianU32_BtoN(theHeader.frameCount);
+
+	if (mFrameCount) {
+		mEntries = (DVIndexEntryRecord *)::NewPtr(sizeof(DVIndexEntryRecord) * mFrameCount);
+		if (NULL == mEntries) { err = ::MemError(); goto bail; }
+
+		err = ::FSReadFork(theFork, fsAtMark, 0, sizeof(DVIndexEntryRecord) * mFrameCount, mEntries, NULL);
+		if (err) goto bail;
+
+		for (UInt32 i = 0; i < mFrameCount; i++) {
+			mEntries[i].position = EndianU64_BtoN(mEntries[i].position);
+			mEntries[i].timecode = EndianU32_BtoN(mEntries[i].timecode);
+			mEntries[i].recorded = EndianU32_BtoN(mEntries[i].recorded);
+		}
+	}
+
+	err = SortTimecodes();
+
+bail:
+	if (theFork) ::FSCloseFork(theFork);
+	if (err) Dispose();
+
+	return err;
+}
+
+OSErr CVideoOutputDVIndex::MakeIndexSpec(const FSSpec &inDVFile, FSSpec &outIndexFile)
+{
+	const UInt8 kSuffix[] = { '.', 'i', 'd', 'x' };
+	Str255		theName;
+	UInt8		theLength = inDVFile.name[0];
+
+	// HFS names are 31 characters at most, so the DV file's name may have to be shortened
+	if (theLength > 31 - sizeof(kSuffix)) theLength = 31 - sizeof(kSuffix);
+
+	::BlockMoveData(inDVFile.name + 1, theName + 1, theLength);
+	::BlockMoveData(kSuffix, theName + 1 + theLength, sizeof(kSuffix));
+	theName[0] = theLength + sizeof(kSuffix);
+
+	return ::FSMakeFSSpec(inDVFile.vRefNum, inDVFile.parID, theName, &outIndexFile);
+}
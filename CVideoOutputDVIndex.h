@@ -0,0 +1,193 @@
+/*
+	File:		 CVideoOutputDVIndex.h
+	
+	Description: An index of the frames in a raw DV file - where each one starts, whether it's
+				 525/60 or 625/50 and its timecode and recording date - kept in a small file next to it
+				 so going to any frame or timecode is a lookup and one read.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 added CVideoOutputDVIndexPtr
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	Build( const FSSpec &inDVFile )
+		Scans inDVFile and indexes every frame in it. The file is split into chunks which are scanned on
+		the CVideoOutputWorkPool, each chunk holding the frames which start in it. Frames are found by their
+		header, subcode and VAUX DIF blocks, so a stream which switches between 525/60 and 625/50 or has
+		damaged or missing data in it is followed frame by frame rather than assuming every frame is the
+		same size. The DV file stays open for ReadFrame().
+
+	Save( const FSSpec &inIndexFile )
+		Writes the index, creating inIndexFile if needed. The index file is a DVIndexHeaderRecord followed by
+		a DVIndexEntryRecord per frame, 16 bytes each, all big endian.
+
+	Load( const FSSpec &inDVFile, const FSSpec &inIndexFile )
+		Reads an index written by Save() and opens inDVFile. Returns paramErr if the DV file has changed
+		size or been modified since it was indexed, Build() it again in that case.
+
+	GetFrameCount( void ) / GetEntry( UInt32 inFrame )
+		The frames in file order. GetOffset(), GetSystem() and GetFlags() pick an entry apart.
+
+	FindTimecode( UInt32 inTimecode )
+		Returns the first frame with timecode inTimecode, see MakeTimecode(), or -1 if there isn't one.
+		A binary search of the frames sorted by timecode, so it works however many times the timecode
+		starts again in the file.
+
+	ReadFrame( UInt32 inFrame, UInt8 *outFrame, UInt32 inBufferSize, UInt32 *outSize = NULL )
+		Reads frame inFrame into outFrame, which must hold kDVFrameSize625_50 bytes to be safe or
+		GetFrameSize() bytes at least. A frame cut short at the end of the file reads what there is of it.
+
+	MakeIndexSpec( const FSSpec &inDVFile, FSSpec &outIndexFile )
+		Where the index of inDVFile goes by default, the same name with ".idx" on the end in the same folder.
+		Returns fnfErr if the file isn't there yet, which is fine to pass to Save().
+*/
+
+#ifndef __CVIDEOOUTPUTDVINDEX_H__
+	#define __CVIDEOOUTPUTDVINDEX_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+#else
+	#include <Carbon.h>
+	#include <Files.h>
+	#include <Endian.h>
+#endif
+
+#include <memory>
+
+#include "CVideoOutputDV.h"
+#include "CVideoOutputWorkPool.h"
+
+namespace dts {
+
+const OSType kDVIndexSignature = FOUR_CHAR_CODE('DVix');
+const UInt32 kDVIndexVersion = 1;
+
+// Entry flags
+enum {
+	kDVIndexPAL			= 0x01,		// 625/50, otherwise 525/60
+	kDVIndexDropFrame	= 0x02,		// drop frame timecode
+	kDVIndexTruncated	= 0x04		// the file ends before the frame does
+};
+
+const UInt64 kDVIndexOffsetMask = 0x0000FFFFFFFFFFFFULL;
+const UInt32 kDVNoTimecode = 0xFFFFFFFF;
+
+typedef struct {
+	UInt64	position;		// file offset in the low 48 bits, flags in the top 8
+	UInt32	timecode;		// hours << 24 | minutes << 16 | seconds << 8 | frames, kDVNoTimecode if it hasn't got one
+	UInt32	recorded;		// recording date and time in seconds since 1904 like GetDateTime(), 0 if unknown
+} DVIndexEntryRecord;
+
+typedef struct {
+	OSType	signature;
+	UInt32	version;
+	UInt32	frameCount;
+	UInt32	modDate;		// of the DV file when it was indexed
+	UInt64	fileSize;
+} DVIndexHeaderRecord;
+
+class CVideoOutputDVIndex {
+	public:
+		CVideoOutputDVIndex();
+		~CVideoOutputDVIndex() { Dispose(); }
+
+		OSErr Build(const FSSpec &inDVFile);
+		OSErr Save(const FSSpec &inIndexFile) const;
+		OSErr Load(const FSSpec &inDVFile, const FSSpec &inIndexFile);
+
+		UInt32 GetFrameCount(void) const { return mFrameCount; }
+		const DVIndexEntryRecord &GetEntry(UInt32 inFrame) const { return mEntries[inFrame]; }
+		SInt32 FindTimecode(UInt32 inTimecode) const;
+		OSErr  ReadFrame(UInt32 inFrame, UInt8 *outFrame, UInt32 inBufferSize, UInt32 *outSize = NULL) const;
+
+		static UInt64	GetOffset(const DVIndexEntryRecord &inEntry) { return inEntry.position & kDVIndexOffsetMask; }
+		static UInt8	GetFlags(const DVIndexEntryRecord &inEntry) { return (UInt8)(inEntry.position >> 56); }
+		static DVSystem	GetSystem(const DVIndexEntryRecord &inEntry) { return (GetFlags(inEntry) & kDVIndexPAL) ? eDVSystem625_50 : eDVSystem525_60; }
+		UInt32			GetFrameSize(UInt32 inFrame) const;
+
+		static UInt32 MakeTimecode(UInt8 inHours, UInt8 inMinutes, UInt8 inSeconds, UInt8 inFrames) { return (inHours << 24) | (inMinutes << 16) | (inSeconds << 8) | inFrames; }
+		static OSErr  MakeIndexSpec(const FSSpec &inDVFile, FSSpec &outIndexFile);
+
+	private:
+		typedef struct {
+			DVIndexEntryRecord	*entries;
+			UInt32				count;
+		} ChunkRecord;
+
+		OSErr OpenDVFile(const FSSpec &inDVFile);
+		OSErr SortTimecodes(void);
+		void  Dispose(void);
+
+		static void ScanChunkProc(void *inRefCon, UInt32 inItem);
+		void ScanChunk(UInt32 inChunk);
+
+		// nope
+		CVideoOutputDVIndex(const CVideoOutputDVIndex &inIndex);
+		CVideoOutputDVIndex operator=(CVideoOutputDVIndex inIndex);
+
+	private:
+		SInt16				mFork;			// the DV file
+		UInt64				mFileSize;
+		UInt32				mModDate;
+
+		DVIndexEntryRecord	*mEntries;
+		UInt32				mFrameCount;
+		UInt32				*mTimecodeOrder;	// frames with a timecode, sorted by it
+		UInt32				mTimecodeCount;
+
+		// only while building
+		UInt32				mChunkSize;
+		ChunkRecord			*mChunks;
+		Ptr					mBuffers[kMaxWorkTasks];
+		UInt32				mFreeBuffers;		// atomic, a bit per free buffer
+		SInt32				mScanError;			// atomic, the first read error
+};
+
+typedef std::auto_ptr<CVideoOutputDVIndex> CVideoOutputDVIndexPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTDVINDEX_H__
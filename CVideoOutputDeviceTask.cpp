@@ -0,0 +1,254 @@
+/*
+	File:		 CVideoOutputDeviceTask.cpp
+	
+	Description: Runs slow video output component calls off the main thread.
+				 See CVideoOutputDeviceTask.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 the task enters the Movie Toolbox, Run() can stay on the calling thread,
+													 Wait() blocks on a semaphore, one event handler UPP for all
+										<2> 10/19/26 added trace points
+										<1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputDeviceTask.h"
+#include "CVideoOutputTrace.h"
+
+using namespace dts;
+
+CVideoOutputDeviceTask::CVideoOutputDeviceTask(DeviceDoneProcPtr inDoneProc, void *inRefCon) throw(OSStatus)
+	: mDoneProc(inDoneProc), mRefCon(inRefCon), mProc(NULL), mStatus(eDeviceIdle), mResult(noErr), mMicroseconds(0),
+	  mMainQueue(NULL), mDoneEvent(NULL), mDoneHandler(NULL), mJobAvailable(0), mJobDone(0), mTaskDone(0), mTask(0), mQuit(false)
+{
+	static EventHandlerUPP sDoneEventHandlerUPP = NULL;
+	EventTypeSpec theEventType = { kEventClassVideoOutput, kEventVideoOutputDeviceDone };
+	CVideoOutputDeviceTask *pThis = this;
+	OSStatus err;
+
+	if (NULL == inDoneProc) { err = paramErr; goto bail; }
+	if (!::MPLibraryIsLoaded()) { err = unimpErr; goto bail; }
+
+	// Everything the task needs to tell the main thread is set up here, it only posts the event
+	mMainQueue = ::GetMainEventQueue();
+
+	err = ::CreateEvent(NULL, kEventClassVideoOutput, kEventVideoOutputDeviceDone, 0, kEventAttributeNone, &mDoneEvent);
+	if (err) goto bail;
+
+	err = ::SetEventParameter(mDoneEvent, kEventParamDirectObject, typeVoidPtr, sizeof(pThis), &pThis);
+	if (err) goto bail;
+
+	if (NULL == sDoneEventHandlerUPP) sDoneEventHandlerUPP = ::NewEventHandlerUPP(DoneEventHandler);
+
+	err = ::InstallEventHandler(::GetApplicationEventTarget(), sDoneEventHandlerUPP, 1, &theEventType, this, &mDoneHandler);
+	if (err) goto bail;
+
+	err = ::MPCreateSemaphore(1, 0, &mJobAvailable);
+	if (err) goto bail;
+
+	err = ::MPCreateSemaphore(1, 0, &mJobDone);
+	if (err) goto bail;
+
+	err = ::MPCreateSemaphore(1, 0, &mTaskDone);
+	if (err) goto bail;
+
+	err = ::MPCreateTask(DeviceTask, this, 0, 0, NULL, NULL, 0, &mTask);
+	if (err) goto bail;
+
+	return;
+
+bail:
+	mTask = 0;
+	Dispose();
+
+	throw err;
+}
+
+CVideoOutputDeviceTask::~CVideoOutputDeviceTask()
+{
+	// Whatever is running gets to finish and be handed back first
+	Wait();
+
+	if (mTask) {
+		mQuit = true;
+		::MPSignalSemaphore(mJobAvailable);
+		::MPWaitOnSemaphore(mTaskDone, kDurationForever);
+	}
+
+	Dispose();
+}
+
+void CVideoOutputDeviceTask::Dispose(void)
+{
+	if (mDoneHandler) ::RemoveEventHandler(mDoneHandler);
+	mDoneHandler = NULL;
+
+	if (mDoneEvent) {
+		::RemoveEventFromQueue(mMainQueue, mDoneEvent);
+		::ReleaseEvent(mDoneEvent);
+	}
+	mDoneEvent = NULL;
+
+	if (mTaskDone) ::MPDeleteSemaphore(mTaskDone);
+	if (mJobDone) ::MPDeleteSemaphore(mJobDone);
+	if (mJobAvailable) ::MPDeleteSemaphore(mJobAvailable);
+	mTaskDone = mJobDone = mJobAvailable = 0;
+}
+
+#pragma mark-
+
+OSErr CVideoOutputDeviceTask::Run(DeviceProcPtr inProc, Boolean inOnTask)
+{
+	if (NULL == inProc) return paramErr;
+	if (!::CompareAndSwap(eDeviceIdle, eDeviceRunning, &mStatus)) return videoOutputInUseErr;
+
+	// Left over from a job no one waited for
+	::MPWaitOnSemaphore(mJobDone, kDurationImmediate);
+
+	mProc = inProc;
+
+	if (inOnTask) {
+		::MPSignalSemaphore(mJobAvailable);
+	} else {
+		Perform();
+	}
+
+	return noErr;
+}
+
+OSErr CVideoOutputDeviceTask::Wait(Duration inTimeout)
+{
+	if (*(volatile UInt32 *)&mStatus == eDeviceRunning) {
+		OSStatus err = ::MPWaitOnSemaphore(mJobDone, inTimeout);
+		if (err) return kMPTimeoutErr;
+	}
+
+	Deliver();
+
+	// Already handed back, the event would only find nothing to do
+	::RemoveEventFromQueue(mMainQueue, mDoneEvent);
+
+	return noErr;
+}
+
+// The device task, or the main thread when Run() isn't to use the task
+void CVideoOutputDeviceTask::Perform(void)
+{
+	AbsoluteTime theStart = ::UpTime();
+	OSErr theResult;
+
+	{
+		VIDEO_OUTPUT_TRACE_SCOPE("device");
+		theResult = (*mProc)(mRefCon);
+	}
+
+	Finish(theResult, ::UnsignedWideToUInt64(::AbsoluteToNanoseconds(::SubAbsoluteFromAbsolute(::UpTime(), theStart))) / 1000);
+}
+
+void CVideoOutputDeviceTask::Finish(OSErr inResult, UInt64 inMicroseconds)
+{
+	mResult = inResult;
+	mMicroseconds = inMicroseconds;
+
+	// CompareAndSwap orders the result before the status the main thread looks at
+	::CompareAndSwap(eDeviceRunning, eDeviceFinished, &mStatus);
+
+	::MPSignalSemaphore(mJobDone);
+	::PostEventToQueue(mMainQueue, mDoneEvent, kEventPriorityStandard);
+}
+
+// Main thread only, from Wait() or the event, whichever is first
+void CVideoOutputDeviceTask::Deliver(void)
+{
+	OSErr  theResult;
+	UInt64 theMicroseconds;
+
+	if (*(volatile UInt32 *)&mStatus != eDeviceFinished) return;
+
+	theResult = mResult;
+	theMicroseconds = mMicroseconds;
+
+	// Idle before the call so the done proc can Run() the next one
+	::CompareAndSwap(eDeviceFinished, eDeviceIdle, &mStatus);
+
+	(*mDoneProc)(mRefCon, theResult, theMicroseconds);
+}
+
+OSStatus CVideoOutputDeviceTask::DeviceTask(void *inParameter)
+{
+	CVideoOutputDeviceTask *pThis = static_cast<CVideoOutputDeviceTask *>(inParameter);
+	OSErr theEnterErr;
+
+	// The Movie Toolbox and Component Manager calls on this thread need it, and only thread-safe
+	// components are opened on it from here on
+	theEnterErr = ::EnterMoviesOnThread(0);
+
+	for (;;) {
+		::MPWaitOnSemaphore(pThis->mJobAvailable, kDurationForever);
+		if (pThis->mQuit) break;
+
+		if (theEnterErr) {
+			pThis->Finish(theEnterErr, 0);
+		} else {
+			pThis->Perform();
+		}
+	}
+
+	if (noErr == theEnterErr) ::ExitMoviesOnThread();
+
+	::MPSignalSemaphore(pThis->mTaskDone);
+
+	return noErr;
+}
+
+pascal OSStatus CVideoOutputDeviceTask::DoneEventHandler(EventHandlerCallRef /*inHandlerCallRef*/, EventRef inEvent, void *inUserData)
+{
+	CVideoOutputDeviceTask *pThis = NULL;
+
+	// Every device task's handler sees every one of these events, only take ours
+	::GetEventParameter(inEvent, kEventParamDirectObject, typeVoidPtr, NULL, sizeof(pThis), NULL, &pThis);
+	if (pThis != inUserData) return eventNotHandledErr;
+
+	pThis->Deliver();
+
+	return noErr;
+}
@@ -0,0 +1,157 @@
+/*
+	File:		 CVideoOutputDeviceTask.h
+	
+	Description: Runs the video output component calls which can take a slow device a long time, on an
+				 MP task of its own, and hands the result back on the main thread. Used by the CVideoOutput
+				 class for BeginAsync() and EndAsync().
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 the task enters the Movie Toolbox, Run() can stay on the calling thread,
+													 Wait() blocks on a semaphore and takes a timeout
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputDeviceTask( DeviceDoneProcPtr inDoneProc, void *inRefCon )
+		Starts the device task. Call from the main thread, inDoneProc is called there with inRefCon, the
+		result of each DeviceProcPtr and how long it took. Throws an OSStatus if Multiprocessing Services
+		aren't available or the task can't be started.
+
+	Run( DeviceProcPtr inProc, Boolean inOnTask = true )
+		Calls inProc(inRefCon) on the device task and returns straight away. One at a time, returns
+		videoOutputInUseErr while the last one hasn't been handed back yet. With inOnTask false inProc is
+		called right here instead, for components which can't be called off the main thread, and the
+		result still comes back through the main event loop.
+
+	Wait( Duration inTimeout = kDurationForever )
+		Waits on a semaphore for the proc that's running and hands back its result before returning,
+		rather than when the main event loop gets to it. Returns kMPTimeoutErr if the proc is still
+		running after inTimeout, its result comes back as usual once it's done. The destructor waits
+		for as long as it takes.
+
+	IsBusy( void )
+		True from Run() until the done proc has been called.
+
+	The result comes back in a kEventClassVideoOutput / kEventVideoOutputDeviceDone Carbon event posted to the
+	main event queue, so the main event loop has to be running for it to arrive.
+	
+	The task calls EnterMoviesOnThread() before its first job and ExitMoviesOnThread() when it quits, which
+	also puts it in kCSAcceptThreadSafeComponentsOnlyMode. A component instance opened on the main thread may
+	only be handed to it when the component is thread-safe, and the main thread mustn't touch the instance
+	until the result is back.
+*/
+
+#ifndef __CVIDEOOUTPUTDEVICETASK_H__
+	#define __CVIDEOOUTPUTDEVICETASK_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <Multiprocessing.h>
+	#include <Movies.h>
+#endif
+
+#include <memory>
+
+namespace dts {
+
+enum {
+	kEventClassVideoOutput		= FOUR_CHAR_CODE('VOut'),
+	kEventVideoOutputDeviceDone = 1
+};
+
+typedef OSErr (*DeviceProcPtr)(void *inRefCon);
+typedef void  (*DeviceDoneProcPtr)(void *inRefCon, OSErr inResult, UInt64 inMicroseconds);
+
+class CVideoOutputDeviceTask {
+	public:
+		CVideoOutputDeviceTask(DeviceDoneProcPtr inDoneProc, void *inRefCon) throw(OSStatus);
+		~CVideoOutputDeviceTask();
+
+		OSErr	Run(DeviceProcPtr inProc, Boolean inOnTask = true);
+		OSErr	Wait(Duration inTimeout = kDurationForever);
+		Boolean IsBusy(void) const { return (*(volatile UInt32 *)&mStatus != eDeviceIdle); }
+
+	private:
+		enum { eDeviceIdle = 0, eDeviceRunning, eDeviceFinished };
+
+		static OSStatus DeviceTask(void *inParameter);
+		static pascal OSStatus DoneEventHandler(EventHandlerCallRef inHandlerCallRef, EventRef inEvent, void *inUserData);
+
+		void Perform(void);
+		void Finish(OSErr inResult, UInt64 inMicroseconds);
+		void Deliver(void);
+		void Dispose(void);
+
+		// nope
+		CVideoOutputDeviceTask(const CVideoOutputDeviceTask &inTask);
+		CVideoOutputDeviceTask operator=(CVideoOutputDeviceTask inTask);
+
+	private:
+		DeviceDoneProcPtr	mDoneProc;
+		void				*mRefCon;
+
+		DeviceProcPtr		mProc;
+		UInt32				mStatus;			// atomic
+		OSErr				mResult;			// written by the task before it finishes
+		UInt64				mMicroseconds;
+
+		EventQueueRef		mMainQueue;
+		EventRef			mDoneEvent;			// posted back to the main queue, one job at a time
+		EventHandlerRef		mDoneHandler;
+
+		MPSemaphoreID		mJobAvailable;
+		MPSemaphoreID		mJobDone;			// signaled as each job finishes, for Wait()
+		MPSemaphoreID		mTaskDone;
+		MPTaskID			mTask;
+		volatile Boolean	mQuit;
+};
+
+typedef std::auto_ptr<CVideoOutputDeviceTask> CVideoOutputDeviceTaskPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTDEVICETASK_H__
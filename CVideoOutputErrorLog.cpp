@@ -0,0 +1,157 @@
+/*
+	File:		 CVideoOutputErrorLog.cpp
+	
+	Description: Error event log for the video output.
+				 See CVideoOutputErrorLog.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputErrorLog.h"
+
+using namespace dts;
+
+CVideoOutputErrorLog::CVideoOutputErrorLog()
+	: mNextEvent(0)
+{
+	for (UInt32 i = 0; i < kErrorLogSize; i++) {
+		mEvents[i].sequence = 0;
+	}
+
+	for (UInt32 i = 0; i < kErrorCodeSlots; i++) {
+		mCodes[i].code = 0;
+		mCodes[i].count = 0;
+	}
+}
+
+OSErr CVideoOutputErrorLog::Log(OSType inOperation, OSType inComponentSubType, OSErr inErr)
+{
+	if (noErr == inErr) return inErr;
+
+	// Take the next position, wrapping round over the oldest
+	UInt32	   thePosition = (UInt32)::IncrementAtomic(&mNextEvent);
+	EventSlot &theSlot = mEvents[thePosition & (kErrorLogSize - 1)];
+	UInt32	   theSequence = theSlot.sequence;
+
+	// Unpublish it first, if whoever had it a lap earlier is still writing it they keep it
+	if (theSequence != kEventBusy && ::CompareAndSwap(theSequence, kEventBusy, &theSlot.sequence)) {
+		theSlot.event.microseconds = ::UnsignedWideToUInt64(::AbsoluteToNanoseconds(::UpTime())) / 1000;
+		theSlot.event.operation = inOperation;
+		theSlot.event.componentSubType = inComponentSubType;
+		theSlot.event.error = inErr;
+
+		// CompareAndSwap orders the event before the sequence a reader checks
+		::CompareAndSwap(kEventBusy, thePosition + 1, &theSlot.sequence);
+	}
+
+	// Then the count, the first empty slot from the code's hash claims the code
+	UInt32 theCode = MakeCode(inErr);
+	UInt32 theIndex = theCode & (kErrorCodeSlots - 1);
+
+	for (UInt32 i = 0; i < kErrorCodeSlots; i++, theIndex = (theIndex + 1) & (kErrorCodeSlots - 1)) {
+		CodeSlot &theCodeSlot = mCodes[theIndex];
+
+		if (theCodeSlot.code == theCode || ::CompareAndSwap(0, theCode, &theCodeSlot.code) || theCodeSlot.code == theCode) {
+			::IncrementAtomic(&theCodeSlot.count);
+			break;
+		}
+	}
+
+	return inErr;
+}
+
+UInt32 CVideoOutputErrorLog::GetEvents(ErrorEventRecord outEvents[], UInt32 inMaxEvents) const
+{
+	UInt32 theNext = GetTotal();
+	UInt32 theCount = 0;
+
+	for (UInt32 i = 0; i < kErrorLogSize && i < theNext && theCount < inMaxEvents; i++) {
+		UInt32			 thePosition = theNext - 1 - i;
+		const EventSlot &theSlot = mEvents[thePosition & (kErrorLogSize - 1)];
+
+		if (*(volatile UInt32 *)&theSlot.sequence != thePosition + 1) continue;
+
+		outEvents[theCount] = theSlot.event;
+
+		// Still the same event, CompareAndSwap orders the copy before the check
+		if (::CompareAndSwap(thePosition + 1, thePosition + 1, (UInt32 *)&theSlot.sequence))
+			theCount++;
+	}
+
+	return theCount;
+}
+
+UInt32 CVideoOutputErrorLog::GetCount(OSErr inErr) const
+{
+	UInt32 theCode = MakeCode(inErr);
+	UInt32 theIndex = theCode & (kErrorCodeSlots - 1);
+
+	for (UInt32 i = 0; i < kErrorCodeSlots; i++, theIndex = (theIndex + 1) & (kErrorCodeSlots - 1)) {
+		UInt32 theSlotCode = *(volatile UInt32 *)&mCodes[theIndex].code;
+
+		if (theSlotCode == theCode) return *(volatile SInt32 *)&mCodes[theIndex].count;
+		if (theSlotCode == 0) break;
+	}
+
+	return 0;
+}
+
+UInt32 CVideoOutputErrorLog::GetCounts(ErrorCountRecord outCounts[], UInt32 inMaxCounts) const
+{
+	UInt32 theCount = 0;
+
+	for (UInt32 i = 0; i < kErrorCodeSlots && theCount < inMaxCounts; i++) {
+		UInt32 theSlotCode = *(volatile UInt32 *)&mCodes[i].code;
+		SInt32 theSlotCount = *(volatile SInt32 *)&mCodes[i].count;
+
+		// a code that's just been claimed may not be counted yet
+		if (theSlotCode == 0 || theSlotCount == 0) continue;
+
+		outCounts[theCount].error = (OSErr)(UInt16)theSlotCode;
+		outCounts[theCount].count = theSlotCount;
+		theCount++;
+	}
+
+	return theCount;
+}
@@ -0,0 +1,170 @@
+/*
+	File:		 CVideoOutputErrorLog.h
+	
+	Description: A fixed size record of the errors the video output ran into, what was being done, on which
+				 component and when, with a count for each error code. Used by the CVideoOutput class.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <4> 10/19/26 added eErrorOperationSyncMonitor
+										<3> 10/19/26 added eErrorOperationDVIndex
+										<2> 10/19/26 added eErrorOperationRateConversion
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	Log(OSType inOperation, OSType inComponentSubType, OSErr inErr)
+		Records an error against the operation that got it, one of the eErrorOperation codes, and the
+		subType of the video output component in use. noErr isn't recorded. Returns inErr so a call
+		can be wrapped, err = log.Log(eErrorOperationBegin, theSubType, ::QTVideoOutputBegin(theInstance)).
+		Takes no locks and doesn't allocate, so it can be called from any thread, the device task and
+		during playback included.
+
+	GetEvents(ErrorEventRecord outEvents[], UInt32 inMaxEvents)
+		Copies out up to inMaxEvents of the last kErrorLogSize events, newest first, and returns how many.
+		Older events are overwritten as new ones come in, and one that's being overwritten while it's
+		copied is left out.
+
+	GetCount(OSErr inErr)
+		How many times inErr has been recorded since the log was made.
+
+	GetCounts(ErrorCountRecord outCounts[], UInt32 inMaxCounts)
+		Copies out the count of up to inMaxCounts of the error codes seen, and returns how many. The first
+		kErrorCodeSlots different codes get a count of their own, any after that are only in GetTotal().
+
+	GetTotal(void)
+		How many errors have been recorded altogether.
+*/
+
+#ifndef __CVIDEOOUTPUTERRORLOG_H__
+	#define __CVIDEOOUTPUTERRORLOG_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+#else
+	#include <Carbon.h>
+#endif
+
+namespace dts {
+
+const UInt32 kErrorLogSize = 64;			// a power of 2
+const UInt32 kErrorCodeSlots = 32;			// a power of 2
+
+// What was being done when the error came back
+enum {
+	eErrorOperationCreate			= FOUR_CHAR_CODE('make'),
+	eErrorOperationOpen				= FOUR_CHAR_CODE('open'),
+	eErrorOperationSetDisplayMode	= FOUR_CHAR_CODE('mode'),
+	eErrorOperationBegin			= FOUR_CHAR_CODE('begn'),
+	eErrorOperationGetSoundOutputInfo = FOUR_CHAR_CODE('gsnd'),
+	eErrorOperationSetSoundOutputInfo = FOUR_CHAR_CODE('ssnd'),
+	eErrorOperationGetGWorld		= FOUR_CHAR_CODE('gwld'),
+	eErrorOperationDVEncoder		= FOUR_CHAR_CODE('dven'),
+	eErrorOperationDVDecoder		= FOUR_CHAR_CODE('dvde'),
+	eErrorOperationAsync			= FOUR_CHAR_CODE('asyn'),
+	eErrorOperationEnd				= FOUR_CHAR_CODE('end '),
+	eErrorOperationSetEchoPort		= FOUR_CHAR_CODE('echo'),
+	eErrorOperationSetSoundDevice	= FOUR_CHAR_CODE('sdev'),
+	eErrorOperationPresentFrame		= FOUR_CHAR_CODE('frme'),
+	eErrorOperationSwapChain		= FOUR_CHAR_CODE('swap'),
+	eErrorOperationRecord			= FOUR_CHAR_CODE('recd'),
+	eErrorOperationRateConversion	= FOUR_CHAR_CODE('rate'),
+	eErrorOperationDVIndex			= FOUR_CHAR_CODE('dvix'),
+	eErrorOperationSyncMonitor		= FOUR_CHAR_CODE('sync')
+};
+
+typedef struct {
+	UInt64	microseconds;			// UpTime() when it was recorded
+	OSType	operation;				// an eErrorOperation code
+	OSType	componentSubType;		// 0 when there's no component
+	OSErr	error;
+} ErrorEventRecord;
+
+typedef struct {
+	OSErr	error;
+	UInt32	count;
+} ErrorCountRecord;
+
+class CVideoOutputErrorLog {
+	public:
+		CVideoOutputErrorLog();
+		~CVideoOutputErrorLog() {}
+
+		OSErr Log(OSType inOperation, OSType inComponentSubType, OSErr inErr);
+
+		UInt32 GetEvents(ErrorEventRecord outEvents[], UInt32 inMaxEvents) const;
+		UInt32 GetCount(OSErr inErr) const;
+		UInt32 GetCounts(ErrorCountRecord outCounts[], UInt32 inMaxCounts) const;
+		UInt32 GetTotal(void) const { return *(volatile UInt32 *)&mNextEvent; }
+
+	private:
+		// a code slot holds the error as a UInt16 with this set so noErr isn't an empty slot
+		static UInt32 MakeCode(OSErr inErr) { return 0x10000 | (UInt16)inErr; }
+
+		// nope
+		CVideoOutputErrorLog(const CVideoOutputErrorLog &inLog);
+		CVideoOutputErrorLog operator=(CVideoOutputErrorLog inLog);
+
+	private:
+		// each event is written and then published by setting its sequence to 1 more than its
+		// position in the log, 0 until the first one and kEventBusy while it's being written
+		enum { kEventBusy = 0xFFFFFFFF };
+
+		struct EventSlot {
+			ErrorEventRecord	event;
+			UInt32				sequence;
+		};
+
+		struct CodeSlot {
+			UInt32				code;			// MakeCode(), 0 for unused
+			SInt32				count;
+		};
+
+		EventSlot			mEvents[kErrorLogSize];
+		SInt32				mNextEvent;			// events ever recorded
+		CodeSlot			mCodes[kErrorCodeSlots];
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTERRORLOG_H__
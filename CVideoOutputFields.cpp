@@ -0,0 +1,175 @@
+/*
+	File:		 CVideoOutputFields.cpp
+	
+	Description: Field handling for interlaced video output.
+				 See CVideoOutputFields.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputFields.h"
+
+using namespace dts;
+
+// DIF section types, the top 3 bits of the first byte of each block
+const UInt8 kDIFSectionHeader = 0;
+const UInt8 kDIFSectionVAUX = 2;
+
+// VAUX packs
+const UInt8 kVAUXVideoSourceControlPack = 0x61;
+const long  kVAUXPackSize = 5;
+const long  kVAUXPacksPerBlock = 15;
+const long  kVAUXFirstBlock = 3;	// blocks 3, 4 and 5 of each DIF sequence
+const long  kVAUXBlockCount = 3;
+
+/* GetDVFieldOrder
+		DV output is always lower field first for both 525 and 625 line systems, but the VSC pack
+		can say a frame only carries one field (FF = 0) or that it isn't interlaced at all (IL = 0).
+*/
+FieldOrder CVideoOutputFields::GetDVFieldOrder(const UInt8 *inDIFFrame, long inSize, Boolean *outIsPAL)
+{
+	if (NULL == inDIFFrame || inSize < kDIFSequenceSize) return eFieldOrderUnknown;
+
+	// The first block of a frame is the header block of the first sequence
+	if ((inDIFFrame[0] >> 5) != kDIFSectionHeader) return eFieldOrderUnknown;
+
+	if (outIsPAL) *outIsPAL = (inDIFFrame[3] & 0x80) != 0;
+
+	for (long block = kVAUXFirstBlock; block < kVAUXFirstBlock + kVAUXBlockCount; block++) {
+		const UInt8 *pBlock = inDIFFrame + block * kDIFBlockSize;
+
+		if ((pBlock[0] >> 5) != kDIFSectionVAUX) continue;
+
+		for (long pack = 0; pack < kVAUXPacksPerBlock; pack++) {
+			const UInt8 *pPack = pBlock + 3 + pack * kVAUXPackSize;
+
+			if (kVAUXVideoSourceControlPack == pPack[0]) {
+				Boolean bothFields = (pPack[3] & 0x80) != 0;	// FF
+				Boolean field1First = (pPack[3] & 0x40) != 0;	// FS
+				Boolean interlaced = (pPack[3] & 0x10) != 0;	// IL
+
+				if (!bothFields || !interlaced) return eFieldOrderProgressive;
+
+				return field1First ? eFieldOrderLowerFirst : eFieldOrderUpperFirst;
+			}
+		}
+	}
+
+	// No VSC pack, go with the DV default
+	return eFieldOrderLowerFirst;
+}
+
+/* GetMovieDVFieldOrder
+		Reads the first DV frame of the first enabled video track.
+*/
+OSErr CVideoOutputFields::GetMovieDVFieldOrder(const Movie inMovie, FieldOrder &outOrder)
+{
+	Handle	  hSample = NULL;
+	Track	  theTrack;
+	long	  theSize = 0;
+	OSErr	  err = noErr;
+
+	outOrder = eFieldOrderUnknown;
+
+	if (NULL == inMovie) return paramErr;
+
+	theTrack = ::GetMovieIndTrackType(inMovie, 1, VideoMediaType, movieTrackMediaType | movieTrackEnabledOnly);
+	if (NULL == theTrack) return invalidTrack;
+
+	hSample = ::NewHandle(0);
+	if (NULL == hSample) return ::MemError();
+
+	err = ::GetMediaSample(::GetTrackMedia(theTrack), hSample, 0, &theSize, 0, NULL, NULL, NULL, NULL, 1, NULL, NULL);
+	if (err) goto bail;
+
+	outOrder = GetDVFieldOrder((UInt8 *)*hSample, theSize);
+
+bail:
+	::DisposeHandle(hSample);
+
+	return err;
+}
+
+#pragma mark-
+
+void CVideoOutputFields::GetFieldPlane(UInt8 *inBaseAddr, long inRowBytes, long inHeight, long inRowLength, FieldOrder inOrder, UInt8 inField, FieldPlaneRecord &outPlane)
+{
+	outPlane.rowLength = inRowLength;
+
+	if (!IsInterlaced(inOrder)) {
+		outPlane.baseAddr = inBaseAddr;
+		outPlane.rowBytes = inRowBytes;
+		outPlane.height = inHeight;
+		return;
+	}
+
+	// The upper field is the even lines, the lower field the odd lines
+	Boolean isLowerField = (eFieldOrderLowerFirst == inOrder) ? (0 == inField) : (1 == inField);
+
+	outPlane.baseAddr = inBaseAddr + (isLowerField ? inRowBytes : 0);
+	outPlane.rowBytes = inRowBytes * 2;
+	outPlane.height = isLowerField ? inHeight / 2 : (inHeight + 1) / 2;
+}
+
+void CVideoOutputFields::ForEachField(UInt8 *inBaseAddr, long inRowBytes, long inHeight, long inRowLength, FieldOrder inOrder, FieldProcPtr inProc, void *inRefCon)
+{
+	UInt8 theFieldCount = IsInterlaced(inOrder) ? 2 : 1;
+
+	for (UInt8 field = 0; field < theFieldCount; field++) {
+		FieldPlaneRecord thePlane;
+
+		GetFieldPlane(inBaseAddr, inRowBytes, inHeight, inRowLength, inOrder, field, thePlane);
+		inProc(thePlane, field, inRefCon);
+	}
+}
+
+void CVideoOutputFields::CopyField(const FieldPlaneRecord &inSource, const FieldPlaneRecord &inDest)
+{
+	long theRows = (inSource.height < inDest.height) ? inSource.height : inDest.height;
+	long theLength = (inSource.rowLength < inDest.rowLength) ? inSource.rowLength : inDest.rowLength;
+
+	for (long row = 0; row < theRows; row++) {
+		::BlockMoveData(inSource.baseAddr + row * inSource.rowBytes, inDest.baseAddr + row * inDest.rowBytes, theLength);
+	}
+}
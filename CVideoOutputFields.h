@@ -0,0 +1,123 @@
+/*
+	File:		 CVideoOutputFields.h
+	
+	Description: Field handling for interlaced video output. Works out the field order of a DV
+				 stream from the DIF data itself and splits a frame buffer into two field planes
+				 so that scaling, pixel conversion, blending and overlays can run on each field
+				 separately and the fields go out to an interlaced display mode untouched.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <1> 10/19/26 initial release
+
+*/
+
+/*
+	GetDVFieldOrder( const UInt8 *inDIFFrame, long inSize, Boolean *outIsPAL = NULL )
+		Reads the DIF header block and the VAUX video source control pack of a DV frame. Returns
+		eFieldOrderProgressive if the frame says only one field is output, otherwise the order the
+		fields are output in, or eFieldOrderUnknown if the data doesn't look like DV. outIsPAL is
+		set from the DSF bit (625/50 if true, 525/60 if false).
+
+	GetFieldPlane( UInt8 *inBaseAddr, long inRowBytes, long inHeight, long inRowLength, FieldOrder inOrder, UInt8 inField, FieldPlaneRecord &outPlane )
+		Describes field 0 (first in time) or field 1 (second in time) of a frame as a plane of its own:
+		every other line of the frame, so rowBytes is doubled and the height halved. For a progressive
+		frame field 0 is the whole frame. No pixels are copied.
+
+	ForEachField( UInt8 *inBaseAddr, long inRowBytes, long inHeight, long inRowLength, FieldOrder inOrder, FieldProcPtr inProc, void *inRefCon )
+		Calls inProc once per field plane (once for the whole frame when progressive). Use this to
+		run any per line stage - scalers, pixel format converters, overlays - so the two fields are
+		never mixed together.
+
+	CopyField( const FieldPlaneRecord &inSource, const FieldPlaneRecord &inDest )
+		Copies one field plane into another, used to weave fields from two different movie frames into
+		one output frame for pulldown.
+*/
+
+#ifndef __CVIDEOOUTPUTFIELDS_H__
+	#define __CVIDEOOUTPUTFIELDS_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <Movies.h>
+#endif
+
+#include "CVideoOutputModeMatcher.h"
+
+namespace dts {
+
+// DV DIF block layout
+const long kDIFBlockSize = 80;
+const long kDIFBlocksPerSequence = 150;
+const long kDIFSequenceSize = kDIFBlockSize * kDIFBlocksPerSequence;
+
+typedef struct {
+	UInt8	*baseAddr;		// first line of the field
+	long	rowBytes;		// distance between lines of the field, twice the frame rowBytes when interlaced
+	long	height;			// lines in the field
+	long	rowLength;		// bytes of pixel data per line
+} FieldPlaneRecord;
+
+typedef void (*FieldProcPtr)(const FieldPlaneRecord &inPlane, UInt8 inField, void *inRefCon);
+
+class CVideoOutputFields {
+	public:
+		static FieldOrder GetDVFieldOrder(const UInt8 *inDIFFrame, long inSize, Boolean *outIsPAL = NULL);
+		static OSErr	  GetMovieDVFieldOrder(const Movie inMovie, FieldOrder &outOrder);
+
+		static Boolean IsInterlaced(FieldOrder inOrder) { return (eFieldOrderUpperFirst == inOrder || eFieldOrderLowerFirst == inOrder); }
+
+		static void GetFieldPlane(UInt8 *inBaseAddr, long inRowBytes, long inHeight, long inRowLength, FieldOrder inOrder, UInt8 inField, FieldPlaneRecord &outPlane);
+		static void ForEachField(UInt8 *inBaseAddr, long inRowBytes, long inHeight, long inRowLength, FieldOrder inOrder, FieldProcPtr inProc, void *inRefCon);
+		static void CopyField(const FieldPlaneRecord &inSource, const FieldPlaneRecord &inDest);
+
+	private:
+		// nope
+		CVideoOutputFields();
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTFIELDS_H__
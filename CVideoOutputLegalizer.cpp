@@ -0,0 +1,293 @@
+/*
+	File:		 CVideoOutputLegalizer.cpp
+	
+	Description: Broadcast safe limits for the video output.
+				 See CVideoOutputLegalizer.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 SSE2 clip, the stats are locked
+										<2> 10/19/26 cDepthErr for a pixel format it doesn't take
+										<1> 10/19/26 initial release
+*/
+
+#include <math.h>
+#if __SSE2__
+	#include <emmintrin.h>
+#endif
+
+#include "CVideoOutputLegalizer.h"
+
+using namespace dts;
+
+// B' - Y' and R' - Y' are +-0.886 and +-0.701 of the 219 codes from black to white at Cb and Cr +-112,
+// and U and V are 0.493 and 0.877 of them
+const double kAmplitudeCb = 0.493 * 0.886 * 219.0 / 112.0;
+const double kAmplitudeCr = 0.877 * 0.701 * 219.0 / 112.0;
+
+CVideoOutputLegalizer::CVideoOutputLegalizer(const LegalizerLimitsRecord &inLimits, OSType inPixelFormat) throw(OSStatus)
+	: mLumaOffset(1), mCbOffset(0), mCrOffset(2), mKnee(inLimits.knee), mAmplitude(NULL), mCompositeLow(0), mCompositeHigh(0), mLock(0)
+{
+	OSStatus err;
+
+	mStats.frames = mStats.framesCorrected = 0;
+	mStats.lastFrameCorrected = mStats.maxFrameCorrected = 0;
+	mStats.totalCorrected = 0;
+
+	switch (inPixelFormat) {
+	case k2vuyPixelFormat:	// Cb Y0 Cr Y1
+		break;
+	case kYUVSPixelFormat:	// Y0 Cb Y1 Cr
+		mLumaOffset = 0; mCbOffset = 1; mCrOffset = 3;
+		break;
+	default:
+		throw (OSStatus)cDepthErr;
+	}
+
+	// Room for a knee at both ends
+	if (inLimits.lumaMin + 2 * inLimits.knee > inLimits.lumaMax || inLimits.chromaMin + 2 * inLimits.knee > inLimits.chromaMax ||
+		inLimits.lumaMin >= inLimits.lumaMax || inLimits.chromaMin >= inLimits.chromaMax) throw (OSStatus)paramErr;
+
+	MakeTable(mLumaTable, inLimits.lumaMin, inLimits.lumaMax, inLimits.knee);
+	MakeTable(mChromaTable, inLimits.chromaMin, inLimits.chromaMax, inLimits.knee);
+
+	// Between the knees nothing changes, a pair of pixels is laid out the same way four times over
+	for (UInt32 i = 0; i < 16; i += 4) {
+		mKneeLow[i + mLumaOffset] = mKneeLow[i + mLumaOffset + 2] = inLimits.lumaMin + inLimits.knee;
+		mKneeHigh[i + mLumaOffset] = mKneeHigh[i + mLumaOffset + 2] = inLimits.lumaMax - inLimits.knee;
+		mKneeLow[i + mCbOffset] = mKneeLow[i + mCrOffset] = inLimits.chromaMin + inLimits.knee;
+		mKneeHigh[i + mCbOffset] = mKneeHigh[i + mCrOffset] = inLimits.chromaMax - inLimits.knee;
+	}
+
+	// Pixels changed by bytes changed in a pair, new chroma changes both
+	for (UInt32 theBits = 0; theBits < 16; theBits++) {
+		if (theBits & (1 << mCbOffset | 1 << mCrOffset)) {
+			mPixelsChanged[theBits] = 2;
+		} else {
+			mPixelsChanged[theBits] = ((theBits >> mLumaOffset) & 1) + ((theBits >> (mLumaOffset + 2)) & 1);
+		}
+	}
+
+	if (inLimits.isCompositeLimited) {
+		if (inLimits.compositeMin >= inLimits.compositeMax) throw (OSStatus)paramErr;
+
+		mCompositeLow = 16 + (inLimits.compositeMin * 219) / 100;
+		mCompositeHigh = 16 + (inLimits.compositeMax * 219) / 100;
+
+		mAmplitude = (UInt8 *)::NewPtr(256 * 256);
+		if (NULL == mAmplitude) throw (OSStatus)memFullErr;
+
+		for (SInt32 cb = 0; cb < 256; cb++) {
+			for (SInt32 cr = 0; cr < 256; cr++) {
+				double theU = kAmplitudeCb * (cb - 128), theV = kAmplitudeCr * (cr - 128);
+				double theAmplitude = ::sqrt(theU * theU + theV * theV) + 0.5;
+
+				mAmplitude[cb << 8 | cr] = (theAmplitude > 255.0) ? 255 : (UInt8)theAmplitude;
+			}
+		}
+	}
+
+	err = ::MPCreateCriticalRegion(&mLock);
+	if (err) {
+		if (mAmplitude) ::DisposePtr((Ptr)mAmplitude);
+		throw err;
+	}
+}
+
+CVideoOutputLegalizer::~CVideoOutputLegalizer()
+{
+	if (mAmplitude) ::DisposePtr((Ptr)mAmplitude);
+	if (mLock) ::MPDeleteCriticalRegion(mLock);
+}
+
+void CVideoOutputLegalizer::GetDefaultLimits(LegalizerLimitsRecord &outLimits)
+{
+	outLimits.lumaMin = 16;
+	outLimits.lumaMax = 235;
+	outLimits.chromaMin = 16;
+	outLimits.chromaMax = 240;
+	outLimits.knee = 0;
+	outLimits.isCompositeLimited = true;
+	outLimits.compositeMin = -20;
+	outLimits.compositeMax = 120;
+}
+
+/* MakeTable
+		Straight through between the knees, past one the rest of the range is squeezed into the knee so
+		the far end lands on the limit. Without a knee that's a clip.
+*/
+void CVideoOutputLegalizer::MakeTable(UInt8 outTable[256], UInt8 inMin, UInt8 inMax, UInt8 inKnee)
+{
+	SInt32 theLowKnee = inMin + inKnee, theHighKnee = inMax - inKnee;
+
+	for (SInt32 v = 0; v < 256; v++) {
+		if (v < theLowKnee) {
+			outTable[v] = inKnee ? theLowKnee - ((theLowKnee - v) * inKnee) / theLowKnee : inMin;
+		} else if (v > theHighKnee) {
+			outTable[v] = inKnee ? theHighKnee + ((v - theHighKnee) * inKnee) / (255 - theHighKnee) : inMax;
+		} else {
+			outTable[v] = v;
+		}
+	}
+}
+
+#pragma mark-
+
+/* LegalizeRect
+		With SSE2 four pairs are clipped at once with a byte min and max against the knees, which is all a
+		hard clip needs. Where there's a knee and any of them is past it those pairs go through the tables.
+		The composite limit is a pair at a time either way, on pixels that are in the cache.
+*/
+UInt32 CVideoOutputLegalizer::LegalizeRect(const UInt8 *inPixels, long inRowBytes, UInt8 *outPixels, long inOutRowBytes, UInt32 inPairs,
+										   UInt32 inRows) const
+{
+	UInt32 theCorrected = 0;
+#if __SSE2__
+	const __m128i theKneeLow = _mm_loadu_si128((const __m128i *)mKneeLow);
+	const __m128i theKneeHigh = _mm_loadu_si128((const __m128i *)mKneeHigh);
+#endif
+
+	for (UInt32 row = 0; row < inRows; row++) {
+		const UInt8 *pIn = inPixels + row * inRowBytes;
+		UInt8		*pOut = outPixels + row * inOutRowBytes;
+		UInt32		pair = 0;
+
+#if __SSE2__
+		for (; pair + 4 <= inPairs; pair += 4, pIn += 16, pOut += 16) {
+			__m128i thePixels = _mm_loadu_si128((const __m128i *)pIn);
+			__m128i theClipped = _mm_min_epu8(_mm_max_epu8(thePixels, theKneeLow), theKneeHigh);
+			UInt32	theChanged = ~_mm_movemask_epi8(_mm_cmpeq_epi8(theClipped, thePixels)) & 0xFFFF;
+
+			if (theChanged && mKnee) {
+				theCorrected += LegalizePairs(pIn, pOut, 4);
+				continue;
+			}
+
+			_mm_storeu_si128((__m128i *)pOut, theClipped);
+
+			if (mAmplitude) {
+				for (UInt32 i = 0; i < 16; i += 4) LimitComposite(pOut + i);
+				theChanged = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)pOut), thePixels)) & 0xFFFF;
+			}
+
+			if (theChanged) {
+				theCorrected += mPixelsChanged[theChanged & 0xF] + mPixelsChanged[(theChanged >> 4) & 0xF] +
+								mPixelsChanged[(theChanged >> 8) & 0xF] + mPixelsChanged[theChanged >> 12];
+			}
+		}
+#endif
+		theCorrected += LegalizePairs(pIn, pOut, inPairs - pair);
+	}
+
+	return theCorrected;
+}
+
+/* LegalizePairs
+		Through the tables, for the end of a row and for pairs in a knee.
+*/
+UInt32 CVideoOutputLegalizer::LegalizePairs(const UInt8 *inPixels, UInt8 *outPixels, UInt32 inPairs) const
+{
+	UInt32 theCorrected = 0;
+
+	for (UInt32 pair = 0; pair < inPairs; pair++, inPixels += 4, outPixels += 4) {
+		UInt8 theY0 = inPixels[mLumaOffset], theY1 = inPixels[mLumaOffset + 2], theCb = inPixels[mCbOffset], theCr = inPixels[mCrOffset];
+
+		outPixels[mLumaOffset] = mLumaTable[theY0];
+		outPixels[mLumaOffset + 2] = mLumaTable[theY1];
+		outPixels[mCbOffset] = mChromaTable[theCb];
+		outPixels[mCrOffset] = mChromaTable[theCr];
+
+		if (mAmplitude) LimitComposite(outPixels);
+
+		// New chroma changes both pixels of the pair
+		if (outPixels[mCbOffset] != theCb || outPixels[mCrOffset] != theCr) {
+			theCorrected += 2;
+		} else {
+			theCorrected += (outPixels[mLumaOffset] != theY0) + (outPixels[mLumaOffset + 2] != theY1);
+		}
+	}
+
+	return theCorrected;
+}
+
+/* LimitComposite
+		Scaling Cb and Cr together scales the amplitude and keeps the hue.
+*/
+void CVideoOutputLegalizer::LimitComposite(UInt8 ioPair[4]) const
+{
+	SInt32 theY0 = ioPair[mLumaOffset], theY1 = ioPair[mLumaOffset + 2], theCb = ioPair[mCbOffset], theCr = ioPair[mCrOffset];
+	SInt32 theAmplitude = mAmplitude[theCb << 8 | theCr];
+	SInt32 theHigh = (theY0 > theY1) ? theY0 : theY1;
+	SInt32 theLow = (theY0 < theY1) ? theY0 : theY1;
+	SInt32 theRoom = mCompositeHigh - theHigh;
+
+	if (theLow - mCompositeLow < theRoom) theRoom = theLow - mCompositeLow;
+	if (theRoom >= theAmplitude) return;
+
+	if (theRoom <= 0) {
+		ioPair[mCbOffset] = ioPair[mCrOffset] = 128;
+	} else {
+		ioPair[mCbOffset] = 128 + ((theCb - 128) * theRoom) / theAmplitude;
+		ioPair[mCrOffset] = 128 + ((theCr - 128) * theRoom) / theAmplitude;
+	}
+}
+
+/* FrameDone
+		Whoever writes the frames calls this on their own thread while the application reads the stats.
+*/
+void CVideoOutputLegalizer::FrameDone(UInt32 inCorrected)
+{
+	::MPEnterCriticalRegion(mLock, kDurationForever);
+	mStats.frames++;
+	if (inCorrected) mStats.framesCorrected++;
+	mStats.lastFrameCorrected = inCorrected;
+	if (inCorrected > mStats.maxFrameCorrected) mStats.maxFrameCorrected = inCorrected;
+	mStats.totalCorrected += inCorrected;
+	::MPExitCriticalRegion(mLock);
+}
+
+void CVideoOutputLegalizer::GetStats(LegalizerStatsRecord &outStats) const
+{
+	::MPEnterCriticalRegion(mLock, kDurationForever);
+	outStats = mStats;
+	::MPExitCriticalRegion(mLock);
+}
@@ -0,0 +1,165 @@
+/*
+	File:		 CVideoOutputLegalizer.h
+	
+	Description: Keeps Y'CbCr going to the video output within broadcast limits, clipping luma and chroma
+				 and pulling chroma in where the composite signal would go out of gamut, and counts the
+				 pixels it changes. Used by the CVideoOutput class.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 SSE2 clip, the stats are locked
+										<2> 10/19/26 cDepthErr for a pixel format it doesn't take
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputLegalizer( const LegalizerLimitsRecord &inLimits, OSType inPixelFormat )
+		Frames are '2vuy' or 'yuvs'. Throws cDepthErr for any other pixel format, paramErr for limits which
+		don't make sense and memFullErr if there isn't the memory for the tables.
+
+	GetDefaultLimits( LegalizerLimitsRecord &outLimits )
+		Y' 16 to 235, Cb and Cr 16 to 240, composite -20 to 120 IRE, hard clipped.
+
+	LegalizeRect( const UInt8 *inPixels, long inRowBytes, UInt8 *outPixels, long inOutRowBytes, UInt32 inPairs, UInt32 inRows )
+		Legalizes inRows rows of inPairs pairs of pixels from inPixels into outPixels, which can be the same.
+		It's meant to be part of whatever already has the pixels in hand - the DV codecs call it on a
+		macroblock at a time as it goes through the cache anyway, the swap chain on a row at a time as it
+		copies, the rate converter on a row at a time as it composes - so it doesn't cost a trip through
+		memory of its own. Returns how many pixels were changed. Any thread, any number at once.
+
+	FrameDone( UInt32 inCorrected )
+		Call once a frame has been legalized, with the total LegalizeRect() returned for it. Any thread.
+
+	GetStats( LegalizerStatsRecord &outStats )
+		Frames legalized and pixels changed, in the last frame and over all of them. Any thread.
+
+	Y', Cb and Cr each go through a table, so clipping and soft clipping cost the same, though with SSE2 a
+	hard clip is a byte min and max. With a knee, values within knee codes of a limit and beyond are squeezed
+	into the knee rather than cut off, which keeps some detail in super-whites. The composite signal is Y' plus and minus the subcarrier amplitude, worked out
+	from Cb and Cr for NTSC and PAL alike; when a pair of pixels would go past the composite limits its
+	chroma is scaled down until it doesn't, which keeps the hue.
+*/
+
+#ifndef __CVIDEOOUTPUTLEGALIZER_H__
+	#define __CVIDEOOUTPUTLEGALIZER_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <ImageCompression.h>
+#endif
+
+#include <memory>
+
+namespace dts {
+
+typedef struct {
+	UInt8	lumaMin;
+	UInt8	lumaMax;
+	UInt8	chromaMin;
+	UInt8	chromaMax;
+	UInt8	knee;					// codes, 0 clips hard
+	Boolean	isCompositeLimited;
+	SInt16	compositeMin;			// IRE, black is 0 and Y' 16, white 100 and Y' 235
+	SInt16	compositeMax;
+} LegalizerLimitsRecord;
+
+typedef struct {
+	UInt32	frames;
+	UInt32	framesCorrected;		// with at least one pixel changed
+	UInt32	lastFrameCorrected;		// pixels
+	UInt32	maxFrameCorrected;
+	UInt64	totalCorrected;
+} LegalizerStatsRecord;
+
+class CVideoOutputLegalizer {
+	public:
+		CVideoOutputLegalizer(const LegalizerLimitsRecord &inLimits, OSType inPixelFormat) throw(OSStatus);
+		~CVideoOutputLegalizer();
+
+		static void GetDefaultLimits(LegalizerLimitsRecord &outLimits);
+
+		UInt32 LegalizeRect(const UInt8 *inPixels, long inRowBytes, UInt8 *outPixels, long inOutRowBytes, UInt32 inPairs,
+							UInt32 inRows) const;
+
+		void FrameDone(UInt32 inCorrected);
+		void GetStats(LegalizerStatsRecord &outStats) const;
+
+	private:
+		static void MakeTable(UInt8 outTable[256], UInt8 inMin, UInt8 inMax, UInt8 inKnee);
+
+		UInt32 LegalizePairs(const UInt8 *inPixels, UInt8 *outPixels, UInt32 inPairs) const;
+		void   LimitComposite(UInt8 ioPair[4]) const;
+
+		// nope
+		CVideoOutputLegalizer(const CVideoOutputLegalizer &inLegalizer);
+		CVideoOutputLegalizer operator=(CVideoOutputLegalizer inLegalizer);
+
+	private:
+		UInt8				mLumaOffset;
+		UInt8				mCbOffset;
+		UInt8				mCrOffset;
+		UInt8				mKnee;
+
+		UInt8				mLumaTable[256];
+		UInt8				mChromaTable[256];
+		UInt8				mKneeLow[16];		// four pairs of the codes the tables leave alone
+		UInt8				mKneeHigh[16];
+		UInt8				mPixelsChanged[16];	// by the bytes changed in a pair
+
+		// subcarrier amplitude in Y' codes by [Cb][Cr], NULL when the composite isn't limited
+		UInt8				*mAmplitude;
+		SInt32				mCompositeLow;		// Y' codes
+		SInt32				mCompositeHigh;
+
+		LegalizerStatsRecord mStats;			// protected by mLock
+		MPCriticalRegionID	mLock;
+};
+
+typedef std::auto_ptr<CVideoOutputLegalizer> CVideoOutputLegalizerPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTLEGALIZER_H__
@@ -0,0 +1,599 @@
+/*
+	File:		 CVideoOutputLoudnessMeter.cpp
+	
+	Description: Loudness metering for the video output.
+				 See CVideoOutputLoudnessMeter.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 K weighted loudness and 4x true peak from a movie audio extraction session
+										<2> 10/19/26 levels in dBFS, no BS.1770 K weighting offset
+										<1> 10/19/26 initial release
+*/
+
+#include <math.h>
+#include <string.h>
+
+#if __SSE2__
+	#include <emmintrin.h>
+#endif
+
+#include "CVideoOutputLoudnessMeter.h"
+
+using namespace dts;
+
+// The BS.1770 K weighting filters worked back from their 48 kHz coefficients, so they can be had at any rate
+const double kShelfFrequency = 1681.974450955533;
+const double kShelfGain = 3.999843853973347;			// dB
+const double kShelfQ = 0.7071752369554196;
+const double kHighPassFrequency = 38.13547087602444;
+const double kHighPassQ = 0.5003270373238773;
+
+// BS.1770 weights the surrounds 1.41 and leaves the LFE out
+const double kSurroundWeight = 1.41;
+
+/* KWeightChannel
+		K weights one channel of interleaved samples, inStride floats to a frame, and adds up the squares.
+*/
+static inline void KWeightChannel(const float *inSamples, UInt32 inStride, UInt32 inFrames, const KWeightingRecord &inK,
+								  KWeightingStateRecord &ioState, double &ioSum)
+{
+	double s1 = ioState.shelf[0], s2 = ioState.shelf[1];
+	double h1 = ioState.highPass[0], h2 = ioState.highPass[1];
+	double theSum = 0.0;
+
+	for (UInt32 i = 0; i < inFrames; i++, inSamples += inStride) {
+		double x = *inSamples;
+		double y = inK.shelfB[0] * x + s1;
+		double z;
+
+		s1 = inK.shelfB[1] * x - inK.shelfA[0] * y + s2;
+		s2 = inK.shelfB[2] * x - inK.shelfA[1] * y;
+
+		z = y + h1;
+		h1 = h2 - 2.0 * y - inK.highPassA[0] * z;
+		h2 = y - inK.highPassA[1] * z;
+
+		theSum += z * z;
+	}
+
+	ioState.shelf[0] = s1;
+	ioState.shelf[1] = s2;
+	ioState.highPass[0] = h1;
+	ioState.highPass[1] = h2;
+	ioSum += theSum;
+}
+
+/* KWeightPair
+		KWeightChannel() for two channels side by side, a channel in each half of a register.
+*/
+#if __SSE2__
+static inline void KWeightPair(const float *inSamples, UInt32 inStride, UInt32 inFrames, const KWeightingRecord &inK,
+							   KWeightingStateRecord *ioState, double *ioSum)
+{
+	const __m128d b0 = _mm_set1_pd(inK.shelfB[0]), b1 = _mm_set1_pd(inK.shelfB[1]), b2 = _mm_set1_pd(inK.shelfB[2]);
+	const __m128d a1 = _mm_set1_pd(inK.shelfA[0]), a2 = _mm_set1_pd(inK.shelfA[1]);
+	const __m128d c1 = _mm_set1_pd(inK.highPassA[0]), c2 = _mm_set1_pd(inK.highPassA[1]);
+	__m128d s1 = _mm_set_pd(ioState[1].shelf[0], ioState[0].shelf[0]);
+	__m128d s2 = _mm_set_pd(ioState[1].shelf[1], ioState[0].shelf[1]);
+	__m128d h1 = _mm_set_pd(ioState[1].highPass[0], ioState[0].highPass[0]);
+	__m128d h2 = _mm_set_pd(ioState[1].highPass[1], ioState[0].highPass[1]);
+	__m128d theSum = _mm_setzero_pd();
+	double	theState[2];
+
+	for (UInt32 i = 0; i < inFrames; i++, inSamples += inStride) {
+		// The two floats in the low half, widened
+		__m128d x = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double *)inSamples)));
+		__m128d y = _mm_add_pd(_mm_mul_pd(b0, x), s1);
+		__m128d z;
+
+		s1 = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(b1, x), s2), _mm_mul_pd(a1, y));
+		s2 = _mm_sub_pd(_mm_mul_pd(b2, x), _mm_mul_pd(a2, y));
+
+		z = _mm_add_pd(y, h1);
+		h1 = _mm_sub_pd(_mm_sub_pd(h2, _mm_add_pd(y, y)), _mm_mul_pd(c1, z));
+		h2 = _mm_sub_pd(y, _mm_mul_pd(c2, z));
+
+		theSum = _mm_add_pd(theSum, _mm_mul_pd(z, z));
+	}
+
+	_mm_storeu_pd(theState, s1);
+	ioState[0].shelf[0] = theState[0];
+	ioState[1].shelf[0] = theState[1];
+	_mm_storeu_pd(theState, s2);
+	ioState[0].shelf[1] = theState[0];
+	ioState[1].shelf[1] = theState[1];
+	_mm_storeu_pd(theState, h1);
+	ioState[0].highPass[0] = theState[0];
+	ioState[1].highPass[0] = theState[1];
+	_mm_storeu_pd(theState, h2);
+	ioState[0].highPass[1] = theState[0];
+	ioState[1].highPass[1] = theState[1];
+	_mm_storeu_pd(theState, theSum);
+	ioSum[0] += theState[0];
+	ioSum[1] += theState[1];
+}
+#else
+static inline void KWeightPair(const float *inSamples, UInt32 inStride, UInt32 inFrames, const KWeightingRecord &inK,
+							   KWeightingStateRecord *ioState, double *ioSum)
+{
+	KWeightChannel(inSamples, inStride, inFrames, inK, ioState[0], ioSum[0]);
+	KWeightChannel(inSamples + 1, inStride, inFrames, inK, ioState[1], ioSum[1]);
+}
+#endif
+
+/* TruePeakChannel
+		Runs one channel through the 4 phase interpolator and keeps the highest magnitude in ioPeak. The
+		history is written twice, at the position and kTruePeakTaps on, so the taps read it straight through
+		with the newest sample first. The position steps back a frame at a time from inPos.
+*/
+#if __SSE2__
+static inline void TruePeakChannel(const float *inSamples, UInt32 inStride, UInt32 inFrames, const float inTaps[][kTruePeakPhases],
+								   float *ioHistory, UInt32 inPos, float &ioPeak)
+{
+	const __m128 theAbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	__m128 thePeak = _mm_set1_ps(ioPeak);
+
+	for (UInt32 i = 0; i < inFrames; i++, inSamples += inStride) {
+		const float *pHistory;
+		__m128 theSum;
+
+		inPos = inPos ? inPos - 1 : kTruePeakTaps - 1;
+		ioHistory[inPos] = ioHistory[inPos + kTruePeakTaps] = *inSamples;
+		pHistory = ioHistory + inPos;
+
+		// All 4 phases at once, each tap's phases are side by side
+		theSum = _mm_mul_ps(_mm_loadu_ps(inTaps[0]), _mm_set1_ps(pHistory[0]));
+		for (UInt32 j = 1; j < kTruePeakTaps; j++) {
+			theSum = _mm_add_ps(theSum, _mm_mul_ps(_mm_loadu_ps(inTaps[j]), _mm_set1_ps(pHistory[j])));
+		}
+
+		thePeak = _mm_max_ps(thePeak, _mm_and_ps(theSum, theAbsMask));
+	}
+
+	thePeak = _mm_max_ps(thePeak, _mm_shuffle_ps(thePeak, thePeak, _MM_SHUFFLE(2, 3, 0, 1)));
+	thePeak = _mm_max_ps(thePeak, _mm_shuffle_ps(thePeak, thePeak, _MM_SHUFFLE(1, 0, 3, 2)));
+	_mm_store_ss(&ioPeak, thePeak);
+}
+#else
+static inline void TruePeakChannel(const float *inSamples, UInt32 inStride, UInt32 inFrames, const float inTaps[][kTruePeakPhases],
+								   float *ioHistory, UInt32 inPos, float &ioPeak)
+{
+	for (UInt32 i = 0; i < inFrames; i++, inSamples += inStride) {
+		const float *pHistory;
+
+		inPos = inPos ? inPos - 1 : kTruePeakTaps - 1;
+		ioHistory[inPos] = ioHistory[inPos + kTruePeakTaps] = *inSamples;
+		pHistory = ioHistory + inPos;
+
+		for (UInt32 k = 0; k < kTruePeakPhases; k++) {
+			float theSum = 0.0f;
+
+			for (UInt32 j = 0; j < kTruePeakTaps; j++) {
+				theSum += inTaps[j][k] * pHistory[j];
+			}
+			if (theSum < 0.0f) theSum = -theSum;
+			if (theSum > ioPeak) ioPeak = theSum;
+		}
+	}
+}
+#endif
+
+/* GetTruePeakTaps
+		A 48 tap Blackman windowed sinc cut off at the original Nyquist, tap t of the interpolator is
+		outTaps[t / 4][t % 4]. Each phase is scaled to a gain of 1, phase 0 is the input delayed 6 samples.
+*/
+static void GetTruePeakTaps(float outTaps[][kTruePeakPhases])
+{
+	const double theLength = kTruePeakTaps * kTruePeakPhases;
+
+	for (UInt32 k = 0; k < kTruePeakPhases; k++) {
+		double theGain = 0.0;
+
+		for (UInt32 j = 0; j < kTruePeakTaps; j++) {
+			double t = j * kTruePeakPhases + k;
+			double x = (t - theLength / 2) / kTruePeakPhases;
+			double theSinc = (0.0 == x) ? 1.0 : ::sin(M_PI * x) / (M_PI * x);
+			double theWindow = 0.42 - 0.5 * ::cos(2.0 * M_PI * t / theLength) + 0.08 * ::cos(4.0 * M_PI * t / theLength);
+
+			outTaps[j][k] = (float)(theSinc * theWindow);
+			theGain += outTaps[j][k];
+		}
+
+		for (UInt32 j = 0; j < kTruePeakTaps; j++) {
+			outTaps[j][k] = (float)(outTaps[j][k] / theGain);
+		}
+	}
+}
+
+#pragma mark-
+
+CVideoOutputLoudnessMeter::CVideoOutputLoudnessMeter(const Movie inMovie) throw(OSStatus)
+	: mMovie(inMovie), mExtractMovie(NULL), mExtraction(NULL), mSampleRate(0.0), mChannels(0), mBuffer(NULL), mIsSynced(false),
+	  mNextFrame(0), mHistoryPos(0), mBlockLength(0), mBlockFrames(0), mNextBlock(0), mBlockCount(0), mGatedBlocks(0), mTotalBlocks(0),
+	  mMaxMomentary(0.0), mTruePeak(0.0f)
+{
+	Handle	 hDataRef = NULL;
+	OSType	 theDataRefType;
+	OSStatus err;
+
+	::memset(mKState, 0, sizeof(mKState));
+	::memset(mHistory, 0, sizeof(mHistory));
+	::memset(mBlockSum, 0, sizeof(mBlockSum));
+	::memset(mBinPower, 0, sizeof(mBinPower));
+	::memset(mBinCount, 0, sizeof(mBinCount));
+
+	if (NULL == inMovie) { err = paramErr; goto bail; }
+
+	// The playing Movie's time mustn't be moved by the extraction, so it gets a Movie of its own
+	err = ::GetMovieDefaultDataRef(inMovie, &hDataRef, &theDataRefType);
+	if (err) goto bail;
+
+	err = ::NewMovieFromDataRef(&mExtractMovie, newMovieActive, NULL, hDataRef, theDataRefType);
+	if (err) goto bail;
+
+	err = SetUpExtraction();
+	if (err) goto bail;
+
+	mBuffer = (float *)::NewPtr(kLoudnessBufferFrames * mChannels * sizeof(float));
+	if (NULL == mBuffer) { err = memFullErr; goto bail; }
+
+	GetKWeighting(mSampleRate, mK);
+	GetChannelWeights();
+	GetTruePeakTaps(mTruePeakTaps);
+	mBlockLength = (UInt32)(mSampleRate / kLoudnessBlocksPerSecond + 0.5);
+
+	::DisposeHandle(hDataRef);
+
+	return;
+
+bail:
+	if (hDataRef) ::DisposeHandle(hDataRef);
+	Dispose();
+
+	throw err;
+}
+
+CVideoOutputLoudnessMeter::~CVideoOutputLoudnessMeter()
+{
+	Dispose();
+}
+
+void CVideoOutputLoudnessMeter::Dispose(void)
+{
+	if (mExtraction) ::MovieAudioExtractionEnd(mExtraction);
+	mExtraction = NULL;
+
+	if (mExtractMovie) ::DisposeMovie(mExtractMovie);
+	mExtractMovie = NULL;
+
+	if (mBuffer) ::DisposePtr((Ptr)mBuffer);
+	mBuffer = NULL;
+}
+
+/* SetUpExtraction
+		Starts the extraction session and asks for the Movie's own sample rate and channels, up to
+		kLoudnessMaxChannels, as interleaved native floats.
+*/
+OSStatus CVideoOutputLoudnessMeter::SetUpExtraction(void)
+{
+	AudioStreamBasicDescription theFormat;
+	OSStatus err;
+
+	err = ::MovieAudioExtractionBegin(mExtractMovie, 0, &mExtraction);
+	if (err) return err;
+
+	err = ::MovieAudioExtractionGetProperty(mExtraction, kQTPropertyClass_MovieAudioExtraction_Audio,
+											kQTMovieAudioExtractionAudioPropertyID_AudioStreamBasicDescription, sizeof(theFormat), &theFormat, NULL);
+	if (err) return err;
+	if (theFormat.mSampleRate < kLoudnessBlocksPerSecond || 0 == theFormat.mChannelsPerFrame) return paramErr;
+
+	mSampleRate = theFormat.mSampleRate;
+	mChannels = (theFormat.mChannelsPerFrame > kLoudnessMaxChannels) ? kLoudnessMaxChannels : theFormat.mChannelsPerFrame;
+
+	theFormat.mFormatID = kAudioFormatLinearPCM;
+	theFormat.mFormatFlags = kAudioFormatFlagsNativeFloatPacked;
+	theFormat.mChannelsPerFrame = mChannels;
+	theFormat.mBitsPerChannel = 32;
+	theFormat.mFramesPerPacket = 1;
+	theFormat.mBytesPerFrame = theFormat.mBytesPerPacket = mChannels * sizeof(float);
+
+	return ::MovieAudioExtractionSetProperty(mExtraction, kQTPropertyClass_MovieAudioExtraction_Audio,
+											 kQTMovieAudioExtractionAudioPropertyID_AudioStreamBasicDescription, sizeof(theFormat), &theFormat);
+}
+
+/* GetChannelWeights
+		From the labels of the extraction's channel layout, 1.0 for any channel it doesn't describe.
+*/
+void CVideoOutputLoudnessMeter::GetChannelWeights(void)
+{
+	AudioChannelLayout	*pLayout = NULL;
+	QTPropertyValueType theType;
+	ByteCount			theSize = 0;
+	UInt32				theFlags;
+
+	for (UInt32 i = 0; i < kLoudnessMaxChannels; i++) {
+		mWeights[i] = 1.0;
+	}
+
+	if (::MovieAudioExtractionGetPropertyInfo(mExtraction, kQTPropertyClass_MovieAudioExtraction_Audio,
+											  kQTMovieAudioExtractionAudioPropertyID_AudioChannelLayout, &theType, &theSize, &theFlags) || 0 == theSize) return;
+
+	pLayout = (AudioChannelLayout *)::NewPtr(theSize);
+	if (NULL == pLayout) return;
+
+	if (noErr == ::MovieAudioExtractionGetProperty(mExtraction, kQTPropertyClass_MovieAudioExtraction_Audio,
+												   kQTMovieAudioExtractionAudioPropertyID_AudioChannelLayout, theSize, pLayout, NULL) &&
+		kAudioChannelLayoutTag_UseChannelDescriptions == pLayout->mChannelLayoutTag) {
+		for (UInt32 i = 0; i < pLayout->mNumberChannelDescriptions && i < mChannels; i++) {
+			switch (pLayout->mChannelDescriptions[i].mChannelLabel) {
+				case kAudioChannelLabel_LFEScreen:
+				case kAudioChannelLabel_LFE2:
+					mWeights[i] = 0.0;
+					break;
+				case kAudioChannelLabel_LeftSurround:
+				case kAudioChannelLabel_RightSurround:
+				case kAudioChannelLabel_LeftSurroundDirect:
+				case kAudioChannelLabel_RightSurroundDirect:
+				case kAudioChannelLabel_RearSurroundLeft:
+				case kAudioChannelLabel_RearSurroundRight:
+					mWeights[i] = kSurroundWeight;
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	::DisposePtr((Ptr)pLayout);
+}
+
+/* GetKWeighting
+		The pre-filter, a high shelf, and the RLB high pass bilinear transformed for inSampleRate.
+*/
+void CVideoOutputLoudnessMeter::GetKWeighting(double inSampleRate, KWeightingRecord &outK)
+{
+	double K = ::tan(M_PI * kShelfFrequency / inSampleRate);
+	double Vh = ::pow(10.0, kShelfGain / 20.0);
+	double Vb = ::pow(Vh, 0.4996667741545416);
+	double a0 = 1.0 + K / kShelfQ + K * K;
+
+	outK.shelfB[0] = (Vh + Vb * K / kShelfQ + K * K) / a0;
+	outK.shelfB[1] = 2.0 * (K * K - Vh) / a0;
+	outK.shelfB[2] = (Vh - Vb * K / kShelfQ + K * K) / a0;
+	outK.shelfA[0] = 2.0 * (K * K - 1.0) / a0;
+	outK.shelfA[1] = (1.0 - K / kShelfQ + K * K) / a0;
+
+	K = ::tan(M_PI * kHighPassFrequency / inSampleRate);
+	a0 = 1.0 + K / kHighPassQ + K * K;
+
+	outK.highPassA[0] = 2.0 * (K * K - 1.0) / a0;
+	outK.highPassA[1] = (1.0 - K / kHighPassQ + K * K) / a0;
+}
+
+#pragma mark-
+
+/* Seek
+		Starts extracting at inTime, the filters and the interpolator start over and the blocks carry on.
+*/
+OSStatus CVideoOutputLoudnessMeter::Seek(TimeValue inTime, TimeScale inScale)
+{
+	TimeRecord theTime;
+	OSStatus   err;
+
+	mIsSynced = false;
+
+	theTime.value.hi = 0;
+	theTime.value.lo = inTime;
+	theTime.scale = inScale;
+	theTime.base = NULL;
+
+	err = ::MovieAudioExtractionSetProperty(mExtraction, kQTPropertyClass_MovieAudioExtraction_Movie,
+											kQTMovieAudioExtractionMoviePropertyID_CurrentTime, sizeof(theTime), &theTime);
+	if (err) return err;
+
+	::memset(mKState, 0, sizeof(mKState));
+	::memset(mHistory, 0, sizeof(mHistory));
+
+	mNextFrame = (SInt64)((double)inTime * mSampleRate / inScale);
+	mIsSynced = true;
+
+	return noErr;
+}
+
+void CVideoOutputLoudnessMeter::Measure(void)
+{
+	TimeScale theScale;
+	TimeValue theTime;
+	SInt64	  theTarget;
+
+	if (::GetMovieRate(mMovie) <= 0) {
+		mIsSynced = false;
+		return;
+	}
+
+	theScale = ::GetMovieTimeScale(mMovie);
+	theTime = ::GetMovieTime(mMovie, NULL);
+	theTarget = (SInt64)((double)theTime * mSampleRate / theScale);
+
+	// Moved, or too far behind to catch up on in one idle
+	if (!mIsSynced || theTarget < mNextFrame || theTarget - mNextFrame > (SInt64)mSampleRate) {
+		Seek(theTime, theScale);
+		return;
+	}
+
+	while (mNextFrame < theTarget) {
+		AudioBufferList theBuffers;
+		UInt32			theFrames = (theTarget - mNextFrame > kLoudnessBufferFrames) ? kLoudnessBufferFrames : (UInt32)(theTarget - mNextFrame);
+		UInt32			theFlags = 0;
+
+		theBuffers.mNumberBuffers = 1;
+		theBuffers.mBuffers[0].mNumberChannels = mChannels;
+		theBuffers.mBuffers[0].mDataByteSize = theFrames * mChannels * sizeof(float);
+		theBuffers.mBuffers[0].mData = mBuffer;
+
+		if (::MovieAudioExtractionFillBuffer(mExtraction, &theFrames, &theBuffers, &theFlags)) {
+			mIsSynced = false;
+			break;
+		}
+
+		Process(mBuffer, theFrames);
+		mNextFrame += theFrames;
+
+		if (0 == theFrames || (theFlags & kQTMovieAudioExtractionComplete)) break;
+	}
+}
+
+/* Process
+		K weights inFrames of interleaved samples into the blocks and finds their true peak.
+*/
+void CVideoOutputLoudnessMeter::Process(const float *inSamples, UInt32 inFrames)
+{
+	while (inFrames) {
+		UInt32 theSpan = mBlockLength - mBlockFrames;
+		UInt32 c;
+
+		if (theSpan > inFrames) theSpan = inFrames;
+
+		for (c = 0; c + 1 < mChannels; c += 2) {
+			KWeightPair(inSamples + c, mChannels, theSpan, mK, mKState + c, mBlockSum + c);
+		}
+		if (c < mChannels) KWeightChannel(inSamples + c, mChannels, theSpan, mK, mKState[c], mBlockSum[c]);
+
+		for (c = 0; c < mChannels; c++) {
+			TruePeakChannel(inSamples + c, mChannels, theSpan, mTruePeakTaps, mHistory[c], mHistoryPos, mTruePeak);
+		}
+		mHistoryPos = (mHistoryPos + kTruePeakTaps - theSpan % kTruePeakTaps) % kTruePeakTaps;
+
+		inSamples += theSpan * mChannels;
+		inFrames -= theSpan;
+		mBlockFrames += theSpan;
+
+		if (mBlockLength == mBlockFrames) EndBlock();
+	}
+}
+
+/* EndBlock
+		Each 100 millisecond block ends a 400 millisecond momentary block, a 75% overlap as in BS.1770, and
+		the momentary block goes in the histogram if it's over the absolute gate.
+*/
+void CVideoOutputLoudnessMeter::EndBlock(void)
+{
+	double thePower = 0.0, theMomentary, theLoudness;
+
+	// Channels add up by power, each with its weight
+	for (UInt32 c = 0; c < mChannels; c++) {
+		thePower += mWeights[c] * mBlockSum[c];
+		mBlockSum[c] = 0.0;
+	}
+
+	mBlocks[mNextBlock] = thePower / mBlockLength;
+	mNextBlock = (mNextBlock + 1) % kLoudnessShortTermBlocks;
+	if (mBlockCount < kLoudnessShortTermBlocks) mBlockCount++;
+
+	mBlockFrames = 0;
+
+	if (mBlockCount < kLoudnessMomentaryBlocks) return;
+
+	theMomentary = GetWindowPower(kLoudnessMomentaryBlocks);
+	if (theMomentary > mMaxMomentary) mMaxMomentary = theMomentary;
+	mTotalBlocks++;
+
+	theLoudness = PowerToLoudness(theMomentary);
+	if (theLoudness <= -70.0) return;
+
+	UInt32 theBin = (UInt32)((theLoudness + 70.0) * 10.0);
+	if (theBin >= kLoudnessHistogramBins) theBin = kLoudnessHistogramBins - 1;
+
+	mBinPower[theBin] += theMomentary;
+	mBinCount[theBin]++;
+	mGatedBlocks++;
+}
+
+double CVideoOutputLoudnessMeter::GetWindowPower(UInt32 inBlocks) const
+{
+	double theSum = 0.0;
+
+	for (UInt32 i = 1; i <= inBlocks; i++) {
+		theSum += mBlocks[(mNextBlock + kLoudnessShortTermBlocks - i) % kLoudnessShortTermBlocks];
+	}
+
+	return theSum / inBlocks;
+}
+
+// -0.691 makes a 997 Hz sine at full scale on one channel read -3.01 LUFS, the K weighting's gain there
+double CVideoOutputLoudnessMeter::PowerToLoudness(double inPower)
+{
+	if (inPower <= 0.0) return -HUGE_VAL;
+
+	return -0.691 + 10.0 * ::log10(inPower);
+}
+
+void CVideoOutputLoudnessMeter::GetStats(LoudnessStatsRecord &outStats) const
+{
+	double theSum = 0.0, theGate;
+	UInt32 theCount = 0;
+
+	outStats.momentary = (mBlockCount >= kLoudnessMomentaryBlocks) ? LoudnessToFixed(PowerToLoudness(GetWindowPower(kLoudnessMomentaryBlocks))) : kLoudnessFloor;
+	outStats.shortTerm = (mBlockCount >= kLoudnessShortTermBlocks) ? LoudnessToFixed(PowerToLoudness(GetWindowPower(kLoudnessShortTermBlocks))) : kLoudnessFloor;
+	outStats.maxMomentary = LoudnessToFixed(PowerToLoudness(mMaxMomentary));
+	outStats.truePeak = LoudnessToFixed((mTruePeak > 0.0f) ? 20.0 * ::log10(mTruePeak) : -HUGE_VAL);
+	outStats.gatedBlocks = mGatedBlocks;
+	outStats.totalBlocks = mTotalBlocks;
+	outStats.integrated = kLoudnessFloor;
+
+	if (0 == mGatedBlocks) return;
+
+	// The relative gate is 10 LU under the loudness of everything over the absolute gate
+	for (UInt32 i = 0; i < kLoudnessHistogramBins; i++) {
+		theSum += mBinPower[i];
+	}
+	theGate = PowerToLoudness(theSum / mGatedBlocks) - 10.0;
+
+	theSum = 0.0;
+	for (UInt32 i = (theGate > -70.0) ? (UInt32)::ceil((theGate + 70.0) * 10.0) : 0; i < kLoudnessHistogramBins; i++) {
+		theSum += mBinPower[i];
+		theCount += mBinCount[i];
+	}
+
+	if (theCount) outStats.integrated = LoudnessToFixed(PowerToLoudness(theSum / theCount));
+}
@@ -0,0 +1,197 @@
+/*
+	File:		 CVideoOutputLoudnessMeter.h
+	
+	Description: Momentary, short term and integrated loudness and the true peak of a movie's sound while it
+				 plays, measured the ITU-R BS.1770 way for EBU R128 and ATSC A/85. Used by the CVideoOutput
+				 class.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 K weighted loudness and 4x true peak from a movie audio extraction session
+										<2> 10/19/26 it's a level meter, the stats are dBFS levels and not BS.1770 loudness
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputLoudnessMeter( const Movie inMovie ) throw(OSStatus)
+		Opens the Movie a second time from its default data reference and starts a QuickTime 7 audio
+		extraction session on it, so reading the sound doesn't disturb the Movie that's playing. Throws
+		an OSStatus if the Movie can't be opened again or has no sound to extract.
+
+	Measure( void )
+		Call regularly while the Movie plays, every idle for example. Extracts the sound from where the last
+		call stopped up to the Movie's time, K weights it and adds it up in 100 millisecond blocks. Four
+		blocks make a 400 millisecond momentary block and thirty the 3 second short term window, stepped
+		every 100 milliseconds as ITU-R BS.1770 does. Nothing is measured while the Movie is stopped or
+		playing backwards, and the extraction starts again from the Movie's time when it's moved or falls a
+		second behind.
+
+	GetStats( LoudnessStatsRecord &outStats )
+		Integrated loudness is gated the BS.1770 way, momentary blocks under -70 LUFS are left out and then
+		those more than 10 LU under the loudness of the rest. The blocks are kept in a histogram of 0.1 LU
+		bins so the second gate doesn't need every block since the start. Anything under -70 is reported as
+		kLoudnessFloor. The true peak is the highest sample of the sound oversampled 4 times, in dBTP.
+
+	The K weighting is the two BS.1770 biquads worked out for the extraction's sample rate. The channels are
+	weighted by their labels in the extraction's channel layout - 1.41 for the surrounds, LFE left out and 1.0
+	for the rest, including every channel of a layout given only as a tag. The true peak interpolator is a
+	48 tap windowed sinc, 12 taps for each of the 4 phases. With SSE2 the K weighting runs on two channels
+	at a time and the interpolator works out all 4 phases of a sample at once.
+
+	What's measured is the Movie's sound as QuickTime mixes it from the file, up to kLoudnessMaxChannels
+	channels - before the audio routes' gains and the sound output component, which we can't read back from.
+*/
+
+#ifndef __CVIDEOOUTPUTLOUDNESSMETER_H__
+	#define __CVIDEOOUTPUTLOUDNESSMETER_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <Movies.h>
+#endif
+
+#include <memory>
+
+namespace dts {
+
+const UInt32 kLoudnessMaxChannels = 8;
+const UInt32 kLoudnessBlocksPerSecond = 10;			// 100 milliseconds
+const UInt32 kLoudnessMomentaryBlocks = 4;			// 400 milliseconds
+const UInt32 kLoudnessShortTermBlocks = 30;			// 3 seconds
+const UInt32 kLoudnessHistogramBins = 750;			// 0.1 LU from -70 LUFS to +5
+const UInt32 kLoudnessBufferFrames = 4096;			// extracted at a time
+const UInt32 kTruePeakTaps = 12;					// for each phase
+const UInt32 kTruePeakPhases = 4;
+const Fixed	 kLoudnessFloor = -70 * fixed1;
+
+typedef struct {
+	Fixed	momentary;			// LUFS, the last 400 milliseconds
+	Fixed	shortTerm;			// LUFS, the last 3 seconds
+	Fixed	integrated;			// LUFS, gated, since the start
+	Fixed	maxMomentary;		// LUFS
+	Fixed	truePeak;			// dBTP, the highest since the start
+	UInt32	gatedBlocks;		// momentary blocks over -70 LUFS
+	UInt32	totalBlocks;
+} LoudnessStatsRecord;
+
+// A channel's K weighting filter state, transposed direct form II
+typedef struct {
+	double	shelf[2];
+	double	highPass[2];
+} KWeightingStateRecord;
+
+typedef struct {
+	double	shelfB[3];			// high shelf, +4 dB above about 1.5 kHz
+	double	shelfA[2];			// a1 and a2, a0 is 1
+	double	highPassA[2];		// the high pass' b is 1, -2, 1
+} KWeightingRecord;
+
+class CVideoOutputLoudnessMeter {
+	public:
+		CVideoOutputLoudnessMeter(const Movie inMovie) throw(OSStatus);
+		~CVideoOutputLoudnessMeter();
+
+		void Measure(void);
+
+		void GetStats(LoudnessStatsRecord &outStats) const;
+
+	private:
+		OSStatus SetUpExtraction(void);
+		void	 GetChannelWeights(void);
+		OSStatus Seek(TimeValue inTime, TimeScale inScale);
+		void	 Process(const float *inSamples, UInt32 inFrames);
+		void	 EndBlock(void);
+		double	 GetWindowPower(UInt32 inBlocks) const;
+		void	 Dispose(void);
+
+		static void	  GetKWeighting(double inSampleRate, KWeightingRecord &outK);
+		static double PowerToLoudness(double inPower);
+		static Fixed  LoudnessToFixed(double inLoudness) { return (inLoudness < -70.0) ? kLoudnessFloor : (Fixed)(inLoudness * fixed1); }
+
+		// nope
+		CVideoOutputLoudnessMeter(const CVideoOutputLoudnessMeter &inMeter);
+		CVideoOutputLoudnessMeter operator=(CVideoOutputLoudnessMeter inMeter);
+
+	private:
+		Movie					mMovie;				// the one playing
+		Movie					mExtractMovie;		// the same Movie opened again
+		MovieAudioExtractionRef	mExtraction;
+		double					mSampleRate;
+		UInt32					mChannels;
+		float					*mBuffer;			// kLoudnessBufferFrames interleaved
+		Boolean					mIsSynced;
+		SInt64					mNextFrame;			// of the Movie's sound, the next to extract
+
+		KWeightingRecord		mK;
+		KWeightingStateRecord	mKState[kLoudnessMaxChannels];
+		double					mWeights[kLoudnessMaxChannels];
+		float					mTruePeakTaps[kTruePeakTaps][kTruePeakPhases];	// all 4 phases of a tap side by side
+		float					mHistory[kLoudnessMaxChannels][2 * kTruePeakTaps];	// twice over so the taps are contiguous
+		UInt32					mHistoryPos;
+
+		// the block being filled, then the last kLoudnessShortTermBlocks of them
+		UInt32					mBlockLength;		// frames
+		UInt32					mBlockFrames;
+		double					mBlockSum[kLoudnessMaxChannels];
+		double					mBlocks[kLoudnessShortTermBlocks];
+		UInt32					mNextBlock;
+		UInt32					mBlockCount;
+
+		// momentary blocks over the absolute gate by loudness
+		double					mBinPower[kLoudnessHistogramBins];
+		UInt32					mBinCount[kLoudnessHistogramBins];
+		UInt32					mGatedBlocks;
+		UInt32					mTotalBlocks;
+
+		double					mMaxMomentary;		// power
+		float					mTruePeak;			// 1.0 is full scale
+};
+
+typedef std::auto_ptr<CVideoOutputLoudnessMeter> CVideoOutputLoudnessMeterPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTLOUDNESSMETER_H__
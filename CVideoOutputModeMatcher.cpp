@@ -0,0 +1,351 @@
+/*
+	File:		 CVideoOutputModeMatcher.cpp
+	
+	Description: Scores display modes against the format of a Movie.
+				 See CVideoOutputModeMatcher.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 FindBestMode looks for an exact fit with the registry first
+										<2> 10/19/26 read the DV field order from the DIF stream
+										<1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputModeMatcher.h"
+#include "CVideoOutputFields.h"
+
+using namespace dts;
+
+const SInt32 kUnusableModeCost = 100000;
+
+// Both a frame rate and a refresh rate are considered the same if they're within 0.2%
+static Boolean RatesMatch(double inRateA, double inRateB)
+{
+	double theDelta = inRateA - inRateB;
+
+	if (theDelta < 0) theDelta = -theDelta;
+
+	return (theDelta <= inRateB * 0.002);
+}
+
+static Boolean IsDVType(OSType inType)
+{
+	switch (inType) {
+	case FOUR_CHAR_CODE('dvc '):	// DV NTSC
+	case FOUR_CHAR_CODE('dvcp'):	// DV PAL
+	case FOUR_CHAR_CODE('dvpp'):	// DVCPRO PAL
+	case FOUR_CHAR_CODE('dv5n'):	// DVCPRO50 NTSC
+	case FOUR_CHAR_CODE('dv5p'):	// DVCPRO50 PAL
+		return true;
+	default:
+		return false;
+	}
+}
+
+static Boolean IsYUVType(OSType inType)
+{
+	switch (inType) {
+	case FOUR_CHAR_CODE('2vuy'):
+	case FOUR_CHAR_CODE('yuvs'):
+	case FOUR_CHAR_CODE('yuv2'):
+	case FOUR_CHAR_CODE('v210'):
+	case FOUR_CHAR_CODE('y420'):
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Codecs whose decompressed form is Y'CbCr
+static Boolean IsYUVCodec(OSType inType)
+{
+	if (IsDVType(inType) || IsYUVType(inType)) return true;
+
+	switch (inType) {
+	case FOUR_CHAR_CODE('jpeg'):
+	case FOUR_CHAR_CODE('mjpa'):
+	case FOUR_CHAR_CODE('mjpb'):
+	case FOUR_CHAR_CODE('mp4v'):
+	case FOUR_CHAR_CODE('avc1'):
+	case FOUR_CHAR_CODE('SVQ3'):
+		return true;
+	default:
+		return false;
+	}
+}
+
+#pragma mark-
+
+/* GetMovieFormat
+		Work out the format of the first enabled video track.
+*/
+OSErr CVideoOutputModeMatcher::GetMovieFormat(const Movie inMovie, MovieFormatRecord &outFormat)
+{
+	ImageDescriptionHandle hImageDesc = NULL;
+	Handle				   hFieldInfo = NULL;
+	Rect				   theBounds;
+	Track				   theTrack;
+	Media				   theMedia;
+	OSErr				   err = noErr;
+
+	outFormat.width = outFormat.height = 0;
+	outFormat.frameRate = 0;
+	outFormat.fieldOrder = eFieldOrderUnknown;
+	outFormat.codecType = 0;
+	outFormat.depth = 0;
+
+	if (NULL == inMovie) return paramErr;
+
+	::GetMovieNaturalBoundsRect(inMovie, &theBounds);
+	outFormat.width = theBounds.right - theBounds.left;
+	outFormat.height = theBounds.bottom - theBounds.top;
+
+	theTrack = ::GetMovieIndTrackType(inMovie, 1, VideoMediaType, movieTrackMediaType | movieTrackEnabledOnly);
+	if (NULL == theTrack) { err = invalidTrack; goto bail; }
+
+	theMedia = ::GetTrackMedia(theTrack);
+
+	// Frame rate - the number of samples over the duration of the media
+	{ // gcc complains without this in brackets
+	long	  theSampleCount = ::GetMediaSampleCount(theMedia);
+	TimeValue theDuration = ::GetMediaDuration(theMedia);
+	if (theSampleCount > 0 && theDuration > 0)
+		outFormat.frameRate = ::X2Fix((double)theSampleCount * ::GetMediaTimeScale(theMedia) / theDuration);
+	}
+
+	hImageDesc = (ImageDescriptionHandle)::NewHandle(0);
+	if (NULL == hImageDesc) { err = ::MemError(); goto bail; }
+
+	::GetMediaSampleDescription(theMedia, 1, (SampleDescriptionHandle)hImageDesc);
+	if ((err = ::GetMoviesError())) goto bail;
+
+	outFormat.codecType = (**hImageDesc).cType;
+	outFormat.depth = (**hImageDesc).depth;
+
+	// Field order - from the 'fiel' image description extension if there is one
+	if (noErr == ::GetImageDescriptionExtension(hImageDesc, &hFieldInfo, kFieldInfoImageDescriptionExtension, 1) && hFieldInfo) {
+		UInt8 *pFieldInfo = (UInt8 *)*hFieldInfo;
+
+		if (::GetHandleSize(hFieldInfo) >= 2) {
+			if (pFieldInfo[0] == kQTFieldsProgressiveScan) {
+				outFormat.fieldOrder = eFieldOrderProgressive;
+			} else {
+				switch (pFieldInfo[1]) {
+				case kQTFieldDetailTemporalTopFirst:
+				case kQTFieldDetailSpatialFirstLineEarly:
+					outFormat.fieldOrder = eFieldOrderUpperFirst;
+					break;
+				case kQTFieldDetailTemporalBottomFirst:
+				case kQTFieldDetailSpatialFirstLineLate:
+					outFormat.fieldOrder = eFieldOrderLowerFirst;
+					break;
+				default:
+					break;
+				}
+			}
+		}
+		::DisposeHandle(hFieldInfo);
+	} else if (IsDVType(outFormat.codecType)) {
+		// DV doesn't carry a 'fiel' extension, ask the DIF stream and fall back to lower field first
+		if (CVideoOutputFields::GetMovieDVFieldOrder(inMovie, outFormat.fieldOrder) || eFieldOrderUnknown == outFormat.fieldOrder)
+			outFormat.fieldOrder = eFieldOrderLowerFirst;
+	}
+
+bail:
+	if (hImageDesc) ::DisposeHandle((Handle)hImageDesc);
+
+	return err;
+}
+
+/* GetModeFieldOrder
+		Display modes don't say whether they are interlaced, so go by the pixel type and the
+		standard definition and HD raster sizes.
+*/
+FieldOrder CVideoOutputModeMatcher::GetModeFieldOrder(const CVideoOutputRegistry &inRegistry, UInt16 inMode)
+{
+	long   theHeight = inRegistry.GetModeHeight(inMode);
+	double theRate = ::Fix2X(inRegistry.GetModeRefreshRate(inMode));
+
+	// NTSC and PAL DV are both lower field first, as is 486 line NTSC
+	if (IsDVType(inRegistry.GetModePixelType(inMode)) || 480 == theHeight || 486 == theHeight)
+		return eFieldOrderLowerFirst;
+
+	// Uncompressed PAL and interlaced 1080 line HD are upper field first
+	if (576 == theHeight || (1080 == theHeight && theRate < 31.0))
+		return eFieldOrderUpperFirst;
+
+	return eFieldOrderProgressive;
+}
+
+#pragma mark-
+
+void CVideoOutputModeMatcher::ScoreMode(const CVideoOutputRegistry &inRegistry, UInt16 inMode, const MovieFormatRecord &inFormat, ModeScoreRecord &outScore)
+{
+	FieldOrder theModeFieldOrder = GetModeFieldOrder(inRegistry, inMode);
+
+	outScore.mode = inMode;
+
+	if (kBadModePixelType == inRegistry.GetModePixelType(inMode) || 0 == inRegistry.GetModeWidth(inMode)) {
+		outScore.scaleCost = outScore.rateCost = outScore.fieldCost = outScore.pixelCost = kUnusableModeCost;
+		outScore.total = kUnusableModeCost;
+		return;
+	}
+
+	outScore.scaleCost = ScaleCost(inFormat.width, inFormat.height, inRegistry.GetModeWidth(inMode), inRegistry.GetModeHeight(inMode));
+	outScore.rateCost = RateCost(inFormat.frameRate, inRegistry.GetModeRefreshRate(inMode), theModeFieldOrder);
+	outScore.fieldCost = FieldCost(inFormat.fieldOrder, theModeFieldOrder);
+	outScore.pixelCost = PixelCost(inFormat.codecType, inFormat.depth, inRegistry.GetModePixelType(inMode));
+
+	outScore.total = outScore.scaleCost * kScaleCostWeight +
+					 outScore.rateCost * kRateCostWeight +
+					 outScore.fieldCost * kFieldCostWeight +
+					 outScore.pixelCost * kPixelCostWeight;
+}
+
+SInt32 CVideoOutputModeMatcher::FindBestMode(const CVideoOutputRegistry &inRegistry, const MovieFormatRecord &inFormat, ModeScorePtr outScore)
+{
+	ModeScoreRecord	 theBest = { 0, 0, 0, 0, 0, kUnusableModeCost };
+	SInt32			 theBestMode = -1;
+	ModeFilterRecord theFilter = { inFormat.width, inFormat.height, 0, inFormat.codecType };
+	UInt16			 theExactModes[16];
+	UInt16			 theExactCount;
+
+	// A mode the movie fits exactly needs nothing scored but the rate and fields
+	theExactCount = (inFormat.width && inFormat.codecType) ? inRegistry.FindModes(theFilter, theExactModes, 16) : 0;
+	for (UInt16 exactIndex = 0; exactIndex < theExactCount; exactIndex++) {
+		ScoreMode(inRegistry, theExactModes[exactIndex], inFormat, theBest);
+		if (0 == theBest.total) {
+			if (outScore) *outScore = theBest;
+			return theExactModes[exactIndex];
+		}
+	}
+	theBest.total = kUnusableModeCost;
+
+	for (UInt16 modeIndex = 0; modeIndex < inRegistry.GetTotalModeCount(); modeIndex++) {
+		ModeScoreRecord theScore;
+
+		ScoreMode(inRegistry, modeIndex, inFormat, theScore);
+		if (theScore.total < theBest.total) {
+			theBest = theScore;
+			theBestMode = modeIndex;
+		}
+	}
+
+	if (outScore && theBestMode >= 0) *outScore = theBest;
+
+	return theBestMode;
+}
+
+#pragma mark-
+
+// 0 for an exact fit, otherwise a fixed cost for having a scaler in the path plus
+// the relative size change in each direction, in percent
+SInt32 CVideoOutputModeMatcher::ScaleCost(long inMovieWidth, long inMovieHeight, long inModeWidth, long inModeHeight)
+{
+	SInt32 theCost;
+
+	if (inMovieWidth == inModeWidth && inMovieHeight == inModeHeight) return 0;
+	if (0 == inMovieWidth || 0 == inMovieHeight) return 10;
+
+	theCost = 10;
+	theCost += (100 * (inModeWidth > inMovieWidth ? inModeWidth - inMovieWidth : inMovieWidth - inModeWidth)) / inMovieWidth;
+	theCost += (100 * (inModeHeight > inMovieHeight ? inModeHeight - inMovieHeight : inMovieHeight - inModeHeight)) / inMovieHeight;
+
+	return (theCost > 200) ? 200 : theCost;
+}
+
+SInt32 CVideoOutputModeMatcher::RateCost(Fixed inMovieRate, Fixed inModeRate, FieldOrder inModeFieldOrder)
+{
+	double theMovieRate = ::Fix2X(inMovieRate);
+	double theModeRate = ::Fix2X(inModeRate);
+	double theRatio;
+
+	// Nothing to go on, don't let the rate influence the choice
+	if (0 == inMovieRate || 0 == inModeRate) return 10;
+
+	if (RatesMatch(theModeRate, theMovieRate)) return 0;
+
+	theRatio = theModeRate / theMovieRate;
+
+	// Each frame repeated the same number of times
+	if (theRatio > 1.5 && RatesMatch(theRatio, (double)(long)(theRatio + 0.5))) return 5;
+
+	// 2:3 pulldown, 23.976 into 29.97 or 59.94 - clean on an interlaced output, judder on a progressive one
+	if (RatesMatch(theRatio, 1.25) || RatesMatch(theRatio, 2.5))
+		return (eFieldOrderProgressive == inModeFieldOrder) ? 25 : 15;
+
+	// Uneven repeats, or dropping frames which is worse
+	return (theRatio > 1.0) ? 40 : 50;
+}
+
+SInt32 CVideoOutputModeMatcher::FieldCost(FieldOrder inMovieFieldOrder, FieldOrder inModeFieldOrder)
+{
+	if (eFieldOrderUnknown == inMovieFieldOrder || eFieldOrderUnknown == inModeFieldOrder) return 5;
+	if (inMovieFieldOrder == inModeFieldOrder) return 0;
+
+	// Progressive frames can always be split into fields
+	if (eFieldOrderProgressive == inMovieFieldOrder) return 5;
+
+	// Interlaced to progressive needs a deinterlacer
+	if (eFieldOrderProgressive == inModeFieldOrder) return 20;
+
+	// Opposite field order means shifting the picture by a line
+	return 25;
+}
+
+SInt32 CVideoOutputModeMatcher::PixelCost(OSType inCodecType, short inDepth, OSType inModePixelType)
+{
+	// The samples can be sent as is - DV out to a DV device
+	if (inCodecType == inModePixelType) return 0;
+
+	// Uncompressed RGB at the depth of the mode
+	if (FOUR_CHAR_CODE('raw ') == inCodecType && (OSType)inDepth == inModePixelType) return 0;
+
+	// The device only takes DV - a decode, possibly a scale and a DV encode
+	if (IsDVType(inModePixelType)) return IsDVType(inCodecType) ? 60 : 50;
+
+	// Decompress straight into the native color space of the mode
+	if (IsYUVType(inModePixelType)) return IsYUVCodec(inCodecType) ? 10 : 20;
+	if (inModePixelType <= 40) return IsYUVCodec(inCodecType) ? 20 : 10;
+
+	return 20;
+}
@@ -0,0 +1,136 @@
+/*
+	File:		 CVideoOutputModeMatcher.h
+	
+	Description: Scores the display modes in a CVideoOutputRegistry against the format of a Movie
+				 and picks the one needing the least work per frame - scaling, frame rate conversion,
+				 field order conversion and pixel format conversion.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 FindBestMode looks for an exact fit with the registry first
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	GetMovieFormat( const Movie inMovie, MovieFormatRecord &outFormat )
+		Fills in the natural size, frame rate, field order and codec type of the first enabled
+		video track of inMovie.
+
+	ScoreMode( const CVideoOutputRegistry &inRegistry, UInt16 inMode, const MovieFormatRecord &inFormat, ModeScoreRecord &outScore )
+		Scores a single mode. Each stage is scored on its own so the choice can be checked, lower is
+		better and a total of 0 means the movie can go straight out without any conversion.
+
+	FindBestMode( const CVideoOutputRegistry &inRegistry, const MovieFormatRecord &inFormat, ModeScoreRecord *outScore = NULL )
+		Asks the registry for the modes with the movie's size and pixel type first and returns the first
+		one needing no conversion at all. Otherwise scores every mode of every component and returns the
+		global index of the best one, or -1 if there are no usable modes. On a tie the mode found first wins, so the registry order (which is
+		the order the Component Manager returns the components in) is the tie breaker.
+*/
+
+#ifndef __CVIDEOOUTPUTMODEMATCHER_H__
+	#define __CVIDEOOUTPUTMODEMATCHER_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <Movies.h>
+	#include <ImageCompression.h>
+#endif
+
+#include "CVideoOutputRegistry.h"
+
+namespace dts {
+
+enum FieldOrder {
+	eFieldOrderUnknown = 0,
+	eFieldOrderProgressive,
+	eFieldOrderUpperFirst,
+	eFieldOrderLowerFirst
+};
+
+// Relative cost of each conversion stage, a full scale of the frame being the most expensive
+const SInt32 kScaleCostWeight = 4;
+const SInt32 kRateCostWeight = 2;
+const SInt32 kFieldCostWeight = 2;
+const SInt32 kPixelCostWeight = 1;
+
+typedef struct {
+	long		width, height;	// natural size of the movie
+	Fixed		frameRate;		// frames per second, 0 if it couldn't be worked out
+	FieldOrder	fieldOrder;
+	OSType		codecType;		// compression type of the video samples
+	short		depth;			// depth from the image description
+} MovieFormatRecord;
+
+typedef struct {
+	UInt16	mode;				// global registry index
+	SInt32	scaleCost;			// resizing the frame to the mode dimensions
+	SInt32	rateCost;			// converting the movie frame rate to the mode refresh rate
+	SInt32	fieldCost;			// deinterlacing, interlacing or swapping field order
+	SInt32	pixelCost;			// decompressing and converting to the mode pixel type
+	SInt32	total;				// weighted sum of the above
+} ModeScoreRecord, *ModeScorePtr;
+
+class CVideoOutputModeMatcher {
+	public:
+		static OSErr GetMovieFormat(const Movie inMovie, MovieFormatRecord &outFormat);
+		static FieldOrder GetModeFieldOrder(const CVideoOutputRegistry &inRegistry, UInt16 inMode);
+
+		static void ScoreMode(const CVideoOutputRegistry &inRegistry, UInt16 inMode, const MovieFormatRecord &inFormat, ModeScoreRecord &outScore);
+		static SInt32 FindBestMode(const CVideoOutputRegistry &inRegistry, const MovieFormatRecord &inFormat, ModeScorePtr outScore = NULL);
+
+	private:
+		static SInt32 ScaleCost(long inMovieWidth, long inMovieHeight, long inModeWidth, long inModeHeight);
+		static SInt32 RateCost(Fixed inMovieRate, Fixed inModeRate, FieldOrder inModeFieldOrder);
+		static SInt32 FieldCost(FieldOrder inMovieFieldOrder, FieldOrder inModeFieldOrder);
+		static SInt32 PixelCost(OSType inCodecType, short inDepth, OSType inModePixelType);
+
+		// nope
+		CVideoOutputModeMatcher();
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTMODEMATCHER_H__
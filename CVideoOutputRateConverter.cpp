@@ -0,0 +1,453 @@
+/*
+	File:		 CVideoOutputRateConverter.cpp
+	
+	Description: Frame rate conversion between a movie and a display mode.
+				 See CVideoOutputRateConverter.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <4> 10/19/26 ComposeFrame() can legalize the rows as it writes them
+										<3> 10/19/26 ComposeFrame() works per field plane, blends are weighted per field
+										<2> 10/19/26 exact rates aren't snapped to NTSC, added the frame store and ComposeFrame
+										<1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputRateConverter.h"
+
+using namespace dts;
+
+static UInt64 GreatestCommonDivisor(UInt64 inA, UInt64 inB)
+{
+	while (inB) {
+		UInt64 theRemainder = inA % inB;
+		inA = inB;
+		inB = theRemainder;
+	}
+
+	return inA;
+}
+
+// Turn a Fixed rate into an exact fraction, snapping to the NTSC rates where they're meant
+static void RateToFraction(Fixed inRate, UInt32 &outNum, UInt32 &outDen)
+{
+	const UInt32 kNTSCRates[] = { 24, 30, 48, 60, 120 };
+	double theRate = ::Fix2X(inRate);
+	UInt32 theWhole = (UInt32)(theRate + 0.5);
+	UInt64 theGCD;
+
+	// Whole rates first, 24.0 is 0.1% from 23.976 and must stay 24
+	if (theWhole && (inRate & 0xFFFF) == 0) {
+		outNum = theWhole;
+		outDen = 1;
+		return;
+	}
+
+	// Rates worked out from sample counts and durations are a few ppm off the real thing, the
+	// nearest whole rate is 1000 ppm away so 100 ppm can't catch one
+	for (UInt8 i = 0; i < sizeof(kNTSCRates) / sizeof(UInt32); i++) {
+		double theNTSCRate = kNTSCRates[i] * 1000.0 / 1001.0;
+		double theDelta = theRate - theNTSCRate;
+		if (theDelta < 0) theDelta = -theDelta;
+		if (theDelta < theNTSCRate * 0.0001) {
+			outNum = kNTSCRates[i] * 1000;
+			outDen = 1001;
+			return;
+		}
+	}
+
+	if (theWhole && (theRate - theWhole) < 0.0001 && (theWhole - theRate) < 0.0001) {
+		outNum = theWhole;
+		outDen = 1;
+		return;
+	}
+
+	theGCD = GreatestCommonDivisor(inRate, 65536);
+	outNum = inRate / theGCD;
+	outDen = 65536 / theGCD;
+}
+
+// Best fraction close to inNum / inDen with a numerator no bigger than inMaxNum
+// taken from the continued fraction convergents
+static void ApproximateRatio(UInt64 &ioNum, UInt64 &ioDen, UInt64 inMaxNum)
+{
+	UInt64 theNum = ioNum, theDen = ioDen;
+	UInt64 h0 = 0, h1 = 1, k0 = 1, k1 = 0;
+
+	while (theDen) {
+		UInt64 a = theNum / theDen;
+		UInt64 h2 = a * h1 + h0;
+		UInt64 k2 = a * k1 + k0;
+		UInt64 theRemainder;
+
+		if (h2 > inMaxNum) break;
+		h0 = h1; h1 = h2;
+		k0 = k1; k1 = k2;
+
+		theRemainder = theNum % theDen;
+		theNum = theDen;
+		theDen = theRemainder;
+	}
+
+	ioNum = h1;
+	ioDen = k1 ? k1 : 1;
+}
+
+// What ComposeField() needs to build one field of an output frame
+typedef struct {
+	const CVideoOutputRateConverter	*converter;
+	const CadenceFrameRecord		*frame;
+	CVideoOutputLegalizer			*legalizer;
+	UInt32							corrected;
+	Boolean							isComplete;
+} ComposeRecord;
+
+#pragma mark-
+
+CVideoOutputRateConverter::CVideoOutputRateConverter() : mMode(eRateConversionOff), mCadence(NULL), mCycleOutputFrames(0), mCycleSourceFrames(0),
+														  mOutputRateNum(0), mOutputRateDen(1), mIsPerField(false), mFrames(NULL), mFrameRowBytes(0),
+														  mFrameRowLength(0), mFrameHeight(0), mFrameFieldOrder(eFieldOrderUnknown)
+{
+	DisposeFrames();
+}
+
+CVideoOutputRateConverter::~CVideoOutputRateConverter()
+{
+	Reset();
+	DisposeFrames();
+}
+
+void CVideoOutputRateConverter::Reset(void)
+{
+	if (mCadence) ::DisposePtr((Ptr)mCadence);
+
+	mCadence = NULL;
+	mMode = eRateConversionOff;
+	mCycleOutputFrames = mCycleSourceFrames = 0;
+	mIsPerField = false;
+}
+
+/* Configure
+		Work out the shortest cycle after which both rates line up again - p output frames for
+		every q movie frames - and precompute which movie frame goes out on each of the p output frames.
+*/
+OSErr CVideoOutputRateConverter::Configure(Fixed inSourceRate, Fixed inOutputRate, RateConversionMode inMode, Boolean inInterlacedOutput)
+{
+	UInt32 theSourceNum, theSourceDen;
+	UInt64 p, q, theGCD;
+	Boolean	perField = ((eRateConversionPulldown == inMode || eRateConversionBlend == inMode) && inInterlacedOutput);
+
+	Reset();
+
+	if (eRateConversionOff == inMode) return noErr;
+	if (inSourceRate <= 0 || inOutputRate <= 0) return paramErr;
+
+	RateToFraction(inSourceRate, theSourceNum, theSourceDen);
+	RateToFraction(inOutputRate, mOutputRateNum, mOutputRateDen);
+
+	// output / source = (on * sd) / (od * sn)
+	p = (UInt64)mOutputRateNum * theSourceDen;
+	q = (UInt64)mOutputRateDen * theSourceNum;
+	theGCD = GreatestCommonDivisor(p, q);
+	p /= theGCD;
+	q /= theGCD;
+
+	if (p > kMaxCadenceLength || q > 0xFFFF) ApproximateRatio(p, q, kMaxCadenceLength);
+	if (0 == p || 0 == q || q > 0xFFFF) return paramErr;
+
+	mCadence = (CadenceEntryPtr)::NewPtrClear(sizeof(CadenceEntryRecord) * p);
+	if (NULL == mCadence) return ::MemError();
+
+	mMode = inMode;
+	mCycleOutputFrames = p;
+	mCycleSourceFrames = q;
+	mIsPerField = perField;
+
+	for (UInt32 i = 0; i < p; i++) {
+		CadenceEntryPtr pEntry = &mCadence[i];
+
+		switch (inMode) {
+		case eRateConversionBlend:
+		{ // gcc complains without this in brackets
+			// Output frame i sits at movie position i * q / p, mix the frames either side of it.
+			// Its second field goes out half an output frame later, at (2i + 1) * q / 2p
+			UInt64 thePosition = (UInt64)i * q;
+			pEntry->firstField = pEntry->secondField = thePosition / p;
+			pEntry->blendWeight = pEntry->secondBlendWeight = ((thePosition % p) << 8) / p;
+			if (perField) {
+				thePosition = (UInt64)(2 * i + 1) * q;
+				pEntry->secondField = thePosition / (2 * p);
+				pEntry->secondBlendWeight = ((thePosition % (2 * p)) << 8) / (2 * p);
+			}
+			break;
+		}
+		default:
+			// Nearest movie frame, the half frame phase spreads the repeats (or drops) evenly
+			// and puts 23.976 into 29.97 on the classic A A B B B C C D D D field pattern
+			if (perField) {
+				pEntry->firstField  = ((UInt64)(2 * i) * q + q / 2) / (2 * p);
+				pEntry->secondField = ((UInt64)(2 * i + 1) * q + q / 2) / (2 * p);
+			} else {
+				pEntry->firstField = pEntry->secondField = ((UInt64)i * q + q / 2) / p;
+			}
+			break;
+		}
+
+		if (i && pEntry->firstField == mCadence[i-1].secondField && pEntry->firstField == pEntry->secondField &&
+			0 == pEntry->blendWeight && 0 == pEntry->secondBlendWeight)
+			pEntry->flags |= kCadenceRepeatFlag;
+	}
+
+	return noErr;
+}
+
+#pragma mark-
+
+void CVideoOutputRateConverter::GetOutputFrame(UInt64 inOutputFrame, CadenceFrameRecord &outFrame) const
+{
+	if (NULL == mCadence) {
+		// No conversion, one movie frame per output frame
+		outFrame.firstField = outFrame.secondField = inOutputFrame;
+		outFrame.blendWeight = outFrame.secondBlendWeight = 0;
+		outFrame.isRepeat = false;
+		return;
+	}
+
+	UInt64 theCycle = inOutputFrame / mCycleOutputFrames;
+	const CadenceEntryRecord &theEntry = mCadence[inOutputFrame % mCycleOutputFrames];
+	UInt64 theBase = theCycle * mCycleSourceFrames;
+
+	outFrame.firstField = theBase + theEntry.firstField;
+	outFrame.secondField = theBase + theEntry.secondField;
+	outFrame.blendWeight = theEntry.blendWeight;
+	outFrame.secondBlendWeight = theEntry.secondBlendWeight;
+	outFrame.isRepeat = (theEntry.flags & kCadenceRepeatFlag) != 0;
+}
+
+// output frame = time * rate = (value / scale) * (on / od)
+UInt64 CVideoOutputRateConverter::GetOutputFrameForTime(const TimeRecord &inTime) const
+{
+	SInt64 theValue = ((SInt64)inTime.value.hi << 32) | inTime.value.lo;
+
+	if (theValue <= 0 || inTime.scale <= 0 || 0 == mOutputRateNum) return 0;
+
+	return ((UInt64)theValue * mOutputRateNum) / ((UInt64)inTime.scale * mOutputRateDen);
+}
+
+/* BlendFrames
+		out = a + (b - a) * weight / 256, one byte at a time so it works for 2vuy, yuvs and 32 bit RGB alike.
+		The inner loop has no dependencies between iterations so the compiler can vectorize it.
+*/
+void CVideoOutputRateConverter::BlendFrames(const UInt8 *inFrameA, const UInt8 *inFrameB, long inSourceRowBytes, UInt8 *outFrame, long inDestRowBytes,
+											long inRowLength, long inRows, UInt8 inWeight)
+{
+	const int theWeight = inWeight;
+
+	for (long row = 0; row < inRows; row++) {
+		const UInt8 *pA = inFrameA + row * inSourceRowBytes;
+		const UInt8 *pB = inFrameB + row * inSourceRowBytes;
+		UInt8		*pOut = outFrame + row * inDestRowBytes;
+
+		for (long i = 0; i < inRowLength; i++) {
+			pOut[i] = pA[i] + (((pB[i] - pA[i]) * theWeight) >> 8);
+		}
+	}
+}
+
+#pragma mark-
+
+UInt16 CVideoOutputRateConverter::GetFramesAhead(void) const
+{
+	switch (mMode) {
+	case eRateConversionBlend:
+		return mIsPerField ? 2 : 1;
+	case eRateConversionPulldown:
+		return mIsPerField ? 1 : 0;
+	default:
+		return 0;
+	}
+}
+
+OSErr CVideoOutputRateConverter::AllocateFrames(long inRowBytes, long inRowLength, long inHeight, FieldOrder inOrder)
+{
+	DisposeFrames();
+
+	if (inRowBytes <= 0 || inRowLength > inRowBytes || inHeight <= 0) return paramErr;
+
+	mFrames = ::NewPtr(inRowBytes * inHeight * kCadenceFrameCount);
+	if (NULL == mFrames) return ::MemError();
+
+	mFrameRowBytes = inRowBytes;
+	mFrameRowLength = inRowLength;
+	mFrameHeight = inHeight;
+	mFrameFieldOrder = inOrder;
+
+	return noErr;
+}
+
+void CVideoOutputRateConverter::DisposeFrames(void)
+{
+	if (mFrames) ::DisposePtr(mFrames);
+
+	mFrames = NULL;
+	mFrameRowBytes = mFrameRowLength = mFrameHeight = 0;
+	mFrameFieldOrder = eFieldOrderUnknown;
+
+	for (UInt16 i = 0; i < kCadenceFrameCount; i++) {
+		mStoredFrame[i] = 0;
+		mIsStored[i] = false;
+	}
+}
+
+UInt8 *CVideoOutputRateConverter::GetStoredFrame(UInt64 inFrame) const
+{
+	for (UInt16 i = 0; i < kCadenceFrameCount; i++) {
+		if (mIsStored[i] && mStoredFrame[i] == inFrame) return (UInt8 *)mFrames + i * mFrameRowBytes * mFrameHeight;
+	}
+
+	return NULL;
+}
+
+// Frames are asked for in order, the lowest is the one least likely to be wanted again
+UInt8 *CVideoOutputRateConverter::StoreFrame(UInt64 inFrame)
+{
+	UInt16 theSlot = 0;
+
+	if (NULL == mFrames) return NULL;
+
+	for (UInt16 i = 0; i < kCadenceFrameCount; i++) {
+		if (mIsStored[i] && mStoredFrame[i] == inFrame) return (UInt8 *)mFrames + i * mFrameRowBytes * mFrameHeight;
+		if (!mIsStored[i]) {
+			if (mIsStored[theSlot]) theSlot = i;
+		} else if (mIsStored[theSlot] && mStoredFrame[i] < mStoredFrame[theSlot]) {
+			theSlot = i;
+		}
+	}
+
+	mStoredFrame[theSlot] = inFrame;
+	mIsStored[theSlot] = true;
+
+	return (UInt8 *)mFrames + theSlot * mFrameRowBytes * mFrameHeight;
+}
+
+void CVideoOutputRateConverter::StoreFrame(UInt64 inFrame, const UInt8 *inPixels, long inRowBytes)
+{
+	UInt8 *pFrame = StoreFrame(inFrame);
+
+	if (NULL == pFrame) return;
+
+	for (long row = 0; row < mFrameHeight; row++) {
+		::BlockMoveData(inPixels + row * inRowBytes, pFrame + row * mFrameRowBytes, mFrameRowLength);
+	}
+}
+
+void CVideoOutputRateConverter::ForgetFrame(UInt64 inFrame)
+{
+	for (UInt16 i = 0; i < kCadenceFrameCount; i++) {
+		if (mStoredFrame[i] == inFrame) mIsStored[i] = false;
+	}
+}
+
+Boolean CVideoOutputRateConverter::ComposeFrame(const CadenceFrameRecord &inFrame, UInt8 *outFrame, long inRowBytes,
+												CVideoOutputLegalizer *inLegalizer) const
+{
+	ComposeRecord theCompose = { this, &inFrame, inLegalizer, 0, true };
+
+	// Check first so a missing frame leaves the whole output frame alone
+	if (NULL == GetStoredFrame(inFrame.firstField) || (inFrame.blendWeight && NULL == GetStoredFrame(inFrame.firstField + 1))) return false;
+	if (CVideoOutputFields::IsInterlaced(mFrameFieldOrder) &&
+		(NULL == GetStoredFrame(inFrame.secondField) || (inFrame.secondBlendWeight && NULL == GetStoredFrame(inFrame.secondField + 1)))) return false;
+
+	CVideoOutputFields::ForEachField(outFrame, inRowBytes, mFrameHeight, mFrameRowLength, mFrameFieldOrder, ComposeField, &theCompose);
+
+	if (inLegalizer && theCompose.isComplete) inLegalizer->FrameDone(theCompose.corrected);
+
+	return theCompose.isComplete;
+}
+
+/* ComposeField
+		Field 0 comes from firstField, field 1 from secondField - each from the same lines of the
+		stored frame as it goes to in the output frame.
+*/
+void CVideoOutputRateConverter::ComposeField(const FieldPlaneRecord &inPlane, UInt8 inField, void *inRefCon)
+{
+	ComposeRecord *pCompose = (ComposeRecord *)inRefCon;
+	const CVideoOutputRateConverter *pThis = pCompose->converter;
+	UInt64 theFrame = inField ? pCompose->frame->secondField : pCompose->frame->firstField;
+	UInt8 theWeight = inField ? pCompose->frame->secondBlendWeight : pCompose->frame->blendWeight;
+	UInt8 *pSource = pThis->GetStoredFrame(theFrame);
+	FieldPlaneRecord theSourcePlane;
+
+	if (NULL == pSource) { pCompose->isComplete = false; return; }
+
+	CVideoOutputFields::GetFieldPlane(pSource, pThis->mFrameRowBytes, pThis->mFrameHeight, pThis->mFrameRowLength, pThis->mFrameFieldOrder,
+									  inField, theSourcePlane);
+
+	if (theWeight) {
+		UInt8 *pNext = pThis->GetStoredFrame(theFrame + 1);
+		FieldPlaneRecord theNextPlane;
+
+		if (NULL == pNext) { pCompose->isComplete = false; return; }
+
+		CVideoOutputFields::GetFieldPlane(pNext, pThis->mFrameRowBytes, pThis->mFrameHeight, pThis->mFrameRowLength, pThis->mFrameFieldOrder,
+										  inField, theNextPlane);
+
+		if (NULL == pCompose->legalizer) {
+			BlendFrames(theSourcePlane.baseAddr, theNextPlane.baseAddr, theSourcePlane.rowBytes, inPlane.baseAddr, inPlane.rowBytes,
+						inPlane.rowLength, inPlane.height, theWeight);
+			return;
+		}
+
+		// A row at a time, it's legalized where it was blended. 4:2:2 so the rows are whole pairs
+		for (long row = 0; row < inPlane.height; row++) {
+			UInt8 *pRow = inPlane.baseAddr + row * inPlane.rowBytes;
+
+			BlendFrames(theSourcePlane.baseAddr + row * theSourcePlane.rowBytes, theNextPlane.baseAddr + row * theNextPlane.rowBytes,
+						theSourcePlane.rowBytes, pRow, inPlane.rowBytes, inPlane.rowLength, 1, theWeight);
+			pCompose->corrected += pCompose->legalizer->LegalizeRect(pRow, inPlane.rowBytes, pRow, inPlane.rowBytes, inPlane.rowLength / 4, 1);
+		}
+	} else if (pCompose->legalizer) {
+		pCompose->corrected += pCompose->legalizer->LegalizeRect(theSourcePlane.baseAddr, theSourcePlane.rowBytes, inPlane.baseAddr, inPlane.rowBytes,
+																 inPlane.rowLength / 4, inPlane.height);
+	} else {
+		CVideoOutputFields::CopyField(theSourcePlane, inPlane);
+	}
+}
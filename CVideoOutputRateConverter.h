@@ -0,0 +1,220 @@
+/*
+	File:		 CVideoOutputRateConverter.h
+	
+	Description: Frame rate conversion between a movie and a display mode. The conversion is worked
+				 out once as a cadence table covering one full cycle of the two rates (4 movie frames
+				 into 5 output frames for 23.976 into 29.97, 1001 into 1200 for 25 into 29.97), so
+				 picking the frame for an output tick is a table lookup with no floating point.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <5> 10/19/26 ComposeFrame() can legalize the rows as it writes them
+										<4> 10/19/26 ComposeFrame() works per field plane, blends are weighted per field
+										<3> 10/19/26 exact rates aren't snapped to NTSC, added the frame store and ComposeFrame
+										<2> 10/19/26 notes on field processing
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	Configure( Fixed inSourceRate, Fixed inOutputRate, RateConversionMode inMode, Boolean inInterlacedOutput )
+		Builds the cadence table. Whole rates are taken as they are, rates within 100 ppm of the NTSC
+		1000/1001 rates are treated as exactly 24000/1001, 30000/1001 and 60000/1001.
+
+		eRateConversionRepeatDrop - each output frame shows the nearest movie frame, the repeats (or
+									drops) are spread evenly through the cycle.
+		eRateConversionPulldown	  - as above but decided per field on an interlaced output, giving
+									2:3 pulldown for 23.976 into 29.97.
+		eRateConversionBlend	  - each output frame is a mix of the two movie frames either side of
+									it, weighted by distance. On an interlaced output each field is
+									weighted for its own time, half an output frame apart.
+
+	GetOutputFrame( UInt64 inOutputFrame, CadenceFrameRecord &outFrame )
+		Returns the movie frame(s) to show for an output frame counted from the start of the conversion.
+		When firstField and secondField differ the two are woven, ComposeFrame() does this for you.
+
+	GetOutputFrameForTime( const TimeRecord &inTime )
+		Converts a time on the output clock into an output frame count, so the conversion can be driven
+		directly by the video output component's clock.
+
+	BlendFrames( ... )
+		Mixes two frames for eRateConversionBlend, works on any 8 bit per component pixel format.
+		On an interlaced mode call it once per field plane (see CVideoOutputFields::ForEachField())
+		so lines from the two fields are never mixed.
+
+	GetFramesAhead()
+		How many movie frames past firstField an output frame can need, 2 for a blend on an interlaced
+		output. Whoever fills the store has to be that far ahead of the cadence.
+
+	AllocateFrames( long inRowBytes, long inRowLength, long inHeight, FieldOrder inOrder )
+		Sets up a store of kCadenceFrameCount movie frames of the given shape, the frames ComposeFrame()
+		builds an output frame from. inOrder is the output's field order. DisposeFrames() gets rid of it,
+		Reset() leaves it alone.
+
+	StoreFrame( UInt64 inFrame )
+		Returns the stored frame for movie frame inFrame to be filled in, reusing the one with the lowest
+		frame number if inFrame isn't already there. ForgetFrame() takes it out again if it couldn't be.
+		The other StoreFrame() copies inPixels in.
+
+	ComposeFrame( const CadenceFrameRecord &inFrame, UInt8 *outFrame, long inRowBytes, CVideoOutputLegalizer *inLegalizer = NULL )
+		Builds the output frame inFrame describes from the store. It goes a field plane at a time
+		(CVideoOutputFields::ForEachField()): each field is copied from its movie frame with CopyField(),
+		weaving pulldown frames, or blended with the next movie frame, so lines from the two fields are
+		never mixed. A progressive output is one plane. Returns false, and leaves outFrame alone, if a
+		frame it needs isn't stored. With inLegalizer the copy is the legalizer's and a blended row is
+		legalized while it's in the cache, then the frame's counted with FrameDone().
+
+		Nothing here deinterlaces: a movie frame's two fields go out as they are, or one of them does
+		when it's woven with another frame.
+*/
+
+#ifndef __CVIDEOOUTPUTRATECONVERTER_H__
+	#define __CVIDEOOUTPUTRATECONVERTER_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <Movies.h>
+#endif
+
+#include "CVideoOutputFields.h"
+#include "CVideoOutputLegalizer.h"
+
+namespace dts {
+
+// Longest cycle we'll build a table for, rate pairs with a longer cycle are approximated
+const UInt32 kMaxCadenceLength = 4096;
+
+// Movie frames kept for ComposeFrame(), enough for a blend on each field
+const UInt16 kCadenceFrameCount = 3;
+
+// CadenceEntryRecord flags
+const UInt8 kCadenceRepeatFlag = 0x01;	// same movie frame as the previous output frame
+
+enum RateConversionMode {
+	eRateConversionOff = 0,
+	eRateConversionRepeatDrop,
+	eRateConversionPulldown,
+	eRateConversionBlend
+};
+
+typedef struct {
+	UInt16	firstField;		// movie frame within the cycle for the first field (or the whole frame)
+	UInt16	secondField;	// movie frame within the cycle for the second field
+	UInt8	blendWeight;	// eRateConversionBlend only - weight out of 256 of firstField + 1
+	UInt8	secondBlendWeight;	// weight out of 256 of secondField + 1
+	UInt8	flags;
+} CadenceEntryRecord, *CadenceEntryPtr;
+
+typedef struct {
+	UInt64	firstField;		// movie frame numbers counted from the start of the conversion
+	UInt64	secondField;
+	UInt8	blendWeight;	// 0 = show firstField as is
+	UInt8	secondBlendWeight;	// 0 = show secondField as is
+	Boolean	isRepeat;		// firstField was already shown on the previous output frame
+} CadenceFrameRecord;
+
+class CVideoOutputRateConverter {
+	public:
+		CVideoOutputRateConverter();
+		~CVideoOutputRateConverter();
+
+		OSErr Configure(Fixed inSourceRate, Fixed inOutputRate, RateConversionMode inMode, Boolean inInterlacedOutput);
+		void  Reset(void);
+
+		RateConversionMode GetMode(void) const { return mMode; }
+		UInt32 GetCycleOutputFrames(void) const { return mCycleOutputFrames; }
+		UInt32 GetCycleSourceFrames(void) const { return mCycleSourceFrames; }
+		const CadenceEntryRecord *GetCadenceTable(void) const { return mCadence; }
+
+		void   GetOutputFrame(UInt64 inOutputFrame, CadenceFrameRecord &outFrame) const;
+		UInt64 GetOutputFrameForTime(const TimeRecord &inTime) const;
+		long   GetOutputFrameDuration(TimeScale inScale) const { return mOutputRateNum ? (long)(((UInt64)inScale * mOutputRateDen) / mOutputRateNum) : 0; }
+
+		static void BlendFrames(const UInt8 *inFrameA, const UInt8 *inFrameB, long inSourceRowBytes, UInt8 *outFrame, long inDestRowBytes,
+								long inRowLength, long inRows, UInt8 inWeight);
+
+		UInt16 GetFramesAhead(void) const;
+
+		OSErr  AllocateFrames(long inRowBytes, long inRowLength, long inHeight, FieldOrder inOrder);
+		void   DisposeFrames(void);
+		Boolean HasFrames(void) const { return (mFrames != NULL); }
+		long   GetFrameRowBytes(void) const { return mFrameRowBytes; }
+
+		UInt8 *GetStoredFrame(UInt64 inFrame) const;
+		UInt8 *StoreFrame(UInt64 inFrame);
+		void   StoreFrame(UInt64 inFrame, const UInt8 *inPixels, long inRowBytes);
+		void   ForgetFrame(UInt64 inFrame);
+
+		Boolean ComposeFrame(const CadenceFrameRecord &inFrame, UInt8 *outFrame, long inRowBytes, CVideoOutputLegalizer *inLegalizer = NULL) const;
+
+	private:
+		// nope
+		CVideoOutputRateConverter(const CVideoOutputRateConverter &inConverter);
+		CVideoOutputRateConverter operator=(CVideoOutputRateConverter inConverter);
+
+		static void ComposeField(const FieldPlaneRecord &inPlane, UInt8 inField, void *inRefCon);
+
+	private:
+		RateConversionMode	mMode;
+		CadenceEntryPtr		mCadence;
+		UInt32				mCycleOutputFrames;	// p output frames...
+		UInt32				mCycleSourceFrames;	// ...show q movie frames
+		UInt32				mOutputRateNum;		// output rate as an exact fraction
+		UInt32				mOutputRateDen;
+		Boolean				mIsPerField;		// the table has a movie frame and weight for each field
+
+		// the frame store
+		Ptr					mFrames;
+		long				mFrameRowBytes;
+		long				mFrameRowLength;
+		long				mFrameHeight;
+		FieldOrder			mFrameFieldOrder;
+		UInt64				mStoredFrame[kCadenceFrameCount];
+		Boolean				mIsStored[kCadenceFrameCount];
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTRATECONVERTER_H__
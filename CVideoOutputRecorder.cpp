@@ -0,0 +1,225 @@
+/*
+	File:		 CVideoOutputRecorder.cpp
+	
+	Description: Records what goes to the video output.
+				 See CVideoOutputRecorder.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 added trace points
+										<1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputRecorder.h"
+#include "CVideoOutputTrace.h"
+
+using namespace dts;
+
+CVideoOutputRecorder::CVideoOutputRecorder(const FSSpec &inFile, OSType inFileType, UInt32 inFrameSize, UInt32 inQueueFrames, Boolean inUncached) throw(OSStatus)
+	: mFork(0), mUncached(inUncached), mRingAlloc(NULL), mRing(NULL), mRingSize(0), mProduced(0), mConsumed(0),
+	  mDataAvailable(0), mIODone(0), mIOTask(0), mStopping(false)
+{
+	HFSUniStr255 theDataForkName;
+	FSRef		 theFileRef;
+	OSStatus	 err;
+
+	mStats.frames = mStats.dropped = 0;
+	mStats.bytesWritten = 0;
+	mStats.error = noErr;
+
+	if (0 == inFrameSize || 0 == inQueueFrames || inFrameSize > 0x10000000 / inQueueFrames) { err = paramErr; goto bail; }
+	if (!::MPLibraryIsLoaded()) { err = unimpErr; goto bail; }
+
+	// Room for the frames and for the I/O task to be writing while the next run fills
+	mRingSize = kRecorderWriteSize * 2;
+	while (mRingSize < inFrameSize * inQueueFrames) mRingSize <<= 1;
+
+	mRingAlloc = ::NewPtr(mRingSize + kRecorderBlockSize);
+	if (NULL == mRingAlloc) { err = ::MemError(); goto bail; }
+	mRing = (UInt8 *)(((unsigned long)mRingAlloc + kRecorderBlockSize - 1) & ~(unsigned long)(kRecorderBlockSize - 1));
+
+	err = ::FSpCreate(&inFile, FOUR_CHAR_CODE('TVOD'), inFileType, smSystemScript);
+	if (err && err != dupFNErr) goto bail;
+
+	err = ::FSpMakeFSRef(&inFile, &theFileRef);
+	if (err) goto bail;
+
+	err = ::FSGetDataForkName(&theDataForkName);
+	if (err) goto bail;
+
+	err = ::FSOpenFork(&theFileRef, theDataForkName.length, theDataForkName.unicode, fsWrPerm, &mFork);
+	if (err) goto bail;
+
+	err = ::FSSetForkSize(mFork, fsFromStart, 0);
+	if (err) goto bail;
+
+	err = ::MPCreateSemaphore(1, 0, &mDataAvailable);
+	if (err) goto bail;
+
+	err = ::MPCreateSemaphore(1, 0, &mIODone);
+	if (err) goto bail;
+
+	err = ::MPCreateTask(IOTask, this, 0, 0, NULL, NULL, 0, &mIOTask);
+	if (err) goto bail;
+
+	return;
+
+bail:
+	mIOTask = 0;
+	Dispose();
+
+	throw err;
+}
+
+CVideoOutputRecorder::~CVideoOutputRecorder()
+{
+	// The I/O task writes out whatever's left before it signals
+	if (mIOTask) {
+		mStopping = true;
+		::MPSignalSemaphore(mDataAvailable);
+		::MPWaitOnSemaphore(mIODone, kDurationForever);
+	}
+
+	Dispose();
+}
+
+void CVideoOutputRecorder::Dispose(void)
+{
+	if (mFork) ::FSCloseFork(mFork);
+	mFork = 0;
+
+	if (mIODone) ::MPDeleteSemaphore(mIODone);
+	if (mDataAvailable) ::MPDeleteSemaphore(mDataAvailable);
+	mIODone = mDataAvailable = 0;
+
+	if (mRingAlloc) ::DisposePtr(mRingAlloc);
+	mRingAlloc = NULL;
+	mRing = NULL;
+}
+
+#pragma mark-
+
+Boolean CVideoOutputRecorder::WriteFrame(const void *inData, long inRowBytes, long inRowLength, long inRows)
+{
+	const UInt8 *pRow = static_cast<const UInt8 *>(inData);
+	UInt32		 theSize = inRowLength * inRows;
+	UInt32		 theProduced = mProduced;
+	UInt32		 thePosition = theProduced & (mRingSize - 1);
+
+	// AddAtomic for the reads of what the I/O task writes, so we see the space it gave back
+	if (::AddAtomic(0, (SInt32 *)&mStats.error) || theSize > mRingSize - (theProduced - (UInt32)::AddAtomic(0, (SInt32 *)&mConsumed))) {
+		mStats.dropped++;
+		return false;
+	}
+
+	for (long y = 0; y < inRows; y++) {
+		UInt32 theFirst = mRingSize - thePosition;
+		if (theFirst > (UInt32)inRowLength) theFirst = inRowLength;
+
+		::BlockMoveData(pRow, mRing + thePosition, theFirst);
+		if (theFirst < (UInt32)inRowLength) ::BlockMoveData(pRow + theFirst, mRing, inRowLength - theFirst);
+
+		thePosition = (thePosition + inRowLength) & (mRingSize - 1);
+		pRow += inRowBytes;
+	}
+
+	// The frame's in before the count says so
+	::AddAtomic(theSize, (SInt32 *)&mProduced);
+	mStats.frames++;
+
+	::MPSignalSemaphore(mDataAvailable);
+
+	return true;
+}
+
+#pragma mark-
+
+OSStatus CVideoOutputRecorder::IOTask(void *inParameter)
+{
+	CVideoOutputRecorder *pThis = static_cast<CVideoOutputRecorder *>(inParameter);
+
+	for (;;) {
+		// Looked at before the queue, so frames queued before mStopping was set are all written
+		Boolean isStopping = pThis->mStopping;
+
+		while (pThis->WriteQueued(isStopping)) ;
+		if (isStopping) break;
+
+		::MPWaitOnSemaphore(pThis->mDataAvailable, kDurationForever);
+	}
+
+	::MPSignalSemaphore(pThis->mIODone);
+
+	return noErr;
+}
+
+// Writes the queued bytes up to the end of the ring, in whole blocks unless we're flushing. Returns false
+// when there wasn't enough to bother with
+Boolean CVideoOutputRecorder::WriteQueued(Boolean inFlush)
+{
+	UInt32	  theConsumed = mConsumed;
+	UInt32	  theQueued = (UInt32)::AddAtomic(0, (SInt32 *)&mProduced) - theConsumed;
+	UInt32	  thePosition = theConsumed & (mRingSize - 1);
+	UInt32	  theSize = mRingSize - thePosition;
+	ByteCount theWritten = 0;
+
+	if (theSize > theQueued) theSize = theQueued;
+
+	if (!inFlush) {
+		if (theQueued < kRecorderWriteSize) return false;
+		theSize &= ~(kRecorderBlockSize - 1);
+	}
+
+	if (0 == theSize) return false;
+
+	if (noErr == mStats.error) {
+		VIDEO_OUTPUT_TRACE_SCOPE("record");
+		OSErr err = ::FSWriteFork(mFork, fsAtMark | (mUncached ? noCacheMask : 0), 0, theSize, mRing + thePosition, &theWritten);
+		if (err) ::AddAtomic(err, (SInt32 *)&mStats.error);
+		mStats.bytesWritten += theWritten;
+	}
+
+	// Written or not the space goes back, after an error WriteFrame drops everything anyway
+	::AddAtomic(theSize, (SInt32 *)&mConsumed);
+
+	return true;
+}
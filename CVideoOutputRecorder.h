@@ -0,0 +1,145 @@
+/*
+	File:		 CVideoOutputRecorder.h
+	
+	Description: Writes a copy of every frame sent to the video output to a file, on an MP task of
+				 its own so presenting a frame never waits for the disk. Used by the CVideoOutput class.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 documented that only video is recorded
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputRecorder( const FSSpec &inFile, OSType inFileType, UInt32 inFrameSize, UInt32 inQueueFrames, Boolean inUncached = false )
+		Creates inFile if it isn't there, empties it and starts the I/O task. inFrameSize and inQueueFrames
+		size the queue, it holds at least inQueueFrames frames. Pass true for inUncached to write around the
+		file system cache, a recording is never read back while it's being made and there's no point pushing
+		everything else out of the cache for it. Throws an OSStatus if the file can't be opened or there's
+		not enough memory.
+
+	WriteFrame( const void *inData, long inRowBytes, long inRowLength, long inRows )
+		Copies a frame into the queue, inRows rows of inRowLength bytes inRowBytes apart, so the padding at
+		the end of the rows of a GWorld doesn't end up in the file. A DV frame is a single row. Never waits:
+		if there isn't room the frame is dropped, counted and false returned. Call from one thread at a time.
+
+	GetStats( RecorderStatsRecord &outStats )
+		Frames queued and dropped, bytes written and the first write error if there was one. Once there's
+		been an error every frame is dropped.
+
+	The file is just the frames one after the other, the I/O task writes the queue out in runs of at least
+	kRecorderWriteSize bytes, always a multiple of kRecorderBlockSize long and at a multiple of it in the
+	file, and many frames at a time. What's left is written out when the recorder is deleted.
+
+	Only video is recorded. A DV frame carries whatever audio was recorded in it, but sound from any
+	other Movie goes from QuickTime straight to the video output component's sound output component
+	and never passes through here, so it isn't in the file.
+*/
+
+#ifndef __CVIDEOOUTPUTRECORDER_H__
+	#define __CVIDEOOUTPUTRECORDER_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+#else
+	#include <Carbon.h>
+	#include <Files.h>
+	#include <Multiprocessing.h>
+#endif
+
+#include <memory>
+
+namespace dts {
+
+const UInt32 kRecorderBlockSize = 4096;
+const UInt32 kRecorderWriteSize = 256 * 1024;
+
+typedef struct {
+	UInt32	frames;			// queued to be written
+	UInt32	dropped;		// no room in the queue, or a write failed
+	UInt64	bytesWritten;
+	OSStatus error;			// first write error
+} RecorderStatsRecord;
+
+class CVideoOutputRecorder {
+	public:
+		CVideoOutputRecorder(const FSSpec &inFile, OSType inFileType, UInt32 inFrameSize, UInt32 inQueueFrames, Boolean inUncached = false) throw(OSStatus);
+		~CVideoOutputRecorder();
+
+		Boolean WriteFrame(const void *inData, long inRowBytes, long inRowLength, long inRows);
+
+		void GetStats(RecorderStatsRecord &outStats) const { outStats = mStats; }
+
+	private:
+		static OSStatus IOTask(void *inParameter);
+		Boolean WriteQueued(Boolean inFlush);
+		void	Dispose(void);
+
+		// nope
+		CVideoOutputRecorder(const CVideoOutputRecorder &inRecorder);
+		CVideoOutputRecorder operator=(CVideoOutputRecorder inRecorder);
+
+	private:
+		SInt16				mFork;
+		Boolean				mUncached;
+
+		// a power of 2 bytes, the counts run on forever and wrap round it
+		Ptr					mRingAlloc;
+		UInt8				*mRing;				// mRingAlloc rounded up to a block
+		UInt32				mRingSize;
+		UInt32				mProduced;			// atomic, only written by WriteFrame
+		UInt32				mConsumed;			// atomic, only written by the I/O task
+
+		MPSemaphoreID		mDataAvailable;
+		MPSemaphoreID		mIODone;
+		MPTaskID			mIOTask;
+		volatile Boolean	mStopping;
+
+		RecorderStatsRecord	mStats;
+};
+
+typedef std::auto_ptr<CVideoOutputRecorder> CVideoOutputRecorderPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTRECORDER_H__
@@ -0,0 +1,335 @@
+/*
+	File:		 CVideoOutputRegistry.cpp
+	
+	Description: The registry of every Video Output Component installed on the system and
+				 the display modes each one supports. See CVideoOutputRegistry.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 keep the Component, removed FindComponent
+										<1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputRegistry.h"
+#include <cstring>
+
+using namespace dts;
+
+#ifdef _CSTD
+	using _CSTD::memcmp;
+	using _CSTD::memcpy;
+#endif
+
+typedef struct {
+	Component		component;
+	QTAtomContainer	modeList;
+	UInt16			numberOfModes;
+} ScratchComponentRecord, *ScratchComponentPtr;
+
+// Hand out the next 16 byte aligned chunk of the arena
+static UInt32 Carve(UInt32 &ioOffset, UInt32 inSize)
+{
+	UInt32 theOffset = ioOffset;
+
+	ioOffset += (inSize + 15) & ~15UL;
+
+	return theOffset;
+}
+
+/*	The registry is built in two passes. The first pass opens every component's mode list and counts
+	the modes and name bytes, the second pass allocates the one arena and fills in the columns. The mode
+	list containers are kept in a scratch array between the passes so each one is only fetched once.
+*/
+CVideoOutputRegistry::CVideoOutputRegistry() throw(ComponentResult) : mArena(NULL), mComponentCount(0), mComponentRef(NULL), mComponentSubType(NULL), mComponentName(NULL),
+																		mComponentFirstMode(NULL), mComponentModeCount(NULL), mModeCount(0),
+																		 mModeWidth(NULL), mModeHeight(NULL), mModeRefreshRate(NULL), mModePixelType(NULL),
+																		  mModeHRes(NULL), mModeVRes(NULL), mModeID(NULL), mModeComponent(NULL),
+																		   mModeName(NULL), mStringPool(NULL), mStringPoolSize(0)
+{
+	ComponentDescription cd = {QTVideoOutputComponentType, 0, 0, 0L, kQTVideoOutputDontDisplayToUser};
+	ScratchComponentPtr	 pScratch = NULL;
+	Handle				 hComponentName = NULL;
+	Component			 theComponent = 0;
+	UInt32				 theTotalModes = 0, thePoolCapacity = 1; // room for the empty name of the bad mode
+	UInt16				 theNumberOfComponents, componentIndex, modeIndex;
+	ComponentResult		 rc = badComponentType;
+
+	try {
+		theNumberOfComponents = ::CountComponents(&cd);
+		if (0 == theNumberOfComponents) throw (rc);
+
+		pScratch = (ScratchComponentPtr)::NewPtrClear(sizeof(ScratchComponentRecord) * theNumberOfComponents);
+		hComponentName = ::NewHandle(0);
+		if (NULL == pScratch || NULL == hComponentName) throw (rc = ::MemError());
+
+		// First pass - count components, modes and name bytes
+		while (mComponentCount < theNumberOfComponents && (theComponent = ::FindNextComponent(theComponent, &cd))) {
+			ScratchComponentPtr pEntry = &pScratch[mComponentCount++];
+			ComponentDescription cInfo;
+
+			pEntry->component = theComponent;
+
+			::GetComponentInfo(theComponent, &cInfo, hComponentName, NULL, NULL);
+			thePoolCapacity += (::GetHandleSize(hComponentName) ? **(UInt8 **)hComponentName : 0) + 1;
+
+			rc = ::QTVideoOutputGetDisplayModeList((ComponentInstance)theComponent, &pEntry->modeList);
+			if (noErr == rc && NULL != pEntry->modeList) {
+				pEntry->numberOfModes = ::QTCountChildrenOfType(pEntry->modeList, kParentAtomIsContainer, kQTVODisplayModeItem);
+				if (theTotalModes + pEntry->numberOfModes > 0xFFFE)
+					pEntry->numberOfModes = 0xFFFE - theTotalModes;
+
+				for (modeIndex = 1; modeIndex <= pEntry->numberOfModes; modeIndex++) {
+					QTAtom theModeAtom = ::QTFindChildByIndex(pEntry->modeList, kParentAtomIsContainer, kQTVODisplayModeItem, modeIndex, NULL);
+					QTAtom theNameAtom = ::QTFindChildByID(pEntry->modeList, theModeAtom, kQTVOName, 1, NULL);
+					long   theNameSize = 0;
+
+					if (theNameAtom) ::QTGetAtomDataSize(pEntry->modeList, theNameAtom, &theNameSize);
+					thePoolCapacity += (theNameSize > 255 ? 255 : theNameSize) + 1;
+				}
+				theTotalModes += pEntry->numberOfModes;
+			} else {
+				// This VOut component has no mode list !! BAD !!
+				pEntry->modeList = NULL;
+				pEntry->numberOfModes = 0;
+			}
+		}
+		if (0 == mComponentCount) throw (rc = badComponentType);
+
+		mModeCount = theTotalModes;
+
+		// Lay out the arena - component columns, mode columns (plus the bad mode slot) then the string pool
+		{ // gcc complains without this in brackets
+		UInt32 theModeSlots = theTotalModes + 1;
+		UInt32 theSize = 0;
+		UInt32 compRefOffset   = Carve(theSize, sizeof(Component) * mComponentCount);
+		UInt32 subTypeOffset   = Carve(theSize, sizeof(OSType) * mComponentCount);
+		UInt32 compNameOffset  = Carve(theSize, sizeof(UInt32) * mComponentCount);
+		UInt32 firstModeOffset = Carve(theSize, sizeof(UInt16) * mComponentCount);
+		UInt32 modeCountOffset = Carve(theSize, sizeof(UInt16) * mComponentCount);
+		UInt32 widthOffset     = Carve(theSize, sizeof(long) * theModeSlots);
+		UInt32 heightOffset    = Carve(theSize, sizeof(long) * theModeSlots);
+		UInt32 refreshOffset   = Carve(theSize, sizeof(Fixed) * theModeSlots);
+		UInt32 pixelOffset     = Carve(theSize, sizeof(OSType) * theModeSlots);
+		UInt32 hResOffset      = Carve(theSize, sizeof(Fixed) * theModeSlots);
+		UInt32 vResOffset      = Carve(theSize, sizeof(Fixed) * theModeSlots);
+		UInt32 idOffset        = Carve(theSize, sizeof(long) * theModeSlots);
+		UInt32 modeCompOffset  = Carve(theSize, sizeof(UInt16) * theModeSlots);
+		UInt32 modeNameOffset  = Carve(theSize, sizeof(UInt32) * theModeSlots);
+		UInt32 poolOffset      = Carve(theSize, thePoolCapacity);
+
+		mArena = ::NewPtrClear(theSize);
+		if (NULL == mArena) throw (rc = ::MemError());
+
+		mComponentRef       = (Component *)(mArena + compRefOffset);
+		mComponentSubType   = (OSType *)(mArena + subTypeOffset);
+		mComponentName      = (UInt32 *)(mArena + compNameOffset);
+		mComponentFirstMode = (UInt16 *)(mArena + firstModeOffset);
+		mComponentModeCount = (UInt16 *)(mArena + modeCountOffset);
+		mModeWidth          = (long *)(mArena + widthOffset);
+		mModeHeight         = (long *)(mArena + heightOffset);
+		mModeRefreshRate    = (Fixed *)(mArena + refreshOffset);
+		mModePixelType      = (OSType *)(mArena + pixelOffset);
+		mModeHRes           = (Fixed *)(mArena + hResOffset);
+		mModeVRes           = (Fixed *)(mArena + vResOffset);
+		mModeID             = (long *)(mArena + idOffset);
+		mModeComponent      = (UInt16 *)(mArena + modeCompOffset);
+		mModeName           = (UInt32 *)(mArena + modeNameOffset);
+		mStringPool         = (UInt8 *)(mArena + poolOffset);
+		}
+
+		// The shared placeholder for components without a usable mode list
+		mModePixelType[mModeCount] = kBadModePixelType;
+		mModeName[mModeCount] = Intern((ConstStringPtr)"\0");
+
+		// Second pass - fill in the columns
+		{ // gcc complains without this in brackets
+		UInt16 theNextMode = 0;
+		for (componentIndex = 0; componentIndex < mComponentCount; componentIndex++) {
+			ScratchComponentPtr pEntry = &pScratch[componentIndex];
+			ComponentDescription cInfo;
+
+			::GetComponentInfo(pEntry->component, &cInfo, hComponentName, NULL, NULL);
+			mComponentRef[componentIndex] = pEntry->component;
+			mComponentSubType[componentIndex] = cInfo.componentSubType;
+			mComponentName[componentIndex] = Intern(::GetHandleSize(hComponentName) ? (ConstStringPtr)*hComponentName : (ConstStringPtr)"\0");
+			mComponentModeCount[componentIndex] = pEntry->numberOfModes;
+			mComponentFirstMode[componentIndex] = pEntry->numberOfModes ? theNextMode : mModeCount;
+
+			for (modeIndex = 1; modeIndex <= pEntry->numberOfModes; modeIndex++, theNextMode++) {
+				QTAtomID theModeID = 0;
+				QTAtom	 theModeAtom = ::QTFindChildByIndex(pEntry->modeList, kParentAtomIsContainer, kQTVODisplayModeItem, modeIndex, &theModeID);
+
+				mModeID[theNextMode] = theModeID;
+				mModeComponent[theNextMode] = componentIndex;
+				ReadModeAtoms(theNextMode, pEntry->modeList, theModeAtom);
+			}
+		}
+		}
+	}
+	catch (ComponentResult) {
+		if (mArena) ::DisposePtr(mArena);
+		mArena = NULL;
+		if (pScratch) {
+			for (componentIndex = 0; componentIndex < mComponentCount; componentIndex++) {
+				if (pScratch[componentIndex].modeList) ::QTDisposeAtomContainer(pScratch[componentIndex].modeList);
+			}
+			::DisposePtr((Ptr)pScratch);
+		}
+		if (hComponentName) ::DisposeHandle(hComponentName);
+		throw;
+	}
+
+	for (componentIndex = 0; componentIndex < mComponentCount; componentIndex++) {
+		if (pScratch[componentIndex].modeList) ::QTDisposeAtomContainer(pScratch[componentIndex].modeList);
+	}
+	::DisposePtr((Ptr)pScratch);
+	::DisposeHandle(hComponentName);
+}
+
+CVideoOutputRegistry::~CVideoOutputRegistry()
+{
+	if (mArena) ::DisposePtr(mArena);
+}
+
+#pragma mark-
+
+// Each criteria only touches its own column so a filter on width and height
+// streams through two small arrays instead of a list of mode records
+UInt16 CVideoOutputRegistry::FindModes(const ModeFilterRecord &inFilter, UInt16 *outModes, UInt16 inMaxModes, SInt32 inComponent) const
+{
+	UInt16 theFirst = 0, theLast = mModeCount;
+	UInt16 theFound = 0;
+
+	if (inComponent >= 0) {
+		if (inComponent >= mComponentCount) return 0;
+		theFirst = mComponentFirstMode[inComponent];
+		theLast = theFirst + mComponentModeCount[inComponent];
+	}
+
+	for (UInt16 modeIndex = theFirst; modeIndex < theLast && theFound < inMaxModes; modeIndex++) {
+		if (inFilter.width && mModeWidth[modeIndex] != inFilter.width) continue;
+		if (inFilter.height && mModeHeight[modeIndex] != inFilter.height) continue;
+		if (inFilter.minRefreshRate && mModeRefreshRate[modeIndex] < inFilter.minRefreshRate) continue;
+		if (inFilter.pixelType && mModePixelType[modeIndex] != inFilter.pixelType) continue;
+
+		outModes[theFound++] = modeIndex;
+	}
+
+	return theFound;
+}
+
+#pragma mark-
+
+// Returns the pool offset of inName, only adding it if an identical name isn't already there
+// Mode names repeat a lot between components ("NTSC", "PAL") so they're only stored once
+UInt32 CVideoOutputRegistry::Intern(ConstStringPtr inName)
+{
+	UInt32 theOffset = 0;
+
+	while (theOffset < mStringPoolSize) {
+		if (mStringPool[theOffset] == inName[0] && 0 == memcmp(&mStringPool[theOffset], inName, inName[0] + 1))
+			return theOffset;
+		theOffset += mStringPool[theOffset] + 1;
+	}
+
+	memcpy(&mStringPool[mStringPoolSize], inName, inName[0] + 1);
+	mStringPoolSize += inName[0] + 1;
+
+	return theOffset;
+}
+
+// Children of the kQTVODisplayModeItem atom are of type:
+// 		kQTVODimensions
+//		kQTVOResolution
+//		kQTVORefreshRate
+//		kQTVOPixelType
+//		kQTVOName
+// 		kQTVODecompressors atom(s)
+void CVideoOutputRegistry::ReadModeAtoms(UInt16 inMode, QTAtomContainer inContainer, QTAtom inModeAtom)
+{
+	QTAtom atom;
+	long   dataSize, *dataPtr;
+	Str255 theName = { 0 };
+
+	// ******************* kQTVODimensions
+	atom = QTFindChildByID(inContainer, inModeAtom, kQTVODimensions, 1, NULL);
+	if (atom && noErr == QTGetAtomDataPtr(inContainer, atom, &dataSize, (Ptr *)&dataPtr)) {
+		mModeWidth[inMode]  = EndianS32_BtoN(dataPtr[0]);
+		mModeHeight[inMode] = EndianS32_BtoN(dataPtr[1]);
+	}
+
+	// ******************* kQTVOResolution
+	atom = QTFindChildByID(inContainer, inModeAtom, kQTVOResolution, 1, NULL);
+	if (atom && noErr == QTGetAtomDataPtr(inContainer, atom, &dataSize, (Ptr *)&dataPtr)) {
+		mModeHRes[inMode] = EndianS32_BtoN(dataPtr[0]);
+		mModeVRes[inMode] = EndianS32_BtoN(dataPtr[1]);
+	}
+
+	// ******************* kQTVORefreshRate
+	atom = QTFindChildByID(inContainer, inModeAtom, kQTVORefreshRate, 1, NULL);
+	if (atom && noErr == QTGetAtomDataPtr(inContainer, atom, &dataSize, (Ptr *)&dataPtr)) {
+		mModeRefreshRate[inMode] = EndianS32_BtoN(dataPtr[0]);
+	}
+
+	// ******************* kQTVOPixelType
+	atom = QTFindChildByID(inContainer, inModeAtom, kQTVOPixelType, 1, NULL);
+	if (atom && noErr == QTGetAtomDataPtr(inContainer, atom, &dataSize, (Ptr *)&dataPtr)) {
+		mModePixelType[inMode] = EndianU32_BtoN(dataPtr[0]);
+	}
+
+	// ******************* kQTVOName
+	atom = QTFindChildByID(inContainer, inModeAtom, kQTVOName, 1, NULL);
+	if (atom && noErr == QTGetAtomDataPtr(inContainer, atom, &dataSize, (Ptr *)&dataPtr)) {
+		// the name is a C string which may or may not include the terminator
+		if (dataSize > 255) dataSize = 255;
+		while (dataSize && '\0' == ((char *)dataPtr)[dataSize-1]) dataSize--;
+		memcpy(&theName[1], dataPtr, dataSize);
+		theName[0] = dataSize;
+	}
+	mModeName[inMode] = Intern(theName);
+
+	// ******************* kQTVODecompressors
+	// We don't care about the kQTVODecompressors atom(s) in this sample, if we did we
+	// would need to go down another level and muck about in much the same fashion.
+	// Because kQTVODecompressors atoms are not required to have consecutive IDs, use
+	// QTFindChildByIndex to iterate through the decompressors.
+}
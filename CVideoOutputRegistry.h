@@ -0,0 +1,161 @@
+/*
+	File:		 CVideoOutputRegistry.h
+	
+	Description: The registry of every Video Output Component installed on the system and
+				 the display modes each one supports, used by the CVideoOutputComponent class.
+
+				 Everything lives in one block of memory: the per-component and per-mode data
+				 are stored as columns (all widths together, all heights together and so on),
+				 and component and mode names are interned into a single string pool.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 keep the Component, removed FindComponent
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputRegistry()
+		Walks all the Video Output Components and their display mode lists and builds the registry.
+		Throws a ComponentResult if there are no components or memory can't be allocated.
+
+	Component indexes run from 0 to GetComponentCount() - 1. Mode indexes are global, run from
+	0 to GetTotalModeCount() - 1 and are grouped by component; GetFirstMode() and GetModeCount()
+	give the range belonging to a component. A component with a bad (or no) mode list has a mode
+	count of 0 and its first mode is a shared placeholder with a pixelType of 'BAD '.
+
+	FindModes( const ModeFilterRecord &inFilter, UInt16 *outModes, UInt16 inMaxModes, SInt32 inComponent = -1 )
+		Fills outModes with the global indexes of the modes matching inFilter and returns how many
+		were found. Pass a component index to restrict the search to that component. Zero fields
+		in the filter match anything. CVideoOutputModeMatcher uses it to look for a mode the movie
+		fits exactly before scoring all of them.
+
+	GetComponent( UInt16 inComponent )
+		The Component found by the walk, so the component can be opened without walking them again.
+*/
+
+#ifndef __CVIDEOOUTPUTREGISTRY_H__
+	#define __CVIDEOOUTPUTREGISTRY_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <QuickTimeComponents.h>
+#endif
+
+namespace dts {
+
+const OSType kBadModePixelType = FOUR_CHAR_CODE('BAD ');
+
+typedef struct {
+	long	width, height;	// 0 = any
+	Fixed	minRefreshRate;	// 0 = any
+	OSType	pixelType;		// 0 = any
+} ModeFilterRecord;
+
+class CVideoOutputRegistry {
+	public:
+		CVideoOutputRegistry() throw(ComponentResult);
+		~CVideoOutputRegistry();
+
+		UInt16 GetComponentCount(void) const { return mComponentCount; }
+		Component GetComponent(UInt16 inComponent) const { return mComponentRef[inComponent]; }
+		OSType GetComponentSubType(UInt16 inComponent) const { return mComponentSubType[inComponent]; }
+		ConstStringPtr GetComponentName(UInt16 inComponent) const { return mStringPool + mComponentName[inComponent]; }
+		UInt16 GetFirstMode(UInt16 inComponent) const { return mComponentFirstMode[inComponent]; }
+		UInt16 GetModeCount(UInt16 inComponent) const { return mComponentModeCount[inComponent]; }
+
+		UInt16 GetTotalModeCount(void) const { return mModeCount; }
+		UInt16 GetModeComponent(UInt16 inMode) const { return mModeComponent[inMode]; }
+		long   GetModeID(UInt16 inMode) const { return mModeID[inMode]; }
+		long   GetModeWidth(UInt16 inMode) const { return mModeWidth[inMode]; }
+		long   GetModeHeight(UInt16 inMode) const { return mModeHeight[inMode]; }
+		Fixed  GetModeHRes(UInt16 inMode) const { return mModeHRes[inMode]; }
+		Fixed  GetModeVRes(UInt16 inMode) const { return mModeVRes[inMode]; }
+		Fixed  GetModeRefreshRate(UInt16 inMode) const { return mModeRefreshRate[inMode]; }
+		OSType GetModePixelType(UInt16 inMode) const { return mModePixelType[inMode]; }
+		ConstStringPtr GetModeName(UInt16 inMode) const { return mStringPool + mModeName[inMode]; }
+
+		UInt16 FindModes(const ModeFilterRecord &inFilter, UInt16 *outModes, UInt16 inMaxModes, SInt32 inComponent = -1) const;
+
+	private:
+		UInt32 Intern(ConstStringPtr inName);
+		void   ReadModeAtoms(UInt16 inMode, QTAtomContainer inContainer, QTAtom inModeAtom);
+
+		// nope
+		CVideoOutputRegistry(const CVideoOutputRegistry &inRegistry);
+		CVideoOutputRegistry operator=(CVideoOutputRegistry inRegistry);
+
+	private:
+		Ptr			mArena;
+
+		// component columns
+		UInt16		mComponentCount;
+		Component	*mComponentRef;
+		OSType		*mComponentSubType;
+		UInt32		*mComponentName;		// offsets into the string pool
+		UInt16		*mComponentFirstMode;
+		UInt16		*mComponentModeCount;
+
+		// mode columns, one extra slot at the end for the bad mode placeholder
+		UInt16		mModeCount;
+		long		*mModeWidth;
+		long		*mModeHeight;
+		Fixed		*mModeRefreshRate;
+		OSType		*mModePixelType;
+		Fixed		*mModeHRes;
+		Fixed		*mModeVRes;
+		long		*mModeID;
+		UInt16		*mModeComponent;
+		UInt32		*mModeName;				// offsets into the string pool
+
+		// interned pascal strings
+		UInt8		*mStringPool;
+		UInt32		mStringPoolSize;
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTREGISTRY_H__
@@ -0,0 +1,387 @@
+/*
+	File:		 CVideoOutputScopes.cpp
+	
+	Description: Video scopes of the frames going to the video output.
+				 See CVideoOutputScopes.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 SampleFrame can legalize the rows it copies, SSE2 Y'CbCr to R'G'B'
+										<1> 10/19/26 initial release
+*/
+
+#include <string.h>
+#if __SSE2__
+	#include <emmintrin.h>
+#endif
+
+#include "CVideoOutputScopes.h"
+#include "CVideoOutputWorkPool.h"
+#include "CVideoOutputTrace.h"
+
+using namespace dts;
+
+static inline UInt8 ClampSample(SInt32 inSample)
+{
+	return (inSample < 0) ? 0 : ((inSample > 255) ? 255 : (UInt8)inSample);
+}
+
+static inline void CountSaturated(UInt16 &ioCount)
+{
+	if (ioCount != 0xFFFF) ioCount++;
+}
+
+CVideoOutputScopes::CVideoOutputScopes(UInt32 inWidth, UInt32 inHeight, OSType inPixelFormat, UInt32 inFrameInterval, UInt32 inStep) throw(OSStatus)
+	: mWidth(inWidth), mRowLength(0), mPixelFormat(inPixelFormat), mFrameInterval(inFrameInterval ? inFrameInterval : 1),
+	  mStep(inStep ? inStep : 1), mFrameCount(0), mRows(NULL), mRowCount(0), mFrameNumber(0), mIsBusy(0), mBands(NULL), mScopes(NULL),
+	  mFrameAvailable(0), mTaskDone(0), mLock(0), mTask(0), mStopping(false)
+{
+	OSStatus err;
+
+	mStats.framesAnalyzed = mStats.framesSkipped = 0;
+
+	switch (inPixelFormat) {
+	case k2vuyPixelFormat:
+	case kYUVSPixelFormat:
+		mRowLength = inWidth * 2;
+		break;
+	case k32ARGBPixelFormat:
+		mRowLength = inWidth * 4;
+		break;
+	default:
+		err = paramErr;
+		goto bail;
+	}
+
+	if (inWidth < 2 || 0 == inHeight) { err = paramErr; goto bail; }
+	if (!::MPLibraryIsLoaded()) { err = unimpErr; goto bail; }
+
+	mRowCount = (inHeight + mStep - 1) / mStep;
+
+	mRows = (UInt8 *)::NewPtr(mRowLength * mRowCount);
+	mBands = (BandTablesRecord *)::NewPtr(sizeof(BandTablesRecord) * kScopeBands);
+	mScopes = (ScopeDataRecord *)::NewPtrClear(sizeof(ScopeDataRecord) * 2);	// the published one and the task's
+	if (NULL == mRows || NULL == mBands || NULL == mScopes) { err = memFullErr; goto bail; }
+
+	// Make sure the pool is created on this thread
+	CVideoOutputWorkPool::GetSharedPool();
+
+	err = ::MPCreateSemaphore(1, 0, &mFrameAvailable);
+	if (err) goto bail;
+
+	err = ::MPCreateSemaphore(1, 0, &mTaskDone);
+	if (err) goto bail;
+
+	err = ::MPCreateCriticalRegion(&mLock);
+	if (err) goto bail;
+
+	err = ::MPCreateTask(ScopeTask, this, 0, 0, NULL, NULL, 0, &mTask);
+	if (err) goto bail;
+
+	return;
+
+bail:
+	mTask = 0;
+	Dispose();
+
+	throw err;
+}
+
+CVideoOutputScopes::~CVideoOutputScopes()
+{
+	if (mTask) {
+		mStopping = true;
+		::MPSignalSemaphore(mFrameAvailable);
+		::MPWaitOnSemaphore(mTaskDone, kDurationForever);
+	}
+
+	Dispose();
+}
+
+void CVideoOutputScopes::Dispose(void)
+{
+	if (mLock) ::MPDeleteCriticalRegion(mLock);
+	if (mTaskDone) ::MPDeleteSemaphore(mTaskDone);
+	if (mFrameAvailable) ::MPDeleteSemaphore(mFrameAvailable);
+	mLock = 0;
+	mTaskDone = mFrameAvailable = 0;
+
+	if (mScopes) ::DisposePtr((Ptr)mScopes);
+	if (mBands) ::DisposePtr((Ptr)mBands);
+	if (mRows) ::DisposePtr((Ptr)mRows);
+	mScopes = NULL;
+	mBands = NULL;
+	mRows = NULL;
+}
+
+#pragma mark-
+
+Boolean CVideoOutputScopes::SampleFrame(const void *inPixels, long inRowBytes, const CVideoOutputLegalizer *inLegalizer)
+{
+	const UInt8 *pRow = static_cast<const UInt8 *>(inPixels);
+
+	if (mFrameCount++ % mFrameInterval) return false;
+
+	// The task hands the rows back when it's done with them
+	if (!::CompareAndSwap(0, 1, &mIsBusy)) {
+		mStats.framesSkipped++;
+		return false;
+	}
+
+	// ARGB is never legalized, the legalizer only takes Y'CbCr
+	if (k32ARGBPixelFormat == mPixelFormat) inLegalizer = NULL;
+
+	for (UInt32 y = 0; y < mRowCount; y++) {
+		if (inLegalizer)
+			inLegalizer->LegalizeRect(pRow, inRowBytes, mRows + y * mRowLength, mRowLength, mWidth / 2, 1);
+		else
+			::BlockMoveData(pRow, mRows + y * mRowLength, mRowLength);
+		pRow += inRowBytes * mStep;
+	}
+	mFrameNumber = mFrameCount - 1;
+
+	::MPSignalSemaphore(mFrameAvailable);
+
+	return true;
+}
+
+void CVideoOutputScopes::GetScopes(ScopeDataRecord &outScopes) const
+{
+	::MPEnterCriticalRegion(mLock, kDurationForever);
+	outScopes = mScopes[0];
+	::MPExitCriticalRegion(mLock);
+}
+
+#pragma mark-
+
+OSStatus CVideoOutputScopes::ScopeTask(void *inParameter)
+{
+	CVideoOutputScopes *pThis = static_cast<CVideoOutputScopes *>(inParameter);
+
+	for (;;) {
+		::MPWaitOnSemaphore(pThis->mFrameAvailable, kDurationForever);
+		if (pThis->mStopping) break;
+
+		pThis->Analyze();
+	}
+
+	::MPSignalSemaphore(pThis->mTaskDone);
+
+	return noErr;
+}
+
+void CVideoOutputScopes::Analyze(void)
+{
+	CVideoOutputWorkPool *pPool = CVideoOutputWorkPool::GetSharedPool();
+	ScopeDataRecord		 &theScopes = mScopes[1];
+
+	VIDEO_OUTPUT_TRACE_SCOPE("scopes");
+
+	if (pPool) {
+		pPool->Run(AnalyzeBand, this, kScopeBands);
+	} else {
+		for (UInt32 i = 0; i < kScopeBands; i++) AnalyzeBand(this, i);
+	}
+
+	// The rows can have the next frame now, the tables are ours
+	theScopes.frameNumber = mFrameNumber;
+	::CompareAndSwap(1, 0, &mIsBusy);
+
+	::memset(&theScopes.waveform, 0, sizeof(theScopes.waveform));
+	::memset(&theScopes.vectorscope, 0, sizeof(theScopes.vectorscope));
+	::memset(&theScopes.histogram, 0, sizeof(theScopes.histogram));
+	theScopes.samples = 0;
+
+	for (UInt32 i = 0; i < kScopeBands; i++) {
+		const BandTablesRecord &theBand = mBands[i];
+
+		for (UInt32 x = 0; x < kScopeWaveformColumns; x++) {
+			for (UInt32 y = 0; y < kScopeLevels; y++) {
+				UInt32 theSum = theScopes.waveform[x][y] + theBand.waveform[x][y];
+				theScopes.waveform[x][y] = (theSum > 0xFFFF) ? 0xFFFF : theSum;
+			}
+		}
+		for (UInt32 cr = 0; cr < kScopeLevels; cr++) {
+			for (UInt32 cb = 0; cb < kScopeLevels; cb++) {
+				UInt32 theSum = theScopes.vectorscope[cr][cb] + theBand.vectorscope[cr][cb];
+				theScopes.vectorscope[cr][cb] = (theSum > 0xFFFF) ? 0xFFFF : theSum;
+			}
+		}
+		for (UInt32 c = 0; c < 3; c++) {
+			for (UInt32 v = 0; v < 256; v++) theScopes.histogram[c][v] += theBand.histogram[c][v];
+		}
+		theScopes.samples += theBand.samples;
+	}
+
+	::MPEnterCriticalRegion(mLock, kDurationForever);
+	mScopes[0] = theScopes;
+	::MPExitCriticalRegion(mLock);
+
+	mStats.framesAnalyzed++;
+}
+
+/* ConvertPixels
+		Eight Y'CbCr pixels to R'G'B', ITU-R BT.601 video range, each pixel with its pair's Cb and Cr.
+*/
+#if __SSE2__
+static inline void ConvertPixels(const SInt16 inY[8], const SInt16 inCb[8], const SInt16 inCr[8], UInt8 outR[8], UInt8 outG[8], UInt8 outB[8])
+{
+	const __m128i theRound = _mm_set1_epi32(128);
+	const __m128i theRV = _mm_set1_epi32((UInt16)298 | ((UInt32)(UInt16)409 << 16));		// c, e
+	const __m128i theGU = _mm_set1_epi32((UInt16)298 | ((UInt32)(UInt16)-100 << 16));		// c, d
+	const __m128i theGV = _mm_set1_epi32((UInt16)-208);									// e, 0
+	const __m128i theBU = _mm_set1_epi32((UInt16)298 | ((UInt32)(UInt16)516 << 16));		// c, d
+	__m128i c = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)inY), _mm_set1_epi16(16));
+	__m128i d = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)inCb), _mm_set1_epi16(128));
+	__m128i e = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)inCr), _mm_set1_epi16(128));
+	__m128i theCELo = _mm_unpacklo_epi16(c, e), theCEHi = _mm_unpackhi_epi16(c, e);
+	__m128i theCDLo = _mm_unpacklo_epi16(c, d), theCDHi = _mm_unpackhi_epi16(c, d);
+	__m128i theE0Lo = _mm_unpacklo_epi16(e, _mm_setzero_si128()), theE0Hi = _mm_unpackhi_epi16(e, _mm_setzero_si128());
+	__m128i theLo, theHi;
+
+	// The sums need 32 bits, a pack back to 16 and another to 8 clamps them like ClampSample()
+	theLo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(theCELo, theRV), theRound), 8);
+	theHi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(theCEHi, theRV), theRound), 8);
+	_mm_storel_epi64((__m128i *)outR, _mm_packus_epi16(_mm_packs_epi32(theLo, theHi), _mm_setzero_si128()));
+
+	theLo = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(theCDLo, theGU), _mm_madd_epi16(theE0Lo, theGV)), theRound), 8);
+	theHi = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(theCDHi, theGU), _mm_madd_epi16(theE0Hi, theGV)), theRound), 8);
+	_mm_storel_epi64((__m128i *)outG, _mm_packus_epi16(_mm_packs_epi32(theLo, theHi), _mm_setzero_si128()));
+
+	theLo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(theCDLo, theBU), theRound), 8);
+	theHi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(theCDHi, theBU), theRound), 8);
+	_mm_storel_epi64((__m128i *)outB, _mm_packus_epi16(_mm_packs_epi32(theLo, theHi), _mm_setzero_si128()));
+}
+#else
+static inline void ConvertPixels(const SInt16 inY[8], const SInt16 inCb[8], const SInt16 inCr[8], UInt8 outR[8], UInt8 outG[8], UInt8 outB[8])
+{
+	for (UInt32 i = 0; i < 8; i++) {
+		SInt32 c = inY[i] - 16, d = inCb[i] - 128, e = inCr[i] - 128;
+
+		outR[i] = ClampSample((298 * c + 409 * e + 128) >> 8);
+		outG[i] = ClampSample((298 * c - 100 * d - 208 * e + 128) >> 8);
+		outB[i] = ClampSample((298 * c + 516 * d + 128) >> 8);
+	}
+}
+#endif
+
+/* CountPairs
+		Adds inCount pairs of pixels to the band's tables, pixel 2i and 2i + 1 being pair i in column inColumns[i].
+*/
+static inline void CountPairs(UInt16 ioWaveform[][kScopeLevels], UInt16 ioVectorscope[][kScopeLevels], UInt32 ioHistogram[][256], UInt32 inCount,
+							  const UInt32 inColumns[], const SInt16 inY[], const SInt16 inCb[], const SInt16 inCr[], const UInt8 inR[], const UInt8 inG[], const UInt8 inB[])
+{
+	for (UInt32 i = 0; i < inCount * 2; i++) {
+		CountSaturated(ioWaveform[inColumns[i / 2]][inY[i] >> 2]);
+		ioHistogram[0][inR[i]]++;
+		ioHistogram[1][inG[i]]++;
+		ioHistogram[2][inB[i]]++;
+	}
+	for (UInt32 i = 0; i < inCount; i++) CountSaturated(ioVectorscope[inCr[i * 2] >> 2][inCb[i * 2] >> 2]);
+}
+
+/* AnalyzeBand
+		A work pool item, every inStep'th pair of pixels of the band's rows into the band's own tables.
+		The pair is the unit so a Y'CbCr pair's chroma is counted once, for ARGB it's the mean of the two.
+		Y'CbCr pairs are gathered four at a time so ConvertPixels() can do eight pixels in one go.
+*/
+void CVideoOutputScopes::AnalyzeBand(void *inRefCon, UInt32 inBand)
+{
+	CVideoOutputScopes *pThis = static_cast<CVideoOutputScopes *>(inRefCon);
+	BandTablesRecord   &theTables = pThis->mBands[inBand];
+	UInt32				theFirst = pThis->mRowCount * inBand / kScopeBands;
+	UInt32				theEnd = pThis->mRowCount * (inBand + 1) / kScopeBands;
+	UInt32				thePairBytes = (k32ARGBPixelFormat == pThis->mPixelFormat) ? 8 : 4;
+	UInt32				theLumaOffset = 1, theCbOffset = 0, theCrOffset = 2;
+	UInt32				theColumns[4], theCount = 0;
+	SInt16				theY[8] = { 0 }, theCb[8] = { 0 }, theCr[8] = { 0 };
+	UInt8				theR[8], theG[8], theB[8];
+
+	::memset(&theTables, 0, sizeof(theTables));
+
+	if (kYUVSPixelFormat == pThis->mPixelFormat) {	// Y0 Cb Y1 Cr
+		theLumaOffset = 0; theCbOffset = 1; theCrOffset = 3;
+	}
+
+	for (UInt32 row = theFirst; row < theEnd; row++) {
+		const UInt8 *pRow = pThis->mRows + row * pThis->mRowLength;
+
+		for (UInt32 x = 0; x + 1 < pThis->mWidth; x += 2 * pThis->mStep) {
+			const UInt8 *p = pRow + (x / 2) * thePairBytes;
+
+			theColumns[theCount] = (x * kScopeWaveformColumns) / pThis->mWidth;
+
+			if (4 == thePairBytes) {
+				theY[theCount * 2] = p[theLumaOffset];
+				theY[theCount * 2 + 1] = p[theLumaOffset + 2];
+				theCb[theCount * 2] = theCb[theCount * 2 + 1] = p[theCbOffset];
+				theCr[theCount * 2] = theCr[theCount * 2 + 1] = p[theCrOffset];
+
+				if (++theCount < 4) continue;
+				ConvertPixels(theY, theCb, theCr, theR, theG, theB);
+			} else {
+				for (UInt32 i = 0; i < 2; i++) {
+					theR[i] = p[i * 4 + 1];
+					theG[i] = p[i * 4 + 2];
+					theB[i] = p[i * 4 + 3];
+					theY[i] = ((66 * theR[i] + 129 * theG[i] + 25 * theB[i] + 128) >> 8) + 16;
+				}
+				SInt32 r = theR[0] + theR[1], g = theG[0] + theG[1], b = theB[0] + theB[1];
+
+				theCb[0] = ClampSample(((-38 * r - 74 * g + 112 * b + 256) >> 9) + 128);
+				theCr[0] = ClampSample(((112 * r - 94 * g - 18 * b + 256) >> 9) + 128);
+				theCount = 1;
+			}
+
+			CountPairs(theTables.waveform, theTables.vectorscope, theTables.histogram, theCount, theColumns, theY, theCb, theCr, theR, theG, theB);
+			theTables.samples += theCount * 2;
+			theCount = 0;
+		}
+	}
+
+	// The Y'CbCr pairs left over, the lanes past them are converted too but not counted
+	if (theCount) {
+		ConvertPixels(theY, theCb, theCr, theR, theG, theB);
+		CountPairs(theTables.waveform, theTables.vectorscope, theTables.histogram, theCount, theColumns, theY, theCb, theCr, theR, theG, theB);
+		theTables.samples += theCount * 2;
+	}
+}
@@ -0,0 +1,167 @@
+/*
+	File:		 CVideoOutputScopes.h
+	
+	Description: Luma waveform, chroma vectorscope and RGB histograms of the frames going to the video
+				 output, worked out on a task of their own. Used by the CVideoOutput class.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 SampleFrame can legalize the rows it copies
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputScopes( UInt32 inWidth, UInt32 inHeight, OSType inPixelFormat, UInt32 inFrameInterval = 1, UInt32 inStep = 1 )
+		Frames are inWidth by inHeight of inPixelFormat, '2vuy', 'yuvs' or 32 bit ARGB. Every inFrameInterval'th
+		frame is looked at, and of those every inStep'th row and every inStep'th pair of pixels, which is what
+		bounds the cost - 2 and 2 is a sixteenth of the work of every pixel of every frame. Starts the scope task.
+		Throws an OSStatus for any other pixel format or if Multiprocessing Services aren't available.
+
+	SampleFrame( const void *inPixels, long inRowBytes, const CVideoOutputLegalizer *inLegalizer = NULL )
+		Call with each frame as it goes out. When it's one to look at the rows are copied for the scope task
+		and it's woken, nothing else is done on the calling thread. Given a legalizer the rows are legalized
+		as they're copied, for pixels that are only legalized on their way into something else - the DV
+		encoder's source - so the scopes show what goes out. Never waits: if the task is still busy with
+		the last one the frame is skipped, counted and false returned. Call from one thread at a time.
+
+	GetScopes( ScopeDataRecord &outScopes )
+		The scopes of the last frame the task finished, about 30K. Any thread.
+
+	The task splits the rows of a frame into kScopeBands bands and runs them on the shared work pool, each
+	band counting into tables of its own so they never share a cache line, then adds the tables up. Counts
+	stop at 65535. Y'CbCr is taken as ITU-R BT.601 video range both ways.
+*/
+
+#ifndef __CVIDEOOUTPUTSCOPES_H__
+	#define __CVIDEOOUTPUTSCOPES_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <Multiprocessing.h>
+	#include <ImageCompression.h>
+#endif
+
+#include <memory>
+
+#include "CVideoOutputLegalizer.h"
+
+namespace dts {
+
+const UInt32 kScopeWaveformColumns = 128;	// across the frame
+const UInt32 kScopeLevels = 64;				// 8 bit values >> 2
+const UInt32 kScopeBands = 8;
+
+typedef struct {
+	UInt32	frameNumber;			// of the frames given to SampleFrame()
+	UInt32	samples;				// pixels looked at
+	UInt16	waveform[kScopeWaveformColumns][kScopeLevels];	// Y' by column
+	UInt16	vectorscope[kScopeLevels][kScopeLevels];		// [Cr][Cb] per pair of pixels
+	UInt32	histogram[3][256];		// R, G, B
+} ScopeDataRecord;
+
+typedef struct {
+	UInt32	framesAnalyzed;
+	UInt32	framesSkipped;			// the task was still busy
+} ScopeStatsRecord;
+
+class CVideoOutputScopes {
+	public:
+		CVideoOutputScopes(UInt32 inWidth, UInt32 inHeight, OSType inPixelFormat, UInt32 inFrameInterval = 1, UInt32 inStep = 1) throw(OSStatus);
+		~CVideoOutputScopes();
+
+		Boolean SampleFrame(const void *inPixels, long inRowBytes, const CVideoOutputLegalizer *inLegalizer = NULL);
+
+		void GetScopes(ScopeDataRecord &outScopes) const;
+		void GetStats(ScopeStatsRecord &outStats) const { outStats = mStats; }
+
+	private:
+		typedef struct {
+			UInt16	waveform[kScopeWaveformColumns][kScopeLevels];
+			UInt16	vectorscope[kScopeLevels][kScopeLevels];
+			UInt32	histogram[3][256];
+			UInt32	samples;
+		} BandTablesRecord;
+
+		static OSStatus ScopeTask(void *inParameter);
+		static void		AnalyzeBand(void *inRefCon, UInt32 inBand);
+		void			Analyze(void);
+		void			Dispose(void);
+
+		// nope
+		CVideoOutputScopes(const CVideoOutputScopes &inScopes);
+		CVideoOutputScopes operator=(CVideoOutputScopes inScopes);
+
+	private:
+		UInt32				mWidth;
+		UInt32				mRowLength;			// bytes
+		OSType				mPixelFormat;
+		UInt32				mFrameInterval;
+		UInt32				mStep;
+		UInt32				mFrameCount;
+
+		// the rows being looked at, the task owns them while mIsBusy
+		UInt8				*mRows;
+		UInt32				mRowCount;
+		UInt32				mFrameNumber;
+		UInt32				mIsBusy;			// atomic
+
+		BandTablesRecord	*mBands;			// kScopeBands of them
+		ScopeDataRecord		*mScopes;			// the last frame done, protected by mLock
+
+		MPSemaphoreID		mFrameAvailable;
+		MPSemaphoreID		mTaskDone;
+		MPCriticalRegionID	mLock;
+		MPTaskID			mTask;
+		volatile Boolean	mStopping;
+
+		ScopeStatsRecord	mStats;
+};
+
+typedef std::auto_ptr<CVideoOutputScopes> CVideoOutputScopesPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTSCOPES_H__
@@ -0,0 +1,386 @@
+/*
+	File:		 CVideoOutputSwapChain.cpp
+	
+	Description: Buffers for drawing frames ahead of the video output.
+				 See CVideoOutputSwapChain.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <6> 10/19/26 copy out without holding the buffer lock, the stats are locked
+										<5> 10/19/26 legalize buffers as they're copied to the output
+										<4> 10/19/26 hand what goes out to the scopes
+										<3> 10/19/26 added trace points
+										<2> 10/19/26 hand what goes out to the recorder
+										<1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputSwapChain.h"
+#include "CVideoOutputTrace.h"
+
+using namespace dts;
+
+// Longest the output task sleeps with something queued, in case the clock and UpTime disagree
+const UInt64 kMaxOutputWaitMicroseconds = 1000000;
+
+CVideoOutputSwapChain::CVideoOutputSwapChain(GWorldPtr inOutputGWorld, UInt16 inBufferCount) throw(OSStatus)
+	: mOutputGWorld(inOutputGWorld), mOutputBaseAddr(NULL), mOutputRowBytes(0), mRowLength(0), mPixelFormat(0), mWidth(0), mHeight(0),
+	  mBufferCount(0), mNextSequence(0), mLock(0), mOutputLock(0), mFreeBuffers(0), mWakeOutput(0), mOutputDone(0), mOutputTask(0), mQuit(false),
+	  mRecorder(NULL), mScopes(NULL), mLegalizer(NULL)
+{
+	PixMapHandle hOutputPixMap;
+	Rect		 theBounds;
+	OSStatus	 err = noErr;
+
+	::BlockZero(mBuffers, sizeof(mBuffers));
+	mStats.presented = mStats.dropped = 0;
+
+	if (NULL == inOutputGWorld || inBufferCount < 2 || inBufferCount > kMaxSwapBuffers) { err = paramErr; goto bail; }
+	if (!::MPLibraryIsLoaded()) { err = unimpErr; goto bail; }
+
+	// The output task writes here, it mustn't move
+	hOutputPixMap = ::GetGWorldPixMap(inOutputGWorld);
+	if (!::LockPixels(hOutputPixMap)) { err = memFullErr; goto bail; }
+
+	mOutputBaseAddr = (UInt8 *)::GetPixBaseAddr(hOutputPixMap);
+	mOutputRowBytes = ::GetPixRowBytes(hOutputPixMap);
+	mPixelFormat = GETPIXMAPPIXELFORMAT(*hOutputPixMap);
+
+	::GetPortBounds(inOutputGWorld, &theBounds);
+	::OffsetRect(&theBounds, -theBounds.left, -theBounds.top);
+	mWidth = theBounds.right;
+	mHeight = theBounds.bottom;
+	mRowLength = (mWidth * ::GetPixDepth(hOutputPixMap) + 7) / 8;
+
+	for (UInt16 i = 0; i < inBufferCount; i++) {
+		BufferRecord &theBuffer = mBuffers[i];
+		PixMapHandle hPixMap;
+
+		err = ::QTNewGWorld(&theBuffer.gWorld, mPixelFormat, &theBounds, NULL, NULL, 0);
+		if (err) goto bail;
+		mBufferCount++;
+
+		// Filled on one thread and copied on another, so these mustn't move either
+		hPixMap = ::GetGWorldPixMap(theBuffer.gWorld);
+		::LockPixels(hPixMap);
+
+		theBuffer.baseAddr = (UInt8 *)::GetPixBaseAddr(hPixMap);
+		theBuffer.rowBytes = ::GetPixRowBytes(hPixMap);
+		theBuffer.state = eSwapBufferFree;
+	}
+
+	err = ::MPCreateCriticalRegion(&mLock);
+	if (err) goto bail;
+
+	err = ::MPCreateCriticalRegion(&mOutputLock);
+	if (err) goto bail;
+
+	err = ::MPCreateSemaphore(inBufferCount, inBufferCount, &mFreeBuffers);
+	if (err) goto bail;
+
+	err = ::MPCreateSemaphore(0xFFFFFFFF, 0, &mWakeOutput);
+	if (err) goto bail;
+
+	err = ::MPCreateSemaphore(1, 0, &mOutputDone);
+	if (err) goto bail;
+
+	err = ::MPCreateTask(OutputTask, this, 0, 0, NULL, NULL, 0, &mOutputTask);
+	if (err) goto bail;
+
+	return;
+
+bail:
+	mOutputTask = 0;
+	Dispose();
+
+	throw err;
+}
+
+CVideoOutputSwapChain::~CVideoOutputSwapChain()
+{
+	if (mOutputTask) {
+		mQuit = true;
+		::MPSignalSemaphore(mWakeOutput);
+		::MPWaitOnSemaphore(mOutputDone, kDurationForever);
+	}
+
+	Dispose();
+}
+
+void CVideoOutputSwapChain::Dispose(void)
+{
+	for (UInt16 i = 0; i < mBufferCount; i++) {
+		::DisposeGWorld(mBuffers[i].gWorld);
+		mBuffers[i].gWorld = NULL;
+	}
+	mBufferCount = 0;
+
+	// The GWorld belongs to the video output component, just undo our lock
+	if (mOutputBaseAddr) ::UnlockPixels(::GetGWorldPixMap(mOutputGWorld));
+	mOutputBaseAddr = NULL;
+
+	if (mOutputDone) ::MPDeleteSemaphore(mOutputDone);
+	if (mWakeOutput) ::MPDeleteSemaphore(mWakeOutput);
+	if (mFreeBuffers) ::MPDeleteSemaphore(mFreeBuffers);
+	if (mOutputLock) ::MPDeleteCriticalRegion(mOutputLock);
+	if (mLock) ::MPDeleteCriticalRegion(mLock);
+	mOutputDone = mWakeOutput = mFreeBuffers = 0;
+	mLock = mOutputLock = 0;
+}
+
+UInt64 CVideoOutputSwapChain::GetCurrentTime(void)
+{
+	Nanoseconds theNow = ::AbsoluteToNanoseconds(::UpTime());
+
+	return ::UnsignedWideToUInt64(theNow);
+}
+
+void CVideoOutputSwapChain::GetStats(SwapChainStatsRecord &outStats) const
+{
+	::MPEnterCriticalRegion(mLock, kDurationForever);
+	outStats = mStats;
+	::MPExitCriticalRegion(mLock);
+}
+
+void CVideoOutputSwapChain::SetRecorder(CVideoOutputRecorder *inRecorder)
+{
+	::MPEnterCriticalRegion(mOutputLock, kDurationForever);
+	mRecorder = inRecorder;
+	::MPExitCriticalRegion(mOutputLock);
+}
+
+void CVideoOutputSwapChain::SetScopes(CVideoOutputScopes *inScopes)
+{
+	::MPEnterCriticalRegion(mOutputLock, kDurationForever);
+	mScopes = inScopes;
+	::MPExitCriticalRegion(mOutputLock);
+}
+
+void CVideoOutputSwapChain::SetLegalizer(CVideoOutputLegalizer *inLegalizer)
+{
+	::MPEnterCriticalRegion(mOutputLock, kDurationForever);
+	mLegalizer = inLegalizer;
+	::MPExitCriticalRegion(mOutputLock);
+}
+
+#pragma mark-
+
+OSErr CVideoOutputSwapChain::AcquireBuffer(SwapBufferRecord &outBuffer, Duration inTimeout)
+{
+	UInt16	 theIndex = 0;
+	OSStatus err;
+
+	// Once we're past this there's a free buffer with our name on it
+	err = ::MPWaitOnSemaphore(mFreeBuffers, inTimeout);
+	if (err) return err;
+
+	::MPEnterCriticalRegion(mLock, kDurationForever);
+	while (mBuffers[theIndex].state != eSwapBufferFree) theIndex++;
+	mBuffers[theIndex].state = eSwapBufferAcquired;
+	::MPExitCriticalRegion(mLock);
+
+	outBuffer.index = theIndex;
+	outBuffer.gWorld = mBuffers[theIndex].gWorld;
+	outBuffer.baseAddr = mBuffers[theIndex].baseAddr;
+	outBuffer.rowBytes = mBuffers[theIndex].rowBytes;
+	outBuffer.pixelFormat = mPixelFormat;
+	outBuffer.width = mWidth;
+	outBuffer.height = mHeight;
+
+	return noErr;
+}
+
+OSErr CVideoOutputSwapChain::PresentBuffer(UInt16 inIndex, UInt64 inDisplayTime)
+{
+	OSErr err = noErr;
+
+	if (inIndex >= mBufferCount) return paramErr;
+
+	::MPEnterCriticalRegion(mLock, kDurationForever);
+	if (mBuffers[inIndex].state == eSwapBufferAcquired) {
+		mBuffers[inIndex].state = eSwapBufferQueued;
+		mBuffers[inIndex].displayTime = inDisplayTime;
+		mBuffers[inIndex].sequence = mNextSequence++;
+	} else {
+		err = paramErr;
+	}
+	::MPExitCriticalRegion(mLock);
+
+	if (noErr == err) ::MPSignalSemaphore(mWakeOutput);
+
+	return err;
+}
+
+OSErr CVideoOutputSwapChain::CancelBuffer(UInt16 inIndex)
+{
+	OSErr err = noErr;
+
+	if (inIndex >= mBufferCount) return paramErr;
+
+	::MPEnterCriticalRegion(mLock, kDurationForever);
+	if (mBuffers[inIndex].state == eSwapBufferAcquired) {
+		mBuffers[inIndex].state = eSwapBufferFree;
+	} else {
+		err = paramErr;
+	}
+	::MPExitCriticalRegion(mLock);
+
+	if (noErr == err) ::MPSignalSemaphore(mFreeBuffers);
+
+	return err;
+}
+
+#pragma mark-
+
+OSStatus CVideoOutputSwapChain::OutputTask(void *inParameter)
+{
+	CVideoOutputSwapChain *pThis = static_cast<CVideoOutputSwapChain *>(inParameter);
+
+	while (!pThis->mQuit) {
+		// Sleeps until the next display time or until something else is presented, whichever is first
+		::MPWaitOnSemaphore(pThis->mWakeOutput, pThis->ShowDueBuffer());
+	}
+
+	::MPSignalSemaphore(pThis->mOutputDone);
+
+	return noErr;
+}
+
+// Shows the latest of the queued buffers whose time has come and frees any others which were due,
+// returns how long to wait for the next one
+Duration CVideoOutputSwapChain::ShowDueBuffer(void)
+{
+	UInt64	 theNow = GetCurrentTime();
+	UInt64	 theNext = 0;
+	SInt32	 theShow = -1;
+	UInt32	 theDropped = 0;
+	Duration theWait = kDurationForever;
+
+	::MPEnterCriticalRegion(mLock, kDurationForever);
+
+	for (UInt16 i = 0; i < mBufferCount; i++) {
+		const BufferRecord &theBuffer = mBuffers[i];
+
+		if (theBuffer.state != eSwapBufferQueued) continue;
+
+		if (theBuffer.displayTime <= theNow) {
+			if (theShow < 0 || theBuffer.displayTime > mBuffers[theShow].displayTime ||
+				(theBuffer.displayTime == mBuffers[theShow].displayTime && theBuffer.sequence > mBuffers[theShow].sequence)) theShow = i;
+		} else if (0 == theNext || theBuffer.displayTime < theNext) {
+			theNext = theBuffer.displayTime;
+		}
+	}
+
+	if (theShow >= 0) {
+		for (UInt16 i = 0; i < mBufferCount; i++) {
+			if (i != theShow && mBuffers[i].state == eSwapBufferQueued && mBuffers[i].displayTime <= theNow) {
+				mBuffers[i].state = eSwapBufferFree;
+				theDropped++;
+			}
+		}
+		mBuffers[theShow].state = eSwapBufferShowing;
+	}
+	mStats.dropped += theDropped;
+
+	::MPExitCriticalRegion(mLock);
+
+	for (UInt32 i = 0; i < theDropped; i++) ::MPSignalSemaphore(mFreeBuffers);
+
+	if (theShow >= 0) {
+		VIDEO_OUTPUT_TRACE_SCOPE("present");
+
+		// A showing buffer is ours alone, so the copy only keeps the legalizer, the recorder and the
+		// scopes from changing under it while clients carry on acquiring and presenting
+		::MPEnterCriticalRegion(mOutputLock, kDurationForever);
+		CopyToOutput(theShow);
+		if (mRecorder) mRecorder->WriteFrame(mBuffers[theShow].baseAddr, mBuffers[theShow].rowBytes, mRowLength, mHeight);
+		if (mScopes) mScopes->SampleFrame(mBuffers[theShow].baseAddr, mBuffers[theShow].rowBytes);
+		::MPExitCriticalRegion(mOutputLock);
+
+		::MPEnterCriticalRegion(mLock, kDurationForever);
+		mBuffers[theShow].state = eSwapBufferFree;
+		mStats.presented++;
+		::MPExitCriticalRegion(mLock);
+
+		::MPSignalSemaphore(mFreeBuffers);
+
+		theNow = GetCurrentTime();
+	}
+
+	// Negative durations are in microseconds
+	if (theNext) {
+		UInt64 theMicroseconds = (theNext > theNow) ? (theNext - theNow + 999) / 1000 : 0;
+		if (theMicroseconds > kMaxOutputWaitMicroseconds) theMicroseconds = kMaxOutputWaitMicroseconds;
+		theWait = theMicroseconds ? -(Duration)theMicroseconds : kDurationImmediate;
+	}
+
+	return theWait;
+}
+
+void CVideoOutputSwapChain::CopyToOutput(UInt16 inIndex)
+{
+	UInt8 *pSource = mBuffers[inIndex].baseAddr;
+	long  theSourceRowBytes = mBuffers[inIndex].rowBytes;
+	UInt8 *pDestination = mOutputBaseAddr;
+
+	VIDEO_OUTPUT_TRACE_SCOPE("copy");
+
+	if (mLegalizer) {
+		UInt32 theCorrected = 0;
+
+		// The row's in the cache from being legalized when it's copied
+		for (long y = 0; y < mHeight; y++) {
+			theCorrected += mLegalizer->LegalizeRect(pSource, theSourceRowBytes, pSource, theSourceRowBytes, mWidth / 2, 1);
+			::BlockMoveData(pSource, pDestination, mRowLength);
+			pSource += theSourceRowBytes;
+			pDestination += mOutputRowBytes;
+		}
+		mLegalizer->FrameDone(theCorrected);
+	} else if (theSourceRowBytes == mOutputRowBytes) {
+		::BlockMoveData(pSource, pDestination, mOutputRowBytes * mHeight);
+	} else {
+		for (long y = 0; y < mHeight; y++) {
+			::BlockMoveData(pSource, pDestination, mRowLength);
+			pSource += theSourceRowBytes;
+			pDestination += mOutputRowBytes;
+		}
+	}
+}
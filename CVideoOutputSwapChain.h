@@ -0,0 +1,208 @@
+/*
+	File:		 CVideoOutputSwapChain.h
+	
+	Description: A set of buffers the size and pixel format of a video output component's GWorld,
+				 used by the CVideoOutput class so frames can be drawn ahead on any thread and
+				 shown at the time they're meant for.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <5> 10/19/26 copy out without holding the buffer lock, the stats are locked
+										<4> 10/19/26 added SetLegalizer
+										<3> 10/19/26 added SetScopes
+										<2> 10/19/26 added SetRecorder
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputSwapChain( GWorldPtr inOutputGWorld, UInt16 inBufferCount )
+		Creates inBufferCount buffers (2 to kMaxSwapBuffers) shaped like inOutputGWorld and starts the
+		output task. Call from the main thread. Throws an OSStatus if the pixel format can't be made into
+		a GWorld or if Multiprocessing Services aren't available.
+
+	AcquireBuffer( SwapBufferRecord &outBuffer, Duration inTimeout = kDurationImmediate )
+		Hands out a free buffer to draw into, waiting up to inTimeout for one. Returns kMPTimeoutErr if
+		they're all in use. The pixels are locked so the buffer can be filled on any thread.
+
+	PresentBuffer( UInt16 inIndex, UInt64 inDisplayTime = 0 )
+		Queues an acquired buffer to go out at inDisplayTime, in nanoseconds since startup (see
+		GetCurrentTime()). 0 means as soon as possible. The output task copies it to the output GWorld
+		once its time comes and frees it again. When more than one buffer is due only the latest goes
+		out, the earlier ones are counted as dropped.
+
+	CancelBuffer( UInt16 inIndex )
+		Gives back an acquired buffer without showing it.
+
+	GetStats( SwapChainStatsRecord &outStats )
+		How many buffers have been presented and dropped so far.
+
+	GetCurrentTime( void )
+		Now, on the same time line as inDisplayTime.
+
+	SetRecorder( CVideoOutputRecorder *inRecorder )
+		Every buffer which goes out is also handed to inRecorder, pass NULL to stop. Once this returns
+		the output task is done with the previous recorder. The output task holds a lock of its own while
+		it copies a buffer out, so this waits for that but AcquireBuffer() and the rest never do.
+
+	SetScopes( CVideoOutputScopes *inScopes )
+		The same for the scopes, pass NULL to stop.
+
+	SetLegalizer( CVideoOutputLegalizer *inLegalizer )
+		Each buffer is legalized a row at a time as it's copied to the output GWorld, pass NULL to stop. The
+		row is legalized in the buffer so the recorder and the scopes get what went out.
+
+	AcquireBuffer(), PresentBuffer() and CancelBuffer() can be called from any thread.
+*/
+
+#ifndef __CVIDEOOUTPUTSWAPCHAIN_H__
+	#define __CVIDEOOUTPUTSWAPCHAIN_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <Multiprocessing.h>
+	#include <QDOffscreen.h>
+	#include <ImageCompression.h>
+#endif
+
+#include <memory>
+
+#include "CVideoOutputRecorder.h"
+#include "CVideoOutputScopes.h"
+#include "CVideoOutputLegalizer.h"
+
+namespace dts {
+
+const UInt16 kMaxSwapBuffers = 8;
+
+enum SwapBufferState {
+	eSwapBufferFree = 0,
+	eSwapBufferAcquired,	// a client is drawing into it
+	eSwapBufferQueued,		// waiting for its display time
+	eSwapBufferShowing		// being copied to the output GWorld
+};
+
+typedef struct {
+	UInt16		index;
+	GWorldPtr	gWorld;
+	UInt8		*baseAddr;
+	long		rowBytes;
+	OSType		pixelFormat;
+	long		width, height;
+} SwapBufferRecord;
+
+typedef struct {
+	UInt32	presented;
+	UInt32	dropped;		// a later buffer was due too
+} SwapChainStatsRecord;
+
+class CVideoOutputSwapChain {
+	public:
+		CVideoOutputSwapChain(GWorldPtr inOutputGWorld, UInt16 inBufferCount) throw(OSStatus);
+		~CVideoOutputSwapChain();
+
+		OSErr AcquireBuffer(SwapBufferRecord &outBuffer, Duration inTimeout = kDurationImmediate);
+		OSErr PresentBuffer(UInt16 inIndex, UInt64 inDisplayTime = 0);
+		OSErr CancelBuffer(UInt16 inIndex);
+
+		void  GetStats(SwapChainStatsRecord &outStats) const;
+		UInt16 GetBufferCount(void) const { return mBufferCount; }
+
+		void  SetRecorder(CVideoOutputRecorder *inRecorder);
+		void  SetScopes(CVideoOutputScopes *inScopes);
+		void  SetLegalizer(CVideoOutputLegalizer *inLegalizer);
+
+		static UInt64 GetCurrentTime(void);
+
+	private:
+		static OSStatus OutputTask(void *inParameter);
+		Duration ShowDueBuffer(void);
+		void	 CopyToOutput(UInt16 inIndex);
+		void	 Dispose(void);
+
+		// nope
+		CVideoOutputSwapChain(const CVideoOutputSwapChain &inSwapChain);
+		CVideoOutputSwapChain operator=(CVideoOutputSwapChain inSwapChain);
+
+	private:
+		typedef struct {
+			GWorldPtr		gWorld;
+			UInt8			*baseAddr;
+			long			rowBytes;
+			SwapBufferState	state;		// protected by mLock
+			UInt64			displayTime;
+			UInt32			sequence;	// order of presentation, breaks ties between equal times
+		} BufferRecord;
+
+		GWorldPtr			mOutputGWorld;
+		UInt8				*mOutputBaseAddr;
+		long				mOutputRowBytes;
+		long				mRowLength;			// bytes of pixels in a row
+		OSType				mPixelFormat;
+		long				mWidth, mHeight;
+
+		BufferRecord		mBuffers[kMaxSwapBuffers];
+		UInt16				mBufferCount;
+		UInt32				mNextSequence;
+
+		MPCriticalRegionID	mLock;
+		MPCriticalRegionID	mOutputLock;		// held while a buffer's copied out
+		MPSemaphoreID		mFreeBuffers;		// one count per free buffer
+		MPSemaphoreID		mWakeOutput;		// something was presented, or it's time to quit
+		MPSemaphoreID		mOutputDone;
+		MPTaskID			mOutputTask;
+		volatile Boolean	mQuit;
+		CVideoOutputRecorder *mRecorder;		// protected by mOutputLock
+		CVideoOutputScopes	 *mScopes;			// protected by mOutputLock
+		CVideoOutputLegalizer *mLegalizer;		// protected by mOutputLock
+
+		SwapChainStatsRecord mStats;			// protected by mLock
+};
+
+typedef std::auto_ptr<CVideoOutputSwapChain> CVideoOutputSwapChainPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTSWAPCHAIN_H__
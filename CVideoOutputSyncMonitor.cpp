@@ -0,0 +1,165 @@
+/*
+	File:		 CVideoOutputSyncMonitor.cpp
+	
+	Description: Audio / video sync measurement for the video output.
+				 See CVideoOutputSyncMonitor.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <1> 10/19/26 initial release
+*/
+
+#include <algorithm>
+
+#include "CVideoOutputSyncMonitor.h"
+
+using namespace dts;
+
+CVideoOutputSyncMonitor::CVideoOutputSyncMonitor(const Movie inMovie, UInt32 inThreshold, SyncEventProcPtr inEventProc, void *inRefCon, UInt32 inAudioLatency)
+	: mMovie(inMovie), mThreshold(inThreshold * 1000), mAudioLatency(inAudioLatency * 1000), mEventProc(inEventProc), mRefCon(inRefCon),
+	  mHasFrame(false), mFrameStart(0), mFrameEnd(0), mNextSample(0), mSampleCount(0), mSampleSum(0), mTotalSamples(0),
+	  mIsOutOfTolerance(false), mInToleranceRun(0), mOutOfToleranceCount(0)
+{
+}
+
+void CVideoOutputSyncMonitor::FramePresented(void)
+{
+	OSType	  theMediaType = VideoMediaType;
+	TimeValue theStart = -1, theDuration = 0;
+
+	// Back to the start of the video sample at the Movie time, then forward for its length
+	::GetMovieNextInterestingTime(mMovie, nextTimeMediaSample | nextTimeEdgeOK, 1, &theMediaType, ::GetMovieTime(mMovie, NULL), -fixed1, &theStart, NULL);
+	if (theStart < 0) return;
+
+	::GetMovieNextInterestingTime(mMovie, nextTimeMediaSample | nextTimeEdgeOK, 1, &theMediaType, theStart, fixed1, NULL, &theDuration);
+
+	mFrameStart = theStart;
+	mFrameEnd = theStart + theDuration;
+	mHasFrame = true;
+}
+
+void CVideoOutputSyncMonitor::Measure(void)
+{
+	Fixed	  theRate = ::GetMovieRate(mMovie);
+	TimeScale theScale = ::GetMovieTimeScale(mMovie);
+	SInt64	  theAudioTime, theFrameStart, theFrameEnd, theOffset = 0;
+
+	if (0 == theRate || 0 == theScale || !mHasFrame) return;
+
+	// In microseconds of Movie time, the latency is real time so it's scaled by the rate
+	theAudioTime = ((SInt64)::GetMovieTime(mMovie, NULL) * 1000000) / theScale - ((SInt64)mAudioLatency * theRate) / fixed1;
+	theFrameStart = ((SInt64)mFrameStart * 1000000) / theScale;
+	theFrameEnd = ((SInt64)mFrameEnd * 1000000) / theScale;
+
+	if (theAudioTime < theFrameStart) {
+		theOffset = theAudioTime - theFrameStart;
+	} else if (theAudioTime > theFrameEnd) {
+		theOffset = theAudioTime - theFrameEnd;
+	}
+
+	// Back to real time, which also turns it round when playing backwards
+	AddSample((SInt32)((theOffset * fixed1) / theRate));
+}
+
+void CVideoOutputSyncMonitor::AddSample(SInt32 inOffset)
+{
+	SyncEventRecord theEvent;
+	Boolean			isOver = (inOffset > mThreshold || -inOffset > mThreshold);
+
+	if (mSampleCount == kSyncWindowSize) {
+		mSampleSum -= mSamples[mNextSample];
+	} else {
+		mSampleCount++;
+	}
+
+	mSamples[mNextSample] = inOffset;
+	mSampleSum += inOffset;
+	mNextSample = (mNextSample + 1) % kSyncWindowSize;
+	mTotalSamples++;
+
+	if (isOver) {
+		mInToleranceRun = 0;
+
+		if (mIsOutOfTolerance) return;
+
+		mIsOutOfTolerance = true;
+		mOutOfToleranceCount++;
+		theEvent.kind = eSyncOutOfTolerance;
+	} else {
+		// One good measurement isn't enough to call it fixed
+		if (!mIsOutOfTolerance || ++mInToleranceRun < kSyncRecoverySamples) return;
+
+		mIsOutOfTolerance = false;
+		mInToleranceRun = 0;
+		theEvent.kind = eSyncInTolerance;
+	}
+
+	theEvent.offset = MicrosecondsToMilliseconds(inOffset);
+	if (mEventProc) mEventProc(theEvent, mRefCon);
+}
+
+/* GetStats
+		The percentile is found by partly sorting a copy of the window, it's only done when asked for
+		rather than for every measurement.
+*/
+void CVideoOutputSyncMonitor::GetStats(SyncStatsRecord &outStats) const
+{
+	SInt32 theSizes[kSyncWindowSize];
+	UInt32 theP99Index;
+
+	outStats.samples = mSampleCount;
+	outStats.totalSamples = mTotalSamples;
+	outStats.meanOffset = outStats.p99Offset = outStats.maxOffset = 0;
+	outStats.outOfToleranceCount = mOutOfToleranceCount;
+	outStats.isOutOfTolerance = mIsOutOfTolerance;
+
+	if (0 == mSampleCount) return;
+
+	outStats.meanOffset = MicrosecondsToMilliseconds(mSampleSum / (SInt64)mSampleCount);
+
+	for (UInt32 i = 0; i < mSampleCount; i++) theSizes[i] = (mSamples[i] < 0) ? -mSamples[i] : mSamples[i];
+
+	theP99Index = (mSampleCount * 99 + 99) / 100 - 1;
+	std::nth_element(theSizes, theSizes + theP99Index, theSizes + mSampleCount);
+	outStats.p99Offset = MicrosecondsToMilliseconds(theSizes[theP99Index]);
+	outStats.maxOffset = MicrosecondsToMilliseconds(*std::max_element(theSizes + theP99Index, theSizes + mSampleCount));
+}
@@ -0,0 +1,170 @@
+/*
+	File:		 CVideoOutputSyncMonitor.h
+	
+	Description: Keeps checking audio / video sync while a movie plays to the video output, with
+				 rolling statistics and a callback when the offset goes out of tolerance. Used by the
+				 CVideoOutput class.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <2> 10/19/26 added kSyncOutputLatency
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputSyncMonitor( const Movie inMovie, UInt32 inThreshold, SyncEventProcPtr inEventProc = NULL, void *inRefCon = NULL, UInt32 inAudioLatency = 0 )
+		inThreshold is the largest offset in milliseconds, either way, before inEventProc is called.
+		inAudioLatency is how long in milliseconds the sound output component takes to play a sample after
+		it's handed over, when it's known.
+
+	FramePresented( void )
+		Call when a frame has been written to the video output. Looks up the start and end of the video
+		sample at the Movie time, that's the frame on the output from now on.
+
+	Measure( void )
+		Call regularly while the Movie plays, every idle for example. The sound media handler hands the sound
+		output component samples in step with the Movie's time base, which runs on the master clock, so the
+		sound being heard is at the Movie time less inAudioLatency. The offset is how far that is outside the
+		frame on the output - 0 while it's inside, positive when the video is behind the sound and negative
+		when it's ahead - so it's measured to the frame, and a frame that stays up too long because drawing
+		was held up shows straight away. Nothing is measured while the Movie is stopped.
+
+	GetStats( SyncStatsRecord &outStats )
+		Statistics over the last kSyncWindowSize measurements. The mean keeps the sign so a steady lead or lag
+		shows, the 99th percentile and maximum are of the size of the offset.
+
+	The event proc is called with eSyncOutOfTolerance when a measurement goes over the threshold, and with
+	eSyncInTolerance once kSyncRecoverySamples measurements in a row are back within it. It's called from
+	Measure(), so on the thread that calls that.
+*/
+
+#ifndef __CVIDEOOUTPUTSYNCMONITOR_H__
+	#define __CVIDEOOUTPUTSYNCMONITOR_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <Movies.h>
+#endif
+
+#include <memory>
+
+namespace dts {
+
+const UInt32 kSyncWindowSize = 512;			// measurements the statistics cover, about 17 seconds of idles
+const UInt32 kSyncRecoverySamples = 15;
+const UInt32 kSyncDefaultThreshold = 45;	// milliseconds, about where a lag starts being noticed
+const UInt32 kSyncOutputLatency = 0xFFFFFFFF;	// ask the sound output component, see CVideoOutput::StartSyncMonitor()
+
+enum SyncEventKind {
+	eSyncOutOfTolerance = 1,
+	eSyncInTolerance
+};
+
+typedef struct {
+	SyncEventKind	kind;
+	Fixed			offset;			// milliseconds, the measurement that crossed the threshold
+} SyncEventRecord;
+
+typedef void (*SyncEventProcPtr)(const SyncEventRecord &inEvent, void *inRefCon);
+
+typedef struct {
+	UInt32	samples;			// in the window
+	UInt32	totalSamples;		// since the start
+	Fixed	meanOffset;			// milliseconds, + is video behind sound
+	Fixed	p99Offset;			// milliseconds
+	Fixed	maxOffset;			// milliseconds
+	UInt32	outOfToleranceCount;
+	Boolean	isOutOfTolerance;
+} SyncStatsRecord;
+
+class CVideoOutputSyncMonitor {
+	public:
+		CVideoOutputSyncMonitor(const Movie inMovie, UInt32 inThreshold, SyncEventProcPtr inEventProc = NULL, void *inRefCon = NULL, UInt32 inAudioLatency = 0);
+		~CVideoOutputSyncMonitor() {}
+
+		void FramePresented(void);
+		void Measure(void);
+
+		void GetStats(SyncStatsRecord &outStats) const;
+
+	private:
+		void AddSample(SInt32 inOffset);
+
+		static Fixed MicrosecondsToMilliseconds(SInt64 inMicroseconds) { return (Fixed)((inMicroseconds * fixed1) / 1000); }
+
+		// nope
+		CVideoOutputSyncMonitor(const CVideoOutputSyncMonitor &inMonitor);
+		CVideoOutputSyncMonitor operator=(CVideoOutputSyncMonitor inMonitor);
+
+	private:
+		Movie				mMovie;
+		SInt32				mThreshold;			// microseconds
+		SInt32				mAudioLatency;		// microseconds
+		SyncEventProcPtr	mEventProc;
+		void				*mRefCon;
+
+		// the frame on the output, in Movie time
+		Boolean				mHasFrame;
+		TimeValue			mFrameStart;
+		TimeValue			mFrameEnd;
+
+		// the last kSyncWindowSize offsets in microseconds
+		SInt32				mSamples[kSyncWindowSize];
+		UInt32				mNextSample;
+		UInt32				mSampleCount;
+		SInt64				mSampleSum;
+		UInt32				mTotalSamples;
+
+		Boolean				mIsOutOfTolerance;
+		UInt32				mInToleranceRun;
+		UInt32				mOutOfToleranceCount;
+};
+
+typedef std::auto_ptr<CVideoOutputSyncMonitor> CVideoOutputSyncMonitorPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTSYNCMONITOR_H__
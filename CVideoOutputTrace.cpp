@@ -0,0 +1,233 @@
+/*
+	File:		 CVideoOutputTrace.cpp
+	
+	Description: Pipeline stage tracing for the video output.
+				 See CVideoOutputTrace.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <1> 10/19/26 initial release
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CVideoOutputTrace.h"
+
+using namespace dts;
+
+volatile Boolean CVideoOutputTrace::sIsOn = false;
+UInt32 CVideoOutputTrace::sGeneration = 0;
+TaskStorageIndex CVideoOutputTrace::sStorageIndex = 0;
+CVideoOutputTrace::TraceBuffer *CVideoOutputTrace::sBuffers[kTraceMaxThreads];
+SInt32 CVideoOutputTrace::sThreadCount = 0;
+
+// A thread past kTraceMaxThreads is given this so it only looks once
+static const TaskStorageValue kNoTraceBuffer = (TaskStorageValue)1;
+
+OSErr CVideoOutputTrace::Start(void)
+{
+	static Boolean sHasStorageIndex = false;
+
+	if (!sHasStorageIndex) {
+		OSErr err = ::MPAllocateTaskStorageIndex(&sStorageIndex);
+		if (err) return err;
+
+		sHasStorageIndex = true;
+	}
+
+	// Each thread drops its old events the next time it records one
+	sIsOn = false;
+	sGeneration++;
+	sIsOn = true;
+
+	return noErr;
+}
+
+void CVideoOutputTrace::Stop(void)
+{
+	sIsOn = false;
+}
+
+void CVideoOutputTrace::AddEvent(const char *inName, UInt64 inStart, UInt64 inEnd)
+{
+	TraceBuffer *pBuffer = GetThreadBuffer();
+	if (NULL == pBuffer) return;
+
+	// Only this thread writes to its buffer
+	if (pBuffer->generation != sGeneration) {
+		pBuffer->generation = sGeneration;
+		pBuffer->count = 0;
+	}
+
+	TraceEventRecord &theEvent = pBuffer->events[pBuffer->count & (kTraceBufferEvents - 1)];
+
+	theEvent.name = inName;
+	theEvent.start = inStart;
+	theEvent.end = inEnd;
+
+	pBuffer->count++;
+}
+
+CVideoOutputTrace::TraceBuffer *CVideoOutputTrace::GetThreadBuffer(void)
+{
+	TaskStorageValue theValue = ::MPGetTaskStorageValue(sStorageIndex);
+
+	if (kNoTraceBuffer == theValue) return NULL;
+	if (theValue) return static_cast<TraceBuffer *>(theValue);
+
+	// First time on this thread, MPAllocateAligned can be called from any task where NewPtr can't
+	UInt32		 theThread = (UInt32)::IncrementAtomic(&sThreadCount);
+	TraceBuffer *pBuffer = NULL;
+
+	if (theThread < kTraceMaxThreads)
+		pBuffer = static_cast<TraceBuffer *>(::MPAllocateAligned(sizeof(TraceBuffer), kMPAllocateDefaultAligned, 0));
+
+	if (NULL == pBuffer) {
+		::MPSetTaskStorageValue(sStorageIndex, kNoTraceBuffer);
+		return NULL;
+	}
+
+	pBuffer->thread = theThread;
+	pBuffer->isMainThread = !::MPTaskIsPreemptive(::MPCurrentTaskID());
+	pBuffer->generation = sGeneration;
+	pBuffer->count = 0;
+
+	::MPSetTaskStorageValue(sStorageIndex, pBuffer);
+	sBuffers[theThread] = pBuffer;
+
+	return pBuffer;
+}
+
+#pragma mark-
+
+OSErr CVideoOutputTrace::WriteChromeTrace(const FSSpec &inFile)
+{
+	HFSUniStr255 theDataForkName;
+	FSRef		 theFileRef;
+	SInt16		 theFork = 0;
+	char		 *pBlock = NULL;
+	UInt32		 theUsed = 0;
+	Boolean		 isFirst = true;
+	char		 theText[256];
+	OSErr		 err;
+
+	err = ::FSpCreate(&inFile, FOUR_CHAR_CODE('ttxt'), FOUR_CHAR_CODE('TEXT'), smSystemScript);
+	if (err && err != dupFNErr) goto bail;
+
+	err = ::FSpMakeFSRef(&inFile, &theFileRef);
+	if (err) goto bail;
+
+	err = ::FSGetDataForkName(&theDataForkName);
+	if (err) goto bail;
+
+	err = ::FSOpenFork(&theFileRef, theDataForkName.length, theDataForkName.unicode, fsWrPerm, &theFork);
+	if (err) goto bail;
+
+	err = ::FSSetForkSize(theFork, fsFromStart, 0);
+	if (err) goto bail;
+
+	pBlock = ::NewPtr(kTraceWriteBlock);
+	if (NULL == pBlock) { err = ::MemError(); goto bail; }
+
+	err = WriteText(theFork, pBlock, theUsed, "{\"traceEvents\":[\n");
+	if (err) goto bail;
+
+	for (UInt32 i = 0; i < kTraceMaxThreads; i++) {
+		const TraceBuffer *pBuffer = sBuffers[i];
+		if (NULL == pBuffer || pBuffer->generation != sGeneration || 0 == pBuffer->count) continue;
+
+		// Name the thread's track, then its events oldest first, timestamps are in microseconds
+		if (pBuffer->isMainThread)
+			snprintf(theText, sizeof(theText), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"main\"}}",
+					 isFirst ? "" : ",\n", (unsigned long)pBuffer->thread);
+		else
+			snprintf(theText, sizeof(theText), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"task %lu\"}}",
+					 isFirst ? "" : ",\n", (unsigned long)pBuffer->thread, (unsigned long)pBuffer->thread);
+		isFirst = false;
+
+		err = WriteText(theFork, pBlock, theUsed, theText);
+		if (err) goto bail;
+
+		UInt32 theFirst = (pBuffer->count > kTraceBufferEvents) ? pBuffer->count - kTraceBufferEvents : 0;
+
+		for (UInt32 j = theFirst; j < pBuffer->count; j++) {
+			const TraceEventRecord &theEvent = pBuffer->events[j & (kTraceBufferEvents - 1)];
+			UInt64 theStart = ::UnsignedWideToUInt64(::AbsoluteToNanoseconds(::UInt64ToUnsignedWide(theEvent.start)));
+			UInt64 theEnd = ::UnsignedWideToUInt64(::AbsoluteToNanoseconds(::UInt64ToUnsignedWide(theEvent.end)));
+
+			snprintf(theText, sizeof(theText), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+					 theEvent.name, (unsigned long)pBuffer->thread, theStart / 1000.0, (theEnd - theStart) / 1000.0);
+
+			err = WriteText(theFork, pBlock, theUsed, theText);
+			if (err) goto bail;
+		}
+	}
+
+	err = WriteText(theFork, pBlock, theUsed, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	if (err) goto bail;
+
+	if (theUsed) err = ::FSWriteFork(theFork, fsAtMark, 0, theUsed, pBlock, NULL);
+
+bail:
+	if (pBlock) ::DisposePtr(pBlock);
+	if (theFork) ::FSCloseFork(theFork);
+
+	return err;
+}
+
+// Adds inText to the block, writing the block out first when it won't fit
+OSErr CVideoOutputTrace::WriteText(SInt16 inFork, char *ioBlock, UInt32 &ioUsed, const char *inText)
+{
+	UInt32 theLength = strlen(inText);
+	OSErr  err = noErr;
+
+	if (ioUsed + theLength > kTraceWriteBlock) {
+		err = ::FSWriteFork(inFork, fsAtMark, 0, ioUsed, ioBlock, NULL);
+		ioUsed = 0;
+	}
+
+	::BlockMoveData(inText, ioBlock + ioUsed, theLength);
+	ioUsed += theLength;
+
+	return err;
+}
@@ -0,0 +1,157 @@
+/*
+	File:		 CVideoOutputTrace.h
+	
+	Description: Timed trace points for the stages of the video output pipeline, recorded per thread and
+				 written out as a Chrome trace so a run can be looked at in chrome://tracing or Perfetto.
+				 Used by the CVideoOutput class and the classes it uses.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <1> 10/19/26 initial release
+
+*/
+
+/*
+	VIDEO_OUTPUT_TRACE_SCOPE(inName)
+		Times the rest of the enclosing block as a stage called inName, which must be a string constant.
+		While tracing is off this is one test of a global, and with VIDEO_OUTPUT_TRACE defined to 0 it's
+		nothing at all.
+
+	Start(void)
+		Turns tracing on, dropping anything recorded before. Each thread that gets to a trace point gets a
+		buffer of its own of kTraceBufferEvents events the first time, so recording takes no locks. When a
+		buffer's full the oldest events are overwritten. The buffers are kept until the application quits.
+
+	Stop(void)
+		Turns tracing off. The buffers are kept for WriteChromeTrace() and the next Start().
+
+	WriteChromeTrace(const FSSpec &inFile)
+		Writes what was recorded since Start() to inFile as Chrome trace event JSON, one track per thread,
+		which chrome://tracing and ui.perfetto.dev both open. Call after Stop(), a thread still recording
+		could be caught halfway through an event.
+*/
+
+#ifndef __CVIDEOOUTPUTTRACE_H__
+	#define __CVIDEOOUTPUTTRACE_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+#else
+	#include <Carbon.h>
+	#include <Multiprocessing.h>
+#endif
+
+// Define to 0 to compile the trace points out
+#ifndef VIDEO_OUTPUT_TRACE
+	#define VIDEO_OUTPUT_TRACE 1
+#endif
+
+#if VIDEO_OUTPUT_TRACE
+	#define VIDEO_OUTPUT_TRACE_SCOPE(inName) dts::CVideoOutputTraceScope theTraceScope(inName)
+#else
+	#define VIDEO_OUTPUT_TRACE_SCOPE(inName)
+#endif
+
+namespace dts {
+
+const UInt32 kTraceBufferEvents = 8192;		// per thread, about 190K each, a power of 2
+const UInt32 kTraceMaxThreads = 32;			// threads after this aren't traced
+const UInt32 kTraceWriteBlock = 32768;
+
+typedef struct {
+	const char	*name;
+	UInt64		start;						// UpTime()
+	UInt64		end;
+} TraceEventRecord;
+
+class CVideoOutputTrace {
+	public:
+		static OSErr Start(void);
+		static void	 Stop(void);
+		static Boolean IsOn(void) { return sIsOn; }
+
+		static OSErr WriteChromeTrace(const FSSpec &inFile);
+
+		static UInt64 GetTime(void) { return ::UnsignedWideToUInt64(::UpTime()); }
+		static void	  AddEvent(const char *inName, UInt64 inStart, UInt64 inEnd);
+
+	private:
+		struct TraceBuffer {
+			UInt32				thread;			// in the order they were made
+			Boolean				isMainThread;
+			UInt32				generation;		// the Start() the events are from
+			UInt32				count;			// events ever added this generation
+			TraceEventRecord	events[kTraceBufferEvents];
+		};
+
+		static TraceBuffer *GetThreadBuffer(void);
+		static OSErr WriteText(SInt16 inFork, char *ioBlock, UInt32 &ioUsed, const char *inText);
+
+		// nope
+		CVideoOutputTrace();
+
+	private:
+		static volatile Boolean sIsOn;
+		static UInt32			sGeneration;
+		static TaskStorageIndex sStorageIndex;	// each thread's TraceBuffer
+		static TraceBuffer		*sBuffers[kTraceMaxThreads];
+		static SInt32			sThreadCount;	// buffers claimed, can go past kTraceMaxThreads
+};
+
+class CVideoOutputTraceScope {
+	public:
+		CVideoOutputTraceScope(const char *inName) : mName(inName), mStart(CVideoOutputTrace::IsOn() ? CVideoOutputTrace::GetTime() : 0) {}
+		~CVideoOutputTraceScope() { if (mStart) CVideoOutputTrace::AddEvent(mName, mStart, CVideoOutputTrace::GetTime()); }
+
+	private:
+		// nope
+		CVideoOutputTraceScope(const CVideoOutputTraceScope &inScope);
+		CVideoOutputTraceScope operator=(CVideoOutputTraceScope inScope);
+
+	private:
+		const char	*mName;
+		UInt64		mStart;					// 0 when tracing was off
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTTRACE_H__
@@ -0,0 +1,124 @@
+/*
+	File:		 CVideoOutputTrackCatalog.cpp
+	
+	Description: Per Movie track catalog for the video output.
+				 See CVideoOutputTrackCatalog.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 keep the Movie's format
+										<2> 10/19/26 keep the sample size
+										<1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputTrackCatalog.h"
+
+using namespace dts;
+
+CVideoOutputTrackCatalog::CVideoOutputTrackCatalog(const Movie inMovie) throw(OSStatus)
+	: mMovie(inMovie), mTracks(NULL), mTrackCount(0), mHighestSampleRate(0), mHighestSampleSize(0), mHighestChannels(0),
+	  mIsHighQuality(false), mMovieFormatErr(noErr)
+{
+	SoundDescriptionHandle hSoundDesc = NULL;
+	long				   theTrackCount = ::GetMovieTrackCount(mMovie);
+
+	// Reads the sample description and for DV the first frame, so it's only done the once
+	mMovieFormatErr = CVideoOutputModeMatcher::GetMovieFormat(mMovie, mMovieFormat);
+
+	if (theTrackCount <= 0) return;
+
+	mTracks = (TrackInfoRecord *)::NewPtrClear(sizeof(TrackInfoRecord) * theTrackCount);
+	if (NULL == mTracks) throw (OSStatus)memFullErr;
+
+	// One handle for all the sound descriptions
+	hSoundDesc = (SoundDescriptionHandle)::NewHandle(0);
+	if (NULL == hSoundDesc) {
+		::DisposePtr((Ptr)mTracks);
+		throw (OSStatus)memFullErr;
+	}
+
+	for (long i = 1; i <= theTrackCount; i++) {
+		TrackInfoRecord &theInfo = mTracks[mTrackCount];
+
+		theInfo.track = ::GetMovieIndTrack(mMovie, i);
+		if (NULL == theInfo.track) continue;
+
+		theInfo.media = ::GetTrackMedia(theInfo.track);
+		theInfo.handler = ::GetMediaHandler(theInfo.media);
+		::GetMediaHandlerDescription(theInfo.media, &theInfo.mediaType, NULL, NULL);
+		theInfo.isEnabled = ::GetTrackEnabled(theInfo.track);
+		theInfo.isVisual = ::MediaHasCharacteristic(theInfo.media, VisualMediaCharacteristic);
+		::GetTrackDimensions(theInfo.track, &theInfo.width, &theInfo.height);
+
+		::GetTrackLoadSettings(theInfo.track, NULL, NULL, NULL, &theInfo.loadHints);
+		if (::GetMoviesError()) theInfo.loadHints = 0;
+
+		if (theInfo.mediaType == SoundMediaType) {
+			::GetMediaSampleDescription(theInfo.media, 1, (SampleDescriptionHandle)hSoundDesc);
+			if (noErr == ::GetMoviesError() && ::GetHandleSize((Handle)hSoundDesc) >= (long)sizeof(SoundDescription)) {
+				theInfo.sampleRate = (**hSoundDesc).sampleRate;
+				theInfo.sampleSize = (**hSoundDesc).sampleSize;
+				theInfo.channels = (**hSoundDesc).numChannels;
+			}
+
+			if (theInfo.sampleRate > mHighestSampleRate) mHighestSampleRate = theInfo.sampleRate;
+			if (theInfo.sampleSize > mHighestSampleSize) mHighestSampleSize = theInfo.sampleSize;
+			if (theInfo.channels > mHighestChannels) mHighestChannels = theInfo.channels;
+		}
+
+		if (theInfo.isEnabled && theInfo.isVisual && (theInfo.loadHints & hintsHighQuality)) mIsHighQuality = true;
+
+		mTrackCount++;
+	}
+
+	::DisposeHandle((Handle)hSoundDesc);
+}
+
+Track CVideoOutputTrackCatalog::FindTrack(OSType inMediaType, Boolean inEnabledOnly) const
+{
+	for (UInt32 i = 0; i < mTrackCount; i++) {
+		if (mTracks[i].mediaType == inMediaType && (mTracks[i].isEnabled || !inEnabledOnly))
+			return mTracks[i].track;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,154 @@
+/*
+	File:		 CVideoOutputTrackCatalog.h
+	
+	Description: What's in each track of a Movie, looked up once so Begin() and the rest don't have to walk
+				 the tracks again every time. Used by the CVideoOutput class.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <3> 10/19/26 keep the Movie's format, added GetMovieFormat and GetFieldOrder
+										<2> 10/19/26 added the sample size, GetHighestSampleSize and GetHighestChannels
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	CVideoOutputTrackCatalog(const Movie inMovie) throw(OSStatus)
+		Walks the tracks of inMovie once and keeps what it finds, media type, media handler, the sample rate,
+		sample size and channels of sound tracks, the default load hints and the track dimensions, and the Movie's
+		format from CVideoOutputModeMatcher::GetMovieFormat(). Nothing changes after
+		that, so make a new one if the tracks of the Movie are added, removed or enabled and disabled.
+		Throws memFullErr if there isn't the memory for it.
+
+	GetTrackCount(void)
+	GetTrack(UInt32 inIndex)
+		The tracks, from 0, in the order of GetMovieIndTrack().
+
+	FindTrack(OSType inMediaType, Boolean inEnabledOnly = true)
+		The first track of inMediaType, NULL if there isn't one.
+
+	GetHighestSampleRate(void)
+	GetHighestSampleSize(void)
+	GetHighestChannels(void)
+		The highest sample rate, sample size in bits and channel count of the sound tracks, 0 with no sound.
+
+	IsHighQuality(void)
+		true when any enabled visual track was saved with the High Quality hint on.
+
+	GetMovieFormat(MovieFormatRecord &outFormat)
+	GetFieldOrder(void)
+		The natural size, frame rate, field order and codec type of the first enabled video track as they
+		were when the catalog was made, GetMovieFormat returns the error working them out got then.
+*/
+
+#ifndef __CVIDEOOUTPUTTRACKCATALOG_H__
+	#define __CVIDEOOUTPUTTRACKCATALOG_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+	#include <QuickTime/QuickTime.h>
+#else
+	#include <Carbon.h>
+	#include <Movies.h>
+#endif
+
+#include <memory>
+
+#include "CVideoOutputModeMatcher.h"
+
+namespace dts {
+
+typedef struct {
+	Track			track;
+	Media			media;
+	MediaHandler	handler;
+	OSType			mediaType;
+	Boolean			isEnabled;
+	Boolean			isVisual;			// has VisualMediaCharacteristic
+	UnsignedFixed	sampleRate;			// sound tracks only, 0 otherwise
+	UInt16			sampleSize;			// bits, sound tracks only, 0 otherwise
+	UInt16			channels;			// sound tracks only, 0 otherwise
+	long			loadHints;			// the default hints from GetTrackLoadSettings()
+	Fixed			width;
+	Fixed			height;
+} TrackInfoRecord;
+
+class CVideoOutputTrackCatalog {
+	public:
+		CVideoOutputTrackCatalog(const Movie inMovie) throw(OSStatus);
+		~CVideoOutputTrackCatalog() { if (mTracks) ::DisposePtr((Ptr)mTracks); }
+
+		Movie  GetMovie(void) const { return mMovie; }
+		UInt32 GetTrackCount(void) const { return mTrackCount; }
+		const TrackInfoRecord &GetTrack(UInt32 inIndex) const { return mTracks[inIndex]; }
+
+		Track		  FindTrack(OSType inMediaType, Boolean inEnabledOnly = true) const;
+		UnsignedFixed GetHighestSampleRate(void) const { return mHighestSampleRate; }
+		UInt16		  GetHighestSampleSize(void) const { return mHighestSampleSize; }
+		UInt16		  GetHighestChannels(void) const { return mHighestChannels; }
+		Boolean		  IsHighQuality(void) const { return mIsHighQuality; }
+
+		OSErr		  GetMovieFormat(MovieFormatRecord &outFormat) const { outFormat = mMovieFormat; return mMovieFormatErr; }
+		FieldOrder	  GetFieldOrder(void) const { return mMovieFormat.fieldOrder; }
+
+	private:
+		// nope
+		CVideoOutputTrackCatalog(const CVideoOutputTrackCatalog &inCatalog);
+		CVideoOutputTrackCatalog operator=(CVideoOutputTrackCatalog inCatalog);
+
+	private:
+		Movie				mMovie;
+		TrackInfoRecord		*mTracks;
+		UInt32				mTrackCount;
+		UnsignedFixed		mHighestSampleRate;
+		UInt16				mHighestSampleSize;
+		UInt16				mHighestChannels;
+		Boolean				mIsHighQuality;
+		MovieFormatRecord	mMovieFormat;
+		OSErr				mMovieFormatErr;
+};
+
+typedef std::auto_ptr<CVideoOutputTrackCatalog> CVideoOutputTrackCatalogPtr;
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTTRACKCATALOG_H__
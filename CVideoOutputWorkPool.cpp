@@ -0,0 +1,339 @@
+/*
+	File:		 CVideoOutputWorkPool.cpp
+	
+	Description: A pool of MP tasks shared by all the parallel work.
+				 See CVideoOutputWorkPool.h for more information.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <5> 10/19/26 added Start and Finish, free tasks go to the job with the fewest helping
+										<4> 10/19/26 tasks take whichever range of a job is free next
+										<3> 10/19/26 added trace points
+										<2> 10/19/26 work stealing, limit the tasks used by a job
+										<1> 10/19/26 initial release
+*/
+
+#include "CVideoOutputWorkPool.h"
+#include "CVideoOutputTrace.h"
+
+using namespace dts;
+
+CVideoOutputWorkPool *CVideoOutputWorkPool::sSharedPool = NULL;
+
+static inline UInt32 RangeFirst(UInt32 inRange) { return inRange >> 16; }
+static inline UInt32 RangeEnd(UInt32 inRange) { return inRange & 0xFFFF; }
+static inline UInt32 MakeRange(UInt32 inFirst, UInt32 inEnd) { return (inFirst << 16) | inEnd; }
+
+static Boolean HasItems(WorkJobPtr inJob)
+{
+	for (UInt32 i = 0; i < inJob->taskCount; i++) {
+		UInt32 theRange = *(volatile UInt32 *)&inJob->ranges[i];
+		if (RangeFirst(theRange) < RangeEnd(theRange)) return true;
+	}
+
+	return false;
+}
+
+CVideoOutputWorkPool *CVideoOutputWorkPool::GetSharedPool(void)
+{
+	if (NULL == sSharedPool && ::MPLibraryIsLoaded()) {
+		try {
+			// The thread calling Run() does its share, so one task less than there are processors
+			UInt32 theProcessors = ::MPProcessors();
+			if (theProcessors > kMaxWorkTasks) theProcessors = kMaxWorkTasks;
+			sSharedPool = new CVideoOutputWorkPool((theProcessors > 1) ? theProcessors - 1 : 0);
+		}
+		catch (...) {
+			sSharedPool = NULL;
+		}
+	}
+
+	return sSharedPool;
+}
+
+CVideoOutputWorkPool::CVideoOutputWorkPool(UInt32 inWorkerCount) throw(OSStatus) : mWorkerCount(0), mWorkers(NULL), mWorkAvailable(0),
+																					 mJobsLock(0), mJobs(NULL), mQuit(false)
+{
+	OSStatus err;
+
+	err = ::MPCreateSemaphore(0xFFFFFFFF, 0, &mWorkAvailable);
+	if (err) goto bail;
+
+	err = ::MPCreateCriticalRegion(&mJobsLock);
+	if (err) goto bail;
+
+	if (inWorkerCount) {
+		mWorkers = (WorkTaskPtr)::NewPtrClear(sizeof(WorkTaskRecord) * inWorkerCount);
+		if (NULL == mWorkers) { err = ::MemError(); goto bail; }
+	}
+
+	for (UInt32 i = 0; i < inWorkerCount; i++) {
+		mWorkers[i].pool = this;
+
+		err = ::MPCreateTask(WorkerTask, &mWorkers[i], 0, 0, NULL, NULL, 0, &mWorkers[i].task);
+		if (err) break;
+		mWorkerCount++;
+	}
+
+	// Carry on with fewer tasks if we couldn't get them all
+	return;
+
+bail:
+	if (mJobsLock) ::MPDeleteCriticalRegion(mJobsLock);
+	if (mWorkAvailable) ::MPDeleteSemaphore(mWorkAvailable);
+	if (mWorkers) ::DisposePtr((Ptr)mWorkers);
+
+	throw err;
+}
+
+CVideoOutputWorkPool::~CVideoOutputWorkPool()
+{
+	mQuit = true;
+	for (UInt32 i = 0; i < mWorkerCount; i++) ::MPSignalSemaphore(mWorkAvailable);
+	for (UInt32 i = 0; i < mWorkerCount; i++) ::MPTerminateTask(mWorkers[i].task, noErr);
+
+	::MPDeleteCriticalRegion(mJobsLock);
+	::MPDeleteSemaphore(mWorkAvailable);
+	if (mWorkers) ::DisposePtr((Ptr)mWorkers);
+}
+
+OSErr CVideoOutputWorkPool::Run(WorkProcPtr inProc, void *inRefCon, UInt32 inItemCount, UInt32 inMaxTasks)
+{
+	WorkJobRecord theJob;
+	OSErr		  err;
+
+	err = Start(theJob, inProc, inRefCon, inItemCount, inMaxTasks);
+	if (err) return err;
+
+	Finish(theJob);
+
+	return noErr;
+}
+
+OSErr CVideoOutputWorkPool::Start(WorkJobRecord &outJob, WorkProcPtr inProc, void *inRefCon, UInt32 inItemCount, UInt32 inMaxTasks)
+{
+	UInt32	 theTaskCount = mWorkerCount + 1;
+	OSStatus err;
+
+	outJob.itemCount = 0;
+	outJob.itemsDone = 0;
+	outJob.isQueued = false;
+
+	if (0 == inItemCount) return noErr;
+	if (inItemCount > kMaxWorkItems) return paramErr;
+
+	if (inMaxTasks && inMaxTasks < theTaskCount) theTaskCount = inMaxTasks;
+	if (inItemCount < theTaskCount) theTaskCount = inItemCount;
+
+	outJob.proc = inProc;
+	outJob.refCon = inRefCon;
+	outJob.itemCount = inItemCount;
+	outJob.taskCount = theTaskCount;
+	outJob.rangesTaken = 1;
+	outJob.tasksActive = 0;
+	outJob.next = NULL;
+
+	// An even share each to start with
+	for (UInt32 i = 0; i < kMaxWorkTasks; i++) {
+		outJob.ranges[i] = (i < theTaskCount) ? MakeRange(inItemCount * i / theTaskCount, inItemCount * (i + 1) / theTaskCount) : 0;
+	}
+
+	// Nobody to hand it to
+	if (1 == theTaskCount) {
+		DoItems(&outJob, 0);
+		return noErr;
+	}
+
+	err = ::MPCreateSemaphore(1, 0, &outJob.doneSemaphore);
+	if (err) { outJob.itemCount = 0; return err; }
+
+	::MPEnterCriticalRegion(mJobsLock, kDurationForever);
+	{ // gcc complains without this in brackets
+		WorkJobPtr *ppJob = &mJobs;
+		while (*ppJob) ppJob = &(*ppJob)->next;
+		*ppJob = &outJob;
+	}
+	::MPExitCriticalRegion(mJobsLock);
+	outJob.isQueued = true;
+
+	for (UInt32 i = 1; i < theTaskCount; i++) ::MPSignalSemaphore(mWorkAvailable);
+
+	return noErr;
+}
+
+void CVideoOutputWorkPool::Finish(WorkJobRecord &ioJob)
+{
+	if (!ioJob.isQueued) return;
+
+	// Range 0 is ours, the tasks may have had it all already
+	DoItems(&ioJob, 0);
+
+	// Whoever finishes the last item signals, wait for it even if that was us
+	::MPWaitOnSemaphore(ioJob.doneSemaphore, kDurationForever);
+
+	::MPEnterCriticalRegion(mJobsLock, kDurationForever);
+	{ // gcc complains without this in brackets
+		WorkJobPtr *ppJob = &mJobs;
+		while (*ppJob != &ioJob) ppJob = &(*ppJob)->next;
+		*ppJob = ioJob.next;
+	}
+	::MPExitCriticalRegion(mJobsLock);
+
+	// Once it's off the list no new task can pick the job up, but one may still be looking for
+	// something to steal and the job is the caller's. AddAtomic so the read is a barrier too
+	while (::AddAtomic(0, &ioJob.tasksActive)) ::MPYield();
+
+	::MPDeleteSemaphore(ioJob.doneSemaphore);
+	ioJob.isQueued = false;
+}
+
+#pragma mark-
+
+// Take the item at the front of our own range
+Boolean CVideoOutputWorkPool::PopItem(WorkJobPtr inJob, UInt32 inRange, UInt32 &outItem)
+{
+	UInt32 *pRange = &inJob->ranges[inRange];
+	UInt32 theRange;
+
+	do {
+		theRange = *(volatile UInt32 *)pRange;
+		if (RangeFirst(theRange) >= RangeEnd(theRange)) return false;
+	} while (!::CompareAndSwap(theRange, MakeRange(RangeFirst(theRange) + 1, RangeEnd(theRange)), pRange));
+
+	outItem = RangeFirst(theRange);
+
+	return true;
+}
+
+// Take the back half of the next range with anything left in it, the first of the stolen items is
+// returned and the rest become our range - which is empty or we wouldn't be stealing
+Boolean CVideoOutputWorkPool::StealItem(WorkJobPtr inJob, UInt32 inRange, UInt32 &outItem)
+{
+	for (UInt32 i = 1; i < inJob->taskCount; i++) {
+		UInt32 *pVictim = &inJob->ranges[(inRange + i) % inJob->taskCount];
+		UInt32 theRange, theSplit = 0;
+
+		do {
+			theRange = *(volatile UInt32 *)pVictim;
+			if (RangeFirst(theRange) >= RangeEnd(theRange)) break;
+			theSplit = RangeEnd(theRange) - (RangeEnd(theRange) - RangeFirst(theRange) + 1) / 2;
+		} while (!::CompareAndSwap(theRange, MakeRange(RangeFirst(theRange), theSplit), pVictim));
+
+		if (RangeFirst(theRange) < RangeEnd(theRange)) {
+			UInt32 *pOwn = &inJob->ranges[inRange];
+			UInt32 theOwn;
+
+			do {
+				theOwn = *(volatile UInt32 *)pOwn;
+			} while (!::CompareAndSwap(theOwn, MakeRange(theSplit + 1, RangeEnd(theRange)), pOwn));
+
+			outItem = theSplit;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void CVideoOutputWorkPool::DoItems(WorkJobPtr inJob, UInt32 inRange)
+{
+	UInt32 theItem;
+
+	VIDEO_OUTPUT_TRACE_SCOPE("work");
+
+	while (PopItem(inJob, inRange, theItem) || StealItem(inJob, inRange, theItem)) {
+		inJob->proc(inJob->refCon, theItem);
+
+		// IncrementAtomic returns the old value, the last one done lets Finish() return
+		if ((UInt32)::IncrementAtomic(&inJob->itemsDone) + 1 == inJob->itemCount && inJob->taskCount > 1)
+			::MPSignalSemaphore(inJob->doneSemaphore);
+	}
+}
+
+// Of the jobs with items left and a range nobody has taken yet, the one with the fewest tasks on it
+// so every session's frame gets its share, and the range becomes ours. It goes to the back of the
+// list so the next free task looks at the other jobs first when it's a tie
+WorkJobPtr CVideoOutputWorkPool::NextJob(UInt32 &outRange)
+{
+	WorkJobPtr *ppJob, *ppBest = NULL, pJob = NULL;
+
+	::MPEnterCriticalRegion(mJobsLock, kDurationForever);
+
+	for (ppJob = &mJobs; *ppJob; ppJob = &(*ppJob)->next) {
+		if ((UInt32)(*ppJob)->rangesTaken < (*ppJob)->taskCount && HasItems(*ppJob) &&
+			(NULL == ppBest || (*ppJob)->rangesTaken < (*ppBest)->rangesTaken)) ppBest = ppJob;
+	}
+
+	if (ppBest) {
+		ppJob = ppBest;
+		pJob = *ppJob;
+		outRange = pJob->rangesTaken++;
+		::IncrementAtomic(&pJob->tasksActive);
+
+		*ppJob = pJob->next;
+		pJob->next = NULL;
+		while (*ppJob) ppJob = &(*ppJob)->next;
+		*ppJob = pJob;
+	}
+
+	::MPExitCriticalRegion(mJobsLock);
+
+	return pJob;
+}
+
+OSStatus CVideoOutputWorkPool::WorkerTask(void *inParameter)
+{
+	WorkTaskPtr			 pTask = (WorkTaskPtr)inParameter;
+	CVideoOutputWorkPool *pPool = pTask->pool;
+	WorkJobPtr			 pJob;
+	UInt32				 theRange;
+
+	while (::MPWaitOnSemaphore(pPool->mWorkAvailable, kDurationForever) == noErr && !pPool->mQuit) {
+		while ((pJob = pPool->NextJob(theRange))) {
+			DoItems(pJob, theRange);
+			::DecrementAtomic(&pJob->tasksActive);
+		}
+	}
+
+	return noErr;
+}
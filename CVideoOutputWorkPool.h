@@ -0,0 +1,165 @@
+/*
+	File:		 CVideoOutputWorkPool.h
+	
+	Description: A pool of MP tasks, one per processor, shared by everything that can split its work
+				 into independent items - DV video segments being the main customer.
+
+	Author:		QuickTime DTS
+				
+	Version:	1.0
+
+	Copyright: 	© Copyright 2026 Apple Computer, Inc. All rights reserved.
+	
+	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+				("Apple") in consideration of your agreement to the following terms, and your
+				use, installation, modification or redistribution of this Apple software
+				constitutes acceptance of these terms.  If you do not agree with these terms,
+				please do not use, install, modify or redistribute this Apple software.
+
+				In consideration of your agreement to abide by the following terms, and subject
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
+				copyrights in this original Apple software (the "Apple Software"), to use,
+				reproduce, modify and redistribute the Apple Software, with or without
+				modifications, in source and/or binary forms; provided that if you redistribute
+				the Apple Software in its entirety and without modifications, you must retain
+				this notice and the following text and disclaimers in all such redistributions of
+				the Apple Software.  Neither the name, trademarks, service marks or logos of
+				Apple Computer, Inc. may be used to endorse or promote products derived from the
+				Apple Software without specific prior written permission from Apple.  Except as
+				expressly stated in this notice, no other rights or licenses, express or implied,
+				are granted by Apple herein, including but not limited to any patent rights that
+				may be infringed by your derivative works or by other works in which the Apple
+				Software may be incorporated.
+
+				The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+				WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+				WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+				PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+				COMBINATION WITH YOUR PRODUCTS.
+
+				IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+				CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+				GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+				ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+				OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+				
+	Change History (most recent first): <4> 10/19/26 added Start and Finish, free tasks go to the job with the fewest helping
+										<3> 10/19/26 tasks take whichever range of a job is free next
+										<2> 10/19/26 work stealing, limit the tasks used by a job
+										<1> 10/19/26 initial release
+
+*/
+
+/*
+	GetSharedPool( void )
+		Returns the application wide pool, creating it the first time. Call it from the main thread
+		before using the pool from anywhere else. Returns NULL if Multiprocessing Services aren't available,
+		callers should then just do the work themselves.
+
+	Run( WorkProcPtr inProc, void *inRefCon, UInt32 inItemCount, UInt32 inMaxTasks = 0 )
+		Calls inProc(inRefCon, item) for every item from 0 to inItemCount - 1 and returns when they've all
+		been done. The items are split into a contiguous range per task, the calling thread being one of
+		them. Each task works through its own range from the front, and once it runs out steals half of
+		what's left at the back of another range, so nobody needs a lock to get the next item. inMaxTasks
+		limits how many tasks, the calling thread included, take part - 0 means all of them. Any free task
+		can take part, it's handed the next range of the job nobody has taken yet.
+		Any number of threads can call Run at once. A free task goes to the job with the fewest tasks on it,
+		so a job started on every task can't keep the others waiting for a turn.
+
+	Start( WorkJobRecord &outJob, WorkProcPtr inProc, void *inRefCon, UInt32 inItemCount, UInt32 inMaxTasks = 0 )
+	Finish( WorkJobRecord &ioJob )
+		Run in two halves. Start queues the job for the MP tasks and returns straight away, they do all of
+		it between them if nobody else is busy. Finish does what's left on the calling thread and returns
+		when every item has been done. outJob is the pool's until then so it mustn't move or go out of scope,
+		and Finish must be called for every job that was started. Without any MP tasks Start does the lot.
+
+	IsFinished( const WorkJobRecord &inJob )
+		True once every item has been done, Finish then just takes the job off the list.
+
+	GetWorkerCount( void )
+		The number of MP tasks, the calling thread makes one more.
+*/
+
+#ifndef __CVIDEOOUTPUTWORKPOOL_H__
+	#define __CVIDEOOUTPUTWORKPOOL_H__
+
+#if __APPLE_CC__ || __MACH__
+	#include <Carbon/Carbon.h>
+#else
+	#include <Carbon.h>
+	#include <Multiprocessing.h>
+#endif
+
+namespace dts {
+
+// The calling thread plus the MP tasks
+const UInt32 kMaxWorkTasks = 16;
+
+// Ranges of items are packed first << 16 | end so they can be swapped atomically
+const UInt32 kMaxWorkItems = 0xFFFF;
+
+typedef void (*WorkProcPtr)(void *inRefCon, UInt32 inItem);
+
+typedef struct WorkJobRecord {
+	WorkProcPtr		proc;
+	void			*refCon;
+	UInt32			itemCount;
+	UInt32			taskCount;				// ranges in use
+	UInt32			ranges[kMaxWorkTasks];	// atomic, range 0 belongs to the calling thread
+	SInt32			rangesTaken;			// protected by the pool lock, the next free range
+	SInt32			itemsDone;				// atomic
+	SInt32			tasksActive;			// atomic, MP tasks still looking at the job
+	MPSemaphoreID	doneSemaphore;
+	Boolean			isQueued;				// on the list until Finish()
+	WorkJobRecord	*next;					// protected by the pool lock
+} WorkJobRecord, *WorkJobPtr;
+
+class CVideoOutputWorkPool;
+
+typedef struct {
+	CVideoOutputWorkPool	*pool;
+	MPTaskID				task;
+} WorkTaskRecord, *WorkTaskPtr;
+
+class CVideoOutputWorkPool {
+	public:
+		static CVideoOutputWorkPool *GetSharedPool(void);
+
+		OSErr  Run(WorkProcPtr inProc, void *inRefCon, UInt32 inItemCount, UInt32 inMaxTasks = 0);
+		OSErr  Start(WorkJobRecord &outJob, WorkProcPtr inProc, void *inRefCon, UInt32 inItemCount, UInt32 inMaxTasks = 0);
+		void   Finish(WorkJobRecord &ioJob);
+		static Boolean IsFinished(const WorkJobRecord &inJob) { return *(volatile UInt32 *)&inJob.itemsDone >= inJob.itemCount; }
+		UInt32 GetWorkerCount(void) const { return mWorkerCount; }
+
+	private:
+		explicit CVideoOutputWorkPool(UInt32 inWorkerCount) throw(OSStatus);
+		~CVideoOutputWorkPool();
+
+		static OSStatus WorkerTask(void *inParameter);
+
+		static Boolean PopItem(WorkJobPtr inJob, UInt32 inRange, UInt32 &outItem);
+		static Boolean StealItem(WorkJobPtr inJob, UInt32 inRange, UInt32 &outItem);
+		static void	   DoItems(WorkJobPtr inJob, UInt32 inRange);
+
+		WorkJobPtr NextJob(UInt32 &outRange);
+
+		// nope
+		CVideoOutputWorkPool(const CVideoOutputWorkPool &inPool);
+		CVideoOutputWorkPool operator=(CVideoOutputWorkPool inPool);
+
+	private:
+		static CVideoOutputWorkPool *sSharedPool;
+
+		UInt32				mWorkerCount;
+		WorkTaskPtr			mWorkers;
+		MPSemaphoreID		mWorkAvailable;
+		MPCriticalRegionID	mJobsLock;
+		WorkJobPtr			mJobs;
+		Boolean				mQuit;
+};
+
+} // namespace
+
+#endif // __CVIDEOOUTPUTWORKPOOL_H__
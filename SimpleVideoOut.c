@@ -10,7 +10,7 @@
 	
 	Version:	2.0.6
 
-	Copyright: 	 Copyright 2000 - 2005 Apple Computer, Inc. All rights reserved.
+	Copyright: 	© Copyright 2000 - 2005 Apple Computer, Inc. All rights reserved.
 	
 	Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
 				("Apple") in consideration of your agreement to the following terms, and your
@@ -19,7 +19,7 @@
 				please do not use, install, modify or redistribute this Apple software.
 
 				In consideration of your agreement to abide by the following terms, and subject
-				to these terms, Apple grants you a personal, non-exclusive license, under Apples
+				to these terms, Apple grants you a personal, non-exclusive license, under AppleÕs
 				copyrights in this original Apple software (the "Apple Software"), to use,
 				reproduce, modify and redistribute the Apple Software, with or without
 				modifications, in source and/or binary forms; provided that if you redistribute
@@ -47,7 +47,25 @@
 				(INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
 				ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 				
-	Change History (most recent first): <6> 07/15/03 added oDoc and respect the highQuality hint to 
+	Change History (most recent first): <24> 10/19/26 the idle finishes the DV frame still being encoded before MCIdle
+										<23> 10/19/26 Benchmark DV stops with an alert when the codecs' round trip check fails
+										<22> 10/19/26 sessions' DV frames are decoded side by side on the work pool
+										<21> 10/19/26 the video output's errors go in the alert instead of stderr
+										<20> 10/19/26 a trace that can't be written is put up in an alert
+										<19> 10/19/26 no more idle rate debug output
+										<18> 10/19/26 DV streams are indexed so cueing goes by their own timecode
+										<17> 10/19/26 Benchmark DV runs the decoder too
+										<16> 10/19/26 hold down option at launch for a Benchmark DV item in the File menu
+										<15> 10/19/26 IsHighQualityOn reads the track catalog
+										<14> 10/19/26 kTraceRun writes a trace of the video output pipeline
+										<13> 10/19/26 log the video output's errors to stderr when it won't begin
+										<12> 10/19/26 begin the video output on the device task, the UI carries on meanwhile
+										<11> 10/19/26 open any number of movies, each in its own session
+										<10> 10/19/26 idle when the movie needs it instead of 30 times a second
+										<9> 10/19/26 present DV frames decoded in place from the idle timer
+										<8> 10/19/26 high quality when the fields can go straight out
+										<7> 10/19/26 open the movie first and preselect the best matching display mode
+										<6> 07/15/03 added oDoc and respect the highQuality hint to 
 													 make jmb happy and added Close to make gd happy
 										<5> 09/25/02 fixed Clock UI to always reflect correct state 
 										<4> 06/14/02 added ability to turn VOut off, minor UI changes
@@ -66,8 +84,11 @@
 #endif
 
 #include <new> // for std::nothrow
+#include <stdio.h>
+#include <string.h>
 
 #include "CVideoOutput.h"
+#include "CVideoOutputTrace.h"
 
 using namespace dts;
 
@@ -94,9 +115,19 @@ const short kHighQOnID		= 13;
 const short kHighQOffID		= 14;
 const short kVOSelectID		= 16;
 
-const EventTime kMCIdleDuration = kEventDurationSecond / 30;
+const EventTime kMCIdleDuration = kEventDurationSecond / 30;	// without QuickTime 6 we poll at this rate
+const long		kQTVersion6 = 0x0600;
+const EventTime kBeginTimeout = kEventDurationSecond * 10;		// a device that takes longer than this isn't coming back
+const Boolean	kTraceRun = false;								// write a Chrome trace of the run to the desktop on quit
+const unsigned char kTraceFileName[] = "\pSimpleVideoOut Trace.json";
+const MenuCommand kBenchmarkCommand = FOUR_CHAR_CODE('DVbm');	// debug item, File menu with option down at launch
+const UInt32	kBenchmarkFrames = 100;
 
-typedef struct {
+// A session is one movie playing out its own video output, they all run off the main event loop
+// each with its own idle timer and share the CVideoOutputWorkPool for the heavy lifting. The Movie's
+// drawing and PresentFrame() only start a DV frame on the pool and the next idle finishes it, so the
+// sessions' frames are encoded and decoded side by side and the pool gives each its share of the tasks
+typedef struct WindowDataRecord {
 	WindowRef			theWindow;
 	Movie				theMovie;
 	MovieController		theController;
@@ -104,10 +135,15 @@ typedef struct {
 	MenuRef				thePopupMenuRef;
  	short				theMCHeight;
  	EventLoopTimerRef	theTimerRef;
+ 	Fixed				thePlayRate;		// to restart with after menu tracking
+ 	struct WindowDataRecord *next;
 } WindowDataRecord, *WindowDataRecordPtr;
 
 // Globals
-static WindowDataRecord gGlobals = { NULL };
+static WindowDataRecordPtr gSessions = NULL;
+static MenuRef			gPopupMenuRef = NULL;		// every session gets its own copy
+static Boolean			gIsAdaptiveIdle = false;	// QuickTime 6 can tell us when it next needs time
+static QTNextTaskNeededSoonerCallbackUPP gNextTaskNeededSoonerUPP = NULL;
 static BitMap			gScreenBits;
 static short			gFileMenuID = 0;
 
@@ -115,13 +151,24 @@ int   main( void );
 void  Initialize( void );
 OSErr DoOpen( ConstFSSpecPtr inFSSpecPtr, WindowDataRecordPtr inUserDataPtr );
 OSErr StartVideoOutput( WindowDataRecordPtr inUserDataPtr );
+void  VideoOutputBegun( WindowDataRecordPtr inUserDataPtr );
 OSErr DoOpenMovieFromFile( ConstFSSpecPtr inFSSpecPtr, WindowDataRecordPtr inUserDataPtr );
 OSErr DoCreateMovieController( WindowDataRecordPtr inUserDataPtr );
 void  DoError( const unsigned char inErrorText[] );
-Boolean IsHighQualityOn( Movie inMovie );
+void  ReportVideoOutputErrors( WindowDataRecordPtr inUserDataPtr, const unsigned char inErrorText[] );
+void  WriteTrace( void );
+void  DoBenchmark( void );
+Boolean IsHighQualityOn( CVideoOutput *inVideoOutput );
 void  SetMCEchoOffWindowSize( WindowDataRecordPtr inUserDataPtr );
 void  SetMCResizeBounds( WindowDataRecordPtr inUserDataPtr, Boolean inResizeable );
 void  SetMCPopupMenuState( WindowDataRecordPtr inUserDataPtr, short inState );
+void  ScheduleNextIdle( WindowDataRecordPtr inUserDataPtr );
+void  WakeIdleTimer( WindowDataRecordPtr inUserDataPtr );
+WindowDataRecordPtr NewSession( void );
+void  DisposeSession( WindowDataRecordPtr inUserDataPtr );
+WindowDataRecordPtr FindSession( WindowRef inWindow );
+void  CloseSession( WindowDataRecordPtr inUserDataPtr );
+OSErr DoOpenSession( ConstFSSpecPtr inFSSpecPtr );
 
 /* HandleAEOpenApplication
 		Open Application Event handler
@@ -130,7 +177,7 @@ static pascal OSErr HandleAEOpenApplication( const AppleEvent *theAppleEvent, Ap
 {
 #pragma unused(theAppleEvent, reply, handlerRefcon)
 	
-	return ( DoOpen( NULL, &gGlobals ) );
+	return ( DoOpenSession( NULL ) );
 }
 
 /* HandleAEOpenDocument
@@ -149,9 +196,6 @@ static pascal OSErr HandleAEOpenDocuments( const AppleEvent *theAppleEvent, Appl
 
  	OSErr		err = noErr;
  	
- 	// only one document at a time
- 	if ( gGlobals.theWindow ) return paramErr;
- 	
  	// get the direct parameter and put it into theDocList
  	theDocList.dataHandle = NULL;
  	err = AEGetParamDesc( theAppleEvent, keyDirectObject, typeAEList, &theDocList );
@@ -160,15 +204,15 @@ static pascal OSErr HandleAEOpenDocuments( const AppleEvent *theAppleEvent, Appl
  	if ( noErr == err )
  		err = AECountItems( &theDocList, &numItems );
   	
-  	// need at least one, cuz we only grab the first
-  	if ( numItems > 0 ) {
-  		err = AEGetNthPtr( &theDocList, 1, typeFSS, &theKeyWord, &theTypeCode, (Ptr)&theFSSpec, sizeof(FSSpec), &theActualSize );
+  	// a session for each one
+  	for ( long i = 1; noErr == err && i <= numItems; i++ ) {
+  		err = AEGetNthPtr( &theDocList, i, typeFSS, &theKeyWord, &theTypeCode, (Ptr)&theFSSpec, sizeof(FSSpec), &theActualSize );
 		if ( noErr == err ) {
 			Boolean canOpenAsMovie;
 			
 			err = CanQuickTimeOpenFile( &theFSSpec, 0, 0, NULL, &canOpenAsMovie, NULL, 0 );
 			if ( noErr == err && true == canOpenAsMovie ) {
-				err = DoOpen( &theFSSpec, &gGlobals );
+				err = DoOpenSession( &theFSSpec );
 			}
 		}
 	}
@@ -277,6 +321,7 @@ static pascal Boolean myMCActionFilterWithRefConProc( MovieController theMC, sho
 			SetMCResizeBounds( pUserData, true );
 			MCDoAction( theMC, mcActionControllerSizeChanged, 0 );
 			MCMovieChanged( theMC, pUserData->theMovie );
+			pUserData->pVideoOutput->CancelAsync();
 			pUserData->pVideoOutput->End();
 			SetMCPopupMenuState( pUserData, kVOutOffID );
 			break;
@@ -306,7 +351,7 @@ static pascal Boolean myMCActionFilterWithRefConProc( MovieController theMC, sho
 			break;
 		} // switch
 		
-		SetEventLoopTimerNextFireTime( pUserData->theTimerRef, kMCIdleDuration );
+		WakeIdleTimer( pUserData );
 			
 		isHandled = true;
 		break;
@@ -317,7 +362,12 @@ static pascal Boolean myMCActionFilterWithRefConProc( MovieController theMC, sho
 		SizeWindow( pUserData->theWindow, theMCBoundsRect.right, theMCBoundsRect.bottom, true );
 		AlignWindow( pUserData->theWindow, false, NULL, NULL );
 		break;
+	case mcActionIdle:
+	case mcActionDraw:
+		break;
 	default:
+		// Play, step, go to time and friends, whatever it was the movie may need time sooner than we planned
+		WakeIdleTimer( pUserData );
 		break;
 			
 	} // switch
@@ -325,8 +375,23 @@ static pascal Boolean myMCActionFilterWithRefConProc( MovieController theMC, sho
 	return isHandled;	
 }
 
+/* myNextTaskNeededSoonerProc
+		QuickTime calls this when something, a rate change, a clock or a callback, needs time before
+		the wakeup we last scheduled.
+*/
+static pascal void myNextTaskNeededSoonerProc( TimeValue inDuration, unsigned long inFlags, void *inRefcon )
+{
+#pragma unused(inFlags)
+
+	WindowDataRecordPtr pUserData = (WindowDataRecordPtr)inRefcon;
+	if ( pUserData == NULL || pUserData->theTimerRef == NULL ) return;
+	
+	SetEventLoopTimerNextFireTime( pUserData->theTimerRef, inDuration ? inDuration * kEventDurationMillisecond : kEventDurationNoWait );
+}
+
 /* myMovieControllerIdleTimer
-		Idle timer to give time to the MovieController.
+		Idle timer to give time to the MovieController. With QuickTime 6 the timer is rescheduled
+		after every idle for when the movie next needs time, so a stopped movie doesn't wake us at all.
 */
 static pascal void myMovieControllerIdleTimer(EventLoopTimerRef inTimer, void *inUserData)
 {
@@ -335,7 +400,19 @@ static pascal void myMovieControllerIdleTimer(EventLoopTimerRef inTimer, void *i
 	WindowDataRecordPtr pUserData = (WindowDataRecordPtr)inUserData;
 	if ( pUserData->theController == NULL ) return;
 	
+	// the frame left on the work pool last time, before the movie draws over what it's reading
+	pUserData->pVideoOutput->FinishFrame();
+	
+  {	// the Movie Toolbox reads, decodes, draws and hands the sound over in here
+	VIDEO_OUTPUT_TRACE_SCOPE( "movie task" );
 	MCIdle( pUserData->theController );
+  }
+	
+	// When DV is decoded straight into the video output GWorld or the frame rate is converted the
+	// movie doesn't draw the output frame, we do
+	pUserData->pVideoOutput->PresentFrame();
+	
+	ScheduleNextIdle( pUserData );
 }
 
 /* myWindowEventHandler
@@ -349,8 +426,6 @@ static pascal OSStatus myWindowEventHandler(EventHandlerCallRef inHandlerCallRef
 	UInt32 theEventKind = GetEventKind(inEvent);
 	
 	OSStatus status = eventNotHandledErr;
-	
-	static Fixed thePlayRate = 0;
 
 	WindowDataRecordPtr pUserData = (WindowDataRecordPtr)inUserData;
 	if ( pUserData == NULL ) return status;
@@ -368,8 +443,11 @@ static pascal OSStatus myWindowEventHandler(EventHandlerCallRef inHandlerCallRef
 		// before shutting down the video output or bad things could happen
 		pUserData->pVideoOutput->SetEchoPort( GetWindowPort(pUserData->theWindow) );
 		MCMovieChanged( pUserData->theController, pUserData->theMovie );
-		pUserData->pVideoOutput->End();
 		
+		// Close rather than End, a Begin still on the device task has to be undone while we have the movie
+		pUserData->pVideoOutput->Close();
+		
+		if ( gIsAdaptiveIdle ) QTUninstallNextTaskNeededSoonerCallback( gNextTaskNeededSoonerUPP, pUserData );
 		RemoveEventLoopTimer( pUserData->theTimerRef );
 		DisposeMovieController( pUserData->theController );
 		DisposeMovie( pUserData->theMovie );
@@ -379,22 +457,18 @@ static pascal OSStatus myWindowEventHandler(EventHandlerCallRef inHandlerCallRef
 		pUserData->theController = NULL;
 		pUserData->theMCHeight = 0;
 		pUserData->theTimerRef = NULL;
+		DisposeSession( pUserData );
 		status = noErr;
 		break;
-	case kEventWindowActivated:
-		MCDoAction( pUserData->theController, mcActionPlay, (Ptr)thePlayRate );
-		SetEventLoopTimerNextFireTime( pUserData->theTimerRef, kMCIdleDuration );
-		goto passEventToController;
-	case kEventWindowDeactivated:
-		MCDoAction( pUserData->theController, mcActionGetPlayRate, &thePlayRate );
-		MCDoAction( pUserData->theController, mcActionPlay, 0 );
-		SetEventLoopTimerNextFireTime( pUserData->theTimerRef, kEventDurationForever );
-		// fall through
-	passEventToController:
 	default:
+		// The other sessions keep playing while we're in back, so activates just go to the controller
 		EventRecord theEvent;
 		ConvertEventRefToEventRecord( inEvent, &theEvent );
-		if ( MCIsPlayerEvent( pUserData->theController, &theEvent )) status = noErr;
+		if ( MCIsPlayerEvent( pUserData->theController, &theEvent )) {
+			// the controller did something with it, give the movie time now rather than when we planned
+			WakeIdleTimer( pUserData );
+			status = noErr;
+		}
 		break;
 	}
 	
@@ -413,10 +487,7 @@ static pascal OSStatus myApplicationEventHandler( EventHandlerCallRef inHandlerC
 	
 	OSStatus status	= eventNotHandledErr;
 	
-	static Fixed thePlayRate = 0;
-	
-	WindowDataRecordPtr pUserData = (WindowDataRecordPtr)inUserData;
-	if ( pUserData == NULL ) return status;
+	WindowDataRecordPtr pUserData;
 	
 	switch ( theEventClass ) {
 	case kEventClassCommand:	
@@ -430,23 +501,26 @@ static pascal OSStatus myApplicationEventHandler( EventHandlerCallRef inHandlerC
 				status = noErr;
 				break;
 			case kHICommandOpen:
-				status = DoOpen( NULL, pUserData );
+				status = DoOpenSession( NULL );
+				break;
+			case kBenchmarkCommand:
+				DoBenchmark();
+				status = noErr;
 				break;
 			case kHICommandClose:
-				// If the window is open tell it to close
-				if ( pUserData->theWindow ) {
-					EventRef theWindowCloseEvent;
-					CreateEvent( NULL, kEventClassWindow, kEventWindowClose, 0, kEventAttributeNone, &theWindowCloseEvent );
-					SendEventToEventTarget( theWindowCloseEvent, GetWindowEventTarget( pUserData->theWindow ) );
-					ReleaseEvent( theWindowCloseEvent );
-				}
+				// If the front window is one of ours tell it to close
+				pUserData = FindSession( FrontNonFloatingWindow() );
+				if ( pUserData ) CloseSession( pUserData );
 				status = noErr;
 				break;
 			case kHICommandQuit:
 			{ // gcc complains without this in brackets
-				HICommand theCommand = { kEventAttributeNone, kHICommandClose };
-
-				ProcessHICommand( &theCommand );
+				// Closing a session takes it off the list
+				WindowDataRecordPtr pNextUserData;
+				for ( pUserData = gSessions; pUserData; pUserData = pNextUserData ) {
+					pNextUserData = pUserData->next;
+					if ( pUserData->theWindow ) CloseSession( pUserData );
+				}
 				
 				QuitApplicationEventLoop();
 				status = noErr;
@@ -464,19 +538,21 @@ static pascal OSStatus myApplicationEventHandler( EventHandlerCallRef inHandlerC
 		
 		switch ( theEventKind ) {
 		case kEventMenuBeginTracking:
-			if ( pUserData->theController ) {
-				// If the movie is playing, stop it during menu tracking then start it
-				// up again or bad things can happen under 9
-				MCDoAction( pUserData->theController, mcActionGetPlayRate, &thePlayRate );
+			// If the movies are playing, stop them during menu tracking then start them
+			// up again or bad things can happen under 9
+			for ( pUserData = gSessions; pUserData; pUserData = pUserData->next ) {
+				if ( pUserData->theController == NULL ) continue;
+				MCDoAction( pUserData->theController, mcActionGetPlayRate, &pUserData->thePlayRate );
 				MCDoAction( pUserData->theController, mcActionPlay, 0 );
 				SetEventLoopTimerNextFireTime( pUserData->theTimerRef, kEventDurationForever );
 				status = noErr;
 			}
 			break;
 		case kEventMenuEndTracking:
-			if ( pUserData->theController ) {
-				MCDoAction( pUserData->theController, mcActionPlay, (Ptr)thePlayRate );
-				SetEventLoopTimerNextFireTime( pUserData->theTimerRef, kMCIdleDuration );
+			for ( pUserData = gSessions; pUserData; pUserData = pUserData->next ) {
+				if ( pUserData->theController == NULL ) continue;
+				MCDoAction( pUserData->theController, mcActionPlay, (Ptr)pUserData->thePlayRate );
+				WakeIdleTimer( pUserData );
 				status = noErr;
 			}
 			break;
@@ -484,10 +560,9 @@ static pascal OSStatus myApplicationEventHandler( EventHandlerCallRef inHandlerC
 			if ( GetMenuRef( gFileMenuID ) == theMenuRef ) {
                 WindowRef theDocumentWindowRef = GetFrontWindowOfClass( kDocumentWindowClass, true );
                 WindowRef theFrontNonFloatingWindowRef = FrontNonFloatingWindow();
-				if ( pUserData->theWindow &&
-                     pUserData->theWindow == theDocumentWindowRef &&
-                     pUserData->theWindow == theFrontNonFloatingWindowRef ) {
-					DisableMenuItem( theMenuRef, kOpenID );
+				pUserData = FindSession( theFrontNonFloatingWindowRef );
+				if ( pUserData && pUserData->theWindow == theDocumentWindowRef ) {
+					EnableMenuItem( theMenuRef, kOpenID );
 					EnableMenuItem( theMenuRef, kCloseID );
 				} else if ( theFrontNonFloatingWindowRef == NULL ) {
 					EnableMenuItem( theMenuRef, kOpenID );
@@ -519,33 +594,120 @@ void DoError( const unsigned char inErrorText[] )
 	StopAlert( kAlert, NULL );
 }
 
+/* ReportVideoOutputErrors
+		Display error alert, inErrorText says what we were trying to do and the video output's error log
+		what went wrong on the way, oldest first for as much as fits.
+*/
+void ReportVideoOutputErrors( WindowDataRecordPtr inUserDataPtr, const unsigned char inErrorText[] )
+{
+	ErrorEventRecord theEvents[kErrorLogSize];
+	UInt32			 theCount = inUserDataPtr->pVideoOutput->GetErrorLog().GetEvents( theEvents, kErrorLogSize );
+	char			 theText[256];
+	size_t			 theLength;
+	Str255			 theMessage;
+	
+	CopyPascalStringToC( inErrorText, theText );
+	
+	// The first error is usually the one that matters, the rest follow from it
+	while ( theCount-- ) {
+		OSType theOperation = EndianU32_NtoB( theEvents[theCount].operation );
+		OSType theSubType = EndianU32_NtoB( theEvents[theCount].componentSubType );
+		
+		theLength = strlen( theText );
+		if ( snprintf( theText + theLength, sizeof(theText) - theLength, " '%.4s' on '%.4s' error %d.",
+					   (char *)&theOperation, (char *)&theSubType, theEvents[theCount].error ) >= (int)( sizeof(theText) - theLength ) ) {
+			theText[theLength] = 0;
+			break;
+		}
+	}
+	CopyCStringToPascal( theText, theMessage );
+	
+	ParamText( theMessage, NULL, NULL, NULL );
+	StopAlert( kAlert, NULL );
+}
+
+/* WriteTrace
+		Stops the trace and writes it to the desktop, open it in chrome://tracing or ui.perfetto.dev.
+*/
+void WriteTrace( void )
+{
+	FSSpec theFile;
+	SInt16 theVRefNum;
+	SInt32 theDirID;
+	OSErr  err;
+	
+	CVideoOutputTrace::Stop();
+	
+	err = FindFolder( kOnSystemDisk, kDesktopFolderType, kCreateFolder, &theVRefNum, &theDirID );
+	if ( err ) goto bail;
+	
+	err = FSMakeFSSpec( theVRefNum, theDirID, kTraceFileName, &theFile );
+	if ( err && err != fnfErr ) goto bail;
+	
+	err = CVideoOutputTrace::WriteChromeTrace( theFile );
+	
+bail:
+	if ( err ) DoError( "\pCould not write the trace to the desktop..." );
+}
+
+/* DoBenchmark
+		Runs the DV encoder and decoder flat out on the shared work pool, on one task and on all of them,
+		and puts the frame rates up in an alert. Nothing else should be playing while it runs. The
+		benchmarks check the codecs' round trip first and a failed check gets a stop alert of its own.
+*/
+void DoBenchmark( void )
+{
+	DVBenchmarkRecord theEncodeOne, theEncodeAll, theDecodeOne, theDecodeAll;
+	char			  theText[256];
+	Str255			  theMessage;
+	OSErr			  err;
+	
+	// The decoder's figures are reported even when the encoder's check stops it running
+	memset( &theDecodeOne, 0, sizeof(theDecodeOne) );
+	
+	SetThemeCursor( kThemeWatchCursor );
+	
+	err = CVideoOutputDVEncoder::Benchmark( eDVSystem525_60, kBenchmarkFrames, 1, theEncodeOne );
+	if ( noErr == err ) err = CVideoOutputDVEncoder::Benchmark( eDVSystem525_60, kBenchmarkFrames, 0, theEncodeAll );
+	if ( noErr == err ) err = CVideoOutputDVDecoder::Benchmark( eDVSystem525_60, kBenchmarkFrames, 1, theDecodeOne );
+	if ( noErr == err ) err = CVideoOutputDVDecoder::Benchmark( eDVSystem525_60, kBenchmarkFrames, 0, theDecodeAll );
+	
+	SetThemeCursor( kThemeArrowCursor );
+	
+	if ( codecBadDataErr == err ) {
+		snprintf( theText, sizeof(theText), "The DV round trip check FAILED. The encoded frame's layout is %s, decoded it's Y' %.1f dB (%.0f needed), CbCr %.1f dB (%.0f needed).",
+				  theEncodeOne.isFormatOK ? "right" : "WRONG", theDecodeOne.lumaPSNR, kDVMinLumaPSNR, theDecodeOne.chromaPSNR, kDVMinChromaPSNR );
+		CopyCStringToPascal( theText, theMessage );
+		
+		ParamText( theMessage, NULL, NULL, NULL );
+		StopAlert( kAlert, NULL );
+		return;
+	}
+	if ( err ) {
+		DoError( "\pThe DV benchmark couldn't run..." );
+		return;
+	}
+	
+	snprintf( theText, sizeof(theText), "DV 525/60 encodes %.1f fps on 1 task, %.1f fps on %lu (%.1f streams). It decodes %.1f fps on 1 task, %.1f fps on %lu (%.1f streams). Round trip Y' %.1f dB, CbCr %.1f dB.",
+			  theEncodeOne.framesPerSecond, theEncodeAll.framesPerSecond, (unsigned long)theEncodeAll.processors, theEncodeAll.realtimeStreams,
+			  theDecodeOne.framesPerSecond, theDecodeAll.framesPerSecond, (unsigned long)theDecodeAll.processors, theDecodeAll.realtimeStreams,
+			  theDecodeOne.lumaPSNR, theDecodeOne.chromaPSNR );
+	CopyCStringToPascal( theText, theMessage );
+	
+	ParamText( theMessage, NULL, NULL, NULL );
+	NoteAlert( kAlert, NULL );
+}
+
 /* IsHighQualityOn
 		Figure out if any visual tracks in the movie were saved with the
 	High Quality hint on. If so turn on the HighQuality play hint for the movie.
+	The video output's track catalog already has the hints of every track.
 */
-Boolean IsHighQualityOn( Movie inMovie )
+Boolean IsHighQualityOn( CVideoOutput *inVideoOutput )
 {
-	Track theTrack;
-	UInt8 theCount;
-	Boolean rc = false;
-	
-	theCount = GetMovieTrackCount( inMovie );
-	
-	while ( theCount ) {
-		// get an enabled visual track
-   		theTrack = GetMovieIndTrackType( inMovie, theCount--, VisualMediaCharacteristic, movieTrackCharacteristic | movieTrackEnabledOnly ); 
-   		if ( theTrack ) {
-   			long theDefaultHints;
-   			GetTrackLoadSettings( theTrack, NULL, NULL, NULL, &theDefaultHints );
-			if ( !GetMoviesError() )
-				if ( theDefaultHints & hintsHighQuality ) {
-					rc = true;
-					break;
-				}
-			}
-	}
+	const CVideoOutputTrackCatalog *pCatalog = inVideoOutput->GetTrackCatalog();
 	
-	return rc;
+	return ( pCatalog && pCatalog->IsHighQuality() );
 }
 
 /* SetMCEchoOffWindowSize
@@ -726,6 +888,37 @@ void SetMCPopupMenuState( WindowDataRecordPtr inUserDataPtr, short inState )
 	
 }
 
+/* ScheduleNextIdle
+		Sets the idle timer to fire when the movie next needs time, the sooner of what QuickTime tells
+		us and the next frame PresentFrame() has to deal with. Stopped with nothing pending that's
+		effectively never, QuickTime calls myNextTaskNeededSoonerProc if that changes. Without QuickTime 6
+		the timer keeps its fixed kMCIdleDuration interval.
+*/
+void ScheduleNextIdle( WindowDataRecordPtr inUserDataPtr )
+{
+	long theDuration = 0;
+	long theFrameDuration;
+	
+	if ( !gIsAdaptiveIdle || inUserDataPtr->theTimerRef == NULL ) return;
+	
+	if ( QTGetTimeUntilNextTask( &theDuration, 1000 ) ) theDuration = 1000 / 30;
+	
+	if ( inUserDataPtr->pVideoOutput->GetTimeUntilNextFrame( theFrameDuration ) && theFrameDuration < theDuration )
+		theDuration = theFrameDuration;
+	
+	SetEventLoopTimerNextFireTime( inUserDataPtr->theTimerRef, theDuration > 0 ? theDuration * kEventDurationMillisecond : kEventDurationNoWait );
+}
+
+/* WakeIdleTimer
+		Idle as soon as we get back to the event loop, the idle then works out the next wakeup.
+*/
+void WakeIdleTimer( WindowDataRecordPtr inUserDataPtr )
+{
+	if ( inUserDataPtr->theTimerRef == NULL ) return;
+	
+	SetEventLoopTimerNextFireTime( inUserDataPtr->theTimerRef, kEventDurationNoWait );
+}
+
 /* Initialize
 		Yer basic init stuff, if any of this fails we ask for our bill
 		and take the express elevator straight to hell - ya, let Bishop go.
@@ -755,6 +948,8 @@ void Initialize( void )
 		ExitToShell();
 	}
 
+	gIsAdaptiveIdle = ( ( result >> 16 ) >= kQTVersion6 );
+	
 	// Remember to call EnterMovies even on X!
 	EnterMovies();
 	GetQDGlobalsScreenBits( &gScreenBits );
@@ -772,6 +967,16 @@ void Initialize( void )
 			
 		if ( theMenuBar ) {
 			SetMenuBar( theMenuBar );
+			
+			// The benchmark is for us, not for everyone
+			if ( GetCurrentKeyModifiers() & optionKey ) {
+				MenuRef theFileMenuRef = GetMenuRef( gFileMenuID );
+				
+				AppendMenu( theFileMenuRef, "\p-" );
+				AppendMenu( theFileMenuRef, "\pBenchmark DV" );
+				SetMenuItemCommandID( theFileMenuRef, CountMenuItems( theFileMenuRef ), kBenchmarkCommand );
+			}
+			
 			DrawMenuBar();
 		} else {
 			DoError( "\pCould not load menu bar..." );
@@ -782,20 +987,13 @@ void Initialize( void )
 		ExitToShell();
 	}
 	
-	// Get the movie controller CustomPopup menu
-	gGlobals.thePopupMenuRef = GetMenu( kPopupMenu );
-	if ( gGlobals.thePopupMenuRef == NULL ) {
+	// Get the movie controller CustomPopup menu, each session works on a copy
+	gPopupMenuRef = GetMenu( kPopupMenu );
+	if ( gPopupMenuRef == NULL ) {
 		DoError( "\pCould not load menu resource..." );
 		ExitToShell();
 	}
 	
-	// Instantiate a VideoOutput object without a specific Movie
-	gGlobals.pVideoOutput = new(std::nothrow) CVideoOutput( "\pSimpleVideoOut" );
-	if ( gGlobals.pVideoOutput == NULL || gGlobals.pVideoOutput->GetError() ) {
-		DoError( "\pProblem initializing CVideoOutput, or component unavailable..." );
-		ExitToShell();
-	}
-	
 	// Install the Apple event handlers
 	result = AEInstallEventHandler( kCoreEventClass, kAEOpenApplication, NewAEEventHandlerUPP(HandleAEOpenApplication), 0, false );
 	if ( result ) { DoError( "\pProblem installing kAEOpenApplication Handler..." ); ExitToShell(); }
@@ -807,7 +1005,7 @@ void Initialize( void )
 	if ( result ) { DoError( "\pProblem installing kAEQuitApplication Handler..." ); ExitToShell(); }
 	
 	if ( InstallStandardEventHandler( GetApplicationEventTarget() )) { DoError( "\pProblem installing Standard App. Event Handler..." ); ExitToShell(); }
-    if ( InstallApplicationEventHandler( NewEventHandlerUPP( myApplicationEventHandler ), GetEventTypeCount( theEventTypes ), theEventTypes, &gGlobals, &theEventRef )) {
+    if ( InstallApplicationEventHandler( NewEventHandlerUPP( myApplicationEventHandler ), GetEventTypeCount( theEventTypes ), theEventTypes, NULL, &theEventRef )) {
     	DoError( "\pProblem installing Application Event Handler..." );
     	ExitToShell();
     }
@@ -824,6 +1022,8 @@ OSErr DoOpenMovieFromFile( ConstFSSpecPtr inFSSpecPtr, WindowDataRecordPtr inUse
 	Rect  theWindowRect = { 50, 20, 300, 300 };
 	Rect  theMovieBox;
 	short theMovieRefNum;
+	FInfo theFileInfo;
+	const unsigned char *pName = inFSSpecPtr->name;
 	
 	OSErr rc = noErr;
 	
@@ -832,6 +1032,10 @@ OSErr DoOpenMovieFromFile( ConstFSSpecPtr inFSSpecPtr, WindowDataRecordPtr inUse
 	if ( inUserDataPtr->theWindow == NULL ) rc = errInvalidWindowRef;
 	if ( rc ) goto bail;
 	
+	// Don't open right on top of the last one
+	if ( inUserDataPtr->next && inUserDataPtr->next->theWindow )
+		RepositionWindow( inUserDataPtr->theWindow, inUserDataPtr->next->theWindow, kWindowCascadeOnParentWindow );
+	
 	SetWTitle( inUserDataPtr->theWindow, inFSSpecPtr->name );
 	SetPortWindowPort( inUserDataPtr->theWindow );
 	
@@ -851,6 +1055,12 @@ OSErr DoOpenMovieFromFile( ConstFSSpecPtr inFSSpecPtr, WindowDataRecordPtr inUse
 	// Tell the output component about the movie
 	inUserDataPtr->pVideoOutput->SetMovie( inUserDataPtr->theMovie );
 	
+	// A raw DV stream gets indexed, the first time it's opened that reads the whole file. It's only
+	// for cueing by timecode so carry on without one
+	if ( ( FSpGetFInfo( inFSSpecPtr, &theFileInfo ) == noErr && theFileInfo.fdType == kQTFileTypeDVC ) ||
+		 ( pName[0] > 3 && pName[pName[0] - 2] == '.' && ( pName[pName[0] - 1] | 0x20 ) == 'd' && ( pName[pName[0]] | 0x20 ) == 'v' ) )
+		inUserDataPtr->pVideoOutput->OpenDVIndex( *inFSSpecPtr );
+	
 bail:
 	return rc;
 }
@@ -907,13 +1117,54 @@ OSErr DoCreateMovieController( WindowDataRecordPtr inUserDataPtr )
 	rc = MCSetActionFilterWithRefCon( inUserDataPtr->theController, NewMCActionFilterWithRefConUPP( myMCActionFilterWithRefConProc ), (long)inUserDataPtr );
 	if ( rc ) goto bail;
 	rc = InstallEventLoopTimer( GetMainEventLoop(), kEventDurationNoWait, kMCIdleDuration, NewEventLoopTimerUPP( myMovieControllerIdleTimer ), inUserDataPtr, &inUserDataPtr->theTimerRef );
+	if ( rc ) goto bail;
+	
+	if ( gIsAdaptiveIdle ) {
+		if ( gNextTaskNeededSoonerUPP == NULL ) gNextTaskNeededSoonerUPP = NewQTNextTaskNeededSoonerCallbackUPP( myNextTaskNeededSoonerProc );
+		
+		// if we can't hear about it sooner we can't sleep, so fall back to polling
+		if ( QTInstallNextTaskNeededSoonerCallback( gNextTaskNeededSoonerUPP, 1000, 0, inUserDataPtr ) ) gIsAdaptiveIdle = false;
+	}
 
 bail:	
 	return rc;
 }
 	
 
+/* myVideoOutputBegunProc
+		BeginAsync() done proc, called from the event loop once the device has answered or timed out.
+*/
+static void myVideoOutputBegunProc( CVideoOutput *inVideoOutput, OSErr inResult, const DeviceTimesRecord &inTimes, void *inRefCon )
+{
+#pragma unused(inVideoOutput, inTimes)
+
+	WindowDataRecordPtr pUserData = (WindowDataRecordPtr)inRefCon;
+	
+	// Canceled, the session is being closed
+	if ( inResult == userCanceledErr ) return;
+	
+	if ( inResult == noErr ) {
+		VideoOutputBegun( pUserData );
+		return;
+	}
+	
+	ReportVideoOutputErrors( pUserData, "\pAttempting to get exclusive access to hardware failed..." );
+	
+	// Carry on in the window with the video output off, VO On can have another go
+	MCSetControllerAttached( pUserData->theController, true );
+	SetMCResizeBounds( pUserData, true );
+	MCDoAction( pUserData->theController, mcActionControllerSizeChanged, 0 );
+	if ( !IsWindowVisible( pUserData->theWindow ) ) {
+		TransitionWindow( pUserData->theWindow, kWindowZoomTransitionEffect, kWindowShowTransitionAction, NULL );
+		MCDraw( pUserData->theController, pUserData->theWindow );
+	}
+	SetMCPopupMenuState( pUserData, 0 );
+	SetMCPopupMenuState( pUserData, kVOutOffID );
+}
+
 /* StartVideoOutput
+		Begins the video output on CVideoOutput's device task so a slow device doesn't hold up the
+		UI or the other sessions, VideoOutputBegun() takes it from there.
 */
 OSErr StartVideoOutput( WindowDataRecordPtr inUserDataPtr )
 {
@@ -921,9 +1172,19 @@ OSErr StartVideoOutput( WindowDataRecordPtr inUserDataPtr )
 	
 	// Begin the video output, both sound and clock options are set to true by default in the interface,
 	// but we need to call SetEchoPort() after Begin() to tell the VOut where to draw
-	err = inUserDataPtr->pVideoOutput->Begin();
-	if ( err ) { DoError( "\pAttempting to get exclusive access to hardware failed..." ); goto bail; }
+	err = inUserDataPtr->pVideoOutput->BeginAsync( myVideoOutputBegunProc, inUserDataPtr, kBeginTimeout );
+	if ( err ) {
+		ReportVideoOutputErrors( inUserDataPtr, "\pAttempting to get exclusive access to hardware failed..." );
+	}
 	
+	return err;
+}
+
+/* VideoOutputBegun
+		Points the Movie and the controller at the video output once we have it.
+*/
+void VideoOutputBegun( WindowDataRecordPtr inUserDataPtr )
+{
 	// If the component supports an echo port, the echo port is our main window and we can resize,
 	// if not, turn off controller resizing and shrink the window to our default non-echo controller size
 	if ( inUserDataPtr->pVideoOutput->CanDoEchoPort() ) {
@@ -948,15 +1209,14 @@ OSErr StartVideoOutput( WindowDataRecordPtr inUserDataPtr )
 	
 	// Set the default state of our UI
 	SetMCPopupMenuState( inUserDataPtr, 0 );
-	if ( IsHighQualityOn( inUserDataPtr->theMovie ) ) {
+	if ( IsHighQualityOn( inUserDataPtr->pVideoOutput ) || inUserDataPtr->pVideoOutput->IsFieldAccurate() ) {
 		// High Quality is on for at least one visual track in the movie, so we
-		// go ahead and turn it on for the entire movie 
+		// go ahead and turn it on for the entire movie. It's also needed when the movie
+		// and the display mode are interlaced the same way, so both fields are decompressed
+		// and go out as they are instead of one field line doubled
 		SetMoviePlayHints( inUserDataPtr->theMovie, hintsHighQuality, hintsHighQuality );
 		SetMCPopupMenuState( inUserDataPtr, kHighQOnID );
 	}
-
-bail:
-	return err;
 }
 
 /* DoOpen
@@ -970,14 +1230,6 @@ OSErr DoOpen( ConstFSSpecPtr inFSSpecPtr, WindowDataRecordPtr inUserDataPtr )
 	
 	OSErr err = noErr;
 	
-	// Select an output component to use
-	err = inUserDataPtr->pVideoOutput->SelectVideoOutputComponent();
-	if ( err ) { DoError( "\pUnable to sucessfully select a video output component..." ); goto bail; }
-	
-	// Open the video output component
-	err = inUserDataPtr->pVideoOutput->Open();
-	if ( err ) { DoError( "\pUnable to sucessfully open the video output component..." ); goto bail; }
-	
 	if (inFSSpecPtr == NULL) {
 		// Get the File if we don't have one from the oDoc AE
 		err = GetOneFileWithPreview( 2, theOpenTypeList, &theFSSpec, NULL );
@@ -991,6 +1243,18 @@ OSErr DoOpen( ConstFSSpecPtr inFSSpecPtr, WindowDataRecordPtr inUserDataPtr )
 	err = DoOpenMovieFromFile( &theFSSpec, inUserDataPtr );
 	if ( err ) { DoError( "\pProblem opening movie from file..." ); goto bail; }
 	
+	// Start the settings dialog off on the mode best suited to the movie, if the
+	// movie format can't be worked out the dialog just shows the last selection
+	inUserDataPtr->pVideoOutput->SelectBestDisplayMode();
+	
+	// Select an output component to use
+	err = inUserDataPtr->pVideoOutput->SelectVideoOutputComponent();
+	if ( err ) { DoError( "\pUnable to sucessfully select a video output component..." ); goto bail; }
+	
+	// Open the video output component
+	err = inUserDataPtr->pVideoOutput->Open();
+	if ( err ) { DoError( "\pUnable to sucessfully open the video output component..." ); goto bail; }
+	
 	// Set up the Controller and install the Window Event Handlers	
 	err = DoCreateMovieController( inUserDataPtr );
 	if ( err ) { DoError( "\pProblem creating movie controller." ); goto bail; }
@@ -1002,6 +1266,7 @@ bail:
 	// There's been some nastiness so reset everything
 	if ( err != noErr ) {
 		if ( inUserDataPtr->theTimerRef ) {
+			if ( gIsAdaptiveIdle ) QTUninstallNextTaskNeededSoonerCallback( gNextTaskNeededSoonerUPP, inUserDataPtr );
 			RemoveEventLoopTimer( inUserDataPtr->theTimerRef );
 			inUserDataPtr->theTimerRef = NULL;
 		}
@@ -1024,13 +1289,115 @@ bail:
 	return err;
 }
 
+#pragma mark-
+
+/* NewSession
+		Creates a session with its own CVideoOutput and popup menu and puts it on the list,
+		DoOpen() does the rest.
+*/
+WindowDataRecordPtr NewSession( void )
+{
+	WindowDataRecordPtr pUserData = (WindowDataRecordPtr)NewPtrClear( sizeof(WindowDataRecord) );
+	if ( pUserData == NULL ) return NULL;
+	
+	// Instantiate a VideoOutput object without a specific Movie
+	pUserData->pVideoOutput = new(std::nothrow) CVideoOutput( "\pSimpleVideoOut" );
+	if ( pUserData->pVideoOutput == NULL || pUserData->pVideoOutput->GetError() ) goto bail;
+	
+	// The check marks are per session
+	if ( DuplicateMenu( gPopupMenuRef, &pUserData->thePopupMenuRef ) ) goto bail;
+	
+	pUserData->next = gSessions;
+	gSessions = pUserData;
+	
+	return pUserData;
+
+bail:
+	if ( pUserData->pVideoOutput ) delete pUserData->pVideoOutput;
+	DisposePtr( (Ptr)pUserData );
+	
+	return NULL;
+}
+
+/* DisposeSession
+		Takes a session off the list and disposes of it, the movie and window must already be gone.
+*/
+void DisposeSession( WindowDataRecordPtr inUserDataPtr )
+{
+	WindowDataRecordPtr *ppUserData;
+	
+	for ( ppUserData = &gSessions; *ppUserData; ppUserData = &(*ppUserData)->next ) {
+		if ( *ppUserData == inUserDataPtr ) {
+			*ppUserData = inUserDataPtr->next;
+			break;
+		}
+	}
+	
+	if ( inUserDataPtr->pVideoOutput ) delete inUserDataPtr->pVideoOutput;
+	if ( inUserDataPtr->thePopupMenuRef ) DisposeMenu( inUserDataPtr->thePopupMenuRef );
+	DisposePtr( (Ptr)inUserDataPtr );
+}
+
+/* FindSession
+		The session playing in inWindow, NULL if the window isn't one of ours.
+*/
+WindowDataRecordPtr FindSession( WindowRef inWindow )
+{
+	WindowDataRecordPtr pUserData;
+	
+	if ( inWindow == NULL ) return NULL;
+	
+	for ( pUserData = gSessions; pUserData; pUserData = pUserData->next ) {
+		if ( pUserData->theWindow == inWindow ) break;
+	}
+	
+	return pUserData;
+}
+
+/* CloseSession
+		Sends the session's window a close event, the window handler shuts everything down
+		and disposes of the session.
+*/
+void CloseSession( WindowDataRecordPtr inUserDataPtr )
+{
+	EventRef theWindowCloseEvent;
+	
+	if ( CreateEvent( NULL, kEventClassWindow, kEventWindowClose, 0, kEventAttributeNone, &theWindowCloseEvent ) ) return;
+	SendEventToEventTarget( theWindowCloseEvent, GetWindowEventTarget( inUserDataPtr->theWindow ) );
+	ReleaseEvent( theWindowCloseEvent );
+}
+
+/* DoOpenSession
+		Opens a movie in a new session, if the user cancels or it doesn't work out the session goes away.
+*/
+OSErr DoOpenSession( ConstFSSpecPtr inFSSpecPtr )
+{
+	OSErr err;
+	
+	WindowDataRecordPtr pUserData = NewSession();
+	if ( pUserData == NULL ) {
+		DoError( "\pProblem initializing CVideoOutput, or component unavailable..." );
+		return memFullErr;
+	}
+	
+	err = DoOpen( inFSSpecPtr, pUserData );
+	if ( err || pUserData->theWindow == NULL ) DisposeSession( pUserData );
+	
+	return err;
+}
+
 int main( void )
 {
 	Initialize();
 	
+	if ( kTraceRun ) CVideoOutputTrace::Start();
+	
 	RunApplicationEventLoop();
+	
+	if ( kTraceRun ) WriteTrace();
 
-	if (gGlobals.pVideoOutput) delete gGlobals.pVideoOutput;
+	// Quitting closes every session, this is just in case
+	while ( gSessions ) DisposeSession( gSessions );
 	ExitMovies();
 	
 	return 0;
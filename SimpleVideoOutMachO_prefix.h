@@ -1,6 +1,6 @@
 /*
   ===========================================================================
-	MacHeadersMach-O.h			2000 Metrowerks Inc. All rights reserved.
+	MacHeadersMach-O.h			©2000 Metrowerks Inc. All rights reserved.
   ===========================================================================
 
 	Processor independant interface to the MacHeadersMach-O files
@@ -18,7 +18,7 @@
 
 /*
   ===========================================================================
-	MSL MacHeadersMach-O.h	 2000-2002 Metrowerks Corporation.  All rights reserved.
+	MSL MacHeadersMach-O.h	© 2000-2002 Metrowerks Corporation.  All rights reserved.
   ===========================================================================
 
 	Processor independant interface to the MSLMacHeadersMach-O files
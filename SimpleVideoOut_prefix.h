@@ -1,5 +1,5 @@
 /* Metrowerks Standard Library
- * Copyright  1995-2001 Metrowerks Corporation.  All rights reserved.
+ * Copyright © 1995-2001 Metrowerks Corporation.  All rights reserved.
  *
  * $Date: 2004/10/05 00:04:53 $
  * $Revision: 1.1 $